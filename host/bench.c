@@ -0,0 +1,1148 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: bench.c
+ *
+ * Search engine benchmarks for host builds.
+ *
+ * By default, a search is run to completion over one or more RISC OS style
+ * paths, and the number of objects, matches and errors are reported along
+ * with the time taken.
+ *
+ * With -b, one of a set of fixed benchmarks is run instead, on data that it
+ * generates itself so that the figures can be reproduced. Those which need
+ * files build a tree in the given host directory (benchtree by default),
+ * which must not already exist, and remove it again afterwards. -N sets the
+ * size of the test, in the units given below.
+ *
+ *   wildcard	Names per second through wildcard_match() and through
+ *		string_wildcard_compare(), over N names (1,000,000).
+ *   intern	Strings per second stored in a text dump with and without its
+ *		hash table, for N strings of which half repeat (1,000,000).
+ *   objdb	Adding N objects to a database, deleting every other one, and
+ *		then looking up and iterating over the rest (1,000,000).
+ *   contents	MB per second for literal and wildcard contents searches over
+ *		N files of 1MB, read through a 256K buffer, and the bytes read
+ *		from disc compared to the bytes in the files (64).
+ *   deep	Objects per second when walking a chain of N nested
+ *		directories, each holding four files (500).
+ *   ignore	Directories and entries listed by a search with and without
+ *		an ignored subtree which holds N files (100,000).
+ *   textdump	Saved database size and time for matches-only and store-all
+ *		searches over a tree of N objects (1,000,000).
+ *
+ * Usage: locatebench [-n <name>] [-r <regex>] [-c <contents>] [-i] [-a] <path>[,<path>...]
+ *        locatebench -b <test> [-N <count>] [<directory>]
+ */
+
+/* ANSI C header files */
+
+#define _XOPEN_SOURCE 700
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* OSLib header files */
+
+#include "oslib/fileswitch.h"
+#include "oslib/os.h"
+#include "oslib/osgbpb.h"
+#include "oslib/types.h"
+
+/* SF-Lib header files. */
+
+#include "sflib/config.h"
+#include "sflib/string.h"
+
+/* Application header files */
+
+#include "discfile.h"
+#include "fsys.h"
+#include "objdb.h"
+#include "results.h"
+#include "search.h"
+#include "textdump.h"
+#include "wildcard.h"
+
+
+#define BENCH_PATH_LENGTH 4096							/**< The space allocated to host and RISC OS pathnames.	*/
+#define BENCH_NAME_LENGTH 32							/**< The longest name generated for the name corpus.		*/
+#define BENCH_FILE_SIZE (1024 * 1024)						/**< The size of the files used by the contents test.	*/
+#define BENCH_CONTENTS_BUFFER 256						/**< The contents buffer size, in KB, for the contents test.	*/
+#define BENCH_FILES_PER_DIR 1000						/**< The number of objects in each directory of a wide tree.	*/
+#define BENCH_MAX_DEPTH 1500							/**< The deepest chain that fits the host pathname buffers.	*/
+
+
+/**
+ * There are no windows on the host, so placeholder file and results blocks
+ * are provided for the database and search to belong to.
+ */
+
+struct file_block {
+	int			reserved;						/**< Unused.						*/
+};
+
+struct results_window {
+	int			reserved;						/**< Unused.						*/
+};
+
+
+/**
+ * A benchmark which can be selected with -b.
+ */
+
+struct bench_test {
+	char			*name;							/**< The name used to select the test.		*/
+	int			(*run)(unsigned count, char *directory);		/**< The function which runs the test.		*/
+	unsigned		count;							/**< The default size of the test.		*/
+};
+
+
+/**
+ * Counters for the output sent to the results window.
+ */
+
+static unsigned		bench_files = 0;					/**< The number of files reported.			*/
+static unsigned		bench_contents = 0;					/**< The number of contents matches reported.		*/
+static unsigned		bench_errors = 0;					/**< The number of errors reported.			*/
+
+static struct file_block	bench_file;						/**< The placeholder file block.			*/
+static struct results_window	bench_results;						/**< The placeholder results window.			*/
+
+static unsigned		bench_seed = 1;						/**< The state of the pseudo-random generator.		*/
+
+
+static struct search_block	*bench_create_search(struct objdb_block *objects, char *path, char *name, char *contents, char *ignore, osbool store_all);
+static double			bench_run_search(struct search_block *search);
+static int			bench_wildcard(unsigned count, char *directory);
+static int			bench_intern(unsigned count, char *directory);
+static int			bench_objdb(unsigned count, char *directory);
+static int			bench_contents_search(unsigned count, char *directory);
+static int			bench_deep(unsigned count, char *directory);
+static int			bench_ignore(unsigned count, char *directory);
+static int			bench_textdump(unsigned count, char *directory);
+static char			*bench_make_corpus(unsigned count);
+static osbool			bench_make_directory(char *path);
+static osbool			bench_make_wide_tree(char *path, unsigned count, unsigned files);
+static osbool			bench_make_file(char *path, int size, char *text, int spacing);
+static void			bench_remove_tree(char *path);
+static int			bench_remove_object(const char *path, const struct stat *info, int flag, struct FTW *ftw);
+static void			bench_riscos_path(char *host, char *buffer, size_t length);
+static unsigned			bench_random(void);
+static double			bench_time(void);
+static void			bench_usage(char *name);
+
+
+/**
+ * The benchmarks which can be selected with -b.
+ */
+
+static struct bench_test	bench_tests[] = {
+	{"wildcard",	bench_wildcard,		1000000},
+	{"intern",	bench_intern,		1000000},
+	{"objdb",	bench_objdb,		1000000},
+	{"contents",	bench_contents_search,	64},
+	{"deep",	bench_deep,		500},
+	{"ignore",	bench_ignore,		100000},
+	{"textdump",	bench_textdump,		1000000},
+	{NULL,		NULL,			0}
+};
+
+
+/**
+ * Record an error from the search.
+ */
+
+void results_add_error(struct results_window *handle, char *message, unsigned key)
+{
+	bench_errors++;
+	fprintf(stderr, "%s\n", message);
+}
+
+
+/**
+ * Record a file matched by the search.
+ */
+
+unsigned results_add_file(struct results_window *handle, unsigned key)
+{
+	return bench_files++;
+}
+
+
+/**
+ * Record a set of duplicate files found by the search.
+ */
+
+unsigned results_add_duplicates(struct results_window *handle, unsigned count, int size)
+{
+	return RESULTS_NULL;
+}
+
+
+/**
+ * Record a file from a set of duplicates.
+ */
+
+unsigned results_add_duplicate(struct results_window *handle, unsigned key, unsigned parent)
+{
+	return bench_files++;
+}
+
+
+/**
+ * Results lines aren't kept, so there are no earlier lines to find.
+ */
+
+unsigned results_find_file(struct results_window *handle, unsigned key)
+{
+	return RESULTS_NULL;
+}
+
+
+/**
+ * Record a contents match from the search.
+ */
+
+void results_add_contents(struct results_window *handle, unsigned key, unsigned parent, char *text)
+{
+	bench_contents++;
+}
+
+
+/**
+ * The remaining results window calls have nothing to do.
+ */
+
+void results_set_options(struct results_window *handle, osbool full_info)
+{
+}
+
+void results_set_status(struct results_window *handle, char *status)
+{
+}
+
+void results_set_status_template(struct results_window *handle, char *token, char *text)
+{
+}
+
+void results_set_title(struct results_window *handle, char *title)
+{
+}
+
+void results_accept_lines(struct results_window *handle)
+{
+}
+
+
+/**
+ * Run the benchmark.
+ */
+
+int main(int argc, char *argv[])
+{
+	struct objdb_block	*objects;
+	struct search_block	*search;
+	struct bench_test	*test;
+	char			*name = NULL, *regex = NULL, *contents = NULL, *benchmark = NULL;
+	osbool			any_case = FALSE, store_all = FALSE;
+	unsigned		count = 0;
+	os_t			start, end;
+	int			option;
+
+	while ((option = getopt(argc, argv, "n:r:c:iab:N:")) != -1) {
+		switch (option) {
+		case 'n':
+			name = optarg;
+			break;
+		case 'r':
+			regex = optarg;
+			break;
+		case 'c':
+			contents = optarg;
+			break;
+		case 'i':
+			any_case = TRUE;
+			break;
+		case 'a':
+			store_all = TRUE;
+			break;
+		case 'b':
+			benchmark = optarg;
+			break;
+		case 'N':
+			count = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			bench_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	config_int_init("MultitaskTimeslot", 10);
+	config_int_init("OSGBPBReadSize", 1000);
+	config_int_init("ContentsBufSize", 0);
+
+	/* Run one of the fixed benchmarks, if one was requested. */
+
+	if (benchmark != NULL) {
+		for (test = bench_tests; test->name != NULL && strcmp(test->name, benchmark) != 0; test++);
+
+		if (test->name == NULL || optind + 1 < argc) {
+			bench_usage(argv[0]);
+			return 1;
+		}
+
+		return test->run((count > 0) ? count : test->count, (optind < argc) ? argv[optind] : "benchtree");
+	}
+
+	if (optind >= argc) {
+		bench_usage(argv[0]);
+		return 1;
+	}
+
+	/* Otherwise, run a search over the paths given. */
+
+	objects = objdb_create(&bench_file);
+	if (objects == NULL)
+		return 1;
+
+	search = search_create(&bench_file, objects, &bench_results, argv[optind]);
+	if (search == NULL)
+		return 1;
+
+	search_set_options(search, FALSE, store_all, FALSE, TRUE, TRUE, TRUE);
+
+	if (name != NULL)
+		search_set_filename(search, name, any_case, FALSE);
+
+	if (regex != NULL && !search_set_filename_regex(search, regex, any_case, FALSE)) {
+		fprintf(stderr, "Bad regular expression\n");
+		return 1;
+	}
+
+	if (contents != NULL)
+		search_set_contents(search, contents, any_case, FALSE);
+
+	start = os_read_monotonic_time();
+
+	search_start(search);
+
+	while (search_poll_required())
+		search_poll_all((os_t) config_int_read("MultitaskTimeslot"));
+
+	end = os_read_monotonic_time();
+
+	printf("Matches: %u, contents: %u, errors: %u, time: %u.%02us\n",
+			bench_files, bench_contents, bench_errors, (end - start) / 100, (end - start) % 100);
+
+	search_destroy(search);
+	objdb_destroy(objects);
+
+	return 0;
+}
+
+
+/**
+ * Create a search for one of the fixed benchmarks, and reset the results
+ * counters ready for it to run.
+ *
+ * \param *objects		The database to hold the objects found.
+ * \param *path			The RISC OS pathname to search.
+ * \param *name			The filename pattern to match, or NULL.
+ * \param *contents		The contents to match, or NULL.
+ * \param *ignore		The ignore list to apply, or NULL.
+ * \param store_all		TRUE to store all objects; FALSE to store
+ *				only matches.
+ * \return			The new search, or NULL on failure.
+ */
+
+static struct search_block *bench_create_search(struct objdb_block *objects, char *path, char *name, char *contents, char *ignore, osbool store_all)
+{
+	struct search_block	*search;
+
+	search = search_create(&bench_file, objects, &bench_results, path);
+	if (search == NULL)
+		return NULL;
+
+	search_set_options(search, FALSE, store_all, FALSE, TRUE, TRUE, TRUE);
+
+	if (name != NULL)
+		search_set_filename(search, name, FALSE, FALSE);
+
+	if (contents != NULL)
+		search_set_contents(search, contents, FALSE, FALSE);
+
+	if (ignore != NULL)
+		search_set_ignore(search, ignore);
+
+	bench_files = 0;
+	bench_contents = 0;
+	bench_errors = 0;
+
+	return search;
+}
+
+
+/**
+ * Run a search to completion.
+ *
+ * \param *search		The search to run.
+ * \return			The time taken, in seconds.
+ */
+
+static double bench_run_search(struct search_block *search)
+{
+	double	start;
+
+	start = bench_time();
+
+	search_start(search);
+
+	while (search_poll_required())
+		search_poll_all((os_t) config_int_read("MultitaskTimeslot"));
+
+	return bench_time() - start;
+}
+
+
+/**
+ * Compare the compiled wildcard matcher with string_wildcard_compare() on a
+ * corpus of generated names. Lists are given to string_wildcard_compare()
+ * one pattern at a time, stopping at the first match.
+ *
+ * \param count			The number of names in the corpus.
+ * \param *directory		Unused.
+ * \return			The exit status.
+ */
+
+static int bench_wildcard(unsigned count, char *directory)
+{
+	struct wildcard_block	*matcher;
+	char			*corpus, *name, *patterns[] = {"Data1*", "*/c", "*ot*", "ReadMe##", "*/c,*/h,Make*,Notes#", NULL};
+	char			list[BENCH_NAME_LENGTH * 4], *pattern, *next;
+	unsigned		i, p, compiled_matches, compare_matches;
+	double			start, compiled_time, compare_time;
+
+	corpus = bench_make_corpus(count);
+	if (corpus == NULL)
+		return 1;
+
+	for (p = 0; patterns[p] != NULL; p++) {
+		matcher = wildcard_create(patterns[p], TRUE);
+		if (matcher == NULL) {
+			free(corpus);
+			return 1;
+		}
+
+		compiled_matches = 0;
+		start = bench_time();
+
+		for (i = 0, name = corpus; i < count; i++, name += BENCH_NAME_LENGTH)
+			if (wildcard_match(matcher, name) != WILDCARD_NONE)
+				compiled_matches++;
+
+		compiled_time = bench_time() - start;
+
+		wildcard_destroy(matcher);
+
+		compare_matches = 0;
+		start = bench_time();
+
+		for (i = 0, name = corpus; i < count; i++, name += BENCH_NAME_LENGTH) {
+			string_copy(list, patterns[p], sizeof(list));
+
+			for (pattern = list; pattern != NULL; pattern = next) {
+				next = strchr(pattern, ',');
+				if (next != NULL)
+					*next++ = '\0';
+
+				if (string_wildcard_compare(pattern, name, TRUE)) {
+					compare_matches++;
+					break;
+				}
+			}
+		}
+
+		compare_time = bench_time() - start;
+
+		printf("%-24s matches: %7u, wildcard_match: %6.0fK names/s, string_wildcard_compare: %6.0fK names/s%s\n",
+				patterns[p], compiled_matches, count / compiled_time / 1000, count / compare_time / 1000,
+				(compiled_matches != compare_matches) ? " (MISMATCH)" : "");
+	}
+
+	free(corpus);
+
+	return 0;
+}
+
+
+/**
+ * Store generated names in a text dump with and without its hash table.
+ * Each name is stored twice, so with the table half of the stores find an
+ * existing copy.
+ *
+ * \param count			The number of strings to store.
+ * \param *directory		Unused.
+ * \return			The exit status.
+ */
+
+static int bench_intern(unsigned count, char *directory)
+{
+	struct textdump_block	*text;
+	char			*corpus;
+	unsigned		i, unique, hash;
+	double			start, time;
+
+	unique = (count + 1) / 2;
+
+	corpus = bench_make_corpus(unique);
+	if (corpus == NULL)
+		return 1;
+
+	for (hash = 0; hash <= 256; hash += 256) {
+		text = textdump_create(0, hash, '\0');
+		if (text == NULL) {
+			free(corpus);
+			return 1;
+		}
+
+		start = bench_time();
+
+		for (i = 0; i < count; i++)
+			if (textdump_store(text, corpus + (i % unique) * BENCH_NAME_LENGTH) == TEXTDUMP_NULL)
+				break;
+
+		time = bench_time() - start;
+
+		printf("%-10s stored: %u, time: %.3fs, %.0fK strings/s, dump size: %zu bytes\n",
+				(hash > 0) ? "Hashed:" : "Unhashed:", i, time, i / time / 1000, textdump_get_size(text));
+
+		textdump_destroy(text);
+	}
+
+	free(corpus);
+
+	return 0;
+}
+
+
+/**
+ * Add objects to a database, delete every other one, and then find the
+ * ones which are left by key and by iterating over the database.
+ *
+ * \param count			The number of objects to add.
+ * \param *directory		Unused.
+ * \return			The exit status.
+ */
+
+static int bench_objdb(unsigned count, char *directory)
+{
+	struct objdb_block	*objects;
+	osgbpb_info		*info;
+	unsigned		root, key, i, found;
+	int			size;
+	unsigned long long	total;
+	int			buffer[(sizeof(osgbpb_info) + BENCH_NAME_LENGTH) / sizeof(int) + 1];
+	double			start, add_time, delete_time, lookup_time, iterate_time;
+
+	objects = objdb_create(&bench_file);
+	if (objects == NULL)
+		return 1;
+
+	root = objdb_add_root(objects, "$");
+	info = (osgbpb_info *) buffer;
+
+	/* Add the objects. */
+
+	start = bench_time();
+
+	for (i = 0; i < count; i++) {
+		info->load_addr = 0xfffffd00u;
+		info->exec_addr = i;
+		info->size = i;
+		info->attr = fileswitch_ATTR_OWNER_READ | fileswitch_ATTR_OWNER_WRITE;
+		info->obj_type = fileswitch_IS_FILE;
+		snprintf(info->name, BENCH_NAME_LENGTH, "File%u", i);
+
+		if (objdb_add_file(objects, root, info) == OBJDB_NULL_KEY)
+			break;
+	}
+
+	add_time = bench_time() - start;
+
+	/* Delete every other object. */
+
+	start = bench_time();
+
+	for (key = objdb_get_next_key(objects, OBJDB_NULL_KEY); key != OBJDB_NULL_KEY; key = objdb_get_next_key(objects, key))
+		if (objdb_get_size(objects, key) % 2 == 1)
+			objdb_delete_key(objects, key);
+
+	delete_time = bench_time() - start;
+
+	/* Look every key up, including the deleted ones. */
+
+	total = 0;
+	start = bench_time();
+
+	for (key = 0; key < objdb_get_key_limit(objects); key++) {
+		size = objdb_get_size(objects, key);
+		if (size > 0)
+			total += size;
+	}
+
+	lookup_time = bench_time() - start;
+
+	/* Iterate over the survivors. */
+
+	found = 0;
+	start = bench_time();
+
+	for (key = objdb_get_next_key(objects, OBJDB_NULL_KEY); key != OBJDB_NULL_KEY; key = objdb_get_next_key(objects, key))
+		found++;
+
+	iterate_time = bench_time() - start;
+
+	printf("Added: %u in %.3fs, deleted half in %.3fs, looked up %u keys in %.3fs, iterated over %u in %.3fs (size total %llu)\n",
+			i, add_time, delete_time, objdb_get_key_limit(objects), lookup_time, found, iterate_time, total);
+
+	objdb_destroy(objects);
+
+	return 0;
+}
+
+
+/**
+ * Run literal and wildcard contents searches over a set of 1MB files, each
+ * holding a match at the start, at the end and across every boundary of the
+ * contents buffer, and compare the bytes read with the size of the files.
+ *
+ * \param count			The number of files to search.
+ * \param *directory		The host directory to build the files in.
+ * \return			The exit status.
+ */
+
+static int bench_contents_search(unsigned count, char *directory)
+{
+	struct objdb_block	*objects;
+	struct search_block	*search;
+	struct fsys_counts	before, after;
+	char			path[BENCH_PATH_LENGTH], riscos[BENCH_PATH_LENGTH], *patterns[] = {"needle", "ne*dle", NULL};
+	unsigned		i, p;
+	unsigned long long	total;
+	double			time;
+
+	if (!bench_make_directory(directory))
+		return 1;
+
+	for (i = 0; i < count; i++) {
+		snprintf(path, sizeof(path), "%s/file%u", directory, i);
+		if (!bench_make_file(path, BENCH_FILE_SIZE, "needle", BENCH_CONTENTS_BUFFER * 1024)) {
+			bench_remove_tree(directory);
+			return 1;
+		}
+	}
+
+	bench_riscos_path(directory, riscos, sizeof(riscos));
+	config_int_set("ContentsBufSize", BENCH_CONTENTS_BUFFER);
+
+	total = (unsigned long long) count * BENCH_FILE_SIZE;
+
+	for (p = 0; patterns[p] != NULL; p++) {
+		objects = objdb_create(&bench_file);
+		search = (objects != NULL) ? bench_create_search(objects, riscos, NULL, patterns[p], NULL, FALSE) : NULL;
+		if (search == NULL) {
+			bench_remove_tree(directory);
+			return 1;
+		}
+
+		fsys_get_counts(&before);
+		time = bench_run_search(search);
+		fsys_get_counts(&after);
+
+		printf("%-8s files: %u, matches: %u, time: %.3fs, %.1f MB/s, bytes held: %llu, read: %llu, read again: %llu\n",
+				patterns[p], bench_files, bench_contents, time, total / time / (1024 * 1024), total, after.bytes - before.bytes,
+				(after.bytes - before.bytes > total) ? after.bytes - before.bytes - total : 0);
+
+		search_destroy(search);
+		objdb_destroy(objects);
+	}
+
+	bench_remove_tree(directory);
+
+	return 0;
+}
+
+
+/**
+ * Walk a single chain of nested directories, each holding four files.
+ *
+ * \param count			The depth of the chain.
+ * \param *directory		The host directory to build the chain in.
+ * \return			The exit status.
+ */
+
+static int bench_deep(unsigned count, char *directory)
+{
+	struct objdb_block	*objects;
+	struct search_block	*search;
+	char			path[BENCH_PATH_LENGTH], riscos[BENCH_PATH_LENGTH], leaf[BENCH_NAME_LENGTH];
+	size_t			length;
+	unsigned		level, i, total;
+	double			time;
+
+	if (count > BENCH_MAX_DEPTH) {
+		fprintf(stderr, "The deepest chain which can be built is %u levels\n", BENCH_MAX_DEPTH);
+		return 1;
+	}
+
+	if (!bench_make_directory(directory))
+		return 1;
+
+	string_copy(path, directory, sizeof(path));
+	length = strlen(path);
+
+	for (level = 0; level < count; level++) {
+		for (i = 0; i < 4; i++) {
+			snprintf(leaf, sizeof(leaf), "/f%u", i);
+			string_copy(path + length, leaf, sizeof(path) - length);
+
+			if (!bench_make_file(path, 0, NULL, 0)) {
+				bench_remove_tree(directory);
+				return 1;
+			}
+		}
+
+		string_copy(path + length, "/d", sizeof(path) - length);
+		length += 2;
+
+		if (!bench_make_directory(path)) {
+			bench_remove_tree(directory);
+			return 1;
+		}
+	}
+
+	bench_riscos_path(directory, riscos, sizeof(riscos));
+
+	objects = objdb_create(&bench_file);
+	search = (objects != NULL) ? bench_create_search(objects, riscos, "f0", NULL, NULL, FALSE) : NULL;
+	if (search == NULL) {
+		bench_remove_tree(directory);
+		return 1;
+	}
+
+	time = bench_run_search(search);
+	search_get_counts(search, &total, NULL, NULL);
+
+	printf("Depth: %u, objects: %u, matches: %u, time: %.3fs, %.0fK objects/s\n",
+			count, total, bench_files, time, total / time / 1000);
+
+	search_destroy(search);
+	objdb_destroy(objects);
+
+	bench_remove_tree(directory);
+
+	return 0;
+}
+
+
+/**
+ * Search a tree with and without its largest subtree on the ignore list,
+ * and compare the directories and entries which are listed.
+ *
+ * \param count			The number of files in the ignored subtree.
+ * \param *directory		The host directory to build the tree in.
+ * \return			The exit status.
+ */
+
+static int bench_ignore(unsigned count, char *directory)
+{
+	struct objdb_block	*objects;
+	struct search_block	*search;
+	struct fsys_counts	before, after;
+	char			path[BENCH_PATH_LENGTH], riscos[BENCH_PATH_LENGTH], *ignore;
+	int			pass;
+	double			time;
+
+	if (!bench_make_directory(directory))
+		return 1;
+
+	snprintf(path, sizeof(path), "%s/Keep", directory);
+	if (!bench_make_wide_tree(path, 1000, 100)) {
+		bench_remove_tree(directory);
+		return 1;
+	}
+
+	snprintf(path, sizeof(path), "%s/Scrap", directory);
+	if (!bench_make_wide_tree(path, count, BENCH_FILES_PER_DIR)) {
+		bench_remove_tree(directory);
+		return 1;
+	}
+
+	bench_riscos_path(directory, riscos, sizeof(riscos));
+
+	for (pass = 0; pass < 2; pass++) {
+		ignore = (pass == 0) ? NULL : "Scrap";
+
+		objects = objdb_create(&bench_file);
+		search = (objects != NULL) ? bench_create_search(objects, riscos, "NoMatch", NULL, ignore, FALSE) : NULL;
+		if (search == NULL) {
+			bench_remove_tree(directory);
+			return 1;
+		}
+
+		fsys_get_counts(&before);
+		time = bench_run_search(search);
+		fsys_get_counts(&after);
+
+		printf("%-14s directories listed: %u, entries read: %u, time: %.3fs\n",
+				(ignore == NULL) ? "No ignore list:" : "Ignore Scrap:",
+				after.directories - before.directories, after.entries - before.entries, time);
+
+		search_destroy(search);
+		objdb_destroy(objects);
+	}
+
+	bench_remove_tree(directory);
+
+	return 0;
+}
+
+
+/**
+ * Run a matches-only and a store-all search over a wide tree, and compare
+ * the size of the object database that each would save. The matches-only
+ * search finds one file in each directory.
+ *
+ * \param count			The number of objects in the tree.
+ * \param *directory		The host directory to build the tree in.
+ * \return			The exit status.
+ */
+
+static int bench_textdump(unsigned count, char *directory)
+{
+	struct objdb_block	*objects;
+	struct search_block	*search;
+	struct discfile_block	*out;
+	struct stat		info;
+	char			saved[BENCH_PATH_LENGTH], riscos[BENCH_PATH_LENGTH];
+	unsigned		total;
+	int			pass;
+	double			time;
+
+	if (!bench_make_wide_tree(directory, count, BENCH_FILES_PER_DIR))
+		return 1;
+
+	bench_riscos_path(directory, riscos, sizeof(riscos));
+	snprintf(saved, sizeof(saved), "%s.objdb", directory);
+
+	for (pass = 0; pass < 2; pass++) {
+		objects = objdb_create(&bench_file);
+		search = (objects != NULL) ? bench_create_search(objects, riscos, "File1", NULL, NULL, (pass == 1) ? TRUE : FALSE) : NULL;
+		if (search == NULL) {
+			bench_remove_tree(directory);
+			return 1;
+		}
+
+		time = bench_run_search(search);
+		search_get_counts(search, &total, NULL, NULL);
+
+		out = discfile_open_write(saved);
+		if (out != NULL) {
+			objdb_save_file(objects, out);
+			discfile_close(out);
+		}
+
+		printf("%-13s objects: %u, matches: %u, time: %.3fs, database saved: %lld bytes\n",
+				(pass == 0) ? "Matches only:" : "Store all:", total, bench_files, time,
+				(out != NULL && stat(saved, &info) == 0) ? (long long) info.st_size : -1ll);
+
+		remove(saved);
+
+		search_destroy(search);
+		objdb_destroy(objects);
+	}
+
+	bench_remove_tree(directory);
+
+	return 0;
+}
+
+
+/**
+ * Generate a corpus of names in the style of those found on a RISC OS disc,
+ * each held in a fixed BENCH_NAME_LENGTH byte slot. The same corpus is
+ * generated on every run.
+ *
+ * \param count			The number of names to generate.
+ * \return			Pointer to the corpus, to be freed by the
+ *				caller, or NULL on failure.
+ */
+
+static char *bench_make_corpus(unsigned count)
+{
+	char		*corpus, *stems[] = {"!Boot", "Data", "Image", "Index", "Make", "Notes", "ReadMe", "Sprites", "Temp", "file"};
+	char		*suffixes[] = {"", "", "", "/c", "/h", "/o", "/txt", "Bak"};
+	unsigned	i, random;
+
+	corpus = malloc((size_t) count * BENCH_NAME_LENGTH);
+	if (corpus == NULL)
+		return NULL;
+
+	bench_seed = 1;
+
+	for (i = 0; i < count; i++) {
+		random = bench_random();
+		snprintf(corpus + (size_t) i * BENCH_NAME_LENGTH, BENCH_NAME_LENGTH, "%s%u%s",
+				stems[random % 10], (random / 10) % 1000, suffixes[(random / 10000) % 8]);
+	}
+
+	return corpus;
+}
+
+
+/**
+ * Create a host directory for a test, which must not already exist.
+ *
+ * \param *path			The host pathname of the directory.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+static osbool bench_make_directory(char *path)
+{
+	if (mkdir(path, 0755) == 0)
+		return TRUE;
+
+	perror(path);
+
+	return FALSE;
+}
+
+
+/**
+ * Build a wide tree of empty files in a new host directory, with up to
+ * the given number of files in each subdirectory. The first file in each
+ * subdirectory is called File1.
+ *
+ * \param *path			The host pathname of the directory.
+ * \param count			The number of objects to create, including
+ *				the subdirectories.
+ * \param files			The number of objects in each subdirectory,
+ *				including the subdirectory itself.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+static osbool bench_make_wide_tree(char *path, unsigned count, unsigned files)
+{
+	char		file[BENCH_PATH_LENGTH];
+	unsigned	made, directory, i;
+
+	if (!bench_make_directory(path))
+		return FALSE;
+
+	for (made = 0, directory = 0; made < count; directory++) {
+		snprintf(file, sizeof(file), "%s/Dir%u", path, directory);
+		if (!bench_make_directory(file))
+			return FALSE;
+
+		made++;
+
+		for (i = 1; i < files && made < count; i++, made++) {
+			snprintf(file, sizeof(file), "%s/Dir%u/File%u", path, directory, i);
+			if (!bench_make_file(file, 0, NULL, 0))
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+
+/**
+ * Create a host file, filled with pseudo-random lower case letters. If a
+ * text is given, it is placed at the start and end of the file and across
+ * each multiple of the spacing.
+ *
+ * \param *path			The host pathname of the file.
+ * \param size			The size of the file.
+ * \param *text			The text to place in the file, or NULL.
+ * \param spacing		The interval at which to place the text.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+static osbool bench_make_file(char *path, int size, char *text, int spacing)
+{
+	char	*data;
+	int	handle, length, i;
+	osbool	success;
+
+	handle = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if (handle < 0) {
+		perror(path);
+		return FALSE;
+	}
+
+	if (size == 0) {
+		close(handle);
+		return TRUE;
+	}
+
+	data = malloc(size);
+	if (data == NULL) {
+		close(handle);
+		return FALSE;
+	}
+
+	for (i = 0; i < size; i++)
+		data[i] = 'a' + bench_random() % 26;
+
+	if (text != NULL) {
+		length = strlen(text);
+
+		memcpy(data, text, length);
+		memcpy(data + size - length, text, length);
+
+		for (i = spacing; i + length / 2 < size - length; i += spacing)
+			memcpy(data + i - length / 2, text, length);
+	}
+
+	success = (write(handle, data, size) == size) ? TRUE : FALSE;
+
+	free(data);
+	close(handle);
+
+	if (!success)
+		perror(path);
+
+	return success;
+}
+
+
+/**
+ * Remove a host directory tree built for a test.
+ *
+ * \param *path			The host pathname of the tree.
+ */
+
+static void bench_remove_tree(char *path)
+{
+	nftw(path, bench_remove_object, 64, FTW_DEPTH | FTW_PHYS);
+}
+
+
+/**
+ * Remove an object found by nftw() while removing a tree.
+ *
+ * \param *path			The host pathname of the object.
+ * \param *info			The details of the object.
+ * \param flag			The type of the object.
+ * \param *ftw			The position of the object in the tree.
+ * \return			0 to continue the walk.
+ */
+
+static int bench_remove_object(const char *path, const struct stat *info, int flag, struct FTW *ftw)
+{
+	remove(path);
+
+	return 0;
+}
+
+
+/**
+ * Convert a host pathname into the RISC OS form used by the search engine,
+ * by swapping the '.' and '/' characters and mapping a leading '/' on to
+ * the root.
+ *
+ * \param *host			The host pathname to convert.
+ * \param *buffer		Pointer to a buffer to take the RISC OS path.
+ * \param length		The size of the buffer.
+ */
+
+static void bench_riscos_path(char *host, char *buffer, size_t length)
+{
+	size_t	out = 0;
+
+	if (*host == '/' && length > 2) {
+		buffer[out++] = '$';
+		buffer[out++] = '.';
+		host++;
+	}
+
+	for (; *host != '\0' && out + 1 < length; host++)
+		buffer[out++] = (*host == '/') ? '.' : (*host == '.') ? '/' : *host;
+
+	buffer[out] = '\0';
+}
+
+
+/**
+ * Return the next value from a simple linear congruential generator, so
+ * that the generated data is the same on every run.
+ *
+ * \return			The next pseudo-random value.
+ */
+
+static unsigned bench_random(void)
+{
+	bench_seed = bench_seed * 1103515245u + 12345u;
+
+	return bench_seed >> 8;
+}
+
+
+/**
+ * Read the time from a high resolution monotonic clock.
+ *
+ * \return			The time, in seconds.
+ */
+
+static double bench_time(void)
+{
+	struct timespec	now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+/**
+ * Report the command syntax.
+ *
+ * \param *name			The name of the command.
+ */
+
+static void bench_usage(char *name)
+{
+	fprintf(stderr, "Usage: %s [-n <name>] [-r <regex>] [-c <contents>] [-i] [-a] <path>[,<path>...]\n"
+			"       %s -b <test> [-N <count>] [<directory>]\n\n"
+			"Tests: wildcard, intern, objdb, contents, deep, ignore, textdump\n", name, name);
+}
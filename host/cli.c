@@ -0,0 +1,1590 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: cli.c
+ *
+ * Headless search front end for host builds. The search parameters are
+ * taken from a saved search file and/or the command line, the search is run
+ * to completion without yielding, and the matches are streamed to stdout or
+ * a file as they are found. A summary of the counts and time taken goes to
+ * stderr.
+ *
+ * Usage: locate [<options>] [<path> ...]
+ *
+ * The exit status is 0 if anything matched, 1 if nothing matched and 2 if
+ * the search could not be set up.
+ *
+ * A filename index of a single root can be built with -B and brought up to
+ * date with -U; searches given an index with -x read their directory listings
+ * from it instead of the disc.
+ *
+ * A search run with -S saves its state to a file if it is interrupted, and
+ * exits with status 3; running again with -R and the same search options
+ * picks it up from where it stopped, appending to any output file.
+ *
+ * With -D, only files which share their size and contents hash with another
+ * of the matches are reported, in sets: plain and info output separate the sets with a blank
+ * line, CSV output gives each file its set number, and JSON output has a
+ * record for each set before its files.
+ */
+
+/* ANSI C header files */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* OSLib header files */
+
+#include "oslib/fileswitch.h"
+#include "oslib/os.h"
+#include "oslib/osfile.h"
+#include "oslib/osfscontrol.h"
+#include "oslib/osgbpb.h"
+#include "oslib/territory.h"
+#include "oslib/types.h"
+
+/* SF-Lib header files. */
+
+#include "sflib/config.h"
+#include "sflib/heap.h"
+#include "sflib/string.h"
+
+/* Application header files */
+
+#include "datetime.h"
+#include "dialogue.h"
+#include "discfile.h"
+#include "flex.h"
+#include "index.h"
+#include "objdb.h"
+#include "results.h"
+#include "search.h"
+
+/**
+ * The offset from the RISC OS epoch (1900) to the Unix one (1970), in
+ * centiseconds.
+ */
+
+#define CLI_EPOCH_OFFSET 0x336e996a00ull
+
+/**
+ * The maximum length of a pathname that will be output.
+ */
+
+#define CLI_PATH_LENGTH 1024
+
+/**
+ * Return the larger of a current buffer size and a new requirement.
+ */
+
+#define MAX_BUFFER(current, size) (((size) > (current)) ? (size) : (current))
+
+
+/**
+ * There are no windows on the host, so placeholder file and results blocks
+ * are provided for the database and search to belong to.
+ */
+
+struct file_block {
+	int			reserved;						/**< Unused.						*/
+};
+
+struct results_window {
+	int			reserved;						/**< Unused.						*/
+};
+
+
+/**
+ * Output formats.
+ */
+
+enum cli_format {
+	CLI_FORMAT_PLAIN,							/**< Pathnames only, one per line.			*/
+	CLI_FORMAT_INFO,							/**< Type, size, date and access before each pathname.	*/
+	CLI_FORMAT_CSV,								/**< Comma-separated values with a header row.		*/
+	CLI_FORMAT_JSON								/**< One JSON object per line.				*/
+};
+
+
+/**
+ * The search settings, following the layout of the search dialogue so that
+ * saved searches can be read straight in. The modes and units take values
+ * from the dialogue_* enums in dialogue.h.
+ */
+
+struct cli_settings {
+	char			*path;							/**< The search path (flex block).			*/
+
+	unsigned		name_mode;						/**< The filename comparison mode.			*/
+	char			*filename;						/**< The filename (flex block).				*/
+	osbool			ignore_case;						/**< Whether filename matching ignores case.		*/
+
+	unsigned		size_mode;						/**< The size comparison mode.				*/
+	unsigned		size_min;						/**< The minimum size.					*/
+	unsigned		size_min_unit;						/**< The unit of the minimum size.			*/
+	unsigned		size_max;						/**< The maximum size.					*/
+	unsigned		size_max_unit;						/**< The unit of the maximum size.			*/
+
+	osbool			use_age;						/**< TRUE to test age; FALSE to test date.		*/
+
+	unsigned		date_mode;						/**< The date comparison mode.				*/
+	os_date_and_time	date_min;						/**< The minimum date.					*/
+	unsigned		date_min_status;					/**< The status of the minimum date.			*/
+	os_date_and_time	date_max;						/**< The maximum date.					*/
+	unsigned		date_max_status;					/**< The status of the maximum date.			*/
+
+	unsigned		age_mode;						/**< The age comparison mode.				*/
+	unsigned		age_min;						/**< The minimum age.					*/
+	unsigned		age_min_unit;						/**< The unit of the minimum age.			*/
+	unsigned		age_max;						/**< The maximum age.					*/
+	unsigned		age_max_unit;						/**< The unit of the maximum age.			*/
+
+	osbool			type_files;						/**< TRUE to match files.				*/
+	osbool			type_directories;					/**< TRUE to match directories.				*/
+	osbool			type_applications;					/**< TRUE to match applications.			*/
+	unsigned		type_mode;						/**< The filetype comparison mode.			*/
+	unsigned		*type_types;						/**< The filetype list (flex block).			*/
+
+	osbool			attributes_locked;					/**< Whether to test the locked attribute.		*/
+	osbool			attributes_locked_yes;					/**< The required locked state.				*/
+	osbool			attributes_owner_read;					/**< Whether to test the owner read attribute.		*/
+	osbool			attributes_owner_read_yes;				/**< The required owner read state.			*/
+	osbool			attributes_owner_write;					/**< Whether to test the owner write attribute.		*/
+	osbool			attributes_owner_write_yes;				/**< The required owner write state.			*/
+	osbool			attributes_public_read;					/**< Whether to test the public read attribute.		*/
+	osbool			attributes_public_read_yes;				/**< The required public read state.			*/
+	osbool			attributes_public_write;				/**< Whether to test the public write attribute.	*/
+	osbool			attributes_public_write_yes;				/**< The required public write state.			*/
+
+	unsigned		contents_mode;						/**< The contents comparison mode.			*/
+	char			*contents_text;						/**< The contents text (flex block).			*/
+	osbool			contents_ignore_case;					/**< Whether contents matching ignores case.		*/
+
+	osbool			store_all;						/**< Whether to record every object found.		*/
+	osbool			ignore_imagefs;						/**< Whether to skip into image filing systems.		*/
+	osbool			full_info;						/**< Whether to gather full file information.		*/
+	osbool			duplicates;						/**< Whether to report only duplicate files.		*/
+	char			*ignore_list;						/**< The list of names to ignore (flex block).		*/
+};
+
+
+/**
+ * The output state.
+ */
+
+static struct objdb_block	*cli_objects = NULL;				/**< The object database for the search.		*/
+static FILE			*cli_out = NULL;				/**< The stream to write matches to.			*/
+static enum cli_format		cli_output_format = CLI_FORMAT_PLAIN;		/**< The format to write matches in.			*/
+static osbool			cli_quiet = FALSE;				/**< TRUE to suppress errors and the summary.		*/
+
+static unsigned			cli_files = 0;					/**< The number of files reported.			*/
+static unsigned			cli_contents = 0;				/**< The number of contents matches reported.		*/
+static unsigned			cli_errors = 0;					/**< The number of errors reported.			*/
+static unsigned			cli_sets = 0;					/**< The number of duplicate sets reported.		*/
+
+static volatile sig_atomic_t	cli_interrupted = 0;				/**< Set when an interrupt has been received.		*/
+
+
+static int cli_update_index(char *filename, char *root);
+static void cli_interrupt(int signal);
+static unsigned cli_write_file(unsigned key, unsigned set);
+static osbool cli_save_state(struct search_block *search, char *filename);
+static osbool cli_initialise_settings(struct cli_settings *settings);
+static void cli_free_settings(struct cli_settings *settings);
+static osbool cli_load_settings(struct cli_settings *settings, char *filename);
+static osbool cli_set_string(char **block, char *text);
+static osbool cli_set_types(struct cli_settings *settings, char *list);
+static osbool cli_set_size(struct cli_settings *settings, char *range);
+static osbool cli_set_age(struct cli_settings *settings, char *range);
+static osbool cli_parse_value(char *value, char *units, unsigned *number, unsigned *unit, unsigned default_unit);
+static osbool cli_apply_settings(struct cli_settings *settings, struct search_block *search);
+static void cli_make_contains_list(char *buffer, size_t length, char *list);
+static int cli_scale_size(unsigned base, unsigned unit, osbool top);
+static void cli_scale_age(os_date_and_time date, unsigned base, unsigned unit, int round);
+static void cli_write_string(char *text);
+static void cli_usage(char *name);
+
+
+/**
+ * Record an error from the search.
+ */
+
+void results_add_error(struct results_window *handle, char *message, unsigned key)
+{
+	char	path[CLI_PATH_LENGTH];
+
+	cli_errors++;
+
+	if (cli_quiet)
+		return;
+
+	if (key != OBJDB_NULL_KEY && objdb_get_name(cli_objects, key, path, CLI_PATH_LENGTH))
+		fprintf(stderr, "%s: %s\n", path, message);
+	else
+		fprintf(stderr, "%s\n", message);
+}
+
+
+/**
+ * Write a file matched by the search to the output in the selected format.
+ */
+
+unsigned results_add_file(struct results_window *handle, unsigned key)
+{
+	return cli_write_file(key, 0);
+}
+
+
+/**
+ * Start a set of duplicate files in the output, returning the set number
+ * for the files which follow.
+ */
+
+unsigned results_add_duplicates(struct results_window *handle, unsigned count, int size)
+{
+	cli_sets++;
+
+	switch (cli_output_format) {
+	case CLI_FORMAT_PLAIN:
+	case CLI_FORMAT_INFO:
+		if (cli_sets > 1)
+			fprintf(cli_out, "\n");
+		break;
+
+	case CLI_FORMAT_CSV:
+		break;
+
+	case CLI_FORMAT_JSON:
+		fprintf(cli_out, "{\"set\":%u,\"files\":%u,\"size\":%d}\n", cli_sets, count, size);
+		break;
+	}
+
+	return cli_sets;
+}
+
+
+/**
+ * Write a file from a set of duplicates to the output in the selected
+ * format.
+ */
+
+unsigned results_add_duplicate(struct results_window *handle, unsigned key, unsigned parent)
+{
+	return cli_write_file(key, parent);
+}
+
+
+/**
+ * Results lines aren't kept, so there are no earlier lines to find.
+ */
+
+unsigned results_find_file(struct results_window *handle, unsigned key)
+{
+	return RESULTS_NULL;
+}
+
+
+/**
+ * Write a contents match from the search to the output in the selected
+ * format.
+ */
+
+void results_add_contents(struct results_window *handle, unsigned key, unsigned parent, char *text)
+{
+	char	path[CLI_PATH_LENGTH];
+
+	cli_contents++;
+
+	switch (cli_output_format) {
+	case CLI_FORMAT_PLAIN:
+	case CLI_FORMAT_INFO:
+		fprintf(cli_out, "\t%s\n", text);
+		break;
+
+	case CLI_FORMAT_CSV:
+		if (!objdb_get_name(cli_objects, key, path, CLI_PATH_LENGTH))
+			break;
+
+		cli_write_string(path);
+		fprintf(cli_out, ",,,,,");
+		cli_write_string(text);
+		fprintf(cli_out, "\n");
+		break;
+
+	case CLI_FORMAT_JSON:
+		if (!objdb_get_name(cli_objects, key, path, CLI_PATH_LENGTH))
+			break;
+
+		fprintf(cli_out, "{\"path\":");
+		cli_write_string(path);
+		fprintf(cli_out, ",\"contents\":");
+		cli_write_string(text);
+		fprintf(cli_out, "}\n");
+		break;
+	}
+}
+
+
+/**
+ * The remaining results window calls have nothing to do.
+ */
+
+void results_set_options(struct results_window *handle, osbool full_info)
+{
+}
+
+void results_set_status(struct results_window *handle, char *status)
+{
+}
+
+void results_set_status_template(struct results_window *handle, char *token, char *text)
+{
+}
+
+void results_set_title(struct results_window *handle, char *title)
+{
+}
+
+void results_accept_lines(struct results_window *handle)
+{
+}
+
+
+/**
+ * Run a search from the command line.
+ */
+
+int main(int argc, char *argv[])
+{
+	struct file_block	file;
+	struct results_window	results;
+	struct cli_settings	settings;
+	struct search_block	*search;
+	struct index_block	*index = NULL;
+	struct discfile_block	*load;
+	char			*output = NULL, *index_file = NULL, *state_file = NULL, *resume_file = NULL;
+	int			index_mode = 0;
+	osbool			resumed, saved = FALSE;
+	unsigned		objects, matches, errors;
+	os_t			start, end;
+	int			option, i;
+	size_t			length;
+
+	config_int_init("MultitaskTimeslot", 10);
+	config_int_init("OSGBPBReadSize", 1000);
+	config_int_init("ContentsBufSize", 0);
+
+	if (!cli_initialise_settings(&settings)) {
+		fprintf(stderr, "Out of memory\n");
+		return 2;
+	}
+
+	/* Process the options in order, so that those given after a saved
+	 * search file override its settings.
+	 */
+
+	while ((option = getopt(argc, argv, "f:n:r:vic:C:t:T:k:s:a:I:ADF:o:qx:B:U:S:R:")) != -1) {
+		switch (option) {
+		case 'f':
+			if (!cli_load_settings(&settings, optarg))
+				return 2;
+			break;
+		case 'n':
+			settings.name_mode = DIALOGUE_NAME_EQUAL_TO;
+			cli_set_string(&settings.filename, optarg);
+			break;
+		case 'r':
+			settings.name_mode = DIALOGUE_NAME_MATCHES_REGEX;
+			cli_set_string(&settings.filename, optarg);
+			break;
+		case 'v':
+			if (settings.name_mode == DIALOGUE_NAME_EQUAL_TO)
+				settings.name_mode = DIALOGUE_NAME_NOT_EQUAL_TO;
+			else if (settings.name_mode == DIALOGUE_NAME_MATCHES_REGEX)
+				settings.name_mode = DIALOGUE_NAME_DOES_NOT_MATCH_REGEX;
+			break;
+		case 'i':
+			settings.ignore_case = TRUE;
+			settings.contents_ignore_case = TRUE;
+			break;
+		case 'c':
+		case 'C':
+			settings.contents_mode = (option == 'c') ? DIALOGUE_CONTENTS_INCLUDE : DIALOGUE_CONTENTS_DO_NOT_INCLUDE;
+			cli_set_string(&settings.contents_text, optarg);
+			break;
+		case 't':
+		case 'T':
+			settings.type_mode = (option == 't') ? DIALOGUE_TYPE_OF_TYPE : DIALOGUE_TYPE_NOT_OF_TYPE;
+			if (!cli_set_types(&settings, optarg))
+				return 2;
+			break;
+		case 'k':
+			settings.type_files = (strchr(optarg, 'f') != NULL) ? TRUE : FALSE;
+			settings.type_directories = (strchr(optarg, 'd') != NULL) ? TRUE : FALSE;
+			settings.type_applications = (strchr(optarg, 'a') != NULL) ? TRUE : FALSE;
+			break;
+		case 's':
+			if (!cli_set_size(&settings, optarg))
+				return 2;
+			break;
+		case 'a':
+			if (!cli_set_age(&settings, optarg))
+				return 2;
+			break;
+		case 'I':
+			cli_set_string(&settings.ignore_list, optarg);
+			break;
+		case 'A':
+			settings.store_all = TRUE;
+			break;
+		case 'D':
+			settings.duplicates = TRUE;
+			break;
+		case 'F':
+			if (strcmp(optarg, "plain") == 0) {
+				cli_output_format = CLI_FORMAT_PLAIN;
+			} else if (strcmp(optarg, "info") == 0) {
+				cli_output_format = CLI_FORMAT_INFO;
+			} else if (strcmp(optarg, "csv") == 0) {
+				cli_output_format = CLI_FORMAT_CSV;
+			} else if (strcmp(optarg, "json") == 0) {
+				cli_output_format = CLI_FORMAT_JSON;
+			} else {
+				fprintf(stderr, "Unknown output format '%s'\n", optarg);
+				return 2;
+			}
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'q':
+			cli_quiet = TRUE;
+			break;
+		case 'x':
+		case 'B':
+		case 'U':
+			index_file = optarg;
+			index_mode = option;
+			break;
+		case 'S':
+			state_file = optarg;
+			break;
+		case 'R':
+			resume_file = optarg;
+			break;
+		default:
+			cli_usage(argv[0]);
+			return 2;
+		}
+	}
+
+	/* Any remaining arguments replace the saved search path. */
+
+	if (optind < argc) {
+		length = 0;
+		for (i = optind; i < argc; i++)
+			length += strlen(argv[i]) + 1;
+
+		if (flex_extend((flex_ptr) &settings.path, length) == 0) {
+			fprintf(stderr, "Out of memory\n");
+			return 2;
+		}
+
+		settings.path[0] = '\0';
+
+		for (i = optind; i < argc; i++) {
+			if (i > optind)
+				strcat(settings.path, ",");
+			strcat(settings.path, argv[i]);
+		}
+	}
+
+	/* If the search is to be saved when interrupted, catch the signals. */
+
+	if (state_file != NULL) {
+		signal(SIGINT, cli_interrupt);
+		signal(SIGTERM, cli_interrupt);
+	}
+
+	/* Building or refreshing an index replaces the search. */
+
+	if (index_mode == 'U' || (index_mode == 'B' && settings.path[0] != '\0')) {
+		i = cli_update_index(index_file, (index_mode == 'B') ? settings.path : NULL);
+		cli_free_settings(&settings);
+		return i;
+	}
+
+	if (index_mode == 'x') {
+		index = index_load_file(index_file);
+		if (index == NULL) {
+			fprintf(stderr, "Unable to load index '%s'\n", index_file);
+			return 2;
+		}
+
+		if (settings.path[0] == '\0')
+			cli_set_string(&settings.path, index_get_root(index));
+	}
+
+	if (settings.path[0] == '\0' && resume_file == NULL) {
+		cli_usage(argv[0]);
+		return 2;
+	}
+
+	/* Set up the output, adding to it if a search is being resumed. */
+
+	if (output != NULL) {
+		cli_out = fopen(output, (resume_file != NULL) ? "a" : "w");
+		if (cli_out == NULL) {
+			fprintf(stderr, "Unable to open '%s' for output\n", output);
+			return 2;
+		}
+	} else {
+		cli_out = stdout;
+	}
+
+	if (cli_output_format == CLI_FORMAT_CSV && resume_file == NULL)
+		fprintf(cli_out, (settings.duplicates) ? "path,filetype,size,date,access,set\n" : "path,filetype,size,date,access,contents\n");
+
+	/* Create the search, taking the object database from the saved state
+	 * if a search is being resumed.
+	 */
+
+	load = NULL;
+
+	if (resume_file != NULL) {
+		load = discfile_open_read(resume_file);
+		cli_objects = (load != NULL) ? objdb_load_file(&file, load) : NULL;
+	} else {
+		cli_objects = objdb_create(&file);
+	}
+
+	if (cli_objects == NULL) {
+		if (load != NULL)
+			discfile_close(load);
+
+		if (resume_file != NULL)
+			fprintf(stderr, "Unable to resume search from '%s'\n", resume_file);
+
+		index_destroy(index);
+		cli_free_settings(&settings);
+		return 2;
+	}
+
+	search = search_create(&file, cli_objects, &results, settings.path);
+	if (search == NULL)
+		return 2;
+
+	if (!cli_apply_settings(&settings, search))
+		return 2;
+
+	search_set_index(search, index);
+
+	if (load != NULL) {
+		resumed = search_load_file(search, load);
+
+		if (discfile_close(load) || !resumed) {
+			fprintf(stderr, "Unable to resume search from '%s'\n", resume_file);
+
+			search_destroy(search);
+			index_destroy(index);
+			objdb_destroy(cli_objects);
+			cli_free_settings(&settings);
+			return 2;
+		}
+	}
+
+	/* Run the search to completion, or until it's interrupted if its state
+	 * is to be saved.
+	 */
+
+	start = os_read_monotonic_time();
+
+	if (resume_file != NULL)
+		search_resume(search);
+	else
+		search_start(search);
+
+	if (state_file != NULL) {
+		while (search_is_active(search) && !cli_interrupted)
+			search_poll_all((os_t) config_int_read("MultitaskTimeslot"));
+	} else {
+		search_run(search);
+	}
+
+	end = os_read_monotonic_time();
+
+	if (search_is_active(search)) {
+		search_pause(search);
+
+		saved = cli_save_state(search, state_file);
+
+		if (!saved)
+			fprintf(stderr, "Unable to save search to '%s'\n", state_file);
+		else if (!cli_quiet)
+			fprintf(stderr, "Search saved to '%s'\n", state_file);
+	}
+
+	search_get_counts(search, &objects, &matches, &errors);
+
+	if (!cli_quiet)
+		fprintf(stderr, "Objects: %u, matches: %u, contents: %u, errors: %u, time: %u.%02us, duty cycle: %u%%\n",
+				objects, matches, cli_contents, errors, (end - start) / 100, (end - start) % 100, search_get_duty_cycle(search));
+
+	if (!cli_quiet && search_get_pruned_paths(search) > 0)
+		fprintf(stderr, "Overlapping paths skipped: %u\n", search_get_pruned_paths(search));
+
+	search_destroy(search);
+	index_destroy(index);
+	objdb_destroy(cli_objects);
+	cli_free_settings(&settings);
+
+	if (cli_out != stdout)
+		fclose(cli_out);
+
+	if (saved)
+		return 3;
+
+	return (cli_files > 0) ? 0 : 1;
+}
+
+
+/**
+ * Note that an interrupt has been received, so that the search can be
+ * stopped and saved at the end of the current poll.
+ *
+ * \param signal		The signal received.
+ */
+
+static void cli_interrupt(int signal)
+{
+	cli_interrupted = 1;
+}
+
+
+/**
+ * Save the state of a paused search, along with its object database.
+ *
+ * \param *search		The search to save.
+ * \param *filename		The name of the file to save to.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+static osbool cli_save_state(struct search_block *search, char *filename)
+{
+	struct discfile_block	*out;
+	osbool			saved;
+
+	out = discfile_open_write(filename);
+	if (out == NULL)
+		return FALSE;
+
+	objdb_save_file(cli_objects, out);
+	saved = search_save_file(search, out);
+
+	return (discfile_close(out) || !saved) ? FALSE : TRUE;
+}
+
+
+/**
+ * Build a new filename index, or refresh an existing one, and save it.
+ *
+ * \param *filename		The name of the index file.
+ * \param *root			The root directory for a new index, or NULL to
+ *				refresh the existing index.
+ * \return			The exit status.
+ */
+
+static int cli_update_index(char *filename, char *root)
+{
+	struct index_block	*index;
+	unsigned		objects, directories, errors, listed;
+	osbool			success;
+	os_t			start, end;
+
+	if (root != NULL && strchr(root, ',') != NULL) {
+		fprintf(stderr, "An index can only have one root\n");
+		return 2;
+	}
+
+	index = (root != NULL) ? index_create(root) : index_load_file(filename);
+	if (index == NULL) {
+		fprintf(stderr, (root != NULL) ? "Out of memory\n" : "Unable to load index '%s'\n", filename);
+		return 2;
+	}
+
+	start = os_read_monotonic_time();
+
+	if (root != NULL) {
+		success = index_build(index);
+		index_get_counts(index, NULL, &listed, NULL);
+	} else {
+		success = index_refresh(index, &listed);
+	}
+
+	end = os_read_monotonic_time();
+
+	if (!success) {
+		fprintf(stderr, "Unable to %s index of '%s'\n", (root != NULL) ? "build" : "refresh", index_get_root(index));
+		index_destroy(index);
+		return 2;
+	}
+
+	if (!index_save_file(index, filename)) {
+		fprintf(stderr, "Unable to save index '%s'\n", filename);
+		index_destroy(index);
+		return 2;
+	}
+
+	index_get_counts(index, &objects, &directories, &errors);
+
+	if (!cli_quiet)
+		fprintf(stderr, "Objects: %u, directories: %u, listed: %u, errors: %u, time: %u.%02us\n",
+				objects, directories, listed, errors, (end - start) / 100, (end - start) % 100);
+
+	index_destroy(index);
+
+	return 0;
+}
+
+
+/**
+ * Initialise a settings block to the dialogue defaults.
+ *
+ * \param *settings		The settings block to initialise.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool cli_initialise_settings(struct cli_settings *settings)
+{
+	memset(settings, 0, sizeof(struct cli_settings));
+
+	settings->size_min_unit = DIALOGUE_SIZE_KBYTES;
+	settings->size_max_unit = DIALOGUE_SIZE_KBYTES;
+	settings->age_min_unit = DIALOGUE_AGE_DAYS;
+	settings->age_max_unit = DIALOGUE_AGE_DAYS;
+	settings->date_min_status = DATETIME_DATE_INVALID;
+	settings->date_max_status = DATETIME_DATE_INVALID;
+
+	settings->type_files = TRUE;
+	settings->type_directories = TRUE;
+	settings->type_applications = TRUE;
+
+	settings->ignore_imagefs = TRUE;
+	settings->full_info = TRUE;
+	settings->duplicates = FALSE;
+
+	if (!cli_set_string(&settings->path, "") || !cli_set_string(&settings->filename, "") ||
+			!cli_set_string(&settings->contents_text, "") || !cli_set_string(&settings->ignore_list, ""))
+		return FALSE;
+
+	if (flex_alloc((flex_ptr) &settings->type_types, sizeof(unsigned)) == 0)
+		return FALSE;
+
+	settings->type_types[0] = 0xffffffffu;
+
+	return TRUE;
+}
+
+
+/**
+ * Free the memory used by a settings block.
+ *
+ * \param *settings		The settings block to free.
+ */
+
+static void cli_free_settings(struct cli_settings *settings)
+{
+	if (settings->path != NULL)
+		flex_free((flex_ptr) &settings->path);
+
+	if (settings->filename != NULL)
+		flex_free((flex_ptr) &settings->filename);
+
+	if (settings->contents_text != NULL)
+		flex_free((flex_ptr) &settings->contents_text);
+
+	if (settings->ignore_list != NULL)
+		flex_free((flex_ptr) &settings->ignore_list);
+
+	if (settings->type_types != NULL)
+		flex_free((flex_ptr) &settings->type_types);
+}
+
+
+/**
+ * Read the search settings from a saved search file, using the same tags as
+ * the search dialogue.
+ *
+ * \param *settings		The settings block to update.
+ * \param *filename		The name of the file to load.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool cli_load_settings(struct cli_settings *settings, char *filename)
+{
+	struct discfile_block	*load;
+
+	load = discfile_open_read(filename);
+	if (load == NULL) {
+		fprintf(stderr, "Unable to open '%s'\n", filename);
+		return FALSE;
+	}
+
+	if (discfile_read_format(load) != DISCFILE_LOCATE2) {
+		fprintf(stderr, "'%s' is not a Locate 2 search file\n", filename);
+		discfile_close(load);
+		return FALSE;
+	}
+
+	if (!discfile_open_section(load, DISCFILE_SECTION_DIALOGUE) || !discfile_open_chunk(load, DISCFILE_CHUNK_OPTIONS)) {
+		fprintf(stderr, "'%s' does not contain any search settings\n", filename);
+		discfile_close(load);
+		return FALSE;
+	}
+
+	discfile_read_option_flex_string(load, "PAT", (flex_ptr) &settings->path);
+
+	discfile_read_option_unsigned(load, "FMD", &settings->name_mode);
+	discfile_read_option_flex_string(load, "FNM", (flex_ptr) &settings->filename);
+	discfile_read_option_boolean(load, "FIC", &settings->ignore_case);
+
+	discfile_read_option_unsigned(load, "SMD", &settings->size_mode);
+	discfile_read_option_unsigned(load, "SMN", &settings->size_min);
+	discfile_read_option_unsigned(load, "SUM", &settings->size_min_unit);
+	discfile_read_option_unsigned(load, "SMX", &settings->size_max);
+	discfile_read_option_unsigned(load, "SUX", &settings->size_max_unit);
+
+	discfile_read_option_boolean(load, "AGE", &settings->use_age);
+
+	discfile_read_option_unsigned(load, "DMD", &settings->date_mode);
+	discfile_read_option_date(load, "DMN", settings->date_min);
+	discfile_read_option_unsigned(load, "DSM", &settings->date_min_status);
+	discfile_read_option_date(load, "DMX", settings->date_max);
+	discfile_read_option_unsigned(load, "DSX", &settings->date_max_status);
+
+	discfile_read_option_unsigned(load, "AMD", &settings->age_mode);
+	discfile_read_option_unsigned(load, "AMN", &settings->age_min);
+	discfile_read_option_unsigned(load, "AUM", &settings->age_min_unit);
+	discfile_read_option_unsigned(load, "AMX", &settings->age_max);
+	discfile_read_option_unsigned(load, "AUX", &settings->age_max_unit);
+
+	discfile_read_option_boolean(load, "TFI", &settings->type_files);
+	discfile_read_option_boolean(load, "TDR", &settings->type_directories);
+	discfile_read_option_boolean(load, "TAP", &settings->type_applications);
+	discfile_read_option_unsigned(load, "TMD", &settings->type_mode);
+	discfile_read_option_unsigned_array(load, "TTL", (flex_ptr) &settings->type_types, 0xffffffffu);
+
+	discfile_read_option_boolean(load, "PLK", &settings->attributes_locked);
+	discfile_read_option_boolean(load, "PLY", &settings->attributes_locked_yes);
+	discfile_read_option_boolean(load, "Prd", &settings->attributes_owner_read);
+	discfile_read_option_boolean(load, "PrY", &settings->attributes_owner_read_yes);
+	discfile_read_option_boolean(load, "Pwr", &settings->attributes_owner_write);
+	discfile_read_option_boolean(load, "PwY", &settings->attributes_owner_write_yes);
+	discfile_read_option_boolean(load, "PRD", &settings->attributes_public_read);
+	discfile_read_option_boolean(load, "PRY", &settings->attributes_public_read_yes);
+	discfile_read_option_boolean(load, "PWR", &settings->attributes_public_write);
+	discfile_read_option_boolean(load, "PRY", &settings->attributes_public_write_yes);
+
+	discfile_read_option_unsigned(load, "CMD", &settings->contents_mode);
+	discfile_read_option_flex_string(load, "CTX", (flex_ptr) &settings->contents_text);
+	discfile_read_option_boolean(load, "CIC", &settings->contents_ignore_case);
+
+	discfile_read_option_boolean(load, "ALL", &settings->store_all);
+	discfile_read_option_boolean(load, "IMG", &settings->ignore_imagefs);
+	discfile_read_option_boolean(load, "FUL", &settings->full_info);
+	discfile_read_option_boolean(load, "DUP", &settings->duplicates);
+	discfile_read_option_flex_string(load, "IGN", (flex_ptr) &settings->ignore_list);
+
+	discfile_close_chunk(load);
+	discfile_close_section(load);
+
+	if (discfile_close(load)) {
+		fprintf(stderr, "Unable to read '%s'\n", filename);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+/**
+ * Copy a string into a flex block, allocating or resizing it as required.
+ *
+ * \param **block		Pointer to the flex anchor for the string.
+ * \param *text			The text to copy.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool cli_set_string(char **block, char *text)
+{
+	size_t	length = strlen(text) + 1;
+
+	if (*block == NULL) {
+		if (flex_alloc((flex_ptr) block, length) == 0)
+			return FALSE;
+	} else {
+		if (flex_extend((flex_ptr) block, length) == 0)
+			return FALSE;
+	}
+
+	string_copy(*block, text, length);
+
+	return TRUE;
+}
+
+
+/**
+ * Set the filetype list from a comma-separated list of type names or hex
+ * numbers.
+ *
+ * \param *settings		The settings block to update.
+ * \param *list			The list of types.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool cli_set_types(struct cli_settings *settings, char *list)
+{
+	char		*copy, *name;
+	unsigned	count = 0;
+	bits		type;
+	os_error	*error;
+
+	copy = strdup(list);
+	if (copy == NULL)
+		return FALSE;
+
+	if (flex_extend((flex_ptr) &settings->type_types, sizeof(unsigned) * (strlen(list) + 2)) == 0) {
+		free(copy);
+		return FALSE;
+	}
+
+	for (name = strtok(copy, ","); name != NULL; name = strtok(NULL, ",")) {
+		error = xosfscontrol_file_type_from_string(name, &type);
+		if (error != NULL) {
+			fprintf(stderr, "Unknown filetype '%s'\n", name);
+			free(copy);
+			return FALSE;
+		}
+
+		settings->type_types[count++] = type;
+	}
+
+	settings->type_types[count] = 0xffffffffu;
+
+	free(copy);
+
+	return TRUE;
+}
+
+
+/**
+ * Set the size limits from a range in the form [<min>]:[<max>] or <size>,
+ * where each value may have a suffix of K or M.
+ *
+ * \param *settings		The settings block to update.
+ * \param *range		The range to parse.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool cli_set_size(struct cli_settings *settings, char *range)
+{
+	char	*max;
+
+	max = strchr(range, ':');
+
+	if (max == NULL) {
+		settings->size_mode = DIALOGUE_SIZE_EQUAL_TO;
+		return cli_parse_value(range, "BKM", &settings->size_min, &settings->size_min_unit, DIALOGUE_SIZE_BYTES);
+	}
+
+	*max++ = '\0';
+
+	if (*range != '\0' && *max != '\0') {
+		settings->size_mode = DIALOGUE_SIZE_BETWEEN;
+		return cli_parse_value(range, "BKM", &settings->size_min, &settings->size_min_unit, DIALOGUE_SIZE_BYTES) &&
+				cli_parse_value(max, "BKM", &settings->size_max, &settings->size_max_unit, DIALOGUE_SIZE_BYTES);
+	} else if (*range != '\0') {
+		settings->size_mode = DIALOGUE_SIZE_GREATER_THAN;
+		return cli_parse_value(range, "BKM", &settings->size_min, &settings->size_min_unit, DIALOGUE_SIZE_BYTES);
+	} else if (*max != '\0') {
+		settings->size_mode = DIALOGUE_SIZE_LESS_THAN;
+		return cli_parse_value(max, "BKM", &settings->size_min, &settings->size_min_unit, DIALOGUE_SIZE_BYTES);
+	}
+
+	fprintf(stderr, "Bad size range\n");
+	return FALSE;
+}
+
+
+/**
+ * Set the age limits from a range in the form [<min>]:[<max>] or <age>,
+ * where each value may have a suffix of m, h, d, w, M or y; the default is
+ * days.
+ *
+ * \param *settings		The settings block to update.
+ * \param *range		The range to parse.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool cli_set_age(struct cli_settings *settings, char *range)
+{
+	char	*max;
+
+	settings->use_age = TRUE;
+
+	max = strchr(range, ':');
+
+	if (max == NULL) {
+		settings->age_mode = DIALOGUE_AGE_EXACTLY;
+		return cli_parse_value(range, "mhdwMy", &settings->age_min, &settings->age_min_unit, DIALOGUE_AGE_DAYS);
+	}
+
+	*max++ = '\0';
+
+	if (*range != '\0' && *max != '\0') {
+		settings->age_mode = DIALOGUE_AGE_BETWEEN;
+		return cli_parse_value(range, "mhdwMy", &settings->age_min, &settings->age_min_unit, DIALOGUE_AGE_DAYS) &&
+				cli_parse_value(max, "mhdwMy", &settings->age_max, &settings->age_max_unit, DIALOGUE_AGE_DAYS);
+	} else if (*range != '\0') {
+		settings->age_mode = DIALOGUE_AGE_MORE_THAN;
+		return cli_parse_value(range, "mhdwMy", &settings->age_min, &settings->age_min_unit, DIALOGUE_AGE_DAYS);
+	} else if (*max != '\0') {
+		settings->age_mode = DIALOGUE_AGE_LESS_THAN;
+		return cli_parse_value(max, "mhdwMy", &settings->age_min, &settings->age_min_unit, DIALOGUE_AGE_DAYS);
+	}
+
+	fprintf(stderr, "Bad age range\n");
+	return FALSE;
+}
+
+
+/**
+ * Parse a number with an optional unit suffix.
+ *
+ * \param *value		The text to parse.
+ * \param *units		The valid suffixes, in order of unit value.
+ * \param *number		Pointer to a variable to take the number.
+ * \param *unit			Pointer to a variable to take the unit.
+ * \param default_unit		The unit to use if there is no suffix.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool cli_parse_value(char *value, char *units, unsigned *number, unsigned *unit, unsigned default_unit)
+{
+	char	*end, *suffix;
+
+	*number = strtoul(value, &end, 10);
+
+	if (end == value) {
+		fprintf(stderr, "Bad value '%s'\n", value);
+		return FALSE;
+	}
+
+	if (*end == '\0') {
+		*unit = default_unit;
+		return TRUE;
+	}
+
+	suffix = strchr(units, *end);
+
+	if (suffix == NULL || *(end + 1) != '\0') {
+		fprintf(stderr, "Bad unit in '%s'\n", value);
+		return FALSE;
+	}
+
+	*unit = suffix - units;
+
+	return TRUE;
+}
+
+
+/**
+ * Apply a settings block to a search, in the same way as the search
+ * dialogue does.
+ *
+ * \param *settings		The settings to apply.
+ * \param *search		The search to apply them to.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool cli_apply_settings(struct cli_settings *settings, struct search_block *search)
+{
+	size_t			buffer_size = 0;
+	char			*buffer;
+	os_date_and_time	min_date, max_date, now;
+	unsigned long long	centiseconds;
+
+	buffer_size = MAX_BUFFER(buffer_size, 3 * strlen(settings->filename) + 3);
+	buffer_size = MAX_BUFFER(buffer_size, strlen(settings->contents_text) + 1);
+	buffer_size = MAX_BUFFER(buffer_size, strlen(settings->ignore_list) + 1);
+
+	buffer = heap_alloc(buffer_size);
+	if (buffer == NULL)
+		return FALSE;
+
+	search_set_options(search, !settings->ignore_imagefs, settings->store_all, settings->full_info,
+			settings->type_files, settings->type_directories, settings->type_applications);
+
+	search_set_duplicates(search, settings->duplicates);
+
+	/* Set the ignore list. */
+
+	if (strcmp(settings->ignore_list, "") != 0) {
+		string_copy(buffer, settings->ignore_list, buffer_size);
+		search_set_ignore(search, buffer);
+	}
+
+	/* Set the filename search options. */
+
+	if (strcmp(settings->filename, "") != 0 && strcmp(settings->filename, "*") != 0) {
+		switch (settings->name_mode) {
+		case DIALOGUE_NAME_EQUAL_TO:
+		case DIALOGUE_NAME_NOT_EQUAL_TO:
+			string_copy(buffer, settings->filename, buffer_size);
+			search_set_filename(search, buffer, settings->ignore_case, (settings->name_mode == DIALOGUE_NAME_NOT_EQUAL_TO) ? TRUE : FALSE);
+			break;
+
+		case DIALOGUE_NAME_CONTAINS:
+		case DIALOGUE_NAME_DOES_NOT_CONTAIN:
+			cli_make_contains_list(buffer, buffer_size, settings->filename);
+			search_set_filename(search, buffer, settings->ignore_case, (settings->name_mode == DIALOGUE_NAME_DOES_NOT_CONTAIN) ? TRUE : FALSE);
+			break;
+
+		case DIALOGUE_NAME_MATCHES_REGEX:
+		case DIALOGUE_NAME_DOES_NOT_MATCH_REGEX:
+			string_copy(buffer, settings->filename, buffer_size);
+			if (!search_set_filename_regex(search, buffer, settings->ignore_case, (settings->name_mode == DIALOGUE_NAME_DOES_NOT_MATCH_REGEX) ? TRUE : FALSE)) {
+				fprintf(stderr, "Bad regular expression '%s'\n", settings->filename);
+				heap_free(buffer);
+				return FALSE;
+			}
+			break;
+		}
+	}
+
+	/* Set the size search options. */
+
+	switch (settings->size_mode) {
+	case DIALOGUE_SIZE_EQUAL_TO:
+	case DIALOGUE_SIZE_NOT_EQUAL_TO:
+		search_set_size(search, (settings->size_mode == DIALOGUE_SIZE_EQUAL_TO) ? TRUE : FALSE,
+				cli_scale_size(settings->size_min, settings->size_min_unit, FALSE),
+				cli_scale_size(settings->size_min, settings->size_min_unit, TRUE));
+		break;
+
+	case DIALOGUE_SIZE_GREATER_THAN:
+		search_set_size(search, TRUE, cli_scale_size(settings->size_min, settings->size_min_unit, TRUE), 0x7fffffff);
+		break;
+
+	case DIALOGUE_SIZE_LESS_THAN:
+		search_set_size(search, TRUE, 0x0u, cli_scale_size(settings->size_min, settings->size_min_unit, FALSE));
+		break;
+
+	case DIALOGUE_SIZE_BETWEEN:
+	case DIALOGUE_SIZE_NOT_BETWEEN:
+		search_set_size(search, (settings->size_mode == DIALOGUE_SIZE_BETWEEN) ? TRUE : FALSE,
+				cli_scale_size(settings->size_min, settings->size_min_unit, FALSE),
+				cli_scale_size(settings->size_max, settings->size_max_unit, TRUE));
+		break;
+	}
+
+	/* Set the datestamp search options. */
+
+	if (!settings->use_age && settings->date_min_status != DATETIME_DATE_INVALID) {
+		switch (settings->date_mode) {
+		case DIALOGUE_DATE_AT:
+		case DIALOGUE_DATE_AT_ANY_TIME_BUT:
+			datetime_copy_date(min_date, settings->date_min);
+			datetime_set_date(max_date, 0u, ((settings->date_min_status == DATETIME_DATE_DAY) ? DATETIME_1_DAY : DATETIME_1_MINUTE) - 1u);
+			datetime_add_date(max_date, min_date);
+			search_set_date(search, (settings->date_mode == DIALOGUE_DATE_AT) ? TRUE : FALSE, min_date, max_date, FALSE);
+			break;
+
+		case DIALOGUE_DATE_AFTER:
+			datetime_set_date(min_date, 0u, ((settings->date_min_status == DATETIME_DATE_DAY) ? DATETIME_1_DAY : DATETIME_1_MINUTE));
+			datetime_add_date(min_date, settings->date_min);
+			datetime_set_date(max_date, 0xffu, 0xffffffffu);
+			search_set_date(search, TRUE, min_date, max_date, FALSE);
+			break;
+
+		case DIALOGUE_DATE_BEFORE:
+			datetime_set_date(min_date, 0u, 0u);
+			datetime_copy_date(max_date, settings->date_min);
+			search_set_date(search, TRUE, min_date, max_date, FALSE);
+			break;
+
+		case DIALOGUE_DATE_BETWEEN:
+		case DIALOGUE_DATE_NOT_BETWEEN:
+			if (settings->date_max_status != DATETIME_DATE_INVALID) {
+				datetime_copy_date(min_date, settings->date_min);
+				datetime_set_date(max_date, 0u, ((settings->date_max_status == DATETIME_DATE_DAY) ? DATETIME_1_DAY : DATETIME_1_MINUTE) - 1u);
+				datetime_add_date(max_date, settings->date_max);
+				search_set_date(search, (settings->date_mode == DIALOGUE_DATE_BETWEEN) ? TRUE : FALSE, min_date, max_date, FALSE);
+			}
+			break;
+		}
+	}
+
+	/* Set the age search options, working from the host clock. */
+
+	if (settings->use_age && settings->age_mode != DIALOGUE_AGE_ANY_AGE) {
+		centiseconds = (unsigned long long) time(NULL) * 100ull + CLI_EPOCH_OFFSET;
+		datetime_set_date(now, (unsigned) (centiseconds >> 32) & 0xffu, (unsigned) centiseconds);
+
+		datetime_copy_date(min_date, now);
+		datetime_copy_date(max_date, now);
+
+		switch (settings->age_mode) {
+		case DIALOGUE_AGE_EXACTLY:
+		case DIALOGUE_AGE_ANY_AGE_BUT:
+			cli_scale_age(min_date, settings->age_min, settings->age_min_unit, -1);
+			cli_scale_age(max_date, settings->age_min, settings->age_min_unit, +1);
+			search_set_date(search, (settings->age_mode == DIALOGUE_AGE_EXACTLY) ? TRUE : FALSE, min_date, max_date, TRUE);
+			break;
+
+		case DIALOGUE_AGE_LESS_THAN:
+			cli_scale_age(min_date, settings->age_min, settings->age_min_unit, 0);
+			datetime_set_date(max_date, 0xffu, 0xffffffffu);
+			search_set_date(search, TRUE, min_date, max_date, TRUE);
+			break;
+
+		case DIALOGUE_AGE_MORE_THAN:
+			datetime_set_date(min_date, 0x0u, 0x0u);
+			cli_scale_age(max_date, settings->age_min, settings->age_min_unit, 0);
+			search_set_date(search, TRUE, min_date, max_date, TRUE);
+			break;
+
+		case DIALOGUE_AGE_BETWEEN:
+		case DIALOGUE_AGE_NOT_BETWEEN:
+			cli_scale_age(min_date, settings->age_min, settings->age_min_unit, 0);
+			cli_scale_age(max_date, settings->age_max, settings->age_max_unit, 0);
+			search_set_date(search, (settings->age_mode == DIALOGUE_AGE_BETWEEN) ? TRUE : FALSE, min_date, max_date, TRUE);
+			break;
+		}
+	}
+
+	/* Set the filetype search options. */
+
+	if (settings->type_mode != DIALOGUE_TYPE_OF_ANY && settings->type_types[0] != 0xffffffffu)
+		search_set_types(search, settings->type_types, (settings->type_mode == DIALOGUE_TYPE_NOT_OF_TYPE) ? TRUE : FALSE);
+
+	/* Set the attributes search options. */
+
+	if (settings->attributes_locked)
+		search_set_attributes(search, fileswitch_ATTR_OWNER_LOCKED, (settings->attributes_locked_yes) ? fileswitch_ATTR_OWNER_LOCKED : 0);
+
+	if (settings->attributes_owner_read)
+		search_set_attributes(search, fileswitch_ATTR_OWNER_READ, (settings->attributes_owner_read_yes) ? fileswitch_ATTR_OWNER_READ : 0);
+
+	if (settings->attributes_owner_write)
+		search_set_attributes(search, fileswitch_ATTR_OWNER_WRITE, (settings->attributes_owner_write_yes) ? fileswitch_ATTR_OWNER_WRITE : 0);
+
+	if (settings->attributes_public_read)
+		search_set_attributes(search, fileswitch_ATTR_WORLD_READ, (settings->attributes_public_read_yes) ? fileswitch_ATTR_WORLD_READ : 0);
+
+	if (settings->attributes_public_write)
+		search_set_attributes(search, fileswitch_ATTR_WORLD_WRITE, (settings->attributes_public_write_yes) ? fileswitch_ATTR_WORLD_WRITE : 0);
+
+	/* Set the contents search options. */
+
+	if (strcmp(settings->contents_text, "") != 0 && strcmp(settings->contents_text, "*") != 0 && settings->contents_mode != DIALOGUE_CONTENTS_ARE_NOT_IMPORTANT) {
+		string_copy(buffer, settings->contents_text, buffer_size);
+		search_set_contents(search, buffer, settings->contents_ignore_case, (settings->contents_mode == DIALOGUE_CONTENTS_DO_NOT_INCLUDE) ? TRUE : FALSE);
+	}
+
+	heap_free(buffer);
+
+	return TRUE;
+}
+
+
+/**
+ * Turn a comma-separated list of filenames into a list of wildcard patterns
+ * which will match any names containing them, by wrapping each in *s.
+ *
+ * \param *buffer		Pointer to the buffer to take the patterns.
+ * \param length		The length of the buffer.
+ * \param *list			Pointer to the list of filenames.
+ */
+
+static void cli_make_contains_list(char *buffer, size_t length, char *list)
+{
+	char	*end;
+
+	if (buffer == NULL || length == 0)
+		return;
+
+	end = buffer + length - 1;
+
+	while (list != NULL && buffer < end) {
+		*buffer++ = '*';
+
+		while (*list != '\0' && *list != ',' && buffer < end)
+			*buffer++ = *list++;
+
+		if (buffer < end)
+			*buffer++ = '*';
+
+		if (*list == ',' && buffer < end)
+			*buffer++ = *list++;
+		else
+			list = NULL;
+	}
+
+	*buffer = '\0';
+}
+
+
+/**
+ * Scale size values up by the dialogue units and round up or down.
+ *
+ * \param base			The base value to scale.
+ * \param unit			The units to be applied to the base value.
+ * \param top			TRUE to round up; FALSE to round down.
+ * \return			The scaled and rounded value in bytes.
+ */
+
+static int cli_scale_size(unsigned base, unsigned unit, osbool top)
+{
+	switch (unit) {
+	case DIALOGUE_SIZE_MBYTES:
+		return (base * 1048576) + ((top) ? +524288 : -524288);
+
+	case DIALOGUE_SIZE_KBYTES:
+		return (base * 1024) + ((top) ? +512 : -512);
+
+	case DIALOGUE_SIZE_BYTES:
+	default:
+		return base;
+	}
+}
+
+
+/**
+ * Scale age values up by the dialogue units and round up or down.
+ *
+ * \param date			The base date to be used and updated.
+ * \param base			The base value to scale.
+ * \param unit			The units to be applied to the base value.
+ * \param round			-1 to round down, 1 to round up, 0 to be exact.
+ */
+
+static void cli_scale_age(os_date_and_time date, unsigned base, unsigned unit, int round)
+{
+	os_date_and_time	factor;
+
+	switch (unit) {
+	case DIALOGUE_AGE_MINUTES:
+		datetime_set_date(factor, 0u, (DATETIME_1_MINUTE * base) + (DATETIME_HALF_MINUTE * round));
+		datetime_subtract_date(date, factor);
+		break;
+
+	case DIALOGUE_AGE_HOURS:
+		datetime_set_date(factor, 0u, (DATETIME_1_HOUR * base) + (DATETIME_HALF_HOUR * round));
+		datetime_subtract_date(date, factor);
+		break;
+
+	case DIALOGUE_AGE_DAYS:
+		datetime_set_date(factor, 0u, (DATETIME_1_DAY * base) + (DATETIME_HALF_DAY * round));
+		datetime_subtract_date(date, factor);
+		break;
+
+	case DIALOGUE_AGE_WEEKS:
+		datetime_set_date(factor, 0u, (DATETIME_1_WEEK * base) + (DATETIME_HALF_WEEK * round));
+		datetime_subtract_date(date, factor);
+		break;
+
+	case DIALOGUE_AGE_MONTHS:
+	case DIALOGUE_AGE_YEARS:
+		datetime_add_months(date, -base * ((unit == DIALOGUE_AGE_YEARS) ? 12 : 1));
+		datetime_set_date(factor, 0u, (unit == DIALOGUE_AGE_YEARS) ? DATETIME_HALF_YEAR : DATETIME_15_DAYS);
+		if (round < 0)
+			datetime_subtract_date(date, factor);
+		else if (round > 0)
+			datetime_add_date(date, factor);
+		break;
+	}
+}
+
+
+/**
+ * Write a file to the output in the selected format.
+ *
+ * \param key			The database key of the file.
+ * \param set			The number of the duplicate set to which the
+ *				file belongs, or 0 if none.
+ * \return			The number of the file in the output.
+ */
+
+static unsigned cli_write_file(unsigned key, unsigned set)
+{
+	char			path[CLI_PATH_LENGTH], date[32], access[8], *a;
+	osgbpb_info		*info;
+	struct objdb_info	additional;
+	size_t			size;
+	unsigned		filetype;
+	os_date_and_time	stamp;
+
+	if (!objdb_get_name(cli_objects, key, path, CLI_PATH_LENGTH))
+		return cli_files++;
+
+	if (cli_output_format == CLI_FORMAT_PLAIN) {
+		fprintf(cli_out, "%s\n", path);
+		return cli_files++;
+	}
+
+	size = objdb_get_info(cli_objects, key, NULL, 0, NULL);
+	info = heap_alloc(size);
+	if (info == NULL)
+		return cli_files++;
+
+	objdb_get_info(cli_objects, key, info, size, &additional);
+
+	filetype = additional.filetype;
+
+	/* Datestamps are only available for typed files. */
+
+	date[0] = '\0';
+
+	if ((info->load_addr & 0xfff00000u) == 0xfff00000u) {
+		datetime_set_date(stamp, info->load_addr & 0xffu, info->exec_addr);
+		territory_convert_date_and_time(territory_CURRENT, (os_date_and_time const *) stamp, date, sizeof(date), "%CE%YR-%MN-%DY %24:%MI:%SE");
+	}
+
+	a = access;
+	*a++ = (info->attr & fileswitch_ATTR_OWNER_LOCKED) ? 'L' : '-';
+	*a++ = (info->attr & fileswitch_ATTR_OWNER_WRITE) ? 'W' : '-';
+	*a++ = (info->attr & fileswitch_ATTR_OWNER_READ) ? 'R' : '-';
+	*a++ = '/';
+	*a++ = (info->attr & fileswitch_ATTR_WORLD_WRITE) ? 'w' : '-';
+	*a++ = (info->attr & fileswitch_ATTR_WORLD_READ) ? 'r' : '-';
+	*a = '\0';
+
+	switch (cli_output_format) {
+	case CLI_FORMAT_INFO:
+		if (filetype == osfile_TYPE_DIR)
+			fprintf(cli_out, "%-4s ", "dir");
+		else if (filetype == osfile_TYPE_APPLICATION)
+			fprintf(cli_out, "%-4s ", "app");
+		else if (filetype == osfile_TYPE_UNTYPED)
+			fprintf(cli_out, "%-4s ", "---");
+		else
+			fprintf(cli_out, "%03x  ", filetype);
+
+		fprintf(cli_out, "%10d  %-19s  %s  %s\n", info->size, date, access, path);
+		break;
+
+	case CLI_FORMAT_CSV:
+		cli_write_string(path);
+		fprintf(cli_out, ",%x,%d,%s,%s", filetype, info->size, date, access);
+		if (set > 0)
+			fprintf(cli_out, ",%u", set);
+		fprintf(cli_out, "\n");
+		break;
+
+	case CLI_FORMAT_JSON:
+		fprintf(cli_out, "{\"path\":");
+		cli_write_string(path);
+		fprintf(cli_out, ",\"filetype\":%d,\"size\":%d,\"date\":\"%s\",\"access\":\"%s\"",
+				(filetype == osfile_TYPE_UNTYPED) ? -1 : (int) filetype, info->size, date, access);
+		if (set > 0)
+			fprintf(cli_out, ",\"set\":%u", set);
+		fprintf(cli_out, "}\n");
+		break;
+
+	case CLI_FORMAT_PLAIN:
+		break;
+	}
+
+	heap_free(info);
+
+	return cli_files++;
+}
+
+
+/**
+ * Write a string to the output as a quoted CSV or JSON value.
+ *
+ * \param *text			The string to write.
+ */
+
+static void cli_write_string(char *text)
+{
+	fputc('"', cli_out);
+
+	for (; *text != '\0'; text++) {
+		if (cli_output_format == CLI_FORMAT_CSV) {
+			if (*text == '"')
+				fputc('"', cli_out);
+			fputc(*text, cli_out);
+		} else if (*text == '"' || *text == '\\') {
+			fprintf(cli_out, "\\%c", *text);
+		} else if ((unsigned char) *text < 0x20) {
+			fprintf(cli_out, "\\u%04x", (unsigned char) *text);
+		} else {
+			fputc(*text, cli_out);
+		}
+	}
+
+	fputc('"', cli_out);
+}
+
+
+/**
+ * Print the command line usage.
+ *
+ * \param *name			The name of the program.
+ */
+
+static void cli_usage(char *name)
+{
+	fprintf(stderr, "Usage: %s [<options>] [<path> ...]\n\n"
+			"  -f <file>      Load settings from a saved search file\n"
+			"  -n <names>     Match filenames against wildcard patterns\n"
+			"  -r <regex>     Match filenames against a regular expression\n"
+			"  -v             Invert the filename match\n"
+			"  -i             Ignore case in filenames and contents\n"
+			"  -c <text>      Match files containing the text\n"
+			"  -C <text>      Match files not containing the text\n"
+			"  -t <types>     Match objects of the filetypes\n"
+			"  -T <types>     Match objects not of the filetypes\n"
+			"  -k <kinds>     Match only (f)iles, (d)irectories and/or (a)pplications\n"
+			"  -s <min>:<max> Match sizes in the range, with B, K or M units\n"
+			"  -a <min>:<max> Match ages in the range, with m, h, d, w, M or y units\n"
+			"  -I <names>     Ignore objects with the names\n"
+			"  -A             Record all objects, not just matches\n"
+			"  -D             Report only matching files which have duplicates, in sets\n"
+			"  -F <format>    Output as plain, info, csv or json\n"
+			"  -o <file>      Write the matches to a file\n"
+			"  -q             Suppress errors and the summary\n"
+			"  -x <index>     Read directories from an index, searching its root by default\n"
+			"  -B <index>     Build an index of the path, instead of searching\n"
+			"  -U <index>     Refresh an index, instead of searching\n"
+			"  -S <file>      Save the search to a file if it is interrupted\n"
+			"  -R <file>      Resume a saved search, given the same options\n", name);
+}
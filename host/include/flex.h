@@ -0,0 +1,43 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: flex.h
+ *
+ * Host build shim for the Acorn C flex heap, backed by malloc().
+ */
+
+#ifndef HOST_FLEX_H
+#define HOST_FLEX_H
+
+typedef void **flex_ptr;
+
+void flex_init(char *program_name, int *error_fd, int dyn_size);
+int flex_alloc(flex_ptr anchor, int size);
+void flex_free(flex_ptr anchor);
+int flex_size(flex_ptr anchor);
+int flex_extend(flex_ptr anchor, int new_size);
+int flex_midextend(flex_ptr anchor, int at, int by);
+
+#endif
+
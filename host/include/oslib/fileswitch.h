@@ -0,0 +1,51 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: oslib/fileswitch.h
+ *
+ * Host build shim for the OSLib FileSwitch definitions.
+ */
+
+#ifndef HOST_OSLIB_FILESWITCH_H
+#define HOST_OSLIB_FILESWITCH_H
+
+#include "oslib/os.h"
+
+typedef bits fileswitch_attr;
+typedef bits fileswitch_object_type;
+
+#define fileswitch_NOT_FOUND ((fileswitch_object_type) 0x0u)
+#define fileswitch_IS_FILE ((fileswitch_object_type) 0x1u)
+#define fileswitch_IS_DIR ((fileswitch_object_type) 0x2u)
+#define fileswitch_IS_IMAGE ((fileswitch_object_type) 0x3u)
+
+#define fileswitch_ATTR_OWNER_READ ((fileswitch_attr) 0x1u)
+#define fileswitch_ATTR_OWNER_WRITE ((fileswitch_attr) 0x2u)
+#define fileswitch_ATTR_OWNER_LOCKED ((fileswitch_attr) 0x8u)
+#define fileswitch_ATTR_WORLD_READ ((fileswitch_attr) 0x10u)
+#define fileswitch_ATTR_WORLD_WRITE ((fileswitch_attr) 0x20u)
+#define fileswitch_ATTR_WORLD_LOCKED ((fileswitch_attr) 0x80u)
+
+#endif
+
@@ -0,0 +1,49 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: oslib/os.h
+ *
+ * Host build shim for the OSLib OS definitions.
+ */
+
+#ifndef HOST_OSLIB_OS_H
+#define HOST_OSLIB_OS_H
+
+#include "oslib/types.h"
+
+typedef struct {
+	int	errnum;
+	char	errmess[252];
+} os_error;
+
+typedef unsigned os_t;
+typedef unsigned os_f;
+typedef unsigned os_fw;
+typedef byte os_date_and_time[5];
+
+os_t os_read_monotonic_time(void);
+os_error *xos_bgetw(os_fw file, char *c, bits *psr);
+
+#endif
+
@@ -0,0 +1,43 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: oslib/osfile.h
+ *
+ * Host build shim for the OSLib OS_File definitions.
+ */
+
+#ifndef HOST_OSLIB_OSFILE_H
+#define HOST_OSLIB_OSFILE_H
+
+#include "oslib/fileswitch.h"
+
+#define osfile_FILE_TYPE 0xfff00u
+#define osfile_FILE_TYPE_SHIFT 8
+#define osfile_TYPE_DIR 0x1000u
+#define osfile_TYPE_APPLICATION 0x2000u
+#define osfile_TYPE_UNTYPED 0xffffffffu
+#define osfile_TYPE_TEXT 0xfffu
+
+#endif
+
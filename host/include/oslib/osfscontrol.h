@@ -0,0 +1,40 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: oslib/osfscontrol.h
+ *
+ * Host build shim for the OSLib OS_FSControl definitions.
+ */
+
+#ifndef HOST_OSLIB_OSFSCONTROL_H
+#define HOST_OSLIB_OSFSCONTROL_H
+
+#include "oslib/os.h"
+
+os_error *xosfscontrol_file_type_from_string(char const *name, bits *file_type);
+os_error *xosfscontrol_canonicalise_path(char const *path, char *buffer, char const *var, char const *path_string,
+		int size, int *spare);
+
+#endif
+
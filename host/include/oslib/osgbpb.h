@@ -0,0 +1,54 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: oslib/osgbpb.h
+ *
+ * Host build shim for the OSLib OS_GBPB definitions.
+ */
+
+#ifndef HOST_OSLIB_OSGBPB_H
+#define HOST_OSLIB_OSGBPB_H
+
+#include "oslib/fileswitch.h"
+
+typedef struct {
+	bits			load_addr;
+	bits			exec_addr;
+	int			size;
+	fileswitch_attr		attr;
+	fileswitch_object_type	obj_type;
+	char			name[UNKNOWN];
+} osgbpb_info;
+
+typedef struct {
+	osgbpb_info		info[UNKNOWN];
+} osgbpb_info_list;
+
+os_error *xosgbpb_read_atw(os_fw file, byte *data, int size, int offset, int *unread);
+os_error *xosgbpb_readw(os_fw file, byte *data, int size, int *unread);
+os_error *xosgbpb_write_atw(os_fw file, byte const *data, int size, int offset, int *unwritten);
+os_error *xosgbpb_writew(os_fw file, byte const *data, int size, int *unwritten);
+
+#endif
+
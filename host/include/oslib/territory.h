@@ -0,0 +1,57 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: oslib/territory.h
+ *
+ * Host build shim for the OSLib Territory definitions.
+ */
+
+#ifndef HOST_OSLIB_TERRITORY_H
+#define HOST_OSLIB_TERRITORY_H
+
+#include "oslib/os.h"
+
+typedef int territory_t;
+
+typedef struct {
+	int	centisecond;
+	int	second;
+	int	minute;
+	int	hour;
+	int	date;
+	int	month;
+	int	year;
+	int	weekday;
+	int	yearday;
+} territory_ordinals;
+
+#define territory_CURRENT ((territory_t) -1)
+
+void territory_convert_time_to_ordinals(territory_t territory, os_date_and_time const *date, territory_ordinals *ordinals);
+void territory_convert_ordinals_to_time(territory_t territory, os_date_and_time *date, territory_ordinals const *ordinals);
+os_error *xterritory_convert_ordinals_to_time(territory_t territory, os_date_and_time *date, territory_ordinals const *ordinals);
+char *territory_convert_date_and_time(territory_t territory, os_date_and_time const *date, char *buffer, int size, char const *format);
+
+#endif
+
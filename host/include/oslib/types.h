@@ -0,0 +1,45 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: oslib/types.h
+ *
+ * Host build shim for the OSLib basic types.
+ */
+
+#ifndef HOST_OSLIB_TYPES_H
+#define HOST_OSLIB_TYPES_H
+
+#include <stddef.h>
+
+typedef int osbool;
+typedef unsigned char byte;
+typedef unsigned bits;
+
+#define TRUE 1
+#define FALSE 0
+#define NONE 0
+#define UNKNOWN 1
+
+#endif
+
@@ -0,0 +1,50 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: oslib/wimp.h
+ *
+ * Host build shim for the OSLib Wimp definitions used by the search engine's headers.
+ */
+
+#ifndef HOST_OSLIB_WIMP_H
+#define HOST_OSLIB_WIMP_H
+
+#include "oslib/os.h"
+#include "oslib/osspriteop.h"
+
+typedef struct wimp_w_ *wimp_w;
+typedef int wimp_i;
+
+typedef struct {
+	int	x;
+	int	y;
+	bits	buttons;
+	wimp_w	w;
+	wimp_i	i;
+} wimp_pointer;
+
+os_error *xwimp_slot_size(int new_curr_slot, int new_next_slot, int *curr_slot, int *next_slot, int *free_slot);
+
+#endif
+
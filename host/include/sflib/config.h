@@ -0,0 +1,46 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: sflib/config.h
+ *
+ * Host build shim for the SFLib configuration routines.
+ */
+
+#ifndef HOST_SFLIB_CONFIG_H
+#define HOST_SFLIB_CONFIG_H
+
+#include "oslib/types.h"
+
+osbool config_int_init(char *name, int value);
+osbool config_opt_init(char *name, osbool value);
+osbool config_str_init(char *name, char *value);
+int config_int_read(char *name);
+osbool config_opt_read(char *name);
+char *config_str_read(char *name);
+void config_int_set(char *name, int value);
+void config_opt_set(char *name, osbool value);
+void config_str_set(char *name, char *value);
+
+#endif
+
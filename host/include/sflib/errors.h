@@ -0,0 +1,43 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: sflib/errors.h
+ *
+ * Host build shim for the SFLib error reporting routines, which report on stderr.
+ */
+
+#ifndef HOST_SFLIB_ERRORS_H
+#define HOST_SFLIB_ERRORS_H
+
+#include "oslib/os.h"
+
+int error_report_error(char *error);
+int error_report_info(char *error);
+int error_report_os_error(os_error *error, int buttons);
+int error_msgs_report_error(char *token);
+int error_msgs_report_info(char *token);
+int error_msgs_param_report_error(char *token, char *a, char *b, char *c, char *d);
+
+#endif
+
@@ -0,0 +1,41 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: sflib/msgs.h
+ *
+ * Host build shim for the SFLib message lookup routines.
+ */
+
+#ifndef HOST_SFLIB_MSGS_H
+#define HOST_SFLIB_MSGS_H
+
+#include <stddef.h>
+#include "oslib/types.h"
+
+void msgs_initialise(char *file);
+char *msgs_lookup(char *token, char *buffer, size_t size);
+char *msgs_param_lookup(char *token, char *buffer, size_t size, char *a, char *b, char *c, char *d);
+
+#endif
+
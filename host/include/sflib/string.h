@@ -0,0 +1,45 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: sflib/string.h
+ *
+ * Host build shim for the SFLib string routines.
+ */
+
+#ifndef HOST_SFLIB_STRING_H
+#define HOST_SFLIB_STRING_H
+
+#include <stddef.h>
+#include "oslib/types.h"
+
+char *string_copy(char *dest, char *src, size_t len);
+char *string_ctrl_strcpy(char *s1, char *s2);
+int string_printf(char *str, size_t len, char *format, ...);
+char *string_toupper(char *text);
+int string_nocase_strcmp(char *s1, char *s2);
+osbool string_wildcard_compare(char *wildcard, char *string, osbool any_case);
+char *string_strip_surrounding_whitespace(char *text);
+
+#endif
+
@@ -0,0 +1,541 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: oslib.c
+ *
+ * Host build implementations of the OSLib SWI veneers used by the search
+ * engine outside of the fsys interface: the file handling in discfile.c,
+ * filetype lookup and path canonicalisation in ignore.c, the Territory
+ * date conversions in datetime.c and the slot size check in contents.c.
+ */
+
+/* ANSI C header files */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+/* POSIX header files */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* OSLib header files */
+
+#include "oslib/os.h"
+#include "oslib/osargs.h"
+#include "oslib/osfind.h"
+#include "oslib/osfscontrol.h"
+#include "oslib/osgbpb.h"
+#include "oslib/territory.h"
+#include "oslib/types.h"
+#include "oslib/wimp.h"
+
+
+#define OSLIB_UNIX_EPOCH 0x336e996a00ll						/**< The Unix epoch, in centiseconds since 1900.			*/
+#define OSLIB_FREE_SLOT (32 * 1024 * 1024)					/**< The free memory reported by Wimp_SlotSize.			*/
+#define OSLIB_PSR_C 0x20000000u							/**< The carry flag returned by OS_BGet at end of file.		*/
+
+
+/**
+ * Filetype names recognised by OS_FSControl 31.
+ */
+
+static const struct {
+	char		*name;							/**< The filetype name.						*/
+	bits		type;							/**< The corresponding filetype.				*/
+} oslib_file_types[] = {
+	{"Text",	0xfff},
+	{"Data",	0xffd},
+	{"Obey",	0xfeb},
+	{"Command",	0xffe},
+	{"Sprite",	0xff9},
+	{"BASIC",	0xffb},
+	{"Module",	0xffa},
+	{"Absolute",	0xff8},
+	{"Utility",	0xffc},
+	{"DrawFile",	0xaff},
+	{"JPEG",	0xc85},
+	{"HTML",	0xfaf},
+	{"CSV",		0xdfe},
+	{"Squash",	0xfca},
+	{"Archive",	0xddc},
+	{NULL,		0}
+};
+
+static os_error			oslib_error_block;				/**< The block used to return errors.				*/
+
+static os_error			*oslib_host_error(void);
+static long long		oslib_read_time(os_date_and_time const *date);
+static void			oslib_write_time(os_date_and_time *date, long long centiseconds);
+
+
+/**
+ * Read the monotonic time, in centiseconds.
+ */
+
+os_t os_read_monotonic_time(void)
+{
+	struct timespec	now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (os_t) (now.tv_sec * 100 + now.tv_nsec / 10000000);
+}
+
+
+/**
+ * OS_BGet: read a byte from an open file, setting C at the end of the file.
+ */
+
+os_error *xos_bgetw(os_fw file, char *c, bits *psr)
+{
+	unsigned char	value = 0;
+	ssize_t		bytes;
+
+	bytes = read((int) file, &value, 1);
+	if (bytes < 0)
+		return oslib_host_error();
+
+	if (c != NULL)
+		*c = value;
+
+	if (psr != NULL)
+		*psr = (bytes == 0) ? OSLIB_PSR_C : 0;
+
+	return NULL;
+}
+
+
+/**
+ * OS_Find &4x: open a file for reading.
+ */
+
+os_error *xosfind_openinw(bits flags, char const *filename, char const *path, os_fw *file)
+{
+	int	handle;
+
+	handle = open(filename, O_RDONLY);
+	if (handle < 0)
+		return oslib_host_error();
+
+	*file = (os_fw) handle;
+
+	return NULL;
+}
+
+
+/**
+ * OS_Find &8x: create a file for writing.
+ */
+
+os_error *xosfind_openoutw(bits flags, char const *filename, char const *path, os_fw *file)
+{
+	int	handle;
+
+	handle = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (handle < 0)
+		return oslib_host_error();
+
+	*file = (os_fw) handle;
+
+	return NULL;
+}
+
+
+/**
+ * OS_Find 0: close an open file.
+ */
+
+os_error *xosfind_closew(os_fw file)
+{
+	if (close((int) file) != 0)
+		return oslib_host_error();
+
+	return NULL;
+}
+
+
+/**
+ * OS_Args 0: read the sequential file pointer.
+ */
+
+os_error *xosargs_read_ptrw(os_fw file, int *ptr)
+{
+	off_t	position;
+
+	position = lseek((int) file, 0, SEEK_CUR);
+	if (position < 0)
+		return oslib_host_error();
+
+	*ptr = (int) position;
+
+	return NULL;
+}
+
+
+/**
+ * OS_Args 2: read the extent of a file.
+ */
+
+os_error *xosargs_read_extw(os_fw file, int *extent)
+{
+	struct stat	info;
+
+	if (fstat((int) file, &info) != 0)
+		return oslib_host_error();
+
+	*extent = (int) info.st_size;
+
+	return NULL;
+}
+
+
+/**
+ * OS_GBPB 3: read bytes from a given position in a file.
+ */
+
+os_error *xosgbpb_read_atw(os_fw file, byte *data, int size, int offset, int *unread)
+{
+	if (lseek((int) file, offset, SEEK_SET) < 0)
+		return oslib_host_error();
+
+	return xosgbpb_readw(file, data, size, unread);
+}
+
+
+/**
+ * OS_GBPB 4: read bytes from the current position in a file.
+ */
+
+os_error *xosgbpb_readw(os_fw file, byte *data, int size, int *unread)
+{
+	ssize_t	bytes;
+	int	total = 0;
+
+	while (total < size) {
+		bytes = read((int) file, data + total, size - total);
+		if (bytes < 0 && errno == EINTR)
+			continue;
+		if (bytes < 0)
+			return oslib_host_error();
+		if (bytes == 0)
+			break;
+
+		total += bytes;
+	}
+
+	if (unread != NULL)
+		*unread = size - total;
+
+	return NULL;
+}
+
+
+/**
+ * OS_GBPB 1: write bytes to a given position in a file.
+ */
+
+os_error *xosgbpb_write_atw(os_fw file, byte const *data, int size, int offset, int *unwritten)
+{
+	if (lseek((int) file, offset, SEEK_SET) < 0)
+		return oslib_host_error();
+
+	return xosgbpb_writew(file, data, size, unwritten);
+}
+
+
+/**
+ * OS_GBPB 2: write bytes to the current position in a file.
+ */
+
+os_error *xosgbpb_writew(os_fw file, byte const *data, int size, int *unwritten)
+{
+	ssize_t	bytes;
+	int	total = 0;
+
+	while (total < size) {
+		bytes = write((int) file, data + total, size - total);
+		if (bytes < 0 && errno == EINTR)
+			continue;
+		if (bytes <= 0)
+			return oslib_host_error();
+
+		total += bytes;
+	}
+
+	if (unwritten != NULL)
+		*unwritten = size - total;
+
+	return NULL;
+}
+
+
+/**
+ * OS_FSControl 31: convert a filetype name or hex number into a filetype.
+ */
+
+os_error *xosfscontrol_file_type_from_string(char const *name, bits *file_type)
+{
+	char	*end;
+	int	i;
+
+	for (i = 0; oslib_file_types[i].name != NULL; i++) {
+		if (strcasecmp(name, oslib_file_types[i].name) == 0) {
+			*file_type = oslib_file_types[i].type;
+			return NULL;
+		}
+	}
+
+	if (*name == '&')
+		name++;
+
+	*file_type = strtoul(name, &end, 16);
+
+	if (*name == '\0' || *end != '\0' || *file_type > 0xfffu) {
+		oslib_error_block.errnum = 0x10000;
+		snprintf(oslib_error_block.errmess, sizeof(oslib_error_block.errmess), "Unknown filetype");
+		return &oslib_error_block;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * OS_FSControl 37: canonicalise a pathname. Host paths are already in their
+ * canonical form, so the path is copied unchanged.
+ */
+
+os_error *xosfscontrol_canonicalise_path(char const *path, char *buffer, char const *var, char const *path_string,
+		int size, int *spare)
+{
+	int	length;
+
+	length = strlen(path) + 1;
+
+	if (buffer != NULL && size >= length)
+		strcpy(buffer, path);
+
+	if (spare != NULL)
+		*spare = size - length;
+
+	return NULL;
+}
+
+
+/**
+ * Wimp_SlotSize: report a fixed amount of free memory, which is used to
+ * size the contents search buffers.
+ */
+
+os_error *xwimp_slot_size(int new_curr_slot, int new_next_slot, int *curr_slot, int *next_slot, int *free_slot)
+{
+	if (curr_slot != NULL)
+		*curr_slot = 0;
+
+	if (next_slot != NULL)
+		*next_slot = 0;
+
+	if (free_slot != NULL)
+		*free_slot = OSLIB_FREE_SLOT;
+
+	return NULL;
+}
+
+
+/**
+ * Territory_ConvertTimeToOrdinals, working in UTC.
+ */
+
+void territory_convert_time_to_ordinals(territory_t territory, os_date_and_time const *date, territory_ordinals *ordinals)
+{
+	struct tm	parts;
+	time_t		seconds;
+	long long	centiseconds;
+
+	centiseconds = oslib_read_time(date) - OSLIB_UNIX_EPOCH;
+	seconds = (time_t) (centiseconds / 100);
+
+	gmtime_r(&seconds, &parts);
+
+	ordinals->centisecond = (int) (centiseconds % 100);
+	ordinals->second = parts.tm_sec;
+	ordinals->minute = parts.tm_min;
+	ordinals->hour = parts.tm_hour;
+	ordinals->date = parts.tm_mday;
+	ordinals->month = parts.tm_mon + 1;
+	ordinals->year = parts.tm_year + 1900;
+	ordinals->weekday = parts.tm_wday + 1;
+	ordinals->yearday = parts.tm_yday + 1;
+}
+
+
+/**
+ * Territory_ConvertOrdinalsToTime, working in UTC.
+ */
+
+void territory_convert_ordinals_to_time(territory_t territory, os_date_and_time *date, territory_ordinals const *ordinals)
+{
+	xterritory_convert_ordinals_to_time(territory, date, ordinals);
+}
+
+
+/**
+ * Territory_ConvertOrdinalsToTime, working in UTC.
+ */
+
+os_error *xterritory_convert_ordinals_to_time(territory_t territory, os_date_and_time *date, territory_ordinals const *ordinals)
+{
+	struct tm	parts;
+	time_t		seconds;
+
+	memset(&parts, 0, sizeof(struct tm));
+
+	parts.tm_sec = ordinals->second;
+	parts.tm_min = ordinals->minute;
+	parts.tm_hour = ordinals->hour;
+	parts.tm_mday = ordinals->date;
+	parts.tm_mon = ordinals->month - 1;
+	parts.tm_year = ordinals->year - 1900;
+
+	seconds = timegm(&parts);
+
+	oslib_write_time(date, OSLIB_UNIX_EPOCH + (long long) seconds * 100 + ordinals->centisecond);
+
+	return NULL;
+}
+
+
+/**
+ * Territory_ConvertDateAndTime, supporting the subset of format fields
+ * used by Locate.
+ */
+
+char *territory_convert_date_and_time(territory_t territory, os_date_and_time const *date, char *buffer, int size, char const *format)
+{
+	territory_ordinals	ordinals;
+	char			field[16];
+	int			out = 0, length;
+
+	if (buffer == NULL || size <= 0)
+		return buffer;
+
+	territory_convert_time_to_ordinals(territory, date, &ordinals);
+
+	while (*format != '\0' && out < size - 1) {
+		field[0] = '\0';
+
+		if (format[0] == '%' && format[1] != '\0' && format[2] != '\0') {
+			if (strncmp(format + 1, "DY", 2) == 0)
+				snprintf(field, sizeof(field), "%02d", ordinals.date);
+			else if (strncmp(format + 1, "MN", 2) == 0)
+				snprintf(field, sizeof(field), "%02d", ordinals.month);
+			else if (strncmp(format + 1, "CE", 2) == 0)
+				snprintf(field, sizeof(field), "%02d", ordinals.year / 100);
+			else if (strncmp(format + 1, "YR", 2) == 0)
+				snprintf(field, sizeof(field), "%02d", ordinals.year % 100);
+			else if (strncmp(format + 1, "24", 2) == 0)
+				snprintf(field, sizeof(field), "%02d", ordinals.hour);
+			else if (strncmp(format + 1, "MI", 2) == 0)
+				snprintf(field, sizeof(field), "%02d", ordinals.minute);
+			else if (strncmp(format + 1, "SE", 2) == 0)
+				snprintf(field, sizeof(field), "%02d", ordinals.second);
+			else if (strncmp(format + 1, "CS", 2) == 0)
+				snprintf(field, sizeof(field), "%02d", ordinals.centisecond);
+		}
+
+		if (field[0] != '\0') {
+			length = strlen(field);
+			if (out + length > size - 1)
+				length = size - 1 - out;
+
+			memcpy(buffer + out, field, length);
+			out += length;
+			format += 3;
+		} else {
+			buffer[out++] = *format++;
+		}
+	}
+
+	buffer[out] = '\0';
+
+	return buffer + out;
+}
+
+
+/**
+ * Build an error block from the current host errno value.
+ *
+ * \return			Pointer to the error block.
+ */
+
+static os_error *oslib_host_error(void)
+{
+	oslib_error_block.errnum = errno;
+	snprintf(oslib_error_block.errmess, sizeof(oslib_error_block.errmess), "%s", strerror(errno));
+
+	return &oslib_error_block;
+}
+
+
+/**
+ * Read a RISC OS five byte date as a count of centiseconds since 1900.
+ *
+ * \param *date			The date to read.
+ * \return			The time in centiseconds.
+ */
+
+static long long oslib_read_time(os_date_and_time const *date)
+{
+	long long	centiseconds = 0;
+	int		i;
+
+	for (i = 4; i >= 0; i--)
+		centiseconds = (centiseconds << 8) | (*date)[i];
+
+	return centiseconds;
+}
+
+
+/**
+ * Store a count of centiseconds since 1900 into a RISC OS five byte date.
+ *
+ * \param *date			The date to update.
+ * \param centiseconds		The time to store.
+ */
+
+static void oslib_write_time(os_date_and_time *date, long long centiseconds)
+{
+	int	i;
+
+	for (i = 0; i < 5; i++)
+		(*date)[i] = (byte) ((centiseconds >> (8 * i)) & 0xff);
+}
+
@@ -0,0 +1,725 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: sflib.c
+ *
+ * Host build implementations of the flex heap and the SFLib routines used
+ * by the search engine. Flex blocks never move on the host, but are
+ * otherwise handled in the same way as on RISC OS.
+ */
+
+/* ANSI C header files */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* Acorn C header files */
+
+#include "flex.h"
+
+/* OSLib header files */
+
+#include "oslib/os.h"
+#include "oslib/types.h"
+
+/* SF-Lib header files. */
+
+#include "sflib/config.h"
+#include "sflib/debug.h"
+#include "sflib/errors.h"
+#include "sflib/heap.h"
+#include "sflib/msgs.h"
+#include "sflib/string.h"
+
+
+#define SFLIB_FLEX_HEADER 16							/**< The space reserved in front of each flex block for its size.	*/
+#define SFLIB_MSGS_LINE 1024							/**< The longest line read from a messages file.			*/
+
+
+/**
+ * A configuration setting, held in a simple linked list.
+ */
+
+struct sflib_config {
+	char			*name;						/**< The name of the setting.					*/
+	int			value;						/**< The integer or boolean value of the setting.		*/
+	char			*text;						/**< The string value of the setting, or NULL.			*/
+	struct sflib_config	*next;						/**< The next setting in the list.				*/
+};
+
+/**
+ * A message token, held in a simple linked list.
+ */
+
+struct sflib_message {
+	char			*token;						/**< The message token.						*/
+	char			*text;						/**< The message text.						*/
+	struct sflib_message	*next;						/**< The next message in the list.				*/
+};
+
+
+static struct sflib_config	*sflib_config_list = NULL;			/**< The configuration settings.				*/
+static struct sflib_message	*sflib_messages = NULL;				/**< The loaded message tokens.					*/
+
+
+static struct sflib_config	*sflib_find_config(char *name, osbool create);
+static char			*sflib_find_message(char *token);
+
+
+/**
+ * Initialise the flex heap. Nothing is required on the host.
+ */
+
+void flex_init(char *program_name, int *error_fd, int dyn_size)
+{
+}
+
+
+/**
+ * Allocate a new flex block.
+ */
+
+int flex_alloc(flex_ptr anchor, int size)
+{
+	char	*block;
+
+	block = malloc(size + SFLIB_FLEX_HEADER);
+	if (block == NULL) {
+		*anchor = NULL;
+		return 0;
+	}
+
+	*((int *) block) = size;
+	*anchor = block + SFLIB_FLEX_HEADER;
+
+	return 1;
+}
+
+
+/**
+ * Free a flex block.
+ */
+
+void flex_free(flex_ptr anchor)
+{
+	if (*anchor != NULL)
+		free((char *) *anchor - SFLIB_FLEX_HEADER);
+
+	*anchor = NULL;
+}
+
+
+/**
+ * Return the size of a flex block.
+ */
+
+int flex_size(flex_ptr anchor)
+{
+	return *((int *) ((char *) *anchor - SFLIB_FLEX_HEADER));
+}
+
+
+/**
+ * Change the size of a flex block.
+ */
+
+int flex_extend(flex_ptr anchor, int new_size)
+{
+	char	*block;
+
+	block = realloc((char *) *anchor - SFLIB_FLEX_HEADER, new_size + SFLIB_FLEX_HEADER);
+	if (block == NULL)
+		return 0;
+
+	*((int *) block) = new_size;
+	*anchor = block + SFLIB_FLEX_HEADER;
+
+	return 1;
+}
+
+
+/**
+ * Insert or remove space part way through a flex block.
+ */
+
+int flex_midextend(flex_ptr anchor, int at, int by)
+{
+	int	size;
+
+	size = flex_size(anchor);
+
+	if (by > 0) {
+		if (!flex_extend(anchor, size + by))
+			return 0;
+
+		memmove((char *) *anchor + at + by, (char *) *anchor + at, size - at);
+	} else if (by < 0) {
+		memmove((char *) *anchor + at + by, (char *) *anchor + at, size - at);
+
+		if (!flex_extend(anchor, size + by))
+			return 0;
+	}
+
+	return 1;
+}
+
+
+/**
+ * Initialise the heap. Nothing is required on the host.
+ */
+
+void heap_initialise(void)
+{
+}
+
+
+/**
+ * Allocate a block from the heap.
+ */
+
+void *heap_alloc(size_t size)
+{
+	return malloc(size);
+}
+
+
+/**
+ * Change the size of a heap block.
+ */
+
+void *heap_extend(void *ptr, size_t new_size)
+{
+	return realloc(ptr, new_size);
+}
+
+
+/**
+ * Copy a string into the heap.
+ */
+
+char *heap_strdup(const char *string)
+{
+	return strdup(string);
+}
+
+
+/**
+ * Free a heap block.
+ */
+
+void heap_free(void *ptr)
+{
+	free(ptr);
+}
+
+
+/**
+ * Initialise an integer configuration setting.
+ */
+
+osbool config_int_init(char *name, int value)
+{
+	struct sflib_config	*config;
+
+	config = sflib_find_config(name, TRUE);
+	if (config == NULL)
+		return FALSE;
+
+	config->value = value;
+
+	return TRUE;
+}
+
+
+/**
+ * Initialise a boolean configuration setting.
+ */
+
+osbool config_opt_init(char *name, osbool value)
+{
+	return config_int_init(name, value);
+}
+
+
+/**
+ * Initialise a string configuration setting.
+ */
+
+osbool config_str_init(char *name, char *value)
+{
+	struct sflib_config	*config;
+
+	config = sflib_find_config(name, TRUE);
+	if (config == NULL)
+		return FALSE;
+
+	free(config->text);
+	config->text = strdup(value);
+
+	return (config->text != NULL) ? TRUE : FALSE;
+}
+
+
+/**
+ * Read an integer configuration setting; unknown settings read as zero.
+ */
+
+int config_int_read(char *name)
+{
+	struct sflib_config	*config;
+
+	config = sflib_find_config(name, FALSE);
+
+	return (config != NULL) ? config->value : 0;
+}
+
+
+/**
+ * Read a boolean configuration setting; unknown settings read as FALSE.
+ */
+
+osbool config_opt_read(char *name)
+{
+	return (config_int_read(name) != 0) ? TRUE : FALSE;
+}
+
+
+/**
+ * Read a string configuration setting; unknown settings read as "".
+ */
+
+char *config_str_read(char *name)
+{
+	struct sflib_config	*config;
+
+	config = sflib_find_config(name, FALSE);
+
+	return (config != NULL && config->text != NULL) ? config->text : "";
+}
+
+
+/**
+ * Set an integer configuration setting.
+ */
+
+void config_int_set(char *name, int value)
+{
+	config_int_init(name, value);
+}
+
+
+/**
+ * Set a boolean configuration setting.
+ */
+
+void config_opt_set(char *name, osbool value)
+{
+	config_int_init(name, value);
+}
+
+
+/**
+ * Set a string configuration setting.
+ */
+
+void config_str_set(char *name, char *value)
+{
+	config_str_init(name, value);
+}
+
+
+/**
+ * Load a messages file into memory. Lines take the form "Token:Text",
+ * with comments starting with a '#'.
+ */
+
+void msgs_initialise(char *file)
+{
+	struct sflib_message	*message;
+	FILE			*in;
+	char			line[SFLIB_MSGS_LINE], *colon, *end;
+
+	in = fopen(file, "r");
+	if (in == NULL)
+		return;
+
+	while (fgets(line, sizeof(line), in) != NULL) {
+		end = line + strcspn(line, "\r\n");
+		*end = '\0';
+
+		colon = strchr(line, ':');
+		if (line[0] == '#' || colon == NULL)
+			continue;
+
+		*colon = '\0';
+
+		message = malloc(sizeof(struct sflib_message));
+		if (message == NULL)
+			break;
+
+		message->token = strdup(line);
+		message->text = strdup(colon + 1);
+		message->next = sflib_messages;
+		sflib_messages = message;
+	}
+
+	fclose(in);
+}
+
+
+/**
+ * Look up a message token, returning the token itself if it isn't known.
+ */
+
+char *msgs_lookup(char *token, char *buffer, size_t size)
+{
+	return msgs_param_lookup(token, buffer, size, NULL, NULL, NULL, NULL);
+}
+
+
+/**
+ * Look up a message token, substituting %0 to %3 with the parameters.
+ */
+
+char *msgs_param_lookup(char *token, char *buffer, size_t size, char *a, char *b, char *c, char *d)
+{
+	char	*text, *param[4];
+	size_t	out = 0, length;
+	int	n;
+
+	if (buffer == NULL || size == 0)
+		return buffer;
+
+	param[0] = a;
+	param[1] = b;
+	param[2] = c;
+	param[3] = d;
+
+	text = sflib_find_message(token);
+	if (text == NULL)
+		text = token;
+
+	while (*text != '\0' && out < size - 1) {
+		if (text[0] == '%' && text[1] >= '0' && text[1] <= '3') {
+			n = text[1] - '0';
+			text += 2;
+
+			if (param[n] == NULL)
+				continue;
+
+			length = strlen(param[n]);
+			if (out + length > size - 1)
+				length = size - 1 - out;
+
+			memcpy(buffer + out, param[n], length);
+			out += length;
+		} else {
+			buffer[out++] = *text++;
+		}
+	}
+
+	buffer[out] = '\0';
+
+	return buffer;
+}
+
+
+/**
+ * Report an error on stderr.
+ */
+
+int error_report_error(char *error)
+{
+	fprintf(stderr, "Error: %s\n", error);
+	return 0;
+}
+
+
+/**
+ * Report information on stderr.
+ */
+
+int error_report_info(char *error)
+{
+	fprintf(stderr, "%s\n", error);
+	return 0;
+}
+
+
+/**
+ * Report an OS error block on stderr.
+ */
+
+int error_report_os_error(os_error *error, int buttons)
+{
+	return error_report_error(error->errmess);
+}
+
+
+/**
+ * Report an error from the messages file on stderr.
+ */
+
+int error_msgs_report_error(char *token)
+{
+	return error_msgs_param_report_error(token, NULL, NULL, NULL, NULL);
+}
+
+
+/**
+ * Report information from the messages file on stderr.
+ */
+
+int error_msgs_report_info(char *token)
+{
+	char	buffer[SFLIB_MSGS_LINE];
+
+	return error_report_info(msgs_lookup(token, buffer, sizeof(buffer)));
+}
+
+
+/**
+ * Report an error from the messages file on stderr, with parameters.
+ */
+
+int error_msgs_param_report_error(char *token, char *a, char *b, char *c, char *d)
+{
+	char	buffer[SFLIB_MSGS_LINE];
+
+	return error_report_error(msgs_param_lookup(token, buffer, sizeof(buffer), a, b, c, d));
+}
+
+
+/**
+ * Write debug output to stderr, if the LOCATE_DEBUG environment variable
+ * is set.
+ */
+
+int debug_printf(char *cntrl_string, ...)
+{
+	va_list	ap;
+	int	result;
+
+	if (getenv("LOCATE_DEBUG") == NULL)
+		return 0;
+
+	va_start(ap, cntrl_string);
+	result = vfprintf(stderr, cntrl_string, ap);
+	va_end(ap);
+
+	fputc('\n', stderr);
+
+	return result;
+}
+
+
+/**
+ * Copy a string, truncating and terminating it to fit the buffer.
+ */
+
+char *string_copy(char *dest, char *src, size_t len)
+{
+	if (dest == NULL || len == 0)
+		return dest;
+
+	strncpy(dest, src, len);
+	dest[len - 1] = '\0';
+
+	return dest;
+}
+
+
+/**
+ * Copy a control-terminated string.
+ */
+
+char *string_ctrl_strcpy(char *s1, char *s2)
+{
+	char	*out = s1;
+
+	while (*s2 >= ' ')
+		*out++ = *s2++;
+
+	*out = '\0';
+
+	return s1;
+}
+
+
+/**
+ * Write formatted text into a buffer.
+ */
+
+int string_printf(char *str, size_t len, char *format, ...)
+{
+	va_list	ap;
+	int	result;
+
+	va_start(ap, format);
+	result = vsnprintf(str, len, format, ap);
+	va_end(ap);
+
+	return result;
+}
+
+
+/**
+ * Convert a string to upper case in place.
+ */
+
+char *string_toupper(char *text)
+{
+	char	*c;
+
+	for (c = text; *c != '\0'; c++)
+		*c = toupper((unsigned char) *c);
+
+	return text;
+}
+
+
+/**
+ * Compare two strings case insensitively.
+ */
+
+int string_nocase_strcmp(char *s1, char *s2)
+{
+	return strcasecmp(s1, s2);
+}
+
+
+/**
+ * Compare a string against a wildcard, where '*' matches any number of
+ * characters and '#' matches a single character.
+ */
+
+osbool string_wildcard_compare(char *wildcard, char *string, osbool any_case)
+{
+	char	*star = NULL, *resume = NULL;
+
+	while (*string != '\0') {
+		if (*wildcard == '*') {
+			star = ++wildcard;
+			resume = string;
+		} else if (*wildcard == '#' || *wildcard == *string ||
+				(any_case && tolower((unsigned char) *wildcard) == tolower((unsigned char) *string))) {
+			wildcard++;
+			string++;
+		} else if (star != NULL) {
+			wildcard = star;
+			string = ++resume;
+		} else {
+			return FALSE;
+		}
+	}
+
+	while (*wildcard == '*')
+		wildcard++;
+
+	return (*wildcard == '\0') ? TRUE : FALSE;
+}
+
+
+/**
+ * Remove leading and trailing whitespace from a string in place.
+ */
+
+char *string_strip_surrounding_whitespace(char *text)
+{
+	char	*end;
+
+	while (isspace((unsigned char) *text))
+		text++;
+
+	end = text + strlen(text);
+
+	while (end > text && isspace((unsigned char) *(end - 1)))
+		*--end = '\0';
+
+	return text;
+}
+
+
+/**
+ * Find a configuration setting.
+ *
+ * \param *name			The name of the setting to find.
+ * \param create		TRUE to create the setting if it doesn't exist.
+ * \return			Pointer to the setting, or NULL.
+ */
+
+static struct sflib_config *sflib_find_config(char *name, osbool create)
+{
+	struct sflib_config	*config;
+
+	for (config = sflib_config_list; config != NULL; config = config->next) {
+		if (strcasecmp(config->name, name) == 0)
+			return config;
+	}
+
+	if (!create)
+		return NULL;
+
+	config = malloc(sizeof(struct sflib_config));
+	if (config == NULL)
+		return NULL;
+
+	config->name = strdup(name);
+	if (config->name == NULL) {
+		free(config);
+		return NULL;
+	}
+
+	config->value = 0;
+	config->text = NULL;
+	config->next = sflib_config_list;
+	sflib_config_list = config;
+
+	return config;
+}
+
+
+/**
+ * Find the text for a message token.
+ *
+ * \param *token		The token to find.
+ * \return			Pointer to the message text, or NULL.
+ */
+
+static char *sflib_find_message(char *token)
+{
+	struct sflib_message	*message;
+
+	for (message = sflib_messages; message != NULL; message = message->next) {
+		if (strcmp(message->token, token) == 0)
+			return message->text;
+	}
+
+	return NULL;
+}
+
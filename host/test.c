@@ -0,0 +1,259 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: test.c
+ *
+ * Checks of the search engine for host builds, run by "make check". Each
+ * failure is reported, and the exit status is non-zero if any check fails.
+ *
+ * Usage: locatetest
+ */
+
+/* ANSI C header files */
+
+#define _XOPEN_SOURCE 700
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* OSLib header files */
+
+#include "oslib/os.h"
+#include "oslib/types.h"
+
+/* Application header files */
+
+#include "index.h"
+#include "wildcard.h"
+
+
+#define TEST_PATH_LENGTH 4096							/**< The space allocated to host and RISC OS pathnames.	*/
+
+
+static unsigned		test_failures = 0;					/**< The number of checks which have failed.		*/
+
+
+static void	test_contains_list(char *list, size_t length, char *expected);
+static void	test_wildcard_match(char *patterns, char *name, unsigned expected);
+static void	test_index_update(void);
+static void	test_check(osbool condition, char *description);
+static int	test_remove_object(const char *path, const struct stat *info, int flag, struct FTW *ftw);
+
+
+/**
+ * Run the checks.
+ */
+
+int main(int argc, char *argv[])
+{
+	/* Contains mode wraps each name in the list in *s. */
+
+	test_contains_list("Smith", 64, "*Smith*");
+	test_contains_list("Smith,Jones", 64, "*Smith*,*Jones*");
+
+	/* An escaped comma is part of its name, so the list isn't split there. */
+
+	test_contains_list("Smith\\,J", 64, "*Smith\\,J*");
+	test_contains_list("Smith\\,J,Jones", 64, "*Smith\\,J*,*Jones*");
+
+	/* An escape which won't fit in the buffer is dropped whole. */
+
+	test_contains_list("Smith\\,J", 8, "*Smith*");
+
+	/* The wrapped list matches names containing the escaped comma. */
+
+	test_wildcard_match("*Smith\\,J*", "Mr Smith,Jones", 0);
+	test_wildcard_match("*Smith\\,J*", "Smith", WILDCARD_NONE);
+	test_wildcard_match("*Smith\\,J*", "Jones", WILDCARD_NONE);
+	test_wildcard_match("*Smith\\,J*,*Jones*", "Jones", 1);
+
+	/* Index updates run in time slices, and can't be read until done. */
+
+	test_index_update();
+
+	printf("%u check%s failed\n", test_failures, (test_failures == 1) ? "" : "s");
+
+	return (test_failures == 0) ? 0 : 1;
+}
+
+
+/**
+ * Check the patterns made from a list of names for a contains search.
+ *
+ * \param *list			The list of names.
+ * \param length		The size of buffer to make the patterns in.
+ * \param *expected		The patterns which should be made.
+ */
+
+static void test_contains_list(char *list, size_t length, char *expected)
+{
+	char	buffer[256];
+
+	if (length > sizeof(buffer))
+		length = sizeof(buffer);
+
+	wildcard_make_contains_list(buffer, length, list);
+
+	if (strcmp(buffer, expected) != 0) {
+		printf("Contains list '%s' (%zu bytes) gave '%s', expected '%s'\n", list, length, buffer, expected);
+		test_failures++;
+	}
+}
+
+
+/**
+ * Check the pattern in a list which matches a name.
+ *
+ * \param *patterns		The list of patterns.
+ * \param *name			The name to match.
+ * \param expected		The index of the pattern which should match,
+ *				or WILDCARD_NONE.
+ */
+
+static void test_wildcard_match(char *patterns, char *name, unsigned expected)
+{
+	struct wildcard_block	*matcher;
+	unsigned		match;
+
+	matcher = wildcard_create(patterns, FALSE);
+	if (matcher == NULL) {
+		printf("Wildcard list '%s' could not be compiled\n", patterns);
+		test_failures++;
+		return;
+	}
+
+	match = wildcard_match(matcher, name);
+
+	wildcard_destroy(matcher);
+
+	if (match != expected) {
+		printf("Wildcard list '%s' on '%s' gave %d, expected %d\n", patterns, name, (int) match, (int) expected);
+		test_failures++;
+	}
+}
+
+
+/**
+ * Check that an index build and refresh can be run in short time slices,
+ * and that the index only covers its root once the update has finished.
+ */
+
+static void test_index_update(void)
+{
+	struct index_block	*index;
+	char			host[] = "/tmp/locatetestXXXXXX", path[TEST_PATH_LENGTH], root[TEST_PATH_LENGTH], *c;
+	unsigned		i, polls, objects;
+	int			handle;
+
+	if (mkdtemp(host) == NULL) {
+		test_check(FALSE, "Test directory created");
+		return;
+	}
+
+	for (i = 0; i < 50; i++) {
+		snprintf(path, sizeof(path), "%s/Dir%u", host, i);
+		mkdir(path, 0755);
+		snprintf(path, sizeof(path), "%s/Dir%u/File", host, i);
+		if ((handle = open(path, O_WRONLY | O_CREAT, 0644)) >= 0)
+			close(handle);
+	}
+
+	/* Swap the host path into RISC OS form, with the root as "$". */
+
+	snprintf(root, sizeof(root), "$%s", host);
+	for (c = root + 1; *c != '\0'; c++)
+		*c = (*c == '/') ? '.' : (*c == '.') ? '/' : *c;
+
+	index = index_create(root);
+	test_check(index != NULL, "Index created");
+
+	test_check(index_start_build(index, NULL), "Index build started");
+	test_check(!index_covers(index, root), "Index not readable during build");
+
+	/* A slice which has already ended still lets one step through. */
+
+	for (polls = 1; !index_poll(index, os_read_monotonic_time() - 1) && polls < 10000; polls++);
+
+	test_check(polls > 1, "Index build ran over several polls");
+	test_check(index_is_valid(index) && index_covers(index, root), "Index readable after build");
+
+	index_get_counts(index, &objects, NULL, NULL);
+	test_check(objects == 101, "Index holds every object");
+
+	/* A refresh is skipped while the index is being read. */
+
+	index_claim(index);
+	test_check(index_start_refresh(index, NULL) && index_is_valid(index), "Index refresh skipped while claimed");
+	index_release(index);
+
+	test_check(index_start_refresh(index, NULL) && !index_is_valid(index), "Index refresh started");
+
+	while (!index_poll(index, os_read_monotonic_time() - 1));
+
+	test_check(index_is_valid(index), "Index readable after refresh");
+
+	index_destroy(index);
+
+	nftw(host, test_remove_object, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+
+/**
+ * Record the result of a check.
+ *
+ * \param condition		TRUE if the check passed; else FALSE.
+ * \param *description		A description of the check.
+ */
+
+static void test_check(osbool condition, char *description)
+{
+	if (condition)
+		return;
+
+	printf("Check failed: %s\n", description);
+	test_failures++;
+}
+
+
+/**
+ * Remove an object found by nftw() while removing a test tree.
+ *
+ * \param *path			The host pathname of the object.
+ * \param *info			The details of the object.
+ * \param flag			The type of the object.
+ * \param *ftw			The position of the object in the tree.
+ * \return			0 to continue the walk.
+ */
+
+static int test_remove_object(const char *path, const struct stat *info, int flag, struct FTW *ftw)
+{
+	remove(path);
+
+	return 0;
+}
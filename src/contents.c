@@ -43,14 +43,13 @@
 
 /* OSLib header files */
 
-#include "oslib/osargs.h"
-#include "oslib/osfile.h"
-#include "oslib/osfind.h"
-#include "oslib/osgbpb.h"
+#include "oslib/os.h"
 #include "oslib/types.h"
+#include "oslib/wimp.h"
 
 /* SF-Lib header files. */
 
+#include "sflib/config.h"
 #include "sflib/debug.h"
 #include "sflib/heap.h"
 #include "sflib/string.h"
@@ -60,13 +59,35 @@
 #include "contents.h"
 
 #include "flexutils.h"
+#include "fsys.h"
 #include "objdb.h"
+#include "quantum.h"
 #include "results.h"
 
 
 #define CONTENTS_FILENAME_SIZE 256						/**< The space in bytes initially allocated to take filenames.	*/
-#define CONTENTS_FILE_BUFFER_SIZE 100						/**< The space in KBytes allocated to load file contents.	*/
-#define CONTENTS_FILE_BACKSPACE 8						/**< 1/n of the buffer space retained when block moves forward.	*/
+#define CONTENTS_FILE_BUFFER_MIN 100						/**< The minimum space in KBytes allocated to load file contents.	*/
+#define CONTENTS_FILE_BUFFER_MAX 4096						/**< The maximum space in KBytes allocated to load file contents.	*/
+#define CONTENTS_FILE_BUFFER_SCALE 32						/**< 1/n of the free memory used when sizing buffers by default.	*/
+#define CONTENTS_MATCH_CONTEXT 30						/**< The number of bytes of context reported either side of a match.	*/
+#define CONTENTS_LITERAL_SLICE 16384						/**< The most bytes scanned in one pass of the literal loop.	*/
+
+
+/**
+ * Counters recording the number of times that files are opened and closed
+ * by the contents search engines.
+ */
+
+static unsigned			contents_open_count = 0;
+static unsigned			contents_close_count = 0;
+
+/**
+ * Counters recording the number of bytes read from disc by the contents search
+ * engines, and how many of those had already been read once before.
+ */
+
+static unsigned			contents_bytes_read = 0;
+static unsigned			contents_bytes_reread = 0;
 
 
 /**
@@ -85,25 +106,41 @@ struct contents_block {
 	osbool				error;					/**< TRUE if an error has occurred; else FALSE.			*/
 
 	char				*filename;				/**< Flex block containing the name of the current file.	*/
+	os_fw				file_handle;				/**< The handle of the current file, or 0 if not open.		*/
 
 	char				*file;					/**< Flex block containing the file data or a subset of it.	*/
 	size_t				file_block_size;			/**< The number of bytes allocated to the file block.		*/
 
 	int				file_extent;				/**< The number of bytes of file data on disc.			*/
 	int				file_offset;				/**< File ptr for the start of the data in memory.		*/
+	int				file_loaded;				/**< The number of bytes of file data held in memory.		*/
 
 	/* Search details. */
 
 	char				*text;					/**< Flex block holding the text to match.			*/
+	int				text_length;				/**< The length of the text to match, in bytes.			*/
+	int				overlap;				/**< The bytes retained before the pointer when the buffer moves.	*/
 
 	osbool				any_case;				/**< TRUE to match case-insensitively.				*/
 	osbool				invert;					/**< TRUE to match files which do not contain the text.		*/
+	osbool				literal;				/**< TRUE if the text contains no wildcards.			*/
+
+	int				skip[256];				/**< The Horspool skip table for literal text.			*/
 
 	int				pointer;				/**< Pointer to the current search byte.			*/
 	osbool				matched;				/**< TRUE if the file has matched the text at least once.	*/
+
+	struct quantum_block		quantum;				/**< The work quantum, in bytes, used to time the search loops.	*/
 };
 
 
+static osbool	contents_start_file(struct contents_block *handle, unsigned key, int pointer, osbool matched, unsigned parent);
+static size_t	contents_get_buffer_size(void);
+static osbool	contents_open_file(struct contents_block *handle);
+static void	contents_close_file(struct contents_block *handle);
+static void	contents_poll_literal(struct contents_block *handle);
+static void	contents_make_skip_table(struct contents_block *handle);
+static void	contents_report_match(struct contents_block *handle, int start, int end);
 static osbool	contents_test_wildcard(struct contents_block *handle, int pointer, int *end);
 static osbool	contents_load_file_chunk(struct contents_block *handle, int position);
 static char	contents_get_byte(struct contents_block *handle, int pointer, osbool ignore_case);
@@ -143,14 +180,20 @@ struct contents_block *contents_create(struct objdb_block *objects, struct resul
 	new->any_case = any_case;
 	new->invert = invert;
 
-	new->file_block_size = 1024 * CONTENTS_FILE_BUFFER_SIZE;
+	new->file_block_size = contents_get_buffer_size();
 
 	new->key = OBJDB_NULL_KEY;
 	new->parent = RESULTS_NULL;
 
 	new->filename = NULL;
+	new->file_handle = 0;
 	new->file = NULL;
 	new->text = NULL;
+	new->text_length = 0;
+	new->overlap = 0;
+	new->literal = FALSE;
+
+	quantum_initialise(&(new->quantum));
 
 	new->error = FALSE;
 
@@ -170,8 +213,30 @@ struct contents_block *contents_create(struct objdb_block *objects, struct resul
 		if (new->any_case)
 			string_toupper(new->text);
 
+		new->text_length = strlen(new->text);
+
+		/* When the buffer moves forward, a wildcard match can look back over
+		 * the length of the text, and the context of any match can look a
+		 * little further, so retain that much data from before the pointer.
+		 * The block must be at least twice that size, or a long text would
+		 * leave no room for the pointer to advance after each load.
+		 */
+
+		new->overlap = new->text_length - 1 + CONTENTS_MATCH_CONTEXT;
+		if (new->file_block_size < 2 * (new->overlap + 1))
+			new->file_block_size = 2 * (new->overlap + 1);
+
+		/* If the text is free of wildcards, it can be matched using the
+		 * literal engine instead of the byte-by-byte wildcard test.
+		 */
+
+		new->literal = (new->text_length > 0 && strpbrk(new->text, "*#?") == NULL) ? TRUE : FALSE;
+
+		if (new->literal)
+			contents_make_skip_table(new);
+
 #ifdef DEBUG
-		debug_printf("String to match: '%s', inverted=%d", new->text, new->invert);
+		debug_printf("String to match: '%s', inverted=%d, literal=%d", new->text, new->invert, new->literal);
 #endif
 	} else {
 		mem_ok = FALSE;
@@ -187,9 +252,12 @@ struct contents_block *contents_create(struct objdb_block *objects, struct resul
 		if (new->filename != NULL)
 			flex_free((flex_ptr) &(new->filename));
 
-		if (new->filename != NULL)
+		if (new->file != NULL)
 			flex_free((flex_ptr) &(new->file));
 
+		if (new->text != NULL)
+			flex_free((flex_ptr) &(new->text));
+
 		heap_free(new);
 
 		return NULL;
@@ -197,6 +265,7 @@ struct contents_block *contents_create(struct objdb_block *objects, struct resul
 
 	new->file_offset = 0;
 	new->file_extent = 0;
+	new->file_loaded = 0;
 
 	new->pointer = 0;
 	new->matched = FALSE;
@@ -220,6 +289,8 @@ void contents_destroy(struct contents_block *handle)
 	debug_printf("Destroyed content search: 0x%x", handle);
 #endif
 
+	contents_close_file(handle);
+
 	if (handle->filename != NULL)
 		flex_free((flex_ptr) &(handle->filename));
 
@@ -242,23 +313,173 @@ void contents_destroy(struct contents_block *handle)
  */
 
 osbool contents_add_file(struct contents_block *handle, unsigned key)
+{
+	return contents_start_file(handle, key, 0, FALSE, RESULTS_NULL);
+}
+
+
+/**
+ * Add a file to the search engine part way through, to carry on from a
+ * position returned by contents_get_position() when the search was saved.
+ *
+ * \param *handle		The handle of the engine to take the file.
+ * \param key			The ObjectDB key for the file to be searched.
+ * \param pointer		The file pointer to carry on from.
+ * \param matched		TRUE if the file had already matched.
+ * \param parent		The results line of the file if it has already
+ *				been reported, or RESULTS_NULL.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+osbool contents_resume_file(struct contents_block *handle, unsigned key, int pointer, osbool matched, unsigned parent)
+{
+	return contents_start_file(handle, key, pointer, matched, parent);
+}
+
+
+/**
+ * Return the position reached in the file currently being searched, so that
+ * the search can be carried on later with contents_resume_file().
+ *
+ * \param *handle		The handle of the engine to report on.
+ * \param *key			Pointer to a variable to take the ObjectDB key
+ *				of the file, or NULL.
+ * \param *pointer		Pointer to a variable to take the file pointer,
+ *				or NULL.
+ * \param *matched		Pointer to a variable to take TRUE if the file
+ *				has matched so far, or NULL.
+ */
+
+void contents_get_position(struct contents_block *handle, unsigned *key, int *pointer, osbool *matched)
+{
+	if (key != NULL)
+		*key = (handle != NULL) ? handle->key : OBJDB_NULL_KEY;
+
+	if (pointer != NULL)
+		*pointer = (handle != NULL) ? handle->pointer : 0;
+
+	if (matched != NULL)
+		*matched = (handle != NULL) ? handle->matched : FALSE;
+}
+
+
+/**
+ * Poll a search to allow it to process the current file.
+ *
+ * \param *handle		The handle of the engine to poll.
+ * \param end_time		The latest time at which control must return.
+ * \param *matched		Pointer to a variable to return the matched state,
+ *				if search completes.
+ * \return			TRUE if the search has completed; else FALSE.
+ */
+
+osbool contents_poll(struct contents_block *handle, os_t end_time, osbool *matched)
+{
+	char		byte;
+	int		start, end;
+	unsigned	units = 0;
+#ifdef DEBUG
+	int		start_pointer;
+	os_t		start_time;
+#endif
+
+	if (handle == NULL)
+		return TRUE;
+
+#ifdef DEBUG
+	start_pointer = handle->pointer;
+	start_time = os_read_monotonic_time();
+	debug_printf("Starting contents search loop %d at time %u", handle->pointer, start_time);
+#endif
+
+	quantum_start(&(handle->quantum), end_time);
+
+	if (handle->literal)
+		contents_poll_literal(handle);
+
+	/* Each byte counts as a unit of work, unless a wildcard test looked
+	 * further ahead, in which case all of the bytes that it read count.
+	 */
+
+	while (!handle->literal && !handle->error && (!handle->invert || !handle->matched) && (handle->pointer < handle->file_extent) &&
+			!quantum_expired(&(handle->quantum), units)) {
+		byte = contents_get_byte(handle, handle->pointer, TRUE);
+
+		start = handle->pointer;
+		end = -1;
+
+		if (byte == *(handle->text) && contents_test_wildcard(handle, handle->pointer, &end)) {
+#ifdef DEBUG
+			debug_printf("Match at offset %d", handle->pointer);
+#endif
+
+			contents_report_match(handle, handle->pointer, end);
+			handle->pointer = end;
+		} else if (end != -1 && end >= handle->file_extent - 1) {
+			/* If the wildcard matching reached the end of the file, then give
+			 * up because we won't manage to find a match.
+			 */
+
+			handle->pointer = end;
+		}
+
+		units = (end > start) ? end - start + 1 : 1;
+
+		handle->pointer++;
+	}
+
+#ifdef DEBUG
+	debug_printf("Finishing contents search loop at time %u, having scanned %d bytes in %u cs",
+			os_read_monotonic_time(), handle->pointer - start_pointer, os_read_monotonic_time() - start_time);
+#endif
+
+	if (handle->error || (handle->matched && handle->invert) || handle->pointer >= handle->file_extent) {
+		contents_close_file(handle);
+
+		if (handle->invert && !handle->matched && !handle->error)
+			results_add_file(handle->results, handle->key);
+
+		if (matched != NULL)
+			*matched = (handle->invert) ? !handle->matched : handle->matched;
+
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+
+/**
+ * Set the engine up to search a file, starting from a given position.
+ *
+ * \param *handle		The handle of the engine to take the file.
+ * \param key			The ObjectDB key for the file to be searched.
+ * \param pointer		The file pointer to start from.
+ * \param matched		TRUE if the file has already matched.
+ * \param parent		The results line of the file, or RESULTS_NULL.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool contents_start_file(struct contents_block *handle, unsigned key, int pointer, osbool matched, unsigned parent)
 {
 	size_t		filename_length;
-	os_error	*error;
 
 	if (handle == NULL || key == OBJDB_NULL_KEY)
 		return FALSE;
 
+	contents_close_file(handle);
+
 	handle->key = key;
-	handle->parent = RESULTS_NULL;
+	handle->parent = parent;
 
 	handle->file_extent = 0;
 	handle->file_offset = 0;
+	handle->file_loaded = 0;
 
 	handle->error = FALSE;
 
-	handle->pointer = 0;
-	handle->matched = FALSE;
+	handle->pointer = (pointer > 0) ? pointer : 0;
+	handle->matched = matched;
 
 #ifdef DEBUG
 	debug_printf("Processing object content: key = %d", key);
@@ -274,94 +495,270 @@ osbool contents_add_file(struct contents_block *handle, unsigned key)
 	if (!objdb_get_name(handle->objects, key, handle->filename, filename_length))
 		return FALSE;
 
-	/* Get the size of the file to be searched and decide if it will fit into the
-	 * available space.
+	/* Take the size of the file to be searched from the object database;
+	 * it will be checked against the file's extent when the file is opened.
+	 * Empty files can't contain anything, so they don't need to be opened.
 	 */
 
-	error = xosfile_read_no_path(handle->filename, NULL, NULL, NULL, &handle->file_extent, NULL);
-	if (error != NULL) {
-		results_add_error(handle->results, error->errmess, handle->key);
+	handle->file_extent = objdb_get_size(handle->objects, key);
+	if (handle->file_extent < 0) {
 		handle->file_extent = 0;
 		return FALSE;
 	}
 
-	/* Load the first chunk of data from the file. */
+	if (handle->file_extent == 0)
+		return TRUE;
 
-	contents_load_file_chunk(handle, 0);
+	/* Open the file, and load the first chunk of data from it. */
+
+	if (!contents_open_file(handle)) {
+		handle->error = TRUE;
+		return FALSE;
+	}
+
+	if (!contents_load_file_chunk(handle, handle->pointer - handle->overlap))
+		handle->error = TRUE;
 
 	return TRUE;
 }
 
 
 /**
- * Poll a search to allow it to process the current file.
+ * Calculate the size of buffer to allocate for file contents. If no size has
+ * been configured, use a fraction of the free memory in the Wimp pool.
  *
- * \param *handle		The handle of the engine to poll.
- * \param end_time		The latest time at which control must return.
- * \param *matched		Pointer to a variable to return the matched state,
- *				if search completes.
- * \return			TRUE if the search has completed; else FALSE.
+ * \return			The buffer size, in bytes.
  */
 
-osbool contents_poll(struct contents_block *handle, os_t end_time, osbool *matched)
+static size_t contents_get_buffer_size(void)
 {
-	char	byte, buffer[1024];
-	int	end;
+	int	size, current, next, free;
 
-	if (handle == NULL)
-		return TRUE;
+	size = config_int_read("ContentsBufSize");
+
+	if (size <= 0) {
+		if (xwimp_slot_size(-1, -1, &current, &next, &free) == NULL)
+			size = free / (1024 * CONTENTS_FILE_BUFFER_SCALE);
+		else
+			size = CONTENTS_FILE_BUFFER_MIN;
+
+		if (size < CONTENTS_FILE_BUFFER_MIN)
+			size = CONTENTS_FILE_BUFFER_MIN;
+		else if (size > CONTENTS_FILE_BUFFER_MAX)
+			size = CONTENTS_FILE_BUFFER_MAX;
+	}
 
 #ifdef DEBUG
-	debug_printf("Starting contents search loop %d at time %u", handle->pointer, os_read_monotonic_time());
+	debug_printf("Contents buffer size: %dK", size);
 #endif
 
-	while (!handle->error && (!handle->invert || !handle->matched) && (handle->pointer < handle->file_extent) &&
-			(os_read_monotonic_time() < end_time)) {
-		byte = contents_get_byte(handle, handle->pointer, TRUE);
+	return 1024 * size;
+}
 
-		end = -1;
 
-		if (byte == *(handle->text) && contents_test_wildcard(handle, handle->pointer, &end)) {
+/**
+ * Open the current file, ready for its contents to be loaded. The handle
+ * remains open until the search of the file completes.
+ *
+ * \param *handle		The contents search handle.
+ * \return			TRUE if successful; FALSE if an error occurs.
+ */
+
+static osbool contents_open_file(struct contents_block *handle)
+{
+	os_error	*error;
+
+	if (handle == NULL)
+		return FALSE;
+
+	if (handle->file_handle != 0)
+		return TRUE;
+
+	error = fsys_open_in(handle->filename, &(handle->file_handle));
+	if (error != NULL || handle->file_handle == 0) {
+		handle->file_handle = 0;
+		results_add_error(handle->results, (error != NULL) ? error->errmess : "Failed to open file", handle->key);
+		return FALSE;
+	}
+
+	contents_open_count++;
+
+	return TRUE;
+}
+
+
+/**
+ * Close the current file, if it is open.
+ *
+ * \param *handle		The contents search handle.
+ */
+
+static void contents_close_file(struct contents_block *handle)
+{
+	os_error	*error;
+
+	if (handle == NULL || handle->file_handle == 0)
+		return;
+
+	error = fsys_close(handle->file_handle);
+	if (error != NULL)
+		results_add_error(handle->results, error->errmess, handle->key);
+
+	handle->file_handle = 0;
+
+	contents_close_count++;
+
 #ifdef DEBUG
-			debug_printf("Match at offset %d", handle->pointer);
+	debug_printf("Contents file handles: %u opened, %u closed", contents_open_count, contents_close_count);
+	debug_printf("Contents bytes: %u read, of which %u were read again", contents_bytes_read, contents_bytes_reread);
 #endif
+}
 
-			if (!handle->invert) {
-				if (!handle->matched)
-					handle->parent = results_add_file(handle->results, handle->key);
 
-				if (contents_get_context(handle, handle->pointer, end, 30, buffer, 1024))
-					results_add_contents(handle->results, handle->key, handle->parent, buffer);
-			}
+/**
+ * Scan the current file for a literal string, using the Boyer-Moore-Horspool
+ * algorithm to work directly on the data in the file buffer.
+ *
+ * The time is taken from the handle's work quantum, which has already been
+ * started, counting the bytes passed over in each pass of the loop.
+ *
+ * \param *handle		The contents search handle.
+ */
 
-			handle->matched = TRUE;
-			handle->pointer = end;
-		} else if (end != -1 && end >= handle->file_extent - 1) {
-			/* If the wildcard matching reached the end of the file, then give
-			 * up because we won't manage to find a match.
-			 */
+static void contents_poll_literal(struct contents_block *handle)
+{
+	int		length, last, position, limit, slice, start, i;
+	unsigned char	*buffer, *text, byte;
 
-			handle->pointer = end;
+	length = handle->text_length;
+	last = length - 1;
+
+	start = handle->pointer;
+
+	while (!handle->error && (!handle->invert || !handle->matched) && (handle->pointer + length <= handle->file_extent) &&
+			!quantum_expired(&(handle->quantum), handle->pointer - start)) {
+		start = handle->pointer;
+
+		/* Make sure that there's a whole pattern's worth of data in memory
+		 * at the current pointer, moving the buffer on so that the pointer
+		 * is close to its start if there isn't.
+		 */
+
+		if ((handle->pointer < handle->file_offset || handle->pointer + length > handle->file_offset + handle->file_block_size) &&
+				!contents_load_file_chunk(handle, handle->pointer - handle->overlap)) {
+			handle->error = TRUE;
+			break;
 		}
 
-		handle->pointer++;
-	}
+		/* Find the last position in the buffer at which a match could
+		 * start, limiting the scan so that the work quantum gets checked.
+		 */
+
+		limit = ((handle->file_extent < handle->file_offset + handle->file_block_size) ?
+				handle->file_extent : handle->file_offset + handle->file_block_size) - handle->file_offset - length;
+
+		position = handle->pointer - handle->file_offset;
+
+		slice = position + CONTENTS_LITERAL_SLICE;
+		if (limit > slice)
+			limit = slice;
+
+		/* NB: Taking copies of the flex pointers assumes that there will be
+		 *     NO FLEX ACTIVITY until a match is found and reported.
+		 */
+
+		buffer = (unsigned char *) handle->file;
+		text = (unsigned char *) handle->text;
+
+		while (position <= limit) {
+			byte = buffer[position + last];
 
+			if (((handle->any_case) ? toupper(byte) : byte) == text[last]) {
+				for (i = 0; i < last; i++) {
+					byte = buffer[position + i];
+
+					if (((handle->any_case) ? toupper(byte) : byte) != text[i])
+						break;
+				}
+
+				if (i == last)
+					break;
+			}
+
+			position += handle->skip[buffer[position + last]];
+		}
+
+		if (position <= limit) {
 #ifdef DEBUG
-	debug_printf("Finishing contents search loop at time %u", os_read_monotonic_time());
+			debug_printf("Literal match at offset %d", handle->file_offset + position);
 #endif
 
-	if (handle->error || (handle->matched && handle->invert) || handle->pointer >= handle->file_extent) {
-		if (handle->invert && !handle->matched && !handle->error)
-			results_add_file(handle->results, handle->key);
+			handle->pointer = handle->file_offset + position;
+			contents_report_match(handle, handle->pointer, handle->pointer + last);
+			handle->pointer += length;
+		} else {
+			handle->pointer = handle->file_offset + position;
+		}
+	}
 
-		if (matched != NULL)
-			*matched = (handle->invert) ? !handle->matched : handle->matched;
+	/* If there's no longer room for a match before the end of the file, the
+	 * search is complete.
+	 */
 
-		return TRUE;
+	if (!handle->error && handle->pointer + length > handle->file_extent)
+		handle->pointer = handle->file_extent;
+}
+
+
+/**
+ * Build the Horspool skip table for the current literal text. If the search
+ * is case-insensitive, entries are made for both cases of each character so
+ * that the table can be indexed directly from the file data.
+ *
+ * \param *handle		The contents search handle.
+ */
+
+static void contents_make_skip_table(struct contents_block *handle)
+{
+	int		i;
+	unsigned char	byte;
+
+	for (i = 0; i < 256; i++)
+		handle->skip[i] = handle->text_length;
+
+	for (i = 0; i < handle->text_length - 1; i++) {
+		byte = handle->text[i];
+
+		handle->skip[byte] = handle->text_length - 1 - i;
+
+		if (handle->any_case)
+			handle->skip[(unsigned char) tolower(byte)] = handle->text_length - 1 - i;
 	}
+}
 
-	return FALSE;
+
+/**
+ * Record a match in the current file, adding it to the results window if
+ * the search is not inverted.
+ *
+ * \param *handle		The contents search handle.
+ * \param start			The pointer to the first character of the match.
+ * \param end			The pointer to the last character of the match.
+ */
+
+static void contents_report_match(struct contents_block *handle, int start, int end)
+{
+	char	buffer[1024];
+
+	if (!handle->invert) {
+		if (!handle->matched)
+			handle->parent = results_add_file(handle->results, handle->key);
+
+		if (contents_get_context(handle, start, end, CONTENTS_MATCH_CONTEXT, buffer, 1024))
+			results_add_contents(handle->results, handle->key, handle->parent, buffer);
+	}
+
+	handle->matched = TRUE;
 }
 
 
@@ -474,8 +871,7 @@ starCheck:
 
 static osbool contents_load_file_chunk(struct contents_block *handle, int position)
 {
-	int		extent, ptr, bytes, unread;
-	os_fw		file;
+	int		extent, ptr, bytes, retained, unread;
 	os_error	*error;
 
 
@@ -485,17 +881,16 @@ static osbool contents_load_file_chunk(struct contents_block *handle, int positi
 	if (position < 0)
 		position = 0;
 
-	/* Open the file. */
+	/* Check that the file is open. */
 
-	error = xosfind_openinw(osfind_NO_PATH | osfind_ERROR_IF_DIR, handle->filename, NULL, &file);
-	if (error != NULL || file == 0) {
-		results_add_error(handle->results, (error != NULL) ? error->errmess : "Failed to open file", handle->key);
+	if (handle->file_handle == 0) {
+		results_add_error(handle->results, "File not open", handle->key);
 		return FALSE;
 	}
 
 	/* Get the file's extent. */
 
-	error = xosargs_read_extw(file, &extent);
+	error = fsys_read_extent(handle->file_handle, &extent);
 	if (error != NULL) {
 		results_add_error(handle->results, error->errmess, handle->key);
 		return FALSE;
@@ -505,9 +900,6 @@ static osbool contents_load_file_chunk(struct contents_block *handle, int positi
 
 	if (extent != handle->file_extent) {
 		results_add_error(handle->results, "File changed!", handle->key);
-		error = xosfind_close(file);
-		if (error != NULL)
-			results_add_error(handle->results, error->errmess, handle->key);
 		return FALSE;
 	}
 
@@ -524,20 +916,40 @@ static osbool contents_load_file_chunk(struct contents_block *handle, int positi
 		bytes = extent;
 	}
 
-	error = xosgbpb_read_atw(file, (byte *) handle->file, bytes, ptr, &unread);
-	if (error != NULL || unread != 0) {
-		results_add_error(handle->results, (error != NULL) ? error->errmess : "Error reading from file", handle->key);
-		return FALSE;
-	} else {
-		handle->file_offset = ptr;
+	/* If the new block starts within the data already in memory, move the
+	 * overlap down to the start of the buffer rather than reading it from
+	 * disc again. OS_GBPB can't read in the background, so this is as close
+	 * as we can get to double-buffering the file.
+	 */
+
+	retained = 0;
+
+	if (ptr >= handle->file_offset && ptr < handle->file_offset + handle->file_loaded) {
+		retained = handle->file_offset + handle->file_loaded - ptr;
+		if (retained > bytes)
+			retained = bytes;
+
+		if (ptr > handle->file_offset)
+			memmove(handle->file, handle->file + (ptr - handle->file_offset), retained);
+	} else if (ptr < handle->file_offset && ptr + bytes > handle->file_offset) {
+		contents_bytes_reread += ptr + bytes - handle->file_offset;
 	}
 
-	error = xosfind_close(file);
-	if (error != NULL) {
-		results_add_error(handle->results, error->errmess, handle->key);
-		return FALSE;
+	handle->file_offset = ptr;
+	handle->file_loaded = retained;
+
+	if (retained < bytes) {
+		error = fsys_read_at(handle->file_handle, (byte *) handle->file + retained, bytes - retained, ptr + retained, &unread);
+		if (error != NULL || unread != 0) {
+			results_add_error(handle->results, (error != NULL) ? error->errmess : "Error reading from file", handle->key);
+			return FALSE;
+		}
+
+		contents_bytes_read += bytes - retained;
 	}
 
+	handle->file_loaded = bytes;
+
 	return TRUE;
 }
 
@@ -561,7 +973,7 @@ static char contents_get_byte(struct contents_block *handle, int pointer, osbool
 		return 0;
 
 	if ((pointer < handle->file_offset || pointer >= handle->file_offset + handle->file_block_size) &&
-			!contents_load_file_chunk(handle, pointer - (handle->file_block_size / CONTENTS_FILE_BACKSPACE))) {
+			!contents_load_file_chunk(handle, pointer - handle->overlap)) {
 		handle->error = TRUE;
 		return 0;
 	}
@@ -73,6 +73,38 @@ void contents_destroy(struct contents_block *handle);
 osbool contents_add_file(struct contents_block *handle, unsigned key);
 
 
+/**
+ * Add a file to the search engine part way through, to carry on from a
+ * position returned by contents_get_position() when the search was saved.
+ *
+ * \param *handle		The handle of the engine to take the file.
+ * \param key			The ObjectDB key for the file to be searched.
+ * \param pointer		The file pointer to carry on from.
+ * \param matched		TRUE if the file had already matched.
+ * \param parent		The results line of the file if it has already
+ *				been reported, or RESULTS_NULL.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+osbool contents_resume_file(struct contents_block *handle, unsigned key, int pointer, osbool matched, unsigned parent);
+
+
+/**
+ * Return the position reached in the file currently being searched, so that
+ * the search can be carried on later with contents_resume_file().
+ *
+ * \param *handle		The handle of the engine to report on.
+ * \param *key			Pointer to a variable to take the ObjectDB key
+ *				of the file, or NULL.
+ * \param *pointer		Pointer to a variable to take the file pointer,
+ *				or NULL.
+ * \param *matched		Pointer to a variable to take TRUE if the file
+ *				has matched so far, or NULL.
+ */
+
+void contents_get_position(struct contents_block *handle, unsigned *key, int *pointer, osbool *matched);
+
+
 /**
  * Poll a search to allow it to process the current file.
  *
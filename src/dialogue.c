@@ -58,6 +58,7 @@
 #include "sflib/heap.h"
 #include "sflib/icons.h"
 #include "sflib/ihelp.h"
+#include "sflib/menus.h"
 #include "sflib/msgs.h"
 #include "sflib/windows.h"
 #include "sflib/debug.h"
@@ -74,9 +75,12 @@
 #include "flexutils.h"
 #include "hotlist.h"
 #include "iconbar.h"
+#include "index.h"
+#include "regex.h"
 #include "search.h"
 #include "settime.h"
 #include "typemenu.h"
+#include "wildcard.h"
 
 
 /* Search Dialogue panes. */
@@ -189,6 +193,8 @@
 
 #define DIALOGUE_MENU_SAVE_SEARCH 0
 #define DIALOGUE_MENU_ADD_TO_HOTLIST 1
+#define DIALOGUE_MENU_FIND_DUPLICATES 2
+#define DIALOGUE_MENU_USE_INDEX 3
 
 #define DIALOGUE_MAX_FILE_LINE 1024
 
@@ -196,71 +202,6 @@
 
 #define MAX_BUFFER(current, size) (((size) > (current)) ? (size) : (current))
 
-enum dialogue_name {
-	DIALOGUE_NAME_NOT_IMPORTANT = 0,
-	DIALOGUE_NAME_EQUAL_TO,
-	DIALOGUE_NAME_NOT_EQUAL_TO,
-	DIALOGUE_NAME_CONTAINS,
-	DIALOGUE_NAME_DOES_NOT_CONTAIN
-};
-
-enum dialogue_size {
-	DIALOGUE_SIZE_NOT_IMPORTANT = 0,
-	DIALOGUE_SIZE_EQUAL_TO,
-	DIALOGUE_SIZE_NOT_EQUAL_TO,
-	DIALOGUE_SIZE_GREATER_THAN,
-	DIALOGUE_SIZE_LESS_THAN,
-	DIALOGUE_SIZE_BETWEEN,
-	DIALOGUE_SIZE_NOT_BETWEEN
-};
-
-enum dialogue_size_unit {
-	DIALOGUE_SIZE_BYTES,
-	DIALOGUE_SIZE_KBYTES,
-	DIALOGUE_SIZE_MBYTES
-};
-
-enum dialogue_date {
-	DIALOGUE_DATE_AT_ANY_TIME = 0,
-	DIALOGUE_DATE_AT,
-	DIALOGUE_DATE_AT_ANY_TIME_BUT,
-	DIALOGUE_DATE_AFTER,
-	DIALOGUE_DATE_BEFORE,
-	DIALOGUE_DATE_BETWEEN,
-	DIALOGUE_DATE_NOT_BETWEEN
-};
-
-enum dialogue_age {
-	DIALOGUE_AGE_ANY_AGE = 0,
-	DIALOGUE_AGE_EXACTLY,
-	DIALOGUE_AGE_ANY_AGE_BUT,
-	DIALOGUE_AGE_LESS_THAN,
-	DIALOGUE_AGE_MORE_THAN,
-	DIALOGUE_AGE_BETWEEN,
-	DIALOGUE_AGE_NOT_BETWEEN
-};
-
-enum dialogue_age_unit {
-	DIALOGUE_AGE_MINUTES,
-	DIALOGUE_AGE_HOURS,
-	DIALOGUE_AGE_DAYS,
-	DIALOGUE_AGE_WEEKS,
-	DIALOGUE_AGE_MONTHS,
-	DIALOGUE_AGE_YEARS
-};
-
-enum dialogue_type {
-	DIALOGUE_TYPE_OF_ANY = 0,
-	DIALOGUE_TYPE_OF_TYPE,
-	DIALOGUE_TYPE_NOT_OF_TYPE
-};
-
-enum dialogue_contents {
-	DIALOGUE_CONTENTS_ARE_NOT_IMPORTANT = 0,
-	DIALOGUE_CONTENTS_INCLUDE,
-	DIALOGUE_CONTENTS_DO_NOT_INCLUDE
-};
-
 /* Settings block for a search dialogue window. */
 
 struct dialogue_block {
@@ -338,6 +279,9 @@ struct dialogue_block {
 	osbool				ignore_imagefs;				/**< Ignore the contents of image filing systems.	*/
 	osbool				suppress_errors;			/**< Suppress errors during the search.			*/
 	osbool				full_info;				/**< Use a full-info display by default.		*/
+	osbool				duplicates;				/**< Report only files which have duplicates.		*/
+	osbool				use_index;				/**< Read directories from the configured index.	*/
+	char				*ignore_list;				/**< The objects to be ignored during the search.	*/
 };
 
 
@@ -363,6 +307,8 @@ static wimp_menu		*dialogue_contents_mode_menu = NULL;		/**< The Contents Mode p
 
 static struct saveas_block	*dialogue_save_search = NULL;			/**< The Save Search savebox data handle.		*/
 
+static struct index_block	*dialogue_index = NULL;				/**< The configured filename index, once loaded.	*/
+
 
 static struct	dialogue_block *dialogue_load_legacy_file(struct file_block *file, struct discfile_block *load);
 static void	dialogue_close_window(void);
@@ -391,6 +337,7 @@ static void	dialogue_drag_end_handler(wimp_pointer *pointer, void *data);
 static osbool	dialogue_xfer_save_handler(char *filename, void *data);
 static osbool	dialogue_icon_drop_handler(wimp_message *message);
 static void	dialogue_start_search(struct dialogue_block *dialogue);
+static struct index_block *dialogue_get_index(void);
 static int	dialogue_scale_size(unsigned base, enum dialogue_size_unit unit, osbool top);
 static void	dialogue_scale_age(os_date_and_time date, unsigned base, enum dialogue_age_unit unit, int round);
 static osbool	dialogue_save_settings(char *filename, osbool selection, void *data);
@@ -566,7 +513,7 @@ struct dialogue_block *dialogue_create(struct file_block *file, char *filename,
 	struct dialogue_block	*new;
 	osbool			mem_ok = TRUE;
 	int			i;
-	size_t			path_len, filename_len, contents_len;
+	size_t			path_len, filename_len, contents_len, ignore_len;
 
 	if (filename == NULL && template == NULL)
 		filename = "";
@@ -580,6 +527,7 @@ struct dialogue_block *dialogue_create(struct file_block *file, char *filename,
 	path_len = strlen((path == NULL) ? template->path : path) + 1;
 	filename_len = strlen((template != NULL) ? template->filename : filename) + 1;
 	contents_len = strlen((template != NULL) ? template->contents_text : "") + 1;
+	ignore_len = strlen((template != NULL) ? template->ignore_list : config_str_read("IgnoreList")) + 1;
 
 	/* Count the number of filetypes that are in the block, then
 	 * allocate all of the memory that we require.
@@ -602,6 +550,7 @@ struct dialogue_block *dialogue_create(struct file_block *file, char *filename,
 		new->filename = NULL;
 		new->type_types = NULL;
 		new->contents_text = NULL;
+		new->ignore_list = NULL;
 
 		if (flex_alloc((flex_ptr) &(new->path), path_len) == 0)
 			mem_ok = FALSE;
@@ -615,6 +564,9 @@ struct dialogue_block *dialogue_create(struct file_block *file, char *filename,
 		if (flex_alloc((flex_ptr) &(new->contents_text), contents_len) == 0)
 			mem_ok = FALSE;
 
+		if (flex_alloc((flex_ptr) &(new->ignore_list), ignore_len) == 0)
+			mem_ok = FALSE;
+
 	}
 
 	if (!mem_ok) {
@@ -700,6 +652,9 @@ struct dialogue_block *dialogue_create(struct file_block *file, char *filename,
 	new->ignore_imagefs = (template != NULL) ? template->ignore_imagefs : config_opt_read("ImageFS");
 	new->suppress_errors = (template != NULL) ? template->suppress_errors : config_opt_read("SuppressErrors");
 	new->full_info = (template != NULL) ? template->full_info : config_opt_read("FullInfoDisplay");
+	new->duplicates = (template != NULL) ? template->duplicates : FALSE;
+	new->use_index = (template != NULL) ? template->use_index : FALSE;
+	string_copy(new->ignore_list, (template != NULL) ? template->ignore_list : config_str_read("IgnoreList"), ignore_len);
 
 	return new;
 }
@@ -753,6 +708,8 @@ void dialogue_destroy(struct dialogue_block *dialogue, enum dialogue_client clie
 		flex_free((flex_ptr) &(dialogue->type_types));
 	if (dialogue->contents_text != NULL)
 		flex_free((flex_ptr) &(dialogue->contents_text));
+	if (dialogue->ignore_list != NULL)
+		flex_free((flex_ptr) &(dialogue->ignore_list));
 
 	heap_free(dialogue);
 }
@@ -881,6 +838,9 @@ void dialogue_save_file(struct dialogue_block *dialogue, struct discfile_block *
 	discfile_write_option_boolean(out, "IMG", dialogue->ignore_imagefs);
 	discfile_write_option_boolean(out, "ERR", dialogue->suppress_errors);
 	discfile_write_option_boolean(out, "FUL", dialogue->full_info);
+	discfile_write_option_boolean(out, "DUP", dialogue->duplicates);
+	discfile_write_option_boolean(out, "IDX", dialogue->use_index);
+	discfile_write_option_string(out, "IGN", dialogue->ignore_list);
 
 	discfile_end_chunk(out);
 	discfile_end_section(out);
@@ -1012,6 +972,9 @@ struct dialogue_block *dialogue_load_file(struct file_block *file, struct discfi
 	discfile_read_option_boolean(load, "IMG", &dialogue->ignore_imagefs);
 	discfile_read_option_boolean(load, "ERR", &dialogue->suppress_errors);
 	discfile_read_option_boolean(load, "FUL", &dialogue->full_info);
+	discfile_read_option_boolean(load, "DUP", &dialogue->duplicates);
+	discfile_read_option_boolean(load, "IDX", &dialogue->use_index);
+	discfile_read_option_flex_string(load, "IGN", (flex_ptr) &dialogue->ignore_list);
 
 	discfile_close_chunk(load);
 	discfile_close_section(load);
@@ -1568,8 +1531,9 @@ static void dialogue_write_filetype_list(char *buffer, size_t length, unsigned t
 
 static osbool dialogue_read_window(struct dialogue_block *dialogue)
 {
-	char		error[128];
-	osbool		success = TRUE;
+	char			error[128];
+	osbool			success = TRUE;
+	struct regex_block	*regex;
 
 	if (dialogue == NULL)
 		return FALSE;
@@ -1599,6 +1563,18 @@ static osbool dialogue_read_window(struct dialogue_block *dialogue)
 	dialogue->name_mode = event_get_window_icon_popup_selection(dialogue_window, DIALOGUE_ICON_NAME_MODE_MENU);
 	dialogue->ignore_case = icons_get_selected(dialogue_window, DIALOGUE_ICON_IGNORE_CASE);
 
+	if (success && (dialogue->name_mode == DIALOGUE_NAME_MATCHES_REGEX || dialogue->name_mode == DIALOGUE_NAME_DOES_NOT_MATCH_REGEX)) {
+		regex = regex_create(dialogue->filename, dialogue->ignore_case);
+
+		if (regex == NULL) {
+			msgs_param_lookup("BadRegex", error, sizeof(error), icons_get_indirected_text_addr(dialogue_window, DIALOGUE_ICON_FILENAME), NULL, NULL, NULL);
+			error_report_info(error);
+			success = FALSE;
+		}
+
+		regex_destroy(regex);
+	}
+
 	/* Set the Size pane */
 
 	dialogue->size_mode = event_get_window_icon_popup_selection(dialogue_panes[DIALOGUE_PANE_SIZE], DIALOGUE_SIZE_ICON_MODE_MENU);
@@ -2048,6 +2024,12 @@ static void dialogue_move_caret_up(void)
 
 static void dialogue_menu_prepare_handler(wimp_w w, wimp_menu *menu, wimp_pointer *pointer)
 {
+	if (menu == dialogue_menu && dialogue_data != NULL) {
+		menus_tick_entry(dialogue_menu, DIALOGUE_MENU_FIND_DUPLICATES, dialogue_data->duplicates);
+		menus_tick_entry(dialogue_menu, DIALOGUE_MENU_USE_INDEX, dialogue_data->use_index);
+		menus_shade_entry(dialogue_menu, DIALOGUE_MENU_USE_INDEX, *config_str_read("IndexFile") == '\0');
+	}
+
 	if (pointer == NULL)
 		return;
 
@@ -2104,6 +2086,16 @@ static void dialogue_menu_selection_handler(wimp_w window, wimp_menu *menu, wimp
 		case DIALOGUE_MENU_ADD_TO_HOTLIST:
 			dialogue_add_to_hotlist();
 			break;
+
+		case DIALOGUE_MENU_FIND_DUPLICATES:
+			if (dialogue_data != NULL)
+				dialogue_data->duplicates = !dialogue_data->duplicates;
+			break;
+
+		case DIALOGUE_MENU_USE_INDEX:
+			if (dialogue_data != NULL)
+				dialogue_data->use_index = !dialogue_data->use_index;
+			break;
 		}
 	} else if (menu == dialogue_name_mode_menu)
 		dialogue_shade_window();
@@ -2272,10 +2264,8 @@ static osbool dialogue_icon_drop_handler(wimp_message *message)
 
 
 /**
- * Take a set of dialogue settings and create a search from them.  This converts
- * the "human-friendly" details from the dialogue into the details used by the
- * search routines. The dialogue must have a parent file, otherwise the function
- * will return immediately.
+ * Take a set of dialogue settings and create a search from them. The dialogue
+ * must have a parent file, otherwise the function will return immediately.
  *
  * \param *dialogue		The dialogue settings to use.
  */
@@ -2283,7 +2273,6 @@ static osbool dialogue_icon_drop_handler(wimp_message *message)
 static void dialogue_start_search(struct dialogue_block *dialogue)
 {
 	struct search_block		*search;
-	size_t				buffer_size = 0;
 	char				*buffer;
 
 
@@ -2296,24 +2285,58 @@ static void dialogue_start_search(struct dialogue_block *dialogue)
 	dialogue_dump_settings(dialogue);
 #endif
 
-	/* Calculate the required fixed buffer size and allocate the buffer. */
-
-	buffer_size = MAX_BUFFER(buffer_size, strlen(dialogue->path) + 1);
-	buffer_size = MAX_BUFFER(buffer_size, strlen(dialogue->filename) + 1);
-	buffer_size = MAX_BUFFER(buffer_size, strlen(dialogue->contents_text) + 1);
+	/* Create the search and give up if this fails. */
 
-	buffer = heap_alloc(buffer_size);
+	buffer = heap_alloc(strlen(dialogue->path) + 1);
 	if (buffer == NULL)
 		return;
 
-	/* Create the search and give up if this fails. */
-
-	string_copy(buffer, dialogue->path, buffer_size);
+	string_copy(buffer, dialogue->path, strlen(dialogue->path) + 1);
 
 	search = file_create_search(dialogue->file, buffer);
 
-	if (search == NULL) {
-		heap_free(buffer);
+	heap_free(buffer);
+
+	if (search == NULL)
+		return;
+
+	/* Set the search options, and start the search. */
+
+	dialogue_set_search_options(dialogue, search);
+
+	iconbar_set_last_search_dialogue(dialogue);
+
+	search_start(search);
+}
+
+
+/**
+ * Take a set of dialogue settings and apply them to a search.  This converts
+ * the "human-friendly" details from the dialogue into the details used by the
+ * search routines.
+ *
+ * \param *dialogue		The dialogue settings to use.
+ * \param *search		The search to apply the settings to.
+ */
+
+void dialogue_set_search_options(struct dialogue_block *dialogue, struct search_block *search)
+{
+	size_t				buffer_size = 0;
+	char				*buffer;
+
+
+	if (dialogue == NULL || search == NULL)
+		return;
+
+	/* Calculate the required fixed buffer size and allocate the buffer. */
+
+	buffer_size = MAX_BUFFER(buffer_size, 3 * strlen(dialogue->filename) + 3);
+	buffer_size = MAX_BUFFER(buffer_size, strlen(dialogue->contents_text) + 1);
+	buffer_size = MAX_BUFFER(buffer_size, strlen(dialogue->ignore_list) + 1);
+
+	buffer = heap_alloc(buffer_size);
+	if (buffer == NULL) {
+		error_msgs_report_error("NoMemStoreParams");
 		return;
 	}
 
@@ -2322,12 +2345,46 @@ static void dialogue_start_search(struct dialogue_block *dialogue)
 	search_set_options(search, !dialogue->ignore_imagefs, dialogue->store_all, dialogue->full_info,
 			dialogue->type_files, dialogue->type_directories, dialogue->type_applications);
 
+	search_set_duplicates(search, dialogue->duplicates);
+
+	/* Read directory listings from the configured index, if requested. */
+
+	if (dialogue->use_index)
+		search_set_index(search, dialogue_get_index());
+
+	/* Set the ignore list. */
+
+	if (strcmp(dialogue->ignore_list, "") != 0) {
+		string_copy(buffer, dialogue->ignore_list, buffer_size);
+		search_set_ignore(search, buffer);
+	}
+
 	/* Set the filename search options. */
 
-	if (strcmp(dialogue->filename, "") != 0 && strcmp(dialogue->filename, "*") != 0 && dialogue->name_mode != DIALOGUE_NAME_NOT_IMPORTANT) {
-		string_copy(buffer, dialogue->filename, buffer_size);
-		search_set_filename(search, buffer, dialogue->ignore_case,
-				(dialogue->name_mode == DIALOGUE_NAME_NOT_EQUAL_TO || dialogue->name_mode == DIALOGUE_NAME_DOES_NOT_CONTAIN) ? TRUE : FALSE);
+	if (strcmp(dialogue->filename, "") != 0 && strcmp(dialogue->filename, "*") != 0) {
+		switch (dialogue->name_mode) {
+		case DIALOGUE_NAME_EQUAL_TO:
+		case DIALOGUE_NAME_NOT_EQUAL_TO:
+			string_copy(buffer, dialogue->filename, buffer_size);
+			search_set_filename(search, buffer, dialogue->ignore_case, (dialogue->name_mode == DIALOGUE_NAME_NOT_EQUAL_TO) ? TRUE : FALSE);
+			break;
+
+		case DIALOGUE_NAME_CONTAINS:
+		case DIALOGUE_NAME_DOES_NOT_CONTAIN:
+			wildcard_make_contains_list(buffer, buffer_size, dialogue->filename);
+			search_set_filename(search, buffer, dialogue->ignore_case, (dialogue->name_mode == DIALOGUE_NAME_DOES_NOT_CONTAIN) ? TRUE : FALSE);
+			break;
+
+		case DIALOGUE_NAME_MATCHES_REGEX:
+		case DIALOGUE_NAME_DOES_NOT_MATCH_REGEX:
+			string_copy(buffer, dialogue->filename, buffer_size);
+			if (!search_set_filename_regex(search, buffer, dialogue->ignore_case, (dialogue->name_mode == DIALOGUE_NAME_DOES_NOT_MATCH_REGEX) ? TRUE : FALSE))
+				error_msgs_report_error("NoMemStoreParams");
+			break;
+
+		case DIALOGUE_NAME_NOT_IMPORTANT:
+			break;
+		}
 	}
 
 	/* Set the size search options. */
@@ -2512,13 +2569,59 @@ static void dialogue_start_search(struct dialogue_block *dialogue)
 		search_set_contents(search, buffer, dialogue->contents_ignore_case, (dialogue->contents_mode == DIALOGUE_CONTENTS_DO_NOT_INCLUDE) ? TRUE : FALSE);
 	}
 
-	/* Tidy up and start the search. */
-
 	heap_free(buffer);
+}
 
-	iconbar_set_last_search_dialogue(dialogue);
 
-	search_start(search);
+/**
+ * Return the filename index set up in the choices, loading it on the first
+ * call; if the file can't be loaded and an index root is set, a new index is
+ * created instead. Each time that the index is used, it is refreshed (or, if
+ * it has never been built or its last update failed, built from scratch) so
+ * that searches see any changes made since. The update runs in time slices
+ * from the polls of the searches waiting for it, and the index is saved back
+ * to the file once it completes. The index is kept until Locate quits, as
+ * searches may still be reading from it. If no index can be set up, the
+ * failure is reported and searches read their directories from disc instead.
+ *
+ * \return			The index handle, or NULL if none is available.
+ */
+
+static struct index_block *dialogue_get_index(void)
+{
+	char			*filename, *root, error[256];
+	osbool			success;
+
+	filename = config_str_read("IndexFile");
+	root = config_str_read("IndexRoot");
+
+	if (filename == NULL || *filename == '\0')
+		return NULL;
+
+	if (dialogue_index == NULL) {
+		hourglass_on();
+		dialogue_index = index_load_file(filename);
+		hourglass_off();
+
+		if (dialogue_index == NULL && root != NULL && *root != '\0')
+			dialogue_index = index_create(root);
+	}
+
+	if (dialogue_index == NULL)
+		success = FALSE;
+	else if (index_is_valid(dialogue_index))
+		success = index_start_refresh(dialogue_index, filename);
+	else
+		success = index_start_build(dialogue_index, filename);
+
+	if (!success) {
+		msgs_param_lookup("BadIndex", error, sizeof(error), filename, NULL, NULL, NULL);
+		error_report_info(error);
+
+		return NULL;
+	}
+
+	return dialogue_index;
 }
 
 
@@ -2774,6 +2877,9 @@ static void dialogue_dump_settings(struct dialogue_block *dialogue)
 	debug_printf("Ignore ImageFS Contents: %s", config_return_opt_string(dialogue->ignore_imagefs));
 	debug_printf("Suppress Errors: %s", config_return_opt_string(dialogue->suppress_errors));
 	debug_printf("Display Full Info: %s", config_return_opt_string(dialogue->full_info));
+	debug_printf("Find Duplicates: %s", config_return_opt_string(dialogue->duplicates));
+	debug_printf("Use Index: %s", config_return_opt_string(dialogue->use_index));
+	debug_printf("Ignore List: '%s'", dialogue->ignore_list);
 }
 #endif
 
@@ -31,6 +31,7 @@
 #define LOCATE_DIALOGUE
 
 struct dialogue_block;
+struct search_block;
 
 #include "discfile.h"
 #include "file.h"
@@ -60,6 +61,105 @@ enum dialogue_file_action {
 	DIALOGUE_READ_DATA							/**< Read any required data from the open section.		*/
 };
 
+/**
+ * Filename comparison modes. The values are stored in saved searches.
+ */
+
+enum dialogue_name {
+	DIALOGUE_NAME_NOT_IMPORTANT = 0,					/**< The filename is not tested.				*/
+	DIALOGUE_NAME_EQUAL_TO,							/**< The filename matches one of the patterns.			*/
+	DIALOGUE_NAME_NOT_EQUAL_TO,						/**< The filename matches none of the patterns.			*/
+	DIALOGUE_NAME_CONTAINS,							/**< The filename contains one of the strings.			*/
+	DIALOGUE_NAME_DOES_NOT_CONTAIN,						/**< The filename contains none of the strings.			*/
+	DIALOGUE_NAME_MATCHES_REGEX,						/**< The filename matches the regular expression.		*/
+	DIALOGUE_NAME_DOES_NOT_MATCH_REGEX					/**< The filename does not match the regular expression.	*/
+};
+
+/**
+ * File size comparison modes. The values are stored in saved searches.
+ */
+
+enum dialogue_size {
+	DIALOGUE_SIZE_NOT_IMPORTANT = 0,					/**< The size is not tested.					*/
+	DIALOGUE_SIZE_EQUAL_TO,							/**< The size is equal to the minimum.				*/
+	DIALOGUE_SIZE_NOT_EQUAL_TO,						/**< The size is not equal to the minimum.			*/
+	DIALOGUE_SIZE_GREATER_THAN,						/**< The size is greater than the minimum.			*/
+	DIALOGUE_SIZE_LESS_THAN,						/**< The size is less than the minimum.				*/
+	DIALOGUE_SIZE_BETWEEN,							/**< The size is between the minimum and maximum.		*/
+	DIALOGUE_SIZE_NOT_BETWEEN						/**< The size is outside the minimum and maximum.		*/
+};
+
+/**
+ * File size units. The values are stored in saved searches.
+ */
+
+enum dialogue_size_unit {
+	DIALOGUE_SIZE_BYTES,							/**< Sizes in bytes.						*/
+	DIALOGUE_SIZE_KBYTES,							/**< Sizes in Kbytes.						*/
+	DIALOGUE_SIZE_MBYTES							/**< Sizes in Mbytes.						*/
+};
+
+/**
+ * Datestamp comparison modes. The values are stored in saved searches.
+ */
+
+enum dialogue_date {
+	DIALOGUE_DATE_AT_ANY_TIME = 0,						/**< The date is not tested.					*/
+	DIALOGUE_DATE_AT,							/**< The date is at the minimum.				*/
+	DIALOGUE_DATE_AT_ANY_TIME_BUT,						/**< The date is not at the minimum.				*/
+	DIALOGUE_DATE_AFTER,							/**< The date is after the minimum.				*/
+	DIALOGUE_DATE_BEFORE,							/**< The date is before the minimum.				*/
+	DIALOGUE_DATE_BETWEEN,							/**< The date is between the minimum and maximum.		*/
+	DIALOGUE_DATE_NOT_BETWEEN						/**< The date is outside the minimum and maximum.		*/
+};
+
+/**
+ * Age comparison modes. The values are stored in saved searches.
+ */
+
+enum dialogue_age {
+	DIALOGUE_AGE_ANY_AGE = 0,						/**< The age is not tested.					*/
+	DIALOGUE_AGE_EXACTLY,							/**< The age is equal to the minimum.				*/
+	DIALOGUE_AGE_ANY_AGE_BUT,						/**< The age is not equal to the minimum.			*/
+	DIALOGUE_AGE_LESS_THAN,							/**< The age is less than the minimum.				*/
+	DIALOGUE_AGE_MORE_THAN,							/**< The age is more than the minimum.				*/
+	DIALOGUE_AGE_BETWEEN,							/**< The age is between the minimum and maximum.		*/
+	DIALOGUE_AGE_NOT_BETWEEN						/**< The age is outside the minimum and maximum.		*/
+};
+
+/**
+ * Age units. The values are stored in saved searches.
+ */
+
+enum dialogue_age_unit {
+	DIALOGUE_AGE_MINUTES,							/**< Ages in minutes.						*/
+	DIALOGUE_AGE_HOURS,							/**< Ages in hours.						*/
+	DIALOGUE_AGE_DAYS,							/**< Ages in days.						*/
+	DIALOGUE_AGE_WEEKS,							/**< Ages in weeks.						*/
+	DIALOGUE_AGE_MONTHS,							/**< Ages in months.						*/
+	DIALOGUE_AGE_YEARS							/**< Ages in years.						*/
+};
+
+/**
+ * Filetype comparison modes. The values are stored in saved searches.
+ */
+
+enum dialogue_type {
+	DIALOGUE_TYPE_OF_ANY = 0,						/**< The filetype is not tested.				*/
+	DIALOGUE_TYPE_OF_TYPE,							/**< The filetype is one of those listed.			*/
+	DIALOGUE_TYPE_NOT_OF_TYPE						/**< The filetype is none of those listed.			*/
+};
+
+/**
+ * File contents comparison modes. The values are stored in saved searches.
+ */
+
+enum dialogue_contents {
+	DIALOGUE_CONTENTS_ARE_NOT_IMPORTANT = 0,				/**< The contents are not tested.				*/
+	DIALOGUE_CONTENTS_INCLUDE,						/**< The contents include the text.				*/
+	DIALOGUE_CONTENTS_DO_NOT_INCLUDE					/**< The contents do not include the text.			*/
+};
+
 /**
  * Initialise the Dialogue module.
  */
@@ -154,5 +254,16 @@ void dialogue_open_window(struct dialogue_block *dialogue, wimp_pointer *pointer
 
 osbool dialogue_window_is_open(void);
 
+
+/**
+ * Take a set of dialogue settings and apply them to a search, converting the
+ * details from the dialogue into the details used by the search routines.
+ *
+ * \param *dialogue		The dialogue settings to use.
+ * \param *search		The search to apply the settings to.
+ */
+
+void dialogue_set_search_options(struct dialogue_block *dialogue, struct search_block *search);
+
 #endif
 
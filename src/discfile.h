@@ -55,6 +55,8 @@ enum discfile_section_type {
 	DISCFILE_SECTION_RESULTS = 2,						/**< The section contains a results window definition.	*/
 	DISCFILE_SECTION_DIALOGUE = 3,						/**< The section contains dialogue settings.		*/
 	DISCFILE_SECTION_HOTLIST = 4,						/**< The section contains hotlist dialogue settings.	*/
+	DISCFILE_SECTION_INDEX = 5,						/**< The section contains a filename index.		*/
+	DISCFILE_SECTION_SEARCH = 6,						/**< The section contains the state of a paused search.	*/
 	DISCFILE_MAX_SECTIONS							/**< The maximum number of section types defined.	*/
 };
 
@@ -67,7 +69,9 @@ enum discfile_chunk_type {
 	DISCFILE_CHUNK_TEXTDUMP = 1,						/**< The chunk contains the contents of a textdump.	*/
 	DISCFILE_CHUNK_OBJECTS = 2,						/**< The chunk contains objects from an ObjectDB.	*/
 	DISCFILE_CHUNK_RESULTS = 3,						/**< The chunk contains entries from a results window.	*/
-	DISCFILE_CHUNK_OPTIONS = 4						/**< The chunk contains a series of option values.	*/
+	DISCFILE_CHUNK_OPTIONS = 4,						/**< The chunk contains a series of option values.	*/
+	DISCFILE_CHUNK_DIRECTORIES = 5,						/**< The chunk contains directories from an index.	*/
+	DISCFILE_CHUNK_STACK = 6						/**< The chunk contains the levels of a search stack.	*/
 };
 
 /**
@@ -0,0 +1,685 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: dupes.c
+ *
+ * Duplicate file detection.
+ */
+
+/* ANSI C Header files. */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Acorn C Header files. */
+
+#include "flex.h"
+
+/* OSLib Header files. */
+
+#include "oslib/os.h"
+#include "oslib/types.h"
+
+/* SF-Lib Header files. */
+
+#include "sflib/debug.h"
+#include "sflib/heap.h"
+
+/* Application header files. */
+
+#include "dupes.h"
+
+#include "flexutils.h"
+#include "fsys.h"
+#include "objdb.h"
+#include "quantum.h"
+#include "results.h"
+
+
+#define DUPES_ALLOC_CHUNK 256							/**< The minimum number of files to allocate at a time.		*/
+#define DUPES_HEAD_SIZE 4096							/**< The size of the first block hashed in every candidate.	*/
+#define DUPES_BUFFER_SIZE 32768							/**< The size of the buffer used to read the rest of a file.	*/
+#define DUPES_FILENAME_SIZE 256							/**< The space in bytes initially allocated to take filenames.	*/
+
+#define DUPES_HASH_BASIS 0xcbf29ce484222325ull					/**< The 64-bit FNV-1a offset basis.				*/
+#define DUPES_HASH_PRIME 0x100000001b3ull					/**< The 64-bit FNV-1a prime.					*/
+
+
+/**
+ * The stages of a duplicate file detection.
+ */
+
+enum dupes_stage {
+	DUPES_STAGE_SIZE,							/**< Files are being grouped by size.				*/
+	DUPES_STAGE_HEAD,							/**< The first block of each candidate is being hashed.		*/
+	DUPES_STAGE_TAIL,							/**< The rest of each remaining candidate is being hashed.	*/
+	DUPES_STAGE_REPORT,							/**< The sets of duplicates are being reported.			*/
+	DUPES_STAGE_COMPLETE							/**< The detection has finished.				*/
+};
+
+
+/**
+ * A file which is a candidate to be a duplicate.
+ */
+
+struct dupes_entry {
+	unsigned		key;						/**< The key of the file.					*/
+	int			size;						/**< The size held for the file.				*/
+	unsigned long long	hash;						/**< The hash of the part of the file read so far.		*/
+	osbool			failed;						/**< TRUE if the file couldn't be read, and must be dropped.	*/
+};
+
+
+/**
+ * A duplicate file detection.
+ */
+
+struct dupes_block {
+	struct objdb_block	*objects;					/**< The database holding the files.				*/
+	struct results_window	*results;					/**< The results window to report to.				*/
+
+	struct dupes_entry	*entries;					/**< The candidate files (flex block).				*/
+	unsigned		entry_count;					/**< The number of candidate files.				*/
+	unsigned		entry_allocation;				/**< The number of files for which space is allocated.		*/
+
+	enum dupes_stage	stage;						/**< The current stage of the detection.			*/
+	unsigned		next;						/**< The next candidate to be processed in the current stage.	*/
+
+	os_fw			file;						/**< The handle of the file being hashed, or 0 if none.		*/
+	int			offset;						/**< The offset of the next byte to be hashed in the file.	*/
+
+	char			*filename;					/**< The pathname of the file being hashed (heap block).	*/
+	size_t			filename_size;					/**< The space allocated to the pathname.			*/
+	byte			*buffer;					/**< The buffer used to read files (heap block).		*/
+
+	unsigned		files;						/**< The number of duplicate files reported.			*/
+	unsigned		sets;						/**< The number of sets of duplicates reported.			*/
+
+	struct quantum_block	quantum;					/**< The work quantum used to time the poll loop.		*/
+};
+
+
+/**
+ * Counters recording the amount of data read by the duplicate file
+ * detections.
+ */
+
+#ifdef DEBUG
+static unsigned		dupes_files_opened = 0;
+static unsigned		dupes_bytes_read = 0;
+#endif
+
+
+static void		dupes_sift(struct dupes_block *handle, osbool by_hash);
+static void		dupes_hash_head(struct dupes_block *handle);
+static void		dupes_hash_tail(struct dupes_block *handle);
+static void		dupes_report_set(struct dupes_block *handle);
+static osbool		dupes_open_file(struct dupes_block *handle, unsigned entry);
+static void		dupes_close_file(struct dupes_block *handle, unsigned entry);
+static osbool		dupes_read_file(struct dupes_block *handle, unsigned entry, int size);
+static osbool		dupes_same_group(struct dupes_entry *a, struct dupes_entry *b, osbool by_hash);
+static int		dupes_compare_sizes(const void *a, const void *b);
+static int		dupes_compare_hashes(const void *a, const void *b);
+
+
+/**
+ * Create a new duplicate file detection for an object database.
+ *
+ * \param *objects		The database holding the files to compare.
+ * \param *results		The results window to report the duplicates to.
+ * \return			The new detection handle, or NULL on failure.
+ */
+
+struct dupes_block *dupes_create(struct objdb_block *objects, struct results_window *results)
+{
+	struct dupes_block	*new;
+
+	if (objects == NULL)
+		return NULL;
+
+	new = heap_alloc(sizeof(struct dupes_block));
+	if (new == NULL)
+		return NULL;
+
+	new->objects = objects;
+	new->results = results;
+
+	new->entry_count = 0;
+	new->entry_allocation = 0;
+
+	new->stage = DUPES_STAGE_SIZE;
+	new->next = 0;
+
+	new->file = 0;
+	new->offset = 0;
+
+	new->files = 0;
+	new->sets = 0;
+
+	quantum_initialise(&(new->quantum));
+
+	if (flex_alloc((flex_ptr) &(new->entries), DUPES_ALLOC_CHUNK * sizeof(struct dupes_entry)) == 1)
+		new->entry_allocation = DUPES_ALLOC_CHUNK;
+	else
+		new->entries = NULL;
+
+	new->filename = heap_alloc(DUPES_FILENAME_SIZE);
+	new->filename_size = DUPES_FILENAME_SIZE;
+	new->buffer = heap_alloc(DUPES_BUFFER_SIZE);
+
+	if (new->entries == NULL || new->filename == NULL || new->buffer == NULL) {
+		dupes_destroy(new);
+		return NULL;
+	}
+
+	return new;
+}
+
+
+/**
+ * Destroy a duplicate file detection and free its memory.
+ *
+ * \param *handle		The detection to destroy.
+ */
+
+void dupes_destroy(struct dupes_block *handle)
+{
+	if (handle == NULL)
+		return;
+
+	if (handle->file != 0)
+		fsys_close(handle->file);
+
+	if (handle->entries != NULL)
+		flex_free((flex_ptr) &(handle->entries));
+
+	if (handle->filename != NULL)
+		heap_free(handle->filename);
+
+	if (handle->buffer != NULL)
+		heap_free(handle->buffer);
+
+	heap_free(handle);
+}
+
+
+/**
+ * Add a file to a duplicate file detection. Files can only be added before
+ * the first call to dupes_poll(); empty files are never reported, so are
+ * accepted and ignored.
+ *
+ * \param *handle		The detection to add the file to.
+ * \param key			The database key of the file.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+osbool dupes_add_key(struct dupes_block *handle, unsigned key)
+{
+	size_t		allocation;
+	int		size;
+
+	if (handle == NULL || handle->stage != DUPES_STAGE_SIZE || key == OBJDB_NULL_KEY)
+		return FALSE;
+
+	size = objdb_get_size(handle->objects, key);
+	if (size <= 0)
+		return TRUE;
+
+	if (handle->entry_count >= handle->entry_allocation) {
+		allocation = flexutils_grow_size(handle->entry_allocation, handle->entry_count + 1, DUPES_ALLOC_CHUNK);
+
+		if (!flexutils_resize((flex_ptr) &(handle->entries), allocation * sizeof(struct dupes_entry)))
+			return FALSE;
+
+		handle->entry_allocation = allocation;
+	}
+
+	handle->entries[handle->entry_count].key = key;
+	handle->entries[handle->entry_count].size = size;
+	handle->entries[handle->entry_count].hash = DUPES_HASH_BASIS;
+	handle->entries[handle->entry_count].failed = FALSE;
+	handle->entry_count++;
+
+	return TRUE;
+}
+
+
+/**
+ * Run a duplicate file detection until it completes or the time slice ends,
+ * adding each set of duplicates to the results window as it is confirmed.
+ *
+ * \param *handle		The detection to run.
+ * \param end_time		The time at which the slice should end.
+ * \return			TRUE if the detection has completed; else FALSE.
+ */
+
+osbool dupes_poll(struct dupes_block *handle, os_t end_time)
+{
+	if (handle == NULL)
+		return TRUE;
+
+	/* On the first pass, drop any files whose size isn't shared: these
+	 * can't have a duplicate, and don't need to be opened.
+	 */
+
+	if (handle->stage == DUPES_STAGE_SIZE) {
+		dupes_sift(handle, FALSE);
+		handle->stage = DUPES_STAGE_HEAD;
+		handle->next = 0;
+	}
+
+	quantum_start(&(handle->quantum), end_time);
+
+	while (!quantum_expired(&(handle->quantum), 0)) {
+		switch (handle->stage) {
+		case DUPES_STAGE_HEAD:
+			if (handle->next < handle->entry_count) {
+				dupes_hash_head(handle);
+				quantum_check(&(handle->quantum));
+				break;
+			}
+
+			dupes_sift(handle, TRUE);
+			handle->stage = DUPES_STAGE_TAIL;
+			handle->next = 0;
+			break;
+
+		case DUPES_STAGE_TAIL:
+			if (handle->next < handle->entry_count) {
+				dupes_hash_tail(handle);
+				quantum_check(&(handle->quantum));
+				break;
+			}
+
+			dupes_sift(handle, TRUE);
+			handle->stage = DUPES_STAGE_REPORT;
+			handle->next = 0;
+			break;
+
+		case DUPES_STAGE_REPORT:
+			if (handle->next < handle->entry_count) {
+				dupes_report_set(handle);
+				quantum_check(&(handle->quantum));
+				break;
+			}
+
+			handle->stage = DUPES_STAGE_COMPLETE;
+#ifdef DEBUG
+			debug_printf("Duplicate files: %u files opened, %u bytes read", dupes_files_opened, dupes_bytes_read);
+#endif
+			break;
+
+		case DUPES_STAGE_SIZE:
+		case DUPES_STAGE_COMPLETE:
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+
+/**
+ * Return details of the progress of a duplicate file detection.
+ *
+ * \param *handle		The detection of interest.
+ * \param *compared		Pointer to a variable to take the number of
+ *				files compared so far in the current stage,
+ *				or NULL.
+ * \param *total		Pointer to a variable to take the number of
+ *				files to be compared in the current stage,
+ *				or NULL.
+ * \param *files		Pointer to a variable to take the number of
+ *				duplicate files reported, or NULL.
+ * \param *sets			Pointer to a variable to take the number of
+ *				sets of duplicates reported, or NULL.
+ */
+
+void dupes_get_progress(struct dupes_block *handle, unsigned *compared, unsigned *total, unsigned *files, unsigned *sets)
+{
+	if (compared != NULL)
+		*compared = (handle != NULL) ? handle->next : 0;
+
+	if (total != NULL)
+		*total = (handle != NULL) ? handle->entry_count : 0;
+
+	if (files != NULL)
+		*files = (handle != NULL) ? handle->files : 0;
+
+	if (sets != NULL)
+		*sets = (handle != NULL) ? handle->sets : 0;
+}
+
+
+/**
+ * Sort the candidate files into groups, and remove any which can no longer
+ * be duplicates: those which couldn't be read, and those which are alone in
+ * their group.
+ *
+ * \param *handle		The detection to sift.
+ * \param by_hash		TRUE to group by size and hash; FALSE to group
+ *				by size alone.
+ */
+
+static void dupes_sift(struct dupes_block *handle, osbool by_hash)
+{
+	unsigned	from, to, end, i;
+
+	/* Remove any failed files first, so that they can't pair up. */
+
+	for (from = 0, to = 0; from < handle->entry_count; from++) {
+		if (!handle->entries[from].failed)
+			handle->entries[to++] = handle->entries[from];
+	}
+
+	handle->entry_count = to;
+
+	qsort(handle->entries, handle->entry_count, sizeof(struct dupes_entry), (by_hash) ? dupes_compare_hashes : dupes_compare_sizes);
+
+	/* Keep only those groups with more than one file in them. */
+
+	for (from = 0, to = 0; from < handle->entry_count; from = end) {
+		for (end = from + 1; end < handle->entry_count && dupes_same_group(handle->entries + from, handle->entries + end, by_hash); end++);
+
+		if (end - from < 2)
+			continue;
+
+		for (i = from; i < end; i++)
+			handle->entries[to++] = handle->entries[i];
+	}
+
+	handle->entry_count = to;
+}
+
+
+/**
+ * Hash the first block of the next candidate file. Files which fit into the
+ * block are then complete; the rest keep the hash to carry on from.
+ *
+ * \param *handle		The detection to process.
+ */
+
+static void dupes_hash_head(struct dupes_block *handle)
+{
+	unsigned	entry = handle->next++;
+	int		size;
+
+	if (!dupes_open_file(handle, entry))
+		return;
+
+	size = handle->entries[entry].size;
+	if (size > DUPES_HEAD_SIZE)
+		size = DUPES_HEAD_SIZE;
+
+	dupes_read_file(handle, entry, size);
+	dupes_close_file(handle, entry);
+}
+
+
+/**
+ * Hash the next part of the current candidate file, following on from the
+ * first block, and move on to the next candidate once it is complete. The
+ * file is left open between calls, so that large files can be read over
+ * several polls.
+ *
+ * \param *handle		The detection to process.
+ */
+
+static void dupes_hash_tail(struct dupes_block *handle)
+{
+	unsigned	entry = handle->next;
+	int		size;
+
+	/* Files which fitted into the first block are already complete. */
+
+	if (handle->file == 0) {
+		if (handle->entries[entry].size <= DUPES_HEAD_SIZE || !dupes_open_file(handle, entry)) {
+			handle->next++;
+			return;
+		}
+
+		handle->offset = DUPES_HEAD_SIZE;
+	}
+
+	size = handle->entries[entry].size - handle->offset;
+	if (size > DUPES_BUFFER_SIZE)
+		size = DUPES_BUFFER_SIZE;
+
+	if (!dupes_read_file(handle, entry, size) || handle->offset >= handle->entries[entry].size) {
+		dupes_close_file(handle, entry);
+		handle->next++;
+	}
+}
+
+
+/**
+ * Report the next set of duplicate files to the results window, with a
+ * heading line as the parent of the files in the set.
+ *
+ * \param *handle		The detection to process.
+ */
+
+static void dupes_report_set(struct dupes_block *handle)
+{
+	unsigned	end, i, line;
+
+	for (end = handle->next + 1; end < handle->entry_count &&
+			dupes_same_group(handle->entries + handle->next, handle->entries + end, TRUE); end++);
+
+	line = results_add_duplicates(handle->results, end - handle->next, handle->entries[handle->next].size);
+
+	for (i = handle->next; i < end; i++)
+		results_add_duplicate(handle->results, handle->entries[i].key, line);
+
+	handle->files += end - handle->next;
+	handle->sets++;
+
+	handle->next = end;
+}
+
+
+/**
+ * Open a candidate file, and check that its size still matches the size
+ * held in the database. On failure, the file is marked to be dropped.
+ *
+ * \param *handle		The detection to process.
+ * \param entry			The candidate to open.
+ * \return			TRUE if the file was opened; else FALSE.
+ */
+
+static osbool dupes_open_file(struct dupes_block *handle, unsigned entry)
+{
+	os_error	*error;
+	size_t		length;
+	char		*filename;
+	int		extent;
+
+	handle->entries[entry].failed = TRUE;
+
+	length = objdb_get_name_length(handle->objects, handle->entries[entry].key);
+	if (length == 0)
+		return FALSE;
+
+	if (length > handle->filename_size) {
+		filename = heap_extend(handle->filename, length);
+		if (filename == NULL)
+			return FALSE;
+
+		handle->filename = filename;
+		handle->filename_size = length;
+	}
+
+	if (!objdb_get_name(handle->objects, handle->entries[entry].key, handle->filename, handle->filename_size))
+		return FALSE;
+
+	error = fsys_open_in(handle->filename, &(handle->file));
+	if (error != NULL || handle->file == 0) {
+		handle->file = 0;
+		results_add_error(handle->results, (error != NULL) ? error->errmess : "Failed to open file", handle->entries[entry].key);
+		return FALSE;
+	}
+
+#ifdef DEBUG
+	dupes_files_opened++;
+#endif
+
+	error = fsys_read_extent(handle->file, &extent);
+	if (error != NULL || extent != handle->entries[entry].size) {
+		results_add_error(handle->results, (error != NULL) ? error->errmess : "File changed!", handle->entries[entry].key);
+		dupes_close_file(handle, entry);
+		return FALSE;
+	}
+
+	handle->entries[entry].failed = FALSE;
+	handle->offset = 0;
+
+	return TRUE;
+}
+
+
+/**
+ * Close the open candidate file, if there is one.
+ *
+ * \param *handle		The detection to process.
+ * \param entry			The candidate to which the file belongs.
+ */
+
+static void dupes_close_file(struct dupes_block *handle, unsigned entry)
+{
+	os_error	*error;
+
+	if (handle->file == 0)
+		return;
+
+	error = fsys_close(handle->file);
+	if (error != NULL)
+		results_add_error(handle->results, error->errmess, handle->entries[entry].key);
+
+	handle->file = 0;
+}
+
+
+/**
+ * Read the next block of data from the open candidate file, and add it to
+ * the file's hash. On failure, the file is marked to be dropped.
+ *
+ * \param *handle		The detection to process.
+ * \param entry			The candidate to which the file belongs.
+ * \param size			The number of bytes to read.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+static osbool dupes_read_file(struct dupes_block *handle, unsigned entry, int size)
+{
+	os_error		*error;
+	unsigned long long	hash;
+	int			unread, i;
+
+	error = fsys_read_at(handle->file, handle->buffer, size, handle->offset, &unread);
+	if (error != NULL || unread != 0) {
+		results_add_error(handle->results, (error != NULL) ? error->errmess : "Error reading from file", handle->entries[entry].key);
+		handle->entries[entry].failed = TRUE;
+		return FALSE;
+	}
+
+#ifdef DEBUG
+	dupes_bytes_read += size;
+#endif
+
+	hash = handle->entries[entry].hash;
+
+	for (i = 0; i < size; i++)
+		hash = (hash ^ handle->buffer[i]) * DUPES_HASH_PRIME;
+
+	handle->entries[entry].hash = hash;
+	handle->offset += size;
+
+	return TRUE;
+}
+
+
+/**
+ * Test whether two candidates fall into the same group.
+ *
+ * \param *a			The first candidate to test.
+ * \param *b			The second candidate to test.
+ * \param by_hash		TRUE to group by size and hash; FALSE to group
+ *				by size alone.
+ * \return			TRUE if the candidates are in the same group;
+ *				else FALSE.
+ */
+
+static osbool dupes_same_group(struct dupes_entry *a, struct dupes_entry *b, osbool by_hash)
+{
+	return (a->size == b->size && (!by_hash || a->hash == b->hash)) ? TRUE : FALSE;
+}
+
+
+/**
+ * Compare two candidates by size and then key, for qsort().
+ *
+ * \param *a			The first candidate to compare.
+ * \param *b			The second candidate to compare.
+ * \return			The result of the comparison.
+ */
+
+static int dupes_compare_sizes(const void *a, const void *b)
+{
+	const struct dupes_entry	*x = a, *y = b;
+
+	if (x->size != y->size)
+		return (x->size < y->size) ? -1 : 1;
+
+	if (x->key != y->key)
+		return (x->key < y->key) ? -1 : 1;
+
+	return 0;
+}
+
+
+/**
+ * Compare two candidates by size, hash and then key, for qsort().
+ *
+ * \param *a			The first candidate to compare.
+ * \param *b			The second candidate to compare.
+ * \return			The result of the comparison.
+ */
+
+static int dupes_compare_hashes(const void *a, const void *b)
+{
+	const struct dupes_entry	*x = a, *y = b;
+
+	if (x->size != y->size)
+		return (x->size < y->size) ? -1 : 1;
+
+	if (x->hash != y->hash)
+		return (x->hash < y->hash) ? -1 : 1;
+
+	if (x->key != y->key)
+		return (x->key < y->key) ? -1 : 1;
+
+	return 0;
+}
+
@@ -0,0 +1,118 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: dupes.h
+ *
+ * Duplicate file detection.
+ *
+ * Files are first grouped by the size held for them in the object database,
+ * and any with a size shared by no other file are dropped without being
+ * opened. The remaining files have their first block hashed, and those whose
+ * hash is unique are dropped in turn; only files which still have a match
+ * are read to the end. The hash of the first block is carried on over the
+ * rest of the file, so no part of a file is read more than once. Files are
+ * reported as duplicates when their sizes and 64-bit FNV-1a hashes match:
+ * the contents are never compared directly, so a hash collision would put
+ * two different files in a set. The work is done in time slices, so that it
+ * can run from the Wimp's null polls.
+ */
+
+#ifndef LOCATE_DUPES
+#define LOCATE_DUPES
+
+#include "oslib/os.h"
+#include "oslib/types.h"
+
+#include "objdb.h"
+#include "results.h"
+
+
+struct dupes_block;
+
+
+/**
+ * Create a new duplicate file detection for an object database.
+ *
+ * \param *objects		The database holding the files to compare.
+ * \param *results		The results window to report the duplicates to.
+ * \return			The new detection handle, or NULL on failure.
+ */
+
+struct dupes_block *dupes_create(struct objdb_block *objects, struct results_window *results);
+
+
+/**
+ * Destroy a duplicate file detection and free its memory.
+ *
+ * \param *handle		The detection to destroy.
+ */
+
+void dupes_destroy(struct dupes_block *handle);
+
+
+/**
+ * Add a file to a duplicate file detection. Files can only be added before
+ * the first call to dupes_poll(); empty files are never reported, so are
+ * accepted and ignored.
+ *
+ * \param *handle		The detection to add the file to.
+ * \param key			The database key of the file.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+osbool dupes_add_key(struct dupes_block *handle, unsigned key);
+
+
+/**
+ * Run a duplicate file detection until it completes or the time slice ends,
+ * adding each set of duplicates to the results window as it is confirmed.
+ *
+ * \param *handle		The detection to run.
+ * \param end_time		The time at which the slice should end.
+ * \return			TRUE if the detection has completed; else FALSE.
+ */
+
+osbool dupes_poll(struct dupes_block *handle, os_t end_time);
+
+
+/**
+ * Return details of the progress of a duplicate file detection.
+ *
+ * \param *handle		The detection of interest.
+ * \param *compared		Pointer to a variable to take the number of
+ *				files compared so far in the current stage,
+ *				or NULL.
+ * \param *total		Pointer to a variable to take the number of
+ *				files to be compared in the current stage,
+ *				or NULL.
+ * \param *files		Pointer to a variable to take the number of
+ *				duplicate files reported, or NULL.
+ * \param *sets			Pointer to a variable to take the number of
+ *				sets of duplicates reported, or NULL.
+ */
+
+void dupes_get_progress(struct dupes_block *handle, unsigned *compared, unsigned *total, unsigned *files, unsigned *sets);
+
+#endif
+
@@ -250,6 +250,8 @@ struct search_block *file_create_search(struct file_block *file, char *paths)
 		return NULL;
 	}
 
+	results_set_foreground(file->results);
+
 	return file->search;
 }
 
@@ -293,6 +295,23 @@ void file_create_from_saved(char *filename)
 	if (new->dialogue != NULL)
 		dialogue_add_client(new->dialogue, DIALOGUE_CLIENT_FILE);
 
+	/* If a search was saved part of the way through, set it up again from
+	 * the search settings and restore its position.
+	 */
+
+	if (new->results != NULL && new->dialogue != NULL && search_check_file(load)) {
+		new->search = search_create(new, new->objects, new->results, "");
+
+		if (new->search != NULL) {
+			dialogue_set_search_options(new->dialogue, new->search);
+
+			if (!search_load_file(new->search, load)) {
+				search_destroy(new->search);
+				new->search = NULL;
+			}
+		}
+	}
+
 	hourglass_off();
 
 	/* If an error is raised when the file closes, or none of the items
@@ -305,6 +324,13 @@ void file_create_from_saved(char *filename)
 		return;
 	}
 
+	/* Set any restored search running again. */
+
+	if (new->search != NULL) {
+		results_set_foreground(new->results);
+		search_resume(new->search);
+	}
+
 	/* If there were no results to display, then open a search dialogue. */
 
 	if (new->results == NULL) {
@@ -353,6 +379,7 @@ osbool file_full_save(struct file_block *block, char *filename)
 	objdb_save_file(block->objects, out);
 	results_save_file(block->results, out);
 	dialogue_save_file(block->dialogue, out, NULL, NULL);
+	search_save_file(block->search, out);
 
 	hourglass_off();
 
@@ -508,3 +535,55 @@ void file_stop_search(struct file_block *file)
 		search_stop(file->search);
 }
 
+
+/**
+ * Identify whether a file has an active search which is paused.
+ *
+ * \param *file			The file to be tested.
+ * \return			TRUE if it has a paused search; else FALSE.
+ */
+
+osbool file_search_paused(struct file_block *file)
+{
+	if (file == NULL)
+		return FALSE;
+
+	return search_is_paused(file->search);
+}
+
+
+/**
+ * Set whether the search associated with a file is in the foreground, so that
+ * it takes a larger share of the time available to searches.
+ *
+ * \param *file			The file to be updated.
+ * \param foreground		TRUE if the search is in the foreground; else FALSE.
+ */
+
+void file_set_search_foreground(struct file_block *file, osbool foreground)
+{
+	if (file == NULL || file->search == NULL)
+		return;
+
+	search_set_priority(file->search, (foreground) ? SEARCH_PRIORITY_FOREGROUND : SEARCH_PRIORITY_NORMAL);
+}
+
+
+/**
+ * Pause or resume any active search associated with a file.
+ *
+ * \param *file			The file to be updated.
+ * \param pause			TRUE to pause the search; FALSE to resume it.
+ */
+
+void file_pause_search(struct file_block *file, osbool pause)
+{
+	if (file == NULL || file->search == NULL)
+		return;
+
+	if (pause)
+		search_pause(file->search);
+	else
+		search_resume(file->search);
+}
+
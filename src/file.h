@@ -170,5 +170,36 @@ struct dialogue_block *file_get_dialogue(struct file_block *file);
 
 void file_stop_search(struct file_block *file);
 
+
+/**
+ * Identify whether a file has an active search which is paused.
+ *
+ * \param *file			The file to be tested.
+ * \return			TRUE if it has a paused search; else FALSE.
+ */
+
+osbool file_search_paused(struct file_block *file);
+
+
+/**
+ * Set whether the search associated with a file is in the foreground, so that
+ * it takes a larger share of the time available to searches.
+ *
+ * \param *file			The file to be updated.
+ * \param foreground		TRUE if the search is in the foreground; else FALSE.
+ */
+
+void file_set_search_foreground(struct file_block *file, osbool foreground);
+
+
+/**
+ * Pause or resume any active search associated with a file.
+ *
+ * \param *file			The file to be updated.
+ * \param pause			TRUE to pause the search; FALSE to resume it.
+ */
+
+void file_pause_search(struct file_block *file, osbool pause);
+
 #endif
 
@@ -50,6 +50,15 @@
 #include "flexutils.h"
 
 
+/**
+ * Counters recording the number of flex blocks resized via flexutils_resize(),
+ * and the number of bytes that those blocks held at the time.
+ */
+
+static unsigned			flexutils_resizes = 0;
+static unsigned			flexutils_resize_bytes = 0;
+
+
 /**
  * Store a string in an already-created flex block.
  *
@@ -77,3 +86,72 @@ osbool flexutils_store_string(flex_ptr ptr, char *text)
 	return TRUE;
 }
 
+
+/**
+ * Calculate the size to which a flex block should be extended in order to
+ * hold a given number of units. Blocks grow by half of their current size,
+ * so that a steady stream of additions only rarely needs to resize them.
+ *
+ * \param current	The current size of the block, in units.
+ * \param required	The number of units which the block must hold.
+ * \param minimum	The smallest step by which the block should grow.
+ * \return		The new size for the block, in units.
+ */
+
+size_t flexutils_grow_size(size_t current, size_t required, size_t minimum)
+{
+	size_t step;
+
+	step = current / 2;
+
+	if (step < minimum)
+		step = minimum;
+
+	return (current + step < required) ? required : current + step;
+}
+
+
+/**
+ * Change the size of a flex block, keeping count of the number of resize
+ * operations and the amount of data held in the blocks concerned.
+ *
+ * \param ptr		The flex block to resize.
+ * \param size		The new size of the block, in bytes.
+ * \return		TRUE if successful; else FALSE.
+ */
+
+osbool flexutils_resize(flex_ptr ptr, size_t size)
+{
+	int old;
+
+	old = flex_size(ptr);
+
+	if (flex_extend(ptr, size) == 0)
+		return FALSE;
+
+	flexutils_resizes++;
+	flexutils_resize_bytes += (old < size) ? old : size;
+
+	return TRUE;
+}
+
+
+/**
+ * Return the number of flex block resizes performed via flexutils_resize(),
+ * and the total number of bytes held in the blocks at the time.
+ *
+ * \param *resizes	Pointer to a variable to take the resize count,
+ *			or NULL.
+ * \param *bytes	Pointer to a variable to take the byte count, or
+ *			NULL.
+ */
+
+void flexutils_get_resize_counts(unsigned *resizes, unsigned *bytes)
+{
+	if (resizes != NULL)
+		*resizes = flexutils_resizes;
+
+	if (bytes != NULL)
+		*bytes = flexutils_resize_bytes;
+}
+
@@ -30,6 +30,7 @@
 #ifndef LOCATE_FLEXUTILS
 #define LOCATE_FLEXUTILS
 
+#include <stddef.h>
 #include "oslib/types.h"
 #include "flex.h"
 
@@ -44,5 +45,44 @@
 
 osbool flexutils_store_string(flex_ptr ptr, char *text);
 
+
+/**
+ * Calculate the size to which a flex block should be extended in order to
+ * hold a given number of units. Blocks grow by half of their current size,
+ * so that a steady stream of additions only rarely needs to resize them.
+ *
+ * \param current	The current size of the block, in units.
+ * \param required	The number of units which the block must hold.
+ * \param minimum	The smallest step by which the block should grow.
+ * \return		The new size for the block, in units.
+ */
+
+size_t flexutils_grow_size(size_t current, size_t required, size_t minimum);
+
+
+/**
+ * Change the size of a flex block, keeping count of the number of resize
+ * operations and the amount of data held in the blocks concerned.
+ *
+ * \param ptr		The flex block to resize.
+ * \param size		The new size of the block, in bytes.
+ * \return		TRUE if successful; else FALSE.
+ */
+
+osbool flexutils_resize(flex_ptr ptr, size_t size);
+
+
+/**
+ * Return the number of flex block resizes performed via flexutils_resize(),
+ * and the total number of bytes held in the blocks at the time.
+ *
+ * \param *resizes	Pointer to a variable to take the resize count,
+ *			or NULL.
+ * \param *bytes	Pointer to a variable to take the byte count, or
+ *			NULL.
+ */
+
+void flexutils_get_resize_counts(unsigned *resizes, unsigned *bytes);
+
 #endif
 
@@ -0,0 +1,154 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: fsys.h
+ *
+ * Filing system access, used by the search engine to enumerate directories,
+ * read object details and load file contents. The RISC OS implementation is
+ * in fsys.c; fsys_posix.c maps the same calls on to a POSIX host, so that
+ * the engine can be built and benchmarked off-target.
+ */
+
+#ifndef LOCATE_FSYS
+#define LOCATE_FSYS
+
+#include "oslib/types.h"
+#include "oslib/os.h"
+#include "oslib/fileswitch.h"
+#include "oslib/osgbpb.h"
+
+
+/**
+ * Counts of the work done through the filing system layer, used to measure
+ * the I/O performed by searches.
+ */
+
+struct fsys_counts {
+	unsigned		directories;					/**< The number of directory listings started.			*/
+	unsigned		entries;					/**< The number of directory entries returned.			*/
+	unsigned		files;						/**< The number of files opened.				*/
+	unsigned long long	bytes;						/**< The number of bytes read from files.			*/
+};
+
+
+/**
+ * Read a block of entries from a directory, in the format returned by
+ * OS_GBPB 10. All entries are returned; no wildcard is applied.
+ *
+ * \param *path			The pathname of the directory to read.
+ * \param *buffer		Pointer to a buffer to take the entries.
+ * \param count			The maximum number of entries to read.
+ * \param context		The context to start reading from: 0 to
+ *				start at the beginning of the directory.
+ * \param size			The size of the buffer, in bytes.
+ * \param *read			Pointer to a variable to take the number
+ *				of entries read.
+ * \param *next			Pointer to a variable to take the context
+ *				for the next read, or -1 if the directory
+ *				has been completed.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_read_dir(char *path, osgbpb_info_list *buffer, int count, int context, int size, int *read, int *next);
+
+
+/**
+ * Read the catalogue information for an object, in the manner of
+ * OS_File 17. If the object doesn't exist, no error is returned and
+ * the type is set to fileswitch_NOT_FOUND.
+ *
+ * \param *path			The pathname of the object to read.
+ * \param *type			Pointer to a variable to take the object type.
+ * \param *load_addr		Pointer to a variable to take the load address,
+ *				or NULL.
+ * \param *exec_addr		Pointer to a variable to take the exec address,
+ *				or NULL.
+ * \param *size			Pointer to a variable to take the size, or NULL.
+ * \param *attr			Pointer to a variable to take the attributes,
+ *				or NULL.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_read_object(char *path, fileswitch_object_type *type, bits *load_addr, bits *exec_addr, int *size, fileswitch_attr *attr);
+
+
+/**
+ * Open a file for reading. Directories are treated as an error.
+ *
+ * \param *filename		The pathname of the file to open.
+ * \param *file			Pointer to a variable to take the file handle,
+ *				which will be zero if the file wasn't found.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_open_in(char *filename, os_fw *file);
+
+
+/**
+ * Close a file opened by fsys_open_in().
+ *
+ * \param file			The handle of the file to close.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_close(os_fw file);
+
+
+/**
+ * Read the extent of an open file.
+ *
+ * \param file			The handle of the file to read.
+ * \param *extent		Pointer to a variable to take the extent.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_read_extent(os_fw file, int *extent);
+
+
+/**
+ * Read a block of data from a given position in an open file.
+ *
+ * \param file			The handle of the file to read.
+ * \param *buffer		Pointer to a buffer to take the data.
+ * \param size			The number of bytes to read.
+ * \param offset		The file offset to read from.
+ * \param *unread		Pointer to a variable to take the number of
+ *				bytes which could not be read.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_read_at(os_fw file, byte *buffer, int size, int offset, int *unread);
+
+
+/**
+ * Read the counts of work done through the filing system layer since the
+ * program started.
+ *
+ * \param *counts		Pointer to a block to take the counts.
+ */
+
+void fsys_get_counts(struct fsys_counts *counts);
+
+#endif
+
@@ -0,0 +1,717 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: fsys_posix.c
+ *
+ * Filing system access, POSIX implementation for host builds.
+ *
+ * RISC OS pathnames are mapped on to the host by swapping '.' and '/', with
+ * a leading '$' standing for the host root and '@' for the current directory.
+ * Filetypes are taken from a ",xxx" suffix on the host leafname, in the
+ * manner of the GCCSDK and NFS; files without a suffix are treated as Text.
+ * Datestamps are converted from Unix time into centiseconds since 1900, and
+ * placed in the load and exec addresses as RISC OS would.
+ */
+
+/* ANSI C header files */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* POSIX header files */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* OSLib header files */
+
+#include "oslib/os.h"
+#include "oslib/fileswitch.h"
+#include "oslib/osgbpb.h"
+#include "oslib/types.h"
+
+/* Application header files */
+
+#include "fsys.h"
+
+
+#define FSYS_PATH_SIZE 4096							/**< The size of buffers used to hold host pathnames.			*/
+#define FSYS_DIR_CACHE 16							/**< The number of directory listings held in the cache.		*/
+#define FSYS_DEFAULT_TYPE 0xfffu						/**< The filetype given to host files without a suffix.		*/
+#define FSYS_UNIX_EPOCH 0x336e996a00ull						/**< The Unix epoch, in centiseconds since 1900.			*/
+
+
+/**
+ * A cached directory listing. The walker returns to a parent directory
+ * after searching each child, so listings are kept between calls rather
+ * than being read and sorted again for every block of entries.
+ */
+
+struct fsys_listing {
+	char			*path;						/**< The host pathname of the directory, or NULL if unused.	*/
+	char			**names;					/**< The sorted host leafnames in the directory.		*/
+	int			count;						/**< The number of names in the listing.			*/
+	unsigned		last_used;					/**< The cache clock when the listing was last used.		*/
+};
+
+
+static struct fsys_listing	fsys_cache[FSYS_DIR_CACHE];			/**< The directory listing cache.				*/
+static unsigned			fsys_cache_clock = 0;				/**< The clock used to find the least recently used listing.	*/
+
+static os_error			fsys_error_block;				/**< The block used to return errors.				*/
+
+static struct fsys_counts	fsys_counts = {0, 0, 0, 0};			/**< The work done through the filing system layer.		*/
+
+
+static osbool			fsys_host_path(char *path, char *buffer, size_t size);
+static osbool			fsys_resolve_path(char *path, char *buffer, size_t size);
+static struct fsys_listing	*fsys_get_listing(char *path, osbool reload);
+static void			fsys_free_listing(struct fsys_listing *listing);
+static int			fsys_compare_names(const void *a, const void *b);
+static int			fsys_split_leafname(char *leafname, char *buffer, size_t size, unsigned *type);
+static void			fsys_convert_stat(struct stat *info, unsigned type, bits *load_addr, bits *exec_addr, int *size,
+						fileswitch_attr *attr, fileswitch_object_type *obj_type);
+static os_error			*fsys_host_error(char *path);
+
+
+/**
+ * Read a block of entries from a directory, in the format returned by
+ * OS_GBPB 10. All entries are returned; no wildcard is applied.
+ *
+ * \param *path			The pathname of the directory to read.
+ * \param *buffer		Pointer to a buffer to take the entries.
+ * \param count			The maximum number of entries to read.
+ * \param context		The context to start reading from: 0 to
+ *				start at the beginning of the directory.
+ * \param size			The size of the buffer, in bytes.
+ * \param *read			Pointer to a variable to take the number
+ *				of entries read.
+ * \param *next			Pointer to a variable to take the context
+ *				for the next read, or -1 if the directory
+ *				has been completed.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_read_dir(char *path, osgbpb_info_list *buffer, int count, int context, int size, int *read, int *next)
+{
+	struct fsys_listing	*listing;
+	osgbpb_info		*info;
+	struct stat		host_info;
+	char			host_path[FSYS_PATH_SIZE], *leaf;
+	int			entry, offset, length, entries;
+	unsigned		type;
+
+	if (read != NULL)
+		*read = 0;
+
+	if (next != NULL)
+		*next = -1;
+
+	if (context < 0)
+		return NULL;
+
+	if (!fsys_host_path(path, host_path, FSYS_PATH_SIZE)) {
+		errno = ENAMETOOLONG;
+		return fsys_host_error(path);
+	}
+
+	if (context == 0)
+		fsys_counts.directories++;
+
+	listing = fsys_get_listing(host_path, context == 0);
+	if (listing == NULL)
+		return fsys_host_error(path);
+
+	/* Copy as many entries as will fit into the buffer, building each
+	 * one's host pathname in the tail of host_path.
+	 */
+
+	length = strlen(host_path);
+	if (length + 1 >= FSYS_PATH_SIZE) {
+		errno = ENAMETOOLONG;
+		return fsys_host_error(path);
+	}
+
+	host_path[length++] = '/';
+	leaf = host_path + length;
+
+	offset = 0;
+	entries = 0;
+
+	for (entry = context; entry < listing->count && entries < count; entry++) {
+		info = (osgbpb_info *) ((byte *) buffer + offset);
+
+		if (offset + offsetof(osgbpb_info, name) > size)
+			break;
+
+		if (fsys_split_leafname(listing->names[entry], info->name, size - offset - offsetof(osgbpb_info, name), &type) == 0)
+			break;
+
+		if (length + strlen(listing->names[entry]) >= FSYS_PATH_SIZE)
+			continue;
+
+		strcpy(leaf, listing->names[entry]);
+
+		/* Objects which vanish between the listing and the stat are
+		 * skipped, as they would have been on RISC OS.
+		 */
+
+		if (stat(host_path, &host_info) != 0)
+			continue;
+
+		fsys_convert_stat(&host_info, type, &(info->load_addr), &(info->exec_addr), &(info->size), &(info->attr), &(info->obj_type));
+
+		offset += (offsetof(osgbpb_info, name) + strlen(info->name) + 4) & ~3;
+		entries++;
+	}
+
+	fsys_counts.entries += entries;
+
+	if (read != NULL)
+		*read = entries;
+
+	if (next != NULL)
+		*next = (entry < listing->count) ? entry : -1;
+
+	return NULL;
+}
+
+
+/**
+ * Read the catalogue information for an object, in the manner of
+ * OS_File 17. If the object doesn't exist, no error is returned and
+ * the type is set to fileswitch_NOT_FOUND.
+ *
+ * \param *path			The pathname of the object to read.
+ * \param *type			Pointer to a variable to take the object type.
+ * \param *load_addr		Pointer to a variable to take the load address,
+ *				or NULL.
+ * \param *exec_addr		Pointer to a variable to take the exec address,
+ *				or NULL.
+ * \param *size			Pointer to a variable to take the size, or NULL.
+ * \param *attr			Pointer to a variable to take the attributes,
+ *				or NULL.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_read_object(char *path, fileswitch_object_type *type, bits *load_addr, bits *exec_addr, int *size, fileswitch_attr *attr)
+{
+	struct stat	host_info;
+	char		host_path[FSYS_PATH_SIZE], leafname[FSYS_PATH_SIZE], *leaf;
+	unsigned	filetype;
+
+	if (type != NULL)
+		*type = fileswitch_NOT_FOUND;
+
+	if (!fsys_resolve_path(path, host_path, FSYS_PATH_SIZE))
+		return NULL;
+
+	if (stat(host_path, &host_info) != 0)
+		return (errno == ENOENT || errno == ENOTDIR) ? NULL : fsys_host_error(path);
+
+	leaf = strrchr(host_path, '/');
+	fsys_split_leafname((leaf != NULL) ? leaf + 1 : host_path, leafname, FSYS_PATH_SIZE, &filetype);
+
+	fsys_convert_stat(&host_info, filetype, load_addr, exec_addr, size, attr, type);
+
+	return NULL;
+}
+
+
+/**
+ * Open a file for reading. Directories are treated as an error.
+ *
+ * \param *filename		The pathname of the file to open.
+ * \param *file			Pointer to a variable to take the file handle,
+ *				which will be zero if the file wasn't found.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_open_in(char *filename, os_fw *file)
+{
+	struct stat	host_info;
+	char		host_path[FSYS_PATH_SIZE];
+	int		handle;
+
+	*file = 0;
+
+	if (!fsys_resolve_path(filename, host_path, FSYS_PATH_SIZE)) {
+		errno = ENAMETOOLONG;
+		return fsys_host_error(filename);
+	}
+
+	handle = open(host_path, O_RDONLY);
+	if (handle < 0)
+		return fsys_host_error(filename);
+
+	if (fstat(handle, &host_info) != 0 || S_ISDIR(host_info.st_mode)) {
+		close(handle);
+		errno = EISDIR;
+		return fsys_host_error(filename);
+	}
+
+	*file = (os_fw) handle;
+	fsys_counts.files++;
+
+	return NULL;
+}
+
+
+/**
+ * Close a file opened by fsys_open_in().
+ *
+ * \param file			The handle of the file to close.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_close(os_fw file)
+{
+	if (close((int) file) != 0)
+		return fsys_host_error(NULL);
+
+	return NULL;
+}
+
+
+/**
+ * Read the extent of an open file.
+ *
+ * \param file			The handle of the file to read.
+ * \param *extent		Pointer to a variable to take the extent.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_read_extent(os_fw file, int *extent)
+{
+	struct stat	host_info;
+
+	if (fstat((int) file, &host_info) != 0)
+		return fsys_host_error(NULL);
+
+	*extent = host_info.st_size;
+
+	return NULL;
+}
+
+
+/**
+ * Read a block of data from a given position in an open file.
+ *
+ * \param file			The handle of the file to read.
+ * \param *buffer		Pointer to a buffer to take the data.
+ * \param size			The number of bytes to read.
+ * \param offset		The file offset to read from.
+ * \param *unread		Pointer to a variable to take the number of
+ *				bytes which could not be read.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *fsys_read_at(os_fw file, byte *buffer, int size, int offset, int *unread)
+{
+	ssize_t	bytes;
+	int	total = 0;
+
+	while (total < size) {
+		bytes = pread((int) file, buffer + total, size - total, offset + total);
+		if (bytes < 0 && errno == EINTR)
+			continue;
+		if (bytes < 0)
+			return fsys_host_error(NULL);
+		if (bytes == 0)
+			break;
+
+		total += bytes;
+	}
+
+	fsys_counts.bytes += total;
+
+	if (unread != NULL)
+		*unread = size - total;
+
+	return NULL;
+}
+
+
+/**
+ * Read the counts of work done through the filing system layer since the
+ * program started.
+ *
+ * \param *counts		Pointer to a block to take the counts.
+ */
+
+void fsys_get_counts(struct fsys_counts *counts)
+{
+	if (counts != NULL)
+		*counts = fsys_counts;
+}
+
+
+/**
+ * Convert a RISC OS pathname into a host pathname, swapping the '.' and '/'
+ * characters and mapping a leading '$' on to the host root and a leading '@'
+ * on to the current directory.
+ *
+ * \param *path			The RISC OS pathname to convert.
+ * \param *buffer		Pointer to a buffer to take the host pathname.
+ * \param size			The size of the buffer.
+ * \return			TRUE if successful; FALSE if the buffer was
+ *				too short.
+ */
+
+static osbool fsys_host_path(char *path, char *buffer, size_t size)
+{
+	size_t	out = 0;
+
+	if (path == NULL || size == 0)
+		return FALSE;
+
+	if (path[0] == '$') {
+		path++;
+		if (*path == '.')
+			path++;
+
+		if (out + 1 >= size)
+			return FALSE;
+
+		buffer[out++] = '/';
+	} else if (path[0] == '@') {
+		path++;
+		if (*path == '.')
+			path++;
+	}
+
+	while (*path != '\0') {
+		if (out + 1 >= size)
+			return FALSE;
+
+		if (*path == '.')
+			buffer[out++] = '/';
+		else if (*path == '/')
+			buffer[out++] = '.';
+		else
+			buffer[out++] = *path;
+
+		path++;
+	}
+
+	if (out == 0)
+		buffer[out++] = '.';
+
+	buffer[out] = '\0';
+
+	return TRUE;
+}
+
+
+/**
+ * Convert a RISC OS pathname into a host pathname and, if there's no object
+ * at the location, look in the parent directory for a leafname carrying a
+ * ",xxx" filetype suffix that would match.
+ *
+ * \param *path			The RISC OS pathname to convert.
+ * \param *buffer		Pointer to a buffer to take the host pathname.
+ * \param size			The size of the buffer.
+ * \return			TRUE if successful; FALSE if the buffer was
+ *				too short.
+ */
+
+static osbool fsys_resolve_path(char *path, char *buffer, size_t size)
+{
+	struct fsys_listing	*listing;
+	struct stat		host_info;
+	char			*leaf, name[FSYS_PATH_SIZE];
+	size_t			length;
+	int			entry;
+	unsigned		type;
+
+	if (!fsys_host_path(path, buffer, size))
+		return FALSE;
+
+	if (lstat(buffer, &host_info) == 0 || errno != ENOENT)
+		return TRUE;
+
+	leaf = strrchr(buffer, '/');
+	if (leaf == NULL || leaf == buffer)
+		return TRUE;
+
+	*leaf++ = '\0';
+	length = strlen(leaf);
+
+	listing = fsys_get_listing(buffer, FALSE);
+
+	for (entry = 0; listing != NULL && entry < listing->count; entry++) {
+		if (strncmp(listing->names[entry], leaf, length) != 0 || listing->names[entry][length] != ',')
+			continue;
+
+		if (fsys_split_leafname(listing->names[entry], name, FSYS_PATH_SIZE, &type) != 0 &&
+				strlen(name) == length && (leaf - buffer) + strlen(listing->names[entry]) < size) {
+			strcpy(leaf, listing->names[entry]);
+			break;
+		}
+	}
+
+	*(leaf - 1) = '/';
+
+	return TRUE;
+}
+
+
+/**
+ * Find the listing for a directory in the cache, reading it in if it
+ * isn't present.
+ *
+ * \param *path			The host pathname of the directory.
+ * \param reload		TRUE to re-read a cached listing; FALSE to
+ *				use any cached copy.
+ * \return			Pointer to the listing, or NULL on failure.
+ */
+
+static struct fsys_listing *fsys_get_listing(char *path, osbool reload)
+{
+	struct fsys_listing	*listing = NULL;
+	DIR			*dir;
+	struct dirent		*entry;
+	char			**names;
+	int			i, count, allocated;
+
+	for (i = 0; i < FSYS_DIR_CACHE; i++) {
+		if (fsys_cache[i].path != NULL && strcmp(fsys_cache[i].path, path) == 0) {
+			listing = fsys_cache + i;
+			break;
+		}
+
+		if (listing == NULL || fsys_cache[i].path == NULL ||
+				(listing->path != NULL && fsys_cache[i].last_used < listing->last_used))
+			listing = fsys_cache + i;
+	}
+
+	if (listing->path != NULL && strcmp(listing->path, path) == 0 && !reload) {
+		listing->last_used = ++fsys_cache_clock;
+		return listing;
+	}
+
+	fsys_free_listing(listing);
+
+	dir = opendir(path);
+	if (dir == NULL)
+		return NULL;
+
+	names = NULL;
+	count = 0;
+	allocated = 0;
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+			continue;
+
+		if (count >= allocated) {
+			char **extended;
+
+			allocated = (allocated == 0) ? 64 : allocated * 2;
+			extended = realloc(names, allocated * sizeof(char *));
+			if (extended == NULL)
+				break;
+
+			names = extended;
+		}
+
+		names[count] = strdup(entry->d_name);
+		if (names[count] == NULL)
+			break;
+
+		count++;
+	}
+
+	closedir(dir);
+
+	if (count > 1)
+		qsort(names, count, sizeof(char *), fsys_compare_names);
+
+	listing->path = strdup(path);
+	listing->names = names;
+	listing->count = count;
+	listing->last_used = ++fsys_cache_clock;
+
+	if (listing->path == NULL) {
+		fsys_free_listing(listing);
+		return NULL;
+	}
+
+	return listing;
+}
+
+
+/**
+ * Free the memory used by a cached directory listing.
+ *
+ * \param *listing		The listing to free.
+ */
+
+static void fsys_free_listing(struct fsys_listing *listing)
+{
+	int	i;
+
+	for (i = 0; i < listing->count; i++)
+		free(listing->names[i]);
+
+	free(listing->names);
+	free(listing->path);
+
+	listing->path = NULL;
+	listing->names = NULL;
+	listing->count = 0;
+}
+
+
+/**
+ * Compare two leafnames for qsort(), so that directories are always
+ * returned in the same order.
+ */
+
+static int fsys_compare_names(const void *a, const void *b)
+{
+	return strcmp(*((char **) a), *((char **) b));
+}
+
+
+/**
+ * Convert a host leafname into RISC OS form, swapping '.' for '/' and
+ * stripping any ",xxx" filetype suffix.
+ *
+ * \param *leafname		The host leafname to convert.
+ * \param *buffer		Pointer to a buffer to take the RISC OS name.
+ * \param size			The size of the buffer.
+ * \param *type			Pointer to a variable to take the filetype.
+ * \return			The length of the RISC OS name, or 0 if it
+ *				would not fit into the buffer.
+ */
+
+static int fsys_split_leafname(char *leafname, char *buffer, size_t size, unsigned *type)
+{
+	size_t	length;
+	int	i;
+
+	length = strlen(leafname);
+	*type = FSYS_DEFAULT_TYPE;
+
+	if (length > 4 && leafname[length - 4] == ',' && isxdigit(leafname[length - 3]) &&
+			isxdigit(leafname[length - 2]) && isxdigit(leafname[length - 1])) {
+		*type = strtoul(leafname + length - 3, NULL, 16);
+		length -= 4;
+	}
+
+	if (length + 1 > size)
+		return 0;
+
+	for (i = 0; i < length; i++)
+		buffer[i] = (leafname[i] == '.') ? '/' : leafname[i];
+
+	buffer[length] = '\0';
+
+	return length;
+}
+
+
+/**
+ * Convert host object details into RISC OS catalogue information.
+ *
+ * \param *info			The host details to convert.
+ * \param type			The filetype to give the object, if it's a file.
+ * \param *load_addr		Pointer to a variable to take the load address,
+ *				or NULL.
+ * \param *exec_addr		Pointer to a variable to take the exec address,
+ *				or NULL.
+ * \param *size			Pointer to a variable to take the size, or NULL.
+ * \param *attr			Pointer to a variable to take the attributes,
+ *				or NULL.
+ * \param *obj_type		Pointer to a variable to take the object type,
+ *				or NULL.
+ */
+
+static void fsys_convert_stat(struct stat *info, unsigned type, bits *load_addr, bits *exec_addr, int *size,
+		fileswitch_attr *attr, fileswitch_object_type *obj_type)
+{
+	unsigned long long	date;
+	fileswitch_attr		attributes = 0;
+	osbool			directory;
+
+	directory = S_ISDIR(info->st_mode);
+	date = FSYS_UNIX_EPOCH + (unsigned long long) info->st_mtime * 100ull;
+
+	if (directory)
+		type = 0xffdu;
+
+	if (load_addr != NULL)
+		*load_addr = 0xfff00000u | ((type & 0xfffu) << 8) | (bits) ((date >> 32) & 0xffu);
+
+	if (exec_addr != NULL)
+		*exec_addr = (bits) (date & 0xffffffffu);
+
+	if (size != NULL)
+		*size = (directory) ? 0 : (int) info->st_size;
+
+	if (info->st_mode & S_IRUSR)
+		attributes |= fileswitch_ATTR_OWNER_READ;
+	if (info->st_mode & S_IWUSR)
+		attributes |= fileswitch_ATTR_OWNER_WRITE;
+	else
+		attributes |= fileswitch_ATTR_OWNER_LOCKED;
+	if (info->st_mode & S_IROTH)
+		attributes |= fileswitch_ATTR_WORLD_READ;
+	if (info->st_mode & S_IWOTH)
+		attributes |= fileswitch_ATTR_WORLD_WRITE;
+
+	if (attr != NULL)
+		*attr = attributes;
+
+	if (obj_type != NULL)
+		*obj_type = (directory) ? fileswitch_IS_DIR : fileswitch_IS_FILE;
+}
+
+
+/**
+ * Build an error block from the current host errno value.
+ *
+ * \param *path			The RISC OS pathname involved, or NULL.
+ * \return			Pointer to the error block.
+ */
+
+static os_error *fsys_host_error(char *path)
+{
+	fsys_error_block.errnum = errno;
+
+	if (path != NULL)
+		snprintf(fsys_error_block.errmess, sizeof(fsys_error_block.errmess), "%s: %s", path, strerror(errno));
+	else
+		snprintf(fsys_error_block.errmess, sizeof(fsys_error_block.errmess), "%s", strerror(errno));
+
+	return &fsys_error_block;
+}
+
@@ -21,45 +21,321 @@
  * permissions and limitations under the Licence.
  */
 
+/**
+ * \file: ignore.c
+ *
+ * File and folder ignore list.
+ *
+ * An ignore list is supplied as a comma-separated string, and compiled into a
+ * matcher when a search is set up. Each entry in the list can be
+ *
+ *  - a filetype, given as & followed by a type name or hex number, such
+ *    as &Sprite or &FFD;
+ *
+ *  - a pathname, which is recognised by containing a '.', ':' or '<' and
+ *    is canonicalised when the list is compiled, such as
+ *    <Wimp$ScrapDir> or ADFS::HardDisc4.$.!Boot.Resources; or
+ *
+ *  - a leafname, which may contain the usual * and # wildcards, such as
+ *    o or *Backup.
+ *
+ * Leafnames and pathnames are matched without regard to case.
+ */
+
+/* ANSI C Header files. */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 /* OSLib header files */
 
+#include "oslib/fileswitch.h"
+#include "oslib/osfscontrol.h"
 #include "oslib/types.h"
 
 /* SF-Lib header files. */
 
 #include "sflib/debug.h"
 #include "sflib/heap.h"
+#include "sflib/string.h"
 
 /* Application header files */
 
 #include "ignore.h"
 
+
 /**
- * \file: ignore.c
- *
- * File and folder ignore list.
+ * An entry in an ignore list.
  */
 
+struct ignore_entry {
+	char			*text;						/**< Pointer to the leaf or pathname to be matched.			*/
+	size_t			length;						/**< The length of the text, in bytes.					*/
+	osbool			wildcard;					/**< TRUE if the text contains wildcards; else FALSE.			*/
+};
+
+/**
+ * A compiled ignore list.
+ */
 
 struct ignore_block {
-	int dummy;
+	char			*text;						/**< A copy of the list, split into individual entries.			*/
+
+	struct ignore_entry	*leaves;					/**< The leafnames to be ignored.					*/
+	unsigned		leaf_count;					/**< The number of leafnames in the list.				*/
+
+	struct ignore_entry	*paths;						/**< The canonical pathnames to be ignored.				*/
+	unsigned		path_count;					/**< The number of pathnames in the list.				*/
+
+	osbool			test_types;					/**< TRUE if any filetypes are to be ignored; else FALSE.		*/
+	bits			types[0x1000 / (8 * sizeof(bits))];		/**< A bitmap of the filetypes to be ignored.				*/
 };
 
+
+static osbool	ignore_add_path(struct ignore_entry *entry, char *path);
+static osbool	ignore_compare_prefix(char *path, char *prefix, size_t length);
+
+
+/**
+ * Compile a comma-separated ignore list into a matcher.
+ *
+ * \param *list			The list of entries to be ignored.
+ * \return			The new ignore list handle, or NULL if the list
+ *				was empty or memory could not be claimed.
+ */
+
+struct ignore_block *ignore_create(char *list)
+{
+	struct ignore_block	*new;
+	char			*entry, *next;
+	unsigned		entries, i;
+	bits			type;
+	os_error		*error;
+
+	if (list == NULL)
+		return NULL;
+
+	/* Count the entries in the list, to size the entry arrays. */
+
+	entries = 1;
+
+	for (entry = list; *entry != '\0'; entry++)
+		if (*entry == ',')
+			entries++;
+
+	new = heap_alloc(sizeof(struct ignore_block));
+	if (new == NULL)
+		return NULL;
+
+	new->leaf_count = 0;
+	new->path_count = 0;
+	new->test_types = FALSE;
+
+	for (i = 0; i < (0x1000 / (8 * sizeof(bits))); i++)
+		new->types[i] = 0;
+
+	new->text = heap_alloc(strlen(list) + 1);
+	new->leaves = heap_alloc(entries * sizeof(struct ignore_entry));
+	new->paths = heap_alloc(entries * sizeof(struct ignore_entry));
+
+	if (new->text == NULL || new->leaves == NULL || new->paths == NULL) {
+		ignore_destroy(new);
+		return NULL;
+	}
+
+	strcpy(new->text, list);
+
+	/* Split the list up at the commas, and sort each entry into the
+	 * appropriate category.
+	 */
+
+	for (entry = new->text; entry != NULL; entry = next) {
+		next = strchr(entry, ',');
+		if (next != NULL)
+			*next++ = '\0';
+
+		entry = string_strip_surrounding_whitespace(entry);
+
+		if (*entry == '\0')
+			continue;
+
+		if (*entry == '&') {
+			error = xosfscontrol_file_type_from_string(entry + 1, &type);
+			if (error == NULL && type < 0x1000) {
+				new->types[type / (8 * sizeof(bits))] |= (1u << (type % (8 * sizeof(bits))));
+				new->test_types = TRUE;
+			}
+		} else if (strpbrk(entry, ".:<") != NULL) {
+			if (ignore_add_path(new->paths + new->path_count, entry))
+				new->path_count++;
+		} else {
+			new->leaves[new->leaf_count].text = entry;
+			new->leaves[new->leaf_count].length = strlen(entry);
+			new->leaves[new->leaf_count].wildcard = (strpbrk(entry, "*#") != NULL) ? TRUE : FALSE;
+			new->leaf_count++;
+		}
+	}
+
+	if (new->leaf_count == 0 && new->path_count == 0 && !new->test_types) {
+		ignore_destroy(new);
+		return NULL;
+	}
+
+#ifdef DEBUG
+	debug_printf("Ignore list compiled: %u leaves, %u paths, types %s", new->leaf_count, new->path_count, (new->test_types) ? "Yes" : "No");
+#endif
+
+	return new;
+}
+
+
+/**
+ * Destroy an ignore list, freeing the memory associated with it.
+ *
+ * \param *handle		The ignore list to be destroyed.
+ */
+
 void ignore_destroy(struct ignore_block *handle)
 {
+	int	i;
+
 	if (handle == NULL)
 		return;
 
+	if (handle->paths != NULL) {
+		for (i = 0; i < handle->path_count; i++)
+			heap_free(handle->paths[i].text);
+
+		heap_free(handle->paths);
+	}
+
+	if (handle->leaves != NULL)
+		heap_free(handle->leaves);
+
+	if (handle->text != NULL)
+		heap_free(handle->text);
+
 	heap_free(handle);
 }
 
-osbool ignore_match_object(struct ignore_block *handle, char *name)
+
+/**
+ * Test an object against an ignore list. If a directory matches, none of its
+ * contents should be examined either.
+ *
+ * \param *handle		The ignore list to test against.
+ * \param *parent		The pathname of the directory holding the object.
+ * \param parent_length		The length of the parent's pathname.
+ * \param *name			The leafname of the object.
+ * \param type			The object's type, using the convention of
+ *				0x000-0xfff, 0x1000, 0x2000, 0x3000.
+ * \return			TRUE if the object is to be ignored; else FALSE.
+ */
+
+osbool ignore_match_object(struct ignore_block *handle, char *parent, size_t parent_length, char *name, unsigned type)
 {
+	size_t		length;
+	int		i;
+
+	if (handle == NULL || name == NULL)
+		return FALSE;
+
+	/* Filetypes are a simple lookup in the bitmap. */
+
+	if (handle->test_types && type < 0x1000 &&
+			(handle->types[type / (8 * sizeof(bits))] & (1u << (type % (8 * sizeof(bits))))) != 0)
+		return TRUE;
+
+	length = strlen(name);
+
+	/* Leafnames without wildcards can be rejected on length alone. */
+
+	for (i = 0; i < handle->leaf_count; i++) {
+		if (handle->leaves[i].wildcard) {
+			if (string_wildcard_compare(handle->leaves[i].text, name, TRUE))
+				return TRUE;
+		} else if (handle->leaves[i].length == length && string_nocase_strcmp(handle->leaves[i].text, name) == 0) {
+			return TRUE;
+		}
+	}
+
+	/* Pathnames must match the parent's pathname, a separator and the
+	 * leafname exactly. Anything below a matching path will never be seen,
+	 * as its parent will already have been ignored.
+	 */
+
+	if (handle->path_count == 0 || parent == NULL)
+		return FALSE;
+
+	for (i = 0; i < handle->path_count; i++) {
+		if (handle->paths[i].length == parent_length + 1 + length &&
+				handle->paths[i].text[parent_length] == '.' &&
+				string_nocase_strcmp(handle->paths[i].text + parent_length + 1, name) == 0 &&
+				ignore_compare_prefix(handle->paths[i].text, parent, parent_length))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+
+/**
+ * Set up an ignore list entry for a pathname, canonicalising it so that it
+ * can be compared with the pathnames built up during a search.
+ *
+ * \param *entry		The entry to set up.
+ * \param *path			The pathname to be ignored.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool ignore_add_path(struct ignore_entry *entry, char *path)
+{
+	int		size;
+	os_error	*error;
+
+	if (entry == NULL || path == NULL)
+		return FALSE;
+
+	/* If the path can't be canonicalised, use it as it was given. */
+
+	error = xosfscontrol_canonicalise_path(path, NULL, NULL, NULL, 0, &size);
+	size = (error == NULL) ? 1 - size : strlen(path) + 1;
+
+	entry->text = heap_alloc(size);
+	if (entry->text == NULL)
+		return FALSE;
+
+	if (error == NULL)
+		error = xosfscontrol_canonicalise_path(path, entry->text, NULL, NULL, size, NULL);
+
+	if (error != NULL)
+		string_copy(entry->text, path, size);
+
+	entry->length = strlen(entry->text);
+	entry->wildcard = FALSE;
+
 	return TRUE;
 }
 
-osbool ignore_search_content(struct ignore_block *handle, char *name)
+
+/**
+ * Compare the start of a pathname with a prefix, without regard to case.
+ *
+ * \param *path			The pathname to test.
+ * \param *prefix		The prefix to compare against.
+ * \param length		The number of characters to compare.
+ * \return			TRUE if the characters match; else FALSE.
+ */
+
+static osbool ignore_compare_prefix(char *path, char *prefix, size_t length)
 {
+	while (length-- > 0) {
+		if (tolower(*path++) != tolower(*prefix++))
+			return FALSE;
+	}
+
 	return TRUE;
 }
 
@@ -30,12 +30,46 @@
 #ifndef LOCATE_IGNORE
 #define LOCATE_IGNORE
 
+#include <stddef.h>
+#include "oslib/types.h"
+
 struct ignore_block;
 
+
+/**
+ * Compile a comma-separated ignore list into a matcher.
+ *
+ * \param *list			The list of entries to be ignored.
+ * \return			The new ignore list handle, or NULL if the list
+ *				was empty or memory could not be claimed.
+ */
+
+struct ignore_block *ignore_create(char *list);
+
+
+/**
+ * Destroy an ignore list, freeing the memory associated with it.
+ *
+ * \param *handle		The ignore list to be destroyed.
+ */
+
 void ignore_destroy(struct ignore_block *handle);
 
-osbool ignore_match_object(struct ignore_block *handle, char *name);
 
-osbool ignore_search_content(struct ignore_block *handle, char *name);
+/**
+ * Test an object against an ignore list. If a directory matches, none of its
+ * contents should be examined either.
+ *
+ * \param *handle		The ignore list to test against.
+ * \param *parent		The pathname of the directory holding the object.
+ * \param parent_length		The length of the parent's pathname.
+ * \param *name			The leafname of the object.
+ * \param type			The object's type, using the convention of
+ *				0x000-0xfff, 0x1000, 0x2000, 0x3000.
+ * \return			TRUE if the object is to be ignored; else FALSE.
+ */
+
+osbool ignore_match_object(struct ignore_block *handle, char *parent, size_t parent_length, char *name, unsigned type);
 
 #endif
+
@@ -0,0 +1,1685 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: index.c
+ *
+ * Persistent filename indexes.
+ */
+
+/* ANSI C Header files. */
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Acorn C Header files. */
+
+#include "flex.h"
+
+/* OSLib Header files. */
+
+#include "oslib/fileswitch.h"
+#include "oslib/os.h"
+#include "oslib/osgbpb.h"
+#include "oslib/types.h"
+
+/* SF-Lib Header files. */
+
+#include "sflib/heap.h"
+#include "sflib/msgs.h"
+
+/* Application header files. */
+
+#include "index.h"
+
+#include "discfile.h"
+#include "flexutils.h"
+#include "fsys.h"
+#include "objdb.h"
+#include "quantum.h"
+
+
+#define INDEX_ALLOC_CHUNK 100							/**< The minimum number of directories to allocate at a time.	*/
+#define INDEX_BUFFER_SIZE 4096							/**< The size of the buffer used to read directories.		*/
+#define INDEX_READ_COUNT 256							/**< The maximum number of objects to read in each call.	*/
+#define INDEX_MAX_DEPTH 255							/**< The maximum directory depth that can be resolved.		*/
+#define INDEX_RUN_SLICE 100							/**< The time slice, in cs, used when running updates to completion.	*/
+
+#define INDEX_NULL 0xffffffffu							/**< A directory record that does not exist.			*/
+
+
+/**
+ * The catalogue information of a directory, as it was when the directory
+ * was last listed.
+ */
+
+struct index_directory {
+	unsigned		key;						/**< The object database key of the directory.			*/
+	bits			load_addr;					/**< The load address of the directory when listed.		*/
+	bits			exec_addr;					/**< The execution address of the directory when listed.	*/
+	int			size;						/**< The size of the directory when listed.			*/
+};
+
+
+/**
+ * The stages of an update to an index.
+ */
+
+enum index_update {
+	INDEX_UPDATE_NONE,							/**< No update is in progress.					*/
+	INDEX_UPDATE_CHECK,							/**< The directories already indexed are being checked.	*/
+	INDEX_UPDATE_SWEEP,							/**< Objects whose parents have gone are being removed.	*/
+	INDEX_UPDATE_SCAN							/**< New directories are being listed in full.		*/
+};
+
+
+/**
+ * An object already in the index, to be matched against a new listing of
+ * its parent directory.
+ */
+
+struct index_child {
+	char			*name;						/**< The name of the object.					*/
+	unsigned		key;						/**< The object database key of the object.			*/
+	fileswitch_object_type	type;						/**< The object type of the object.				*/
+	osbool			seen;						/**< TRUE if the object has been found in the new listing.	*/
+};
+
+
+/**
+ * An index.
+ */
+
+struct index_block {
+	struct objdb_block	*objects;					/**< The object database holding the indexed objects.		*/
+	char			*root;						/**< The pathname of the root directory (heap block).		*/
+	unsigned		root_key;					/**< The object database key of the root directory.		*/
+
+	struct index_directory	*directories;					/**< The directory records, in key order (flex block).		*/
+	unsigned		directory_count;				/**< The number of directory records.				*/
+	unsigned		directory_allocation;				/**< The number of records for which space is allocated.	*/
+
+	unsigned		*first_child;					/**< The first child of each key (flex block).			*/
+	unsigned		*next_sibling;					/**< The next sibling of each key (flex block).			*/
+	unsigned		link_limit;					/**< The number of keys covered by the child links.		*/
+
+	char			*cache_path;					/**< The last pathname resolved (heap block).			*/
+	size_t			cache_size;					/**< The space allocated to the resolved pathname.		*/
+	unsigned		cache_depth;					/**< The number of levels of the resolved pathname held.	*/
+	unsigned		cache_keys[INDEX_MAX_DEPTH];			/**< The key of each level of the resolved pathname.		*/
+	size_t			cache_ends[INDEX_MAX_DEPTH];			/**< The offset to the end of each level of the pathname.	*/
+
+	byte			*buffer;					/**< The buffer used to read directories (heap block).		*/
+	char			*path;						/**< Space to build object pathnames (heap block).		*/
+	size_t			path_size;					/**< The space allocated to the pathname.			*/
+	osgbpb_info		*info;						/**< Space to read object details (heap block).			*/
+	size_t			info_size;					/**< The space allocated to the object details.			*/
+
+	unsigned		listed;						/**< The number of directories listed by the last update.	*/
+	unsigned		errors;						/**< The number of directories which couldn't be listed.	*/
+
+	enum index_update	update;						/**< The stage reached by the update in progress.		*/
+	unsigned		position;					/**< The next record or key for the update to deal with.	*/
+	unsigned		scan_from;					/**< The first key added by the update.				*/
+	unsigned		live;						/**< The number of objects found to be live by the update.	*/
+	osbool			update_ok;					/**< FALSE if the update in progress has failed.		*/
+	osbool			valid;						/**< TRUE if the last update completed successfully.		*/
+	char			*save_file;					/**< The file to save to after the update, or NULL (heap block).	*/
+	struct quantum_block	quantum;					/**< The work quantum used to time the update.			*/
+
+	unsigned		readers;					/**< The number of searches reading from the index.		*/
+};
+
+
+static os_error			index_error_block;				/**< The block used to return errors.				*/
+
+
+static struct index_block	*index_new(void);
+static osbool			index_load_sections(struct index_block *index, struct discfile_block *load);
+static void			index_check_next(struct index_block *index);
+static void			index_sweep_next(struct index_block *index);
+static void			index_scan_next(struct index_block *index);
+static void			index_end_update(struct index_block *index, osbool success);
+static osbool			index_set_save_file(struct index_block *index, char *filename);
+static osbool			index_list_directory(struct index_block *index, unsigned key, unsigned record, osgbpb_info *catalogue,
+						struct index_child *children, unsigned child_count);
+static osbool			index_get_children(struct index_block *index, unsigned key, struct index_child **children, unsigned *count);
+static int			index_compare_children(const void *a, const void *b);
+static unsigned			index_add_directory(struct index_block *index, unsigned key);
+static void			index_tidy_directories(struct index_block *index);
+static osbool			index_compact(struct index_block *index);
+static osbool			index_link(struct index_block *index);
+static unsigned			index_find_directory(struct index_block *index, char *path);
+static unsigned			index_find_child(struct index_block *index, unsigned parent, char *leaf, size_t length, unsigned hint);
+static size_t			index_match_root(struct index_block *index, char *path);
+static osbool			index_is_live(struct index_block *index, unsigned key);
+static osbool			index_get_path(struct index_block *index, unsigned key);
+static osgbpb_info		*index_get_info(struct index_block *index, unsigned key);
+
+
+/**
+ * Create a new, empty index for a root directory. The index must be built
+ * with index_build() before it can be used.
+ *
+ * \param *root			The pathname of the root directory.
+ * \return			The new index handle, or NULL on failure.
+ */
+
+struct index_block *index_create(char *root)
+{
+	struct index_block	*new;
+
+	if (root == NULL)
+		return NULL;
+
+	new = index_new();
+	if (new == NULL)
+		return NULL;
+
+	new->root = heap_strdup(root);
+	if (new->root == NULL) {
+		index_destroy(new);
+		return NULL;
+	}
+
+	return new;
+}
+
+
+/**
+ * Destroy an index and free the memory that it uses.
+ *
+ * \param *index		The index to destroy.
+ */
+
+void index_destroy(struct index_block *index)
+{
+	if (index == NULL)
+		return;
+
+	if (index->objects != NULL)
+		objdb_destroy(index->objects);
+
+	if (index->directories != NULL)
+		flex_free((flex_ptr) &(index->directories));
+
+	if (index->first_child != NULL)
+		flex_free((flex_ptr) &(index->first_child));
+
+	if (index->next_sibling != NULL)
+		flex_free((flex_ptr) &(index->next_sibling));
+
+	if (index->root != NULL)
+		heap_free(index->root);
+
+	if (index->save_file != NULL)
+		heap_free(index->save_file);
+
+	if (index->cache_path != NULL)
+		heap_free(index->cache_path);
+
+	if (index->buffer != NULL)
+		heap_free(index->buffer);
+
+	if (index->path != NULL)
+		heap_free(index->path);
+
+	if (index->info != NULL)
+		heap_free(index->info);
+
+	heap_free(index);
+}
+
+
+/**
+ * Load an index from a file.
+ *
+ * \param *filename		The name of the file to load.
+ * \return			The new index handle, or NULL on failure.
+ */
+
+struct index_block *index_load_file(char *filename)
+{
+	struct discfile_block	*load;
+	struct index_block	*new;
+	osbool			success;
+
+	if (filename == NULL)
+		return NULL;
+
+	load = discfile_open_read(filename);
+	if (load == NULL)
+		return NULL;
+
+	new = index_new();
+
+	success = (new != NULL) ? index_load_sections(new, load) : FALSE;
+
+	/* The file must always be closed, even if the load has failed. */
+
+	if (discfile_close(load))
+		success = FALSE;
+
+	if (success && (!index_get_path(new, new->root_key) || (new->root = heap_strdup(new->path)) == NULL || !index_link(new)))
+		success = FALSE;
+
+	if (!success) {
+		index_destroy(new);
+		return NULL;
+	}
+
+	new->valid = TRUE;
+
+	return new;
+}
+
+
+/**
+ * Save an index to a file.
+ *
+ * \param *index		The index to save.
+ * \param *filename		The name of the file to save to.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+osbool index_save_file(struct index_block *index, char *filename)
+{
+	struct discfile_block	*out;
+
+	if (index == NULL || index->objects == NULL || filename == NULL)
+		return FALSE;
+
+	out = discfile_open_write(filename);
+	if (out == NULL)
+		return FALSE;
+
+	/* Write the object database. */
+
+	objdb_save_file(index->objects, out);
+
+	/* Write the directory records. */
+
+	discfile_start_section(out, DISCFILE_SECTION_INDEX, FALSE);
+
+	discfile_start_chunk(out, DISCFILE_CHUNK_OPTIONS);
+	discfile_write_option_unsigned(out, "RKY", index->root_key);
+	discfile_write_option_unsigned(out, "DIR", index->directory_count);
+	discfile_write_option_unsigned(out, "DSZ", sizeof(struct index_directory));
+	discfile_end_chunk(out);
+
+	discfile_start_chunk(out, DISCFILE_CHUNK_DIRECTORIES);
+	discfile_write_chunk(out, (byte *) index->directories, index->directory_count * sizeof(struct index_directory));
+	discfile_end_chunk(out);
+
+	discfile_end_section(out);
+
+	return (discfile_close(out)) ? FALSE : TRUE;
+}
+
+
+/**
+ * Build an index from scratch, by scanning every directory below its root.
+ * The scan runs to completion without returning.
+ *
+ * \param *index		The index to build.
+ * \return			TRUE if successful; FALSE if the root could
+ *				not be read or memory ran out.
+ */
+
+osbool index_build(struct index_block *index)
+{
+	if (!index_start_build(index, NULL))
+		return FALSE;
+
+	while (!index_poll(index, os_read_monotonic_time() + INDEX_RUN_SLICE));
+
+	return index->valid;
+}
+
+
+/**
+ * Bring an index up to date, by listing again only those directories whose
+ * catalogue information has changed since they were last listed. Objects
+ * which have gone are removed, and new directories are scanned in full.
+ * The refresh runs to completion without returning.
+ *
+ * \param *index		The index to refresh.
+ * \param *rescanned		Pointer to a variable to take the number of
+ *				directories listed, or NULL.
+ * \return			TRUE if successful; FALSE if the root could
+ *				not be read or memory ran out.
+ */
+
+osbool index_refresh(struct index_block *index, unsigned *rescanned)
+{
+	if (rescanned != NULL)
+		*rescanned = 0;
+
+	if (!index_start_refresh(index, NULL))
+		return FALSE;
+
+	while (!index_poll(index, os_read_monotonic_time() + INDEX_RUN_SLICE));
+
+	if (rescanned != NULL)
+		*rescanned = index->listed;
+
+	return index->valid;
+}
+
+
+/**
+ * Start to build an index from scratch, by scanning every directory below
+ * its root. The scan is carried out by subsequent calls to index_poll(). If
+ * the index is already being updated, that update is left to continue.
+ *
+ * \param *index		The index to build.
+ * \param *filename		The file to save the index to once it has
+ *				been built, or NULL.
+ * \return			TRUE if the build has started or an update is
+ *				already running; FALSE if the root could not
+ *				be read, memory ran out or the index is being
+ *				read.
+ */
+
+osbool index_start_build(struct index_block *index, char *filename)
+{
+	os_error		*error;
+	osgbpb_info		catalogue;
+
+	if (index == NULL)
+		return FALSE;
+
+	if (index->update != INDEX_UPDATE_NONE)
+		return TRUE;
+
+	if (index->readers > 0)
+		return FALSE;
+
+	index->valid = FALSE;
+
+	if (!index_set_save_file(index, filename))
+		return FALSE;
+
+	if (index->objects != NULL)
+		objdb_destroy(index->objects);
+
+	index->directory_count = 0;
+	index->link_limit = 0;
+	index->cache_depth = 0;
+	index->listed = 0;
+	index->errors = 0;
+
+	index->objects = objdb_create(NULL);
+	if (index->objects == NULL)
+		return FALSE;
+
+	objdb_set_full_scan(index->objects, TRUE);
+
+	/* The root must be a directory, or an image to be listed as one. */
+
+	error = fsys_read_object(index->root, &(catalogue.obj_type), &(catalogue.load_addr), &(catalogue.exec_addr),
+			&(catalogue.size), &(catalogue.attr));
+
+	if (error != NULL || (catalogue.obj_type != fileswitch_IS_DIR && catalogue.obj_type != fileswitch_IS_IMAGE))
+		return FALSE;
+
+	catalogue.obj_type = fileswitch_IS_DIR;
+
+	index->root_key = objdb_add_root(index->objects, index->root);
+	if (index->root_key == OBJDB_NULL_KEY || !objdb_update_file(index->objects, index->root_key, &catalogue))
+		return FALSE;
+
+	/* Everything is new, so the update goes straight to the scan. */
+
+	index->scan_from = 0;
+	index->live = 0;
+	index->position = index->root_key;
+	index->update_ok = TRUE;
+	index->update = INDEX_UPDATE_SCAN;
+
+	return TRUE;
+}
+
+
+/**
+ * Start to bring an index up to date, by listing again only those
+ * directories whose catalogue information has changed since they were last
+ * listed. The refresh is carried out by subsequent calls to index_poll(). If
+ * the index is already being updated, that update is left to continue.
+ *
+ * An index can't change while searches are reading from it, so if it is in
+ * use the refresh is skipped: it will have been refreshed when the first of
+ * its current readers started.
+ *
+ * \param *index		The index to refresh.
+ * \param *filename		The file to save the index to once it has
+ *				been refreshed, or NULL.
+ * \return			TRUE if the refresh has started, was skipped
+ *				or an update is already running; FALSE on
+ *				failure.
+ */
+
+osbool index_start_refresh(struct index_block *index, char *filename)
+{
+	if (index == NULL)
+		return FALSE;
+
+	if (index->update != INDEX_UPDATE_NONE || index->readers > 0)
+		return TRUE;
+
+	if (index->objects == NULL || index->link_limit != objdb_get_key_limit(index->objects))
+		return FALSE;
+
+	if (!index_set_save_file(index, filename))
+		return FALSE;
+
+	index->valid = FALSE;
+	index->listed = 0;
+	index->errors = 0;
+
+	index->scan_from = objdb_get_key_limit(index->objects);
+	index->live = 0;
+	index->position = 0;
+	index->update_ok = TRUE;
+	index->update = INDEX_UPDATE_CHECK;
+
+	return TRUE;
+}
+
+
+/**
+ * Run the update of an index until it completes or the time slice ends.
+ *
+ * \param *index		The index to update.
+ * \param end_time		The time at which the slice should end.
+ * \return			TRUE if there is no update left to run; else
+ *				FALSE.
+ */
+
+osbool index_poll(struct index_block *index, os_t end_time)
+{
+	if (index == NULL)
+		return TRUE;
+
+	if (index->update == INDEX_UPDATE_NONE)
+		return TRUE;
+
+	/* Each object or directory record counts as a unit of work; the clock
+	 * is also read after every filing system call. At least one step is
+	 * taken on every poll, so that the update always moves forward.
+	 */
+
+	quantum_start(&(index->quantum), end_time);
+
+	do {
+		switch (index->update) {
+		case INDEX_UPDATE_CHECK:
+			index_check_next(index);
+			break;
+
+		case INDEX_UPDATE_SWEEP:
+			index_sweep_next(index);
+			break;
+
+		case INDEX_UPDATE_SCAN:
+			index_scan_next(index);
+			break;
+
+		case INDEX_UPDATE_NONE:
+			break;
+		}
+	} while (index->update != INDEX_UPDATE_NONE && !quantum_expired(&(index->quantum), 1));
+
+	return (index->update == INDEX_UPDATE_NONE) ? TRUE : FALSE;
+}
+
+
+/**
+ * Test whether an index is ready to be read, with no update in progress and
+ * the last build or refresh having completed successfully.
+ *
+ * \param *index		The index to test.
+ * \return			TRUE if the index can be read; else FALSE.
+ */
+
+osbool index_is_valid(struct index_block *index)
+{
+	return (index != NULL && index->update == INDEX_UPDATE_NONE && index->valid) ? TRUE : FALSE;
+}
+
+
+/**
+ * Register a search as reading from an index, so that the index won't be
+ * refreshed under it.
+ *
+ * \param *index		The index being read.
+ */
+
+void index_claim(struct index_block *index)
+{
+	if (index != NULL)
+		index->readers++;
+}
+
+
+/**
+ * Register that a search has finished reading from an index.
+ *
+ * \param *index		The index that was being read.
+ */
+
+void index_release(struct index_block *index)
+{
+	if (index != NULL && index->readers > 0)
+		index->readers--;
+}
+
+
+/**
+ * Return the pathname of the root directory of an index.
+ *
+ * \param *index		The index of interest.
+ * \return			Pointer to the root pathname, or NULL.
+ */
+
+char *index_get_root(struct index_block *index)
+{
+	return (index != NULL) ? index->root : NULL;
+}
+
+
+/**
+ * Return the object, directory and error counts for an index.
+ *
+ * \param *index		The index of interest.
+ * \param *objects		Pointer to a variable to take the number of
+ *				objects in the index, or NULL.
+ * \param *directories		Pointer to a variable to take the number of
+ *				directories in the index, or NULL.
+ * \param *errors		Pointer to a variable to take the number of
+ *				directories which couldn't be read during the
+ *				last build or refresh, or NULL.
+ */
+
+void index_get_counts(struct index_block *index, unsigned *objects, unsigned *directories, unsigned *errors)
+{
+	unsigned	key, count = 0;
+
+	if (index != NULL && index->objects != NULL) {
+		for (key = objdb_get_next_key(index->objects, OBJDB_NULL_KEY); key != OBJDB_NULL_KEY; key = objdb_get_next_key(index->objects, key))
+			count++;
+	}
+
+	if (objects != NULL)
+		*objects = count;
+
+	if (directories != NULL)
+		*directories = (index != NULL) ? index->directory_count : 0;
+
+	if (errors != NULL)
+		*errors = (index != NULL) ? index->errors : 0;
+}
+
+
+/**
+ * Test whether a pathname falls within the root of an index, so that its
+ * listing can be read from the index.
+ *
+ * \param *index		The index to test against.
+ * \param *path			The pathname to test.
+ * \return			TRUE if the path is covered; else FALSE.
+ */
+
+osbool index_covers(struct index_block *index, char *path)
+{
+	if (!index_is_valid(index))
+		return FALSE;
+
+	return (index_match_root(index, path) > 0) ? TRUE : FALSE;
+}
+
+
+/**
+ * Read a block of entries for a directory from an index, in the format
+ * returned by OS_GBPB 10, as a direct replacement for fsys_read_dir().
+ * Image files are held as files, so reading one returns no entries.
+ *
+ * \param *index		The index to read from.
+ * \param *path			The pathname of the directory to read.
+ * \param *buffer		Pointer to a buffer to take the entries.
+ * \param count			The maximum number of entries to read.
+ * \param context		The context to start reading from: 0 to
+ *				start at the beginning of the directory.
+ * \param size			The size of the buffer, in bytes.
+ * \param *read			Pointer to a variable to take the number
+ *				of entries read.
+ * \param *next			Pointer to a variable to take the context
+ *				for the next read, or -1 if the directory
+ *				has been completed.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *index_read_dir(struct index_block *index, char *path, osgbpb_info_list *buffer, int count, int context, int size, int *read, int *next)
+{
+	unsigned	key, child;
+	size_t		length, record;
+	int		offset, entries;
+
+	if (read != NULL)
+		*read = 0;
+
+	if (next != NULL)
+		*next = -1;
+
+	if (index == NULL || index->objects == NULL || path == NULL || context < 0)
+		return NULL;
+
+	key = index_find_directory(index, path);
+
+	if (key == OBJDB_NULL_KEY) {
+		index_error_block.errnum = 0;
+		msgs_param_lookup("NotIndexed", index_error_block.errmess, sizeof(index_error_block.errmess), path, NULL, NULL, NULL);
+		return &index_error_block;
+	}
+
+	/* The root is never anyone's child, so the key of the next child
+	 * to be returned serves as the context.
+	 */
+
+	child = (context == 0) ? index->first_child[key] : (unsigned) context;
+
+	if (child != OBJDB_NULL_KEY && child >= index->link_limit)
+		return NULL;
+
+	offset = 0;
+	entries = 0;
+
+	while (child != OBJDB_NULL_KEY && entries < count) {
+		length = objdb_get_info(index->objects, child, NULL, 0, NULL);
+		record = (length + 3) & ~3u;
+
+		if (offset + record > size)
+			break;
+
+		objdb_get_info(index->objects, child, (osgbpb_info *) ((byte *) buffer + offset), length, NULL);
+
+		offset += record;
+		entries++;
+
+		child = index->next_sibling[child];
+	}
+
+	if (read != NULL)
+		*read = entries;
+
+	if (next != NULL)
+		*next = (child != OBJDB_NULL_KEY) ? (int) child : -1;
+
+	return NULL;
+}
+
+
+/**
+ * Allocate and initialise a new index block, without an object database
+ * or root.
+ *
+ * \return			The new index handle, or NULL on failure.
+ */
+
+static struct index_block *index_new(void)
+{
+	struct index_block	*new;
+
+	new = heap_alloc(sizeof(struct index_block));
+	if (new == NULL)
+		return NULL;
+
+	new->objects = NULL;
+	new->root = NULL;
+	new->root_key = OBJDB_NULL_KEY;
+
+	new->directory_count = 0;
+	new->directory_allocation = 0;
+	new->link_limit = 0;
+
+	new->cache_path = NULL;
+	new->cache_size = 0;
+	new->cache_depth = 0;
+
+	new->path = NULL;
+	new->path_size = 0;
+	new->info = NULL;
+	new->info_size = 0;
+
+	new->listed = 0;
+	new->errors = 0;
+
+	new->update = INDEX_UPDATE_NONE;
+	new->position = 0;
+	new->scan_from = 0;
+	new->live = 0;
+	new->update_ok = FALSE;
+	new->valid = FALSE;
+	new->save_file = NULL;
+	new->readers = 0;
+
+	quantum_initialise(&(new->quantum));
+
+	if (flex_alloc((flex_ptr) &(new->directories), INDEX_ALLOC_CHUNK * sizeof(struct index_directory)) == 1)
+		new->directory_allocation = INDEX_ALLOC_CHUNK;
+	else
+		new->directories = NULL;
+
+	if (flex_alloc((flex_ptr) &(new->first_child), sizeof(unsigned)) == 0)
+		new->first_child = NULL;
+
+	if (flex_alloc((flex_ptr) &(new->next_sibling), sizeof(unsigned)) == 0)
+		new->next_sibling = NULL;
+
+	new->buffer = heap_alloc(INDEX_BUFFER_SIZE);
+
+	if (new->directories == NULL || new->first_child == NULL || new->next_sibling == NULL || new->buffer == NULL) {
+		index_destroy(new);
+		return NULL;
+	}
+
+	return new;
+}
+
+
+/**
+ * Read the object database and directory records of an index from an
+ * open discfile.
+ *
+ * \param *index		The index to load into.
+ * \param *load			The discfile handle to load from.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+static osbool index_load_sections(struct index_block *index, struct discfile_block *load)
+{
+	unsigned	record, count, size;
+
+	index->objects = objdb_load_file(NULL, load);
+	if (index->objects == NULL)
+		return FALSE;
+
+	if (!discfile_open_section(load, DISCFILE_SECTION_INDEX)) {
+		discfile_set_error(load, "FileUnrec");
+		return FALSE;
+	}
+
+	/* Load the settings chunk. */
+
+	if (!discfile_open_chunk(load, DISCFILE_CHUNK_OPTIONS)) {
+		discfile_set_error(load, "FileUnrec");
+		return FALSE;
+	}
+
+	if (!discfile_read_option_unsigned(load, "RKY", &(index->root_key)) ||
+			!discfile_read_option_unsigned(load, "DIR", &count) ||
+			!discfile_read_option_unsigned(load, "DSZ", &size) ||
+			size != sizeof(struct index_directory) || !index_is_live(index, index->root_key)) {
+		discfile_set_error(load, "FileUnrec");
+		return FALSE;
+	}
+
+	discfile_close_chunk(load);
+
+	if (count > index->directory_allocation) {
+		if (!flexutils_resize((flex_ptr) &(index->directories), count * sizeof(struct index_directory))) {
+			discfile_set_error(load, "FileMem");
+			return FALSE;
+		}
+
+		index->directory_allocation = count;
+	}
+
+	/* Load the directory records. */
+
+	if (!discfile_open_chunk(load, DISCFILE_CHUNK_DIRECTORIES) || discfile_chunk_size(load) != count * sizeof(struct index_directory)) {
+		discfile_set_error(load, "FileUnrec");
+		return FALSE;
+	}
+
+	discfile_read_chunk(load, (byte *) index->directories, count * sizeof(struct index_directory));
+	discfile_close_chunk(load);
+
+	index->directory_count = count;
+
+	for (record = 0; record < count; record++) {
+		if (!index_is_live(index, index->directories[record].key)) {
+			discfile_set_error(load, "FileUnrec");
+			return FALSE;
+		}
+	}
+
+	discfile_close_section(load);
+
+	return TRUE;
+}
+
+
+/**
+ * Check the next directory record during the refresh of an index, listing
+ * the directory again if its catalogue information has changed. The records
+ * are in key order, so a directory's parent will always have been dealt
+ * with by the time that the directory itself is reached.
+ *
+ * \param *index		The index being refreshed.
+ */
+
+static void index_check_next(struct index_block *index)
+{
+	os_error		*error;
+	osgbpb_info		catalogue;
+	struct index_child	*children;
+	unsigned		record, key, parent, child_count;
+
+	if (!index->update_ok) {
+		index_end_update(index, FALSE);
+		return;
+	}
+
+	if (index->position >= index->directory_count) {
+		index->position = 0;
+		index->update = INDEX_UPDATE_SWEEP;
+		return;
+	}
+
+	record = index->position++;
+	key = index->directories[record].key;
+
+	if (!index_is_live(index, key))
+		return;
+
+	parent = objdb_get_parent(index->objects, key);
+
+	if (key != index->root_key && !index_is_live(index, parent)) {
+		objdb_delete_key(index->objects, key);
+		return;
+	}
+
+	if (!index_get_path(index, key)) {
+		index->update_ok = FALSE;
+		return;
+	}
+
+	error = fsys_read_object(index->path, &(catalogue.obj_type), &(catalogue.load_addr), &(catalogue.exec_addr),
+			&(catalogue.size), &(catalogue.attr));
+
+	quantum_check(&(index->quantum));
+
+	if (error != NULL) {
+		index->errors++;
+		return;
+	}
+
+	if (key == index->root_key && catalogue.obj_type == fileswitch_IS_IMAGE)
+		catalogue.obj_type = fileswitch_IS_DIR;
+
+	/* Directories which have gone, or been replaced by files, are
+	 * removed along with everything that was inside them.
+	 */
+
+	if (catalogue.obj_type != fileswitch_IS_DIR) {
+		if (key == index->root_key)
+			index->update_ok = FALSE;
+		else
+			objdb_delete_key(index->objects, key);
+
+		return;
+	}
+
+	if (catalogue.load_addr == index->directories[record].load_addr &&
+			catalogue.exec_addr == index->directories[record].exec_addr &&
+			catalogue.size == index->directories[record].size)
+		return;
+
+	if (key == index->root_key)
+		objdb_update_file(index->objects, key, &catalogue);
+
+	if (!index_get_children(index, key, &children, &child_count)) {
+		index->update_ok = FALSE;
+		return;
+	}
+
+	if (!index_list_directory(index, key, record, &catalogue, children, child_count))
+		index->update_ok = FALSE;
+
+	heap_free(children);
+
+	quantum_check(&(index->quantum));
+}
+
+
+/**
+ * Check the next object from before the refresh of an index, removing it if
+ * its parent has gone. Parents always have lower keys than their children,
+ * so a single pass clears whole trees.
+ *
+ * \param *index		The index being refreshed.
+ */
+
+static void index_sweep_next(struct index_block *index)
+{
+	unsigned	key, parent;
+
+	if (index->position >= index->scan_from) {
+		index->update = INDEX_UPDATE_SCAN;
+		return;
+	}
+
+	key = index->position++;
+
+	if (!index_is_live(index, key))
+		return;
+
+	parent = objdb_get_parent(index->objects, key);
+
+	if (key != index->root_key && !index_is_live(index, parent))
+		objdb_delete_key(index->objects, key);
+	else
+		index->live++;
+}
+
+
+/**
+ * Scan the next new object during the update of an index, listing it if it
+ * is a directory. As new objects are added to the end of the database, any
+ * subdirectories found are reached in turn.
+ *
+ * \param *index		The index being updated.
+ */
+
+static void index_scan_next(struct index_block *index)
+{
+	osgbpb_info	*info, catalogue;
+	unsigned	key;
+
+	if (index->position >= objdb_get_key_limit(index->objects)) {
+		index_end_update(index, TRUE);
+		return;
+	}
+
+	key = index->position++;
+
+	if (!index_is_live(index, key))
+		return;
+
+	info = index_get_info(index, key);
+	if (info == NULL) {
+		index_end_update(index, FALSE);
+		return;
+	}
+
+	if (info->obj_type != fileswitch_IS_DIR)
+		return;
+
+	catalogue.load_addr = info->load_addr;
+	catalogue.exec_addr = info->exec_addr;
+	catalogue.size = info->size;
+
+	if (!index_list_directory(index, key, INDEX_NULL, &catalogue, NULL, 0))
+		index_end_update(index, FALSE);
+
+	quantum_check(&(index->quantum));
+}
+
+
+/**
+ * Finish the update of an index, tidying up and relinking it so that it can
+ * be read, and saving it if requested. If more than half of the objects
+ * from before a refresh have gone, the database is compacted.
+ *
+ * \param *index		The index being updated.
+ * \param success		TRUE if the update succeeded; else FALSE.
+ */
+
+static void index_end_update(struct index_block *index, osbool success)
+{
+	index->update = INDEX_UPDATE_NONE;
+
+	index_tidy_directories(index);
+
+	if (success && index->live < index->scan_from / 2)
+		success = index_compact(index);
+
+	if (!index_link(index))
+		success = FALSE;
+
+	index->valid = success;
+
+	if (success && index->save_file != NULL)
+		index_save_file(index, index->save_file);
+}
+
+
+/**
+ * Set the file that an index will be saved to when its update completes.
+ *
+ * \param *index		The index to update.
+ * \param *filename		The file to save to, or NULL for none.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+static osbool index_set_save_file(struct index_block *index, char *filename)
+{
+	if (index->save_file != NULL) {
+		heap_free(index->save_file);
+		index->save_file = NULL;
+	}
+
+	if (filename == NULL)
+		return TRUE;
+
+	index->save_file = heap_strdup(filename);
+
+	return (index->save_file != NULL) ? TRUE : FALSE;
+}
+
+
+/**
+ * List a directory on disc, and add its contents to the index. If the objects
+ * which were already in the index are supplied, they are matched against the
+ * listing by name: those found are updated in place, and those not found are
+ * removed from the index.
+ *
+ * \param *index		The index to add to.
+ * \param key			The key of the directory to list.
+ * \param record		The directory's record, or INDEX_NULL to add one.
+ * \param *catalogue		The directory's current catalogue information.
+ * \param *children		The objects already in the directory, or NULL.
+ * \param child_count		The number of objects already in the directory.
+ * \return			TRUE if successful; FALSE if memory ran out.
+ */
+
+static osbool index_list_directory(struct index_block *index, unsigned key, unsigned record, osgbpb_info *catalogue,
+		struct index_child *children, unsigned child_count)
+{
+	os_error		*error;
+	osgbpb_info		*file;
+	struct index_child	*child, find;
+	unsigned		i;
+	int			read, context, offset;
+
+	if (!index_get_path(index, key))
+		return FALSE;
+
+	if (record == INDEX_NULL && (record = index_add_directory(index, key)) == INDEX_NULL)
+		return FALSE;
+
+	index->directories[record].load_addr = catalogue->load_addr;
+	index->directories[record].exec_addr = catalogue->exec_addr;
+	index->directories[record].size = catalogue->size;
+
+	index->listed++;
+
+	context = 0;
+
+	while (context != -1) {
+		error = fsys_read_dir(index->path, (osgbpb_info_list *) index->buffer, INDEX_READ_COUNT, context, INDEX_BUFFER_SIZE, &read, &context);
+
+		/* If the directory can't be read, keep what was there before
+		 * and clear the datestamp so that it is tried again next time.
+		 */
+
+		if (error != NULL) {
+			index->errors++;
+
+			index->directories[record].load_addr = 0;
+			index->directories[record].exec_addr = 0;
+
+			for (i = 0; i < child_count; i++)
+				children[i].seen = TRUE;
+
+			break;
+		}
+
+		offset = 0;
+
+		for (i = 0; i < read; i++) {
+			file = (osgbpb_info *) (index->buffer + offset);
+			offset += (offsetof(osgbpb_info, name) + strlen(file->name) + 4) & 0xfffffffc;
+
+			/* Objects which were already present are updated, unless they
+			 * have changed between being files and directories.
+			 */
+
+			if (children != NULL) {
+				find.name = file->name;
+				child = bsearch(&find, children, child_count, sizeof(struct index_child), index_compare_children);
+
+				if (child != NULL && !child->seen) {
+					child->seen = TRUE;
+
+					if ((child->type == fileswitch_IS_DIR) == (file->obj_type == fileswitch_IS_DIR)) {
+						objdb_update_file(index->objects, child->key, file);
+						continue;
+					}
+
+					objdb_delete_key(index->objects, child->key);
+				}
+			}
+
+			if (objdb_add_file(index->objects, key, file) == OBJDB_NULL_KEY)
+				return FALSE;
+		}
+	}
+
+	for (i = 0; i < child_count; i++) {
+		if (!children[i].seen)
+			objdb_delete_key(index->objects, children[i].key);
+	}
+
+	return TRUE;
+}
+
+
+/**
+ * Collect the objects held in the index for a directory, sorted by name, so
+ * that they can be matched against a new listing. The names are copied, as
+ * the object database's text will move as new objects are added.
+ *
+ * \param *index		The index to look in.
+ * \param key			The key of the directory.
+ * \param **children		Pointer to a variable to take the heap block
+ *				holding the objects and their names.
+ * \param *count		Pointer to a variable to take the object count.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool index_get_children(struct index_block *index, unsigned key, struct index_child **children, unsigned *count)
+{
+	osgbpb_info	*info;
+	unsigned	child, i;
+	size_t		text;
+	char		*name;
+
+	*children = NULL;
+	*count = 0;
+
+	if (key >= index->link_limit)
+		return FALSE;
+
+	text = 0;
+
+	for (child = index->first_child[key]; child != OBJDB_NULL_KEY; child = index->next_sibling[child]) {
+		if (!index_is_live(index, child))
+			continue;
+
+		(*count)++;
+		text += objdb_get_info(index->objects, child, NULL, 0, NULL);
+	}
+
+	*children = heap_alloc(*count * sizeof(struct index_child) + text + 1);
+	if (*children == NULL)
+		return FALSE;
+
+	name = (char *) (*children + *count);
+	i = 0;
+
+	for (child = index->first_child[key]; child != OBJDB_NULL_KEY; child = index->next_sibling[child]) {
+		if (!index_is_live(index, child) || (info = index_get_info(index, child)) == NULL)
+			continue;
+
+		strcpy(name, info->name);
+
+		(*children)[i].name = name;
+		(*children)[i].key = child;
+		(*children)[i].type = info->obj_type;
+		(*children)[i].seen = FALSE;
+
+		name += strlen(name) + 1;
+		i++;
+	}
+
+	*count = i;
+
+	qsort(*children, *count, sizeof(struct index_child), index_compare_children);
+
+	return TRUE;
+}
+
+
+/**
+ * Compare two objects by name, for qsort() and bsearch().
+ *
+ * \param *a			The first object to compare.
+ * \param *b			The second object to compare.
+ * \return			The result of comparing the names.
+ */
+
+static int index_compare_children(const void *a, const void *b)
+{
+	return strcmp(((struct index_child *) a)->name, ((struct index_child *) b)->name);
+}
+
+
+/**
+ * Add a new directory record to the end of an index.
+ *
+ * \param *index		The index to add the record to.
+ * \param key			The key of the directory.
+ * \return			The new record, or INDEX_NULL on failure.
+ */
+
+static unsigned index_add_directory(struct index_block *index, unsigned key)
+{
+	size_t		allocation;
+
+	if (index->directory_count >= index->directory_allocation) {
+		allocation = flexutils_grow_size(index->directory_allocation, index->directory_count + 1, INDEX_ALLOC_CHUNK);
+
+		if (!flexutils_resize((flex_ptr) &(index->directories), allocation * sizeof(struct index_directory)))
+			return INDEX_NULL;
+
+		index->directory_allocation = allocation;
+	}
+
+	index->directories[index->directory_count].key = key;
+	index->directories[index->directory_count].load_addr = 0;
+	index->directories[index->directory_count].exec_addr = 0;
+	index->directories[index->directory_count].size = 0;
+
+	return index->directory_count++;
+}
+
+
+/**
+ * Remove the records of any directories which are no longer in the index,
+ * keeping the rest in key order.
+ *
+ * \param *index		The index to tidy.
+ */
+
+static void index_tidy_directories(struct index_block *index)
+{
+	unsigned	from, to = 0;
+
+	for (from = 0; from < index->directory_count; from++) {
+		if (!index_is_live(index, index->directories[from].key))
+			continue;
+
+		if (from != to)
+			index->directories[to] = index->directories[from];
+
+		to++;
+	}
+
+	index->directory_count = to;
+}
+
+
+/**
+ * Copy the live objects in an index into a new object database, to recover
+ * the space taken by those which have been deleted. Parents are always
+ * copied before their children, so the new keys keep the same ordering.
+ *
+ * \param *index		The index to compact.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool index_compact(struct index_block *index)
+{
+	struct objdb_block	*objects;
+	osgbpb_info		*info;
+	unsigned		*map, key, limit, record;
+
+	limit = objdb_get_key_limit(index->objects);
+
+	objects = objdb_create(NULL);
+	if (objects == NULL)
+		return FALSE;
+
+	objdb_set_full_scan(objects, TRUE);
+
+	if (flex_alloc((flex_ptr) &map, (limit + 1) * sizeof(unsigned)) == 0) {
+		objdb_destroy(objects);
+		return FALSE;
+	}
+
+	for (key = 0; key < limit; key++) {
+		map[key] = OBJDB_NULL_KEY;
+
+		if (!index_is_live(index, key) || (info = index_get_info(index, key)) == NULL)
+			continue;
+
+		if (key == index->root_key) {
+			map[key] = objdb_add_root(objects, index->root);
+			objdb_update_file(objects, map[key], info);
+		} else {
+			map[key] = objdb_add_file(objects, map[objdb_get_parent(index->objects, key)], info);
+		}
+
+		if (map[key] == OBJDB_NULL_KEY) {
+			flex_free((flex_ptr) &map);
+			objdb_destroy(objects);
+			return FALSE;
+		}
+	}
+
+	for (record = 0; record < index->directory_count; record++)
+		index->directories[record].key = map[index->directories[record].key];
+
+	index->root_key = map[index->root_key];
+
+	flex_free((flex_ptr) &map);
+
+	objdb_destroy(index->objects);
+	index->objects = objects;
+
+	return TRUE;
+}
+
+
+/**
+ * Link each directory in an index to its children, so that listings can be
+ * returned without searching the whole database.
+ *
+ * \param *index		The index to link.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool index_link(struct index_block *index)
+{
+	unsigned	key, parent, limit;
+
+	index->link_limit = 0;
+	index->cache_depth = 0;
+
+	limit = objdb_get_key_limit(index->objects);
+
+	if (!flexutils_resize((flex_ptr) &(index->first_child), (limit + 1) * sizeof(unsigned)) ||
+			!flexutils_resize((flex_ptr) &(index->next_sibling), (limit + 1) * sizeof(unsigned)))
+		return FALSE;
+
+	for (key = 0; key < limit; key++) {
+		index->first_child[key] = OBJDB_NULL_KEY;
+		index->next_sibling[key] = OBJDB_NULL_KEY;
+	}
+
+	/* Work backwards, so that each list ends up in catalogue order. */
+
+	for (key = limit; key > 0; key--) {
+		parent = objdb_get_parent(index->objects, key - 1);
+
+		if (parent == OBJDB_NULL_KEY)
+			continue;
+
+		index->next_sibling[key - 1] = index->first_child[parent];
+		index->first_child[parent] = key - 1;
+	}
+
+	index->link_limit = limit;
+
+	return TRUE;
+}
+
+
+/**
+ * Find the key of a directory in an index from its pathname. Searches
+ * resolve pathnames in catalogue order, so the last path resolved is kept
+ * and any levels that it shares with the new one are reused.
+ *
+ * \param *index		The index to look in.
+ * \param *path			The pathname to resolve.
+ * \return			The key of the directory, or OBJDB_NULL_KEY.
+ */
+
+static unsigned index_find_directory(struct index_block *index, char *path)
+{
+	size_t		pos, end, length;
+	unsigned	key, depth, hint;
+	char		*cache;
+
+	pos = index_match_root(index, path);
+	if (pos == 0)
+		return OBJDB_NULL_KEY;
+
+	length = strlen(path);
+
+	if (length >= index->cache_size) {
+		cache = heap_extend(index->cache_path, length + 1);
+		if (cache == NULL)
+			return OBJDB_NULL_KEY;
+
+		index->cache_path = cache;
+		index->cache_size = length + 1;
+	}
+
+	if (index->cache_depth == 0) {
+		index->cache_keys[0] = index->root_key;
+		index->cache_ends[0] = pos;
+		index->cache_depth = 1;
+	}
+
+	/* Reuse as many levels of the last path as match the new one. */
+
+	depth = 0;
+	key = index->root_key;
+
+	while (depth + 1 < index->cache_depth) {
+		end = index->cache_ends[depth + 1];
+
+		if (end > length || (path[end] != '.' && path[end] != '\0') || strncmp(path + pos, index->cache_path + pos, end - pos) != 0)
+			break;
+
+		depth++;
+		pos = end;
+		key = index->cache_keys[depth];
+	}
+
+	strcpy(index->cache_path, path);
+
+	/* Resolve the remaining levels one at a time, starting the search for
+	 * each from the sibling after the one found last time.
+	 */
+
+	while (path[pos] == '.') {
+		end = pos + 1;
+
+		while (path[end] != '.' && path[end] != '\0')
+			end++;
+
+		if (depth + 1 >= INDEX_MAX_DEPTH)
+			return OBJDB_NULL_KEY;
+
+		hint = (depth + 1 < index->cache_depth) ? index->cache_keys[depth + 1] : OBJDB_NULL_KEY;
+
+		key = index_find_child(index, key, path + pos + 1, end - pos - 1, hint);
+
+		index->cache_depth = depth + 1;
+
+		if (key == OBJDB_NULL_KEY)
+			return OBJDB_NULL_KEY;
+
+		depth++;
+		pos = end;
+
+		index->cache_keys[depth] = key;
+		index->cache_ends[depth] = end;
+		index->cache_depth = depth + 1;
+	}
+
+	return (path[pos] == '\0') ? key : OBJDB_NULL_KEY;
+}
+
+
+/**
+ * Find a named child of a directory in an index.
+ *
+ * \param *index		The index to look in.
+ * \param parent		The key of the directory.
+ * \param *leaf			Pointer to the name of the child.
+ * \param length		The length of the name.
+ * \param hint			The child found last time, or OBJDB_NULL_KEY.
+ * \return			The key of the child, or OBJDB_NULL_KEY.
+ */
+
+static unsigned index_find_child(struct index_block *index, unsigned parent, char *leaf, size_t length, unsigned hint)
+{
+	osgbpb_info	*info;
+	unsigned	start, child;
+
+	if (parent >= index->link_limit)
+		return OBJDB_NULL_KEY;
+
+	if (hint != OBJDB_NULL_KEY && hint < index->link_limit && objdb_get_parent(index->objects, hint) == parent)
+		start = index->next_sibling[hint];
+	else
+		start = index->first_child[parent];
+
+	/* Search from the starting point to the end of the list, and then
+	 * wrap around from the start of the list if required.
+	 */
+
+	child = start;
+
+	do {
+		if (child == OBJDB_NULL_KEY) {
+			child = index->first_child[parent];
+
+			if (child == start)
+				break;
+		}
+
+		info = index_get_info(index, child);
+
+		if (info != NULL && strlen(info->name) == length && strncmp(info->name, leaf, length) == 0)
+			return child;
+
+		child = index->next_sibling[child];
+	} while (child != start);
+
+	return OBJDB_NULL_KEY;
+}
+
+
+/**
+ * Test whether a pathname starts with the root of an index, ignoring case
+ * as the filing system would.
+ *
+ * \param *index		The index to test against.
+ * \param *path			The pathname to test.
+ * \return			The length of the root within the pathname,
+ *				or 0 if the root doesn't match.
+ */
+
+static size_t index_match_root(struct index_block *index, char *path)
+{
+	size_t		length;
+
+	if (index == NULL || index->root == NULL || path == NULL)
+		return 0;
+
+	for (length = 0; index->root[length] != '\0'; length++) {
+		if (toupper(path[length]) != toupper(index->root[length]))
+			return 0;
+	}
+
+	return (path[length] == '.' || path[length] == '\0') ? length : 0;
+}
+
+
+/**
+ * Test whether a key refers to an object which is still in an index.
+ *
+ * \param *index		The index to look in.
+ * \param key			The key to test.
+ * \return			TRUE if the object is present; else FALSE.
+ */
+
+static osbool index_is_live(struct index_block *index, unsigned key)
+{
+	if (key == OBJDB_NULL_KEY)
+		return FALSE;
+
+	return (objdb_get_name_length(index->objects, key) > 0) ? TRUE : FALSE;
+}
+
+
+/**
+ * Build the full pathname of an object into the index's pathname buffer.
+ *
+ * \param *index		The index holding the object.
+ * \param key			The key of the object.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool index_get_path(struct index_block *index, unsigned key)
+{
+	size_t		length;
+	char		*path;
+
+	length = objdb_get_name_length(index->objects, key);
+	if (length == 0)
+		return FALSE;
+
+	if (length > index->path_size) {
+		path = heap_extend(index->path, length);
+		if (path == NULL)
+			return FALSE;
+
+		index->path = path;
+		index->path_size = length;
+	}
+
+	return objdb_get_name(index->objects, key, index->path, index->path_size);
+}
+
+
+/**
+ * Read the details of an object into the index's information buffer.
+ *
+ * \param *index		The index holding the object.
+ * \param key			The key of the object.
+ * \return			Pointer to the details, or NULL on failure.
+ */
+
+static osgbpb_info *index_get_info(struct index_block *index, unsigned key)
+{
+	size_t		size;
+	osgbpb_info	*info;
+
+	if (!index_is_live(index, key))
+		return NULL;
+
+	size = objdb_get_info(index->objects, key, NULL, 0, NULL);
+
+	if (size > index->info_size) {
+		info = heap_extend(index->info, size);
+		if (info == NULL)
+			return NULL;
+
+		index->info = info;
+		index->info_size = size;
+	}
+
+	objdb_get_info(index->objects, key, index->info, index->info_size, NULL);
+
+	return index->info;
+}
+
@@ -0,0 +1,256 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: index.h
+ *
+ * Persistent filename indexes.
+ *
+ * An index holds a full scan of the catalogue below a root directory in an
+ * object database, along with the datestamp of each directory at the time
+ * that it was listed. Searches can read their directory listings from the
+ * index instead of the filing system, and a refresh only lists again those
+ * directories whose catalogue information has changed since.
+ */
+
+#ifndef LOCATE_INDEX
+#define LOCATE_INDEX
+
+#include "oslib/types.h"
+#include "oslib/os.h"
+#include "oslib/osgbpb.h"
+
+
+struct index_block;
+
+
+/**
+ * Create a new, empty index for a root directory. The index must be built
+ * with index_build() before it can be used.
+ *
+ * \param *root			The pathname of the root directory.
+ * \return			The new index handle, or NULL on failure.
+ */
+
+struct index_block *index_create(char *root);
+
+
+/**
+ * Destroy an index and free the memory that it uses.
+ *
+ * \param *index		The index to destroy.
+ */
+
+void index_destroy(struct index_block *index);
+
+
+/**
+ * Load an index from a file.
+ *
+ * \param *filename		The name of the file to load.
+ * \return			The new index handle, or NULL on failure.
+ */
+
+struct index_block *index_load_file(char *filename);
+
+
+/**
+ * Save an index to a file.
+ *
+ * \param *index		The index to save.
+ * \param *filename		The name of the file to save to.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+osbool index_save_file(struct index_block *index, char *filename);
+
+
+/**
+ * Build an index from scratch, by scanning every directory below its root.
+ * The scan runs to completion without returning.
+ *
+ * \param *index		The index to build.
+ * \return			TRUE if successful; FALSE if the root could
+ *				not be read or memory ran out.
+ */
+
+osbool index_build(struct index_block *index);
+
+
+/**
+ * Bring an index up to date, by listing again only those directories whose
+ * catalogue information has changed since they were last listed. Objects
+ * which have gone are removed, and new directories are scanned in full.
+ * The refresh runs to completion without returning.
+ *
+ * \param *index		The index to refresh.
+ * \param *rescanned		Pointer to a variable to take the number of
+ *				directories listed, or NULL.
+ * \return			TRUE if successful; FALSE if the root could
+ *				not be read or memory ran out.
+ */
+
+osbool index_refresh(struct index_block *index, unsigned *rescanned);
+
+
+/**
+ * Start to build an index from scratch, by scanning every directory below
+ * its root. The scan is carried out by subsequent calls to index_poll(). If
+ * the index is already being updated, that update is left to continue.
+ *
+ * \param *index		The index to build.
+ * \param *filename		The file to save the index to once it has
+ *				been built, or NULL.
+ * \return			TRUE if the build has started or an update is
+ *				already running; FALSE if the root could not
+ *				be read, memory ran out or the index is being
+ *				read.
+ */
+
+osbool index_start_build(struct index_block *index, char *filename);
+
+
+/**
+ * Start to bring an index up to date, by listing again only those
+ * directories whose catalogue information has changed since they were last
+ * listed. The refresh is carried out by subsequent calls to index_poll().
+ * If the index is already being updated, that update is left to continue;
+ * if searches are reading from the index, the refresh is skipped.
+ *
+ * \param *index		The index to refresh.
+ * \param *filename		The file to save the index to once it has
+ *				been refreshed, or NULL.
+ * \return			TRUE if the refresh has started, was skipped
+ *				or an update is already running; FALSE on
+ *				failure.
+ */
+
+osbool index_start_refresh(struct index_block *index, char *filename);
+
+
+/**
+ * Run the update of an index until it completes or the time slice ends.
+ *
+ * \param *index		The index to update.
+ * \param end_time		The time at which the slice should end.
+ * \return			TRUE if there is no update left to run; else
+ *				FALSE.
+ */
+
+osbool index_poll(struct index_block *index, os_t end_time);
+
+
+/**
+ * Test whether an index is ready to be read, with no update in progress and
+ * the last build or refresh having completed successfully.
+ *
+ * \param *index		The index to test.
+ * \return			TRUE if the index can be read; else FALSE.
+ */
+
+osbool index_is_valid(struct index_block *index);
+
+
+/**
+ * Register a search as reading from an index, so that the index won't be
+ * refreshed under it. Each claim must be matched by a call to
+ * index_release().
+ *
+ * \param *index		The index being read.
+ */
+
+void index_claim(struct index_block *index);
+
+
+/**
+ * Register that a search has finished reading from an index.
+ *
+ * \param *index		The index that was being read.
+ */
+
+void index_release(struct index_block *index);
+
+
+/**
+ * Return the pathname of the root directory of an index.
+ *
+ * \param *index		The index of interest.
+ * \return			Pointer to the root pathname, or NULL.
+ */
+
+char *index_get_root(struct index_block *index);
+
+
+/**
+ * Return the object, directory and error counts for an index.
+ *
+ * \param *index		The index of interest.
+ * \param *objects		Pointer to a variable to take the number of
+ *				objects in the index, or NULL.
+ * \param *directories		Pointer to a variable to take the number of
+ *				directories in the index, or NULL.
+ * \param *errors		Pointer to a variable to take the number of
+ *				directories which couldn't be read during the
+ *				last build or refresh, or NULL.
+ */
+
+void index_get_counts(struct index_block *index, unsigned *objects, unsigned *directories, unsigned *errors);
+
+
+/**
+ * Test whether a pathname falls within the root of an index, so that its
+ * listing can be read from the index. Nothing is covered while the index is
+ * being updated, or if its last update failed.
+ *
+ * \param *index		The index to test against.
+ * \param *path			The pathname to test.
+ * \return			TRUE if the path is covered; else FALSE.
+ */
+
+osbool index_covers(struct index_block *index, char *path);
+
+
+/**
+ * Read a block of entries for a directory from an index, in the format
+ * returned by OS_GBPB 10, as a direct replacement for fsys_read_dir().
+ * Image files are held as files, so reading one returns no entries.
+ *
+ * \param *index		The index to read from.
+ * \param *path			The pathname of the directory to read.
+ * \param *buffer		Pointer to a buffer to take the entries.
+ * \param count			The maximum number of entries to read.
+ * \param context		The context to start reading from: 0 to
+ *				start at the beginning of the directory.
+ * \param size			The size of the buffer, in bytes.
+ * \param *read			Pointer to a variable to take the number
+ *				of entries read.
+ * \param *next			Pointer to a variable to take the context
+ *				for the next read, or -1 if the directory
+ *				has been completed.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+os_error *index_read_dir(struct index_block *index, char *path, osgbpb_info_list *buffer, int count, int context, int size, int *read, int *next);
+
+#endif
+
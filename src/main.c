@@ -98,9 +98,22 @@
 
 #define MAIN_TASKNAME_BUFFER_LEN 64
 
+/**
+ * The longest gap, in cs, between Null polls for the desktop to be idle.
+ */
+
+#define MAIN_IDLE_GAP 2
+
+/**
+ * The factor by which the timeslot is lengthened on an idle desktop.
+ */
+
+#define MAIN_IDLE_BOOST 4
+
 /* ------------------------------------------------------------------------------------------------------------------ */
 
 static void	main_poll_loop(void);
+static void	main_null_poll(void);
 static void	main_initialise(void);
 static void	main_post_initialise(void);
 static void	main_parse_command_line(int argc, char *argv[]);
@@ -116,6 +129,13 @@ osbool			main_quit_flag = FALSE;
 osspriteop_area		*main_wimp_sprites;
 
 
+/*
+ * Local variables
+ */
+
+static os_t		main_last_null_poll = 0;				/**< The time at which the last Null poll's work finished.	*/
+
+
 /**
  * Main code entry point.
  */
@@ -152,7 +172,7 @@ static void main_poll_loop(void)
 	wimp_poll_flags		mask;
 
 	while (!main_quit_flag) {
-		mask = ((search_poll_required()) ? 0 : wimp_MASK_NULL);
+		mask = ((search_poll_required() || results_poll_required()) ? 0 : wimp_MASK_NULL);
 
 		reason = wimp_poll(mask, &blk, 0);
 
@@ -168,7 +188,7 @@ static void main_poll_loop(void)
 		if (!event_process_event(reason, &blk, 0, NULL)) {
 			switch (reason) {
 			case wimp_NULL_REASON_CODE:
-				search_poll_all();
+				main_null_poll();
 				break;
 
 			case wimp_OPEN_WINDOW_REQUEST:
@@ -188,6 +208,43 @@ static void main_poll_loop(void)
 }
 
 
+/**
+ * Share the multitasking timeslot between the active searches and the results
+ * windows which are checking their objects. If both have work, the searches
+ * are offered half of the slot and the checks get whatever remains. If the
+ * ThroughputMode option is set and the Wimp returned to us almost as soon as
+ * the last Null poll's work ended, the desktop is taken to be idle and the
+ * timeslot is lengthened.
+ */
+
+static void main_null_poll(void)
+{
+	os_t		timeslot, start_time, used;
+	osbool		checking;
+
+	start_time = os_read_monotonic_time();
+
+	timeslot = (os_t) config_int_read("MultitaskTimeslot");
+
+	if (config_opt_read("ThroughputMode") && (start_time - main_last_null_poll) <= MAIN_IDLE_GAP)
+		timeslot *= MAIN_IDLE_BOOST;
+
+	checking = results_poll_required();
+
+	if (search_poll_required()) {
+		search_poll_all((checking) ? timeslot / 2 : timeslot);
+
+		used = os_read_monotonic_time() - start_time;
+		timeslot = (used < timeslot) ? timeslot - used : 0;
+	}
+
+	if (checking)
+		results_poll_all(timeslot);
+
+	main_last_null_poll = os_read_monotonic_time();
+}
+
+
 /**
  * Application initialisation.
  */
@@ -240,12 +297,17 @@ static void main_initialise(void)
 	config_opt_init("ImageFS", FALSE);					/**< TRUE to search ImageFS contents; else FALSE.		*/
 	config_opt_init("SuppressErrors", TRUE);				/**< TRUE to list errors in search results; FALSE to report.	*/
 	config_opt_init("ScrollResults", TRUE);					/**< TRUE to scroll the results window to the last entry.	*/
-	config_int_init("OSGBPBReadSize", 1000);				/**< The number of bytes allocated ot OS_GBPB calls.		*/
+	config_int_init("OSGBPBReadSize", 1000);				/**< The maximum number of objects read by each OS_GBPB call.	*/
 	config_opt_init("QuitAsPlugin", FALSE);					/**< Quit when complete if running as a FilerAction plugin.	*/
 	config_opt_init("SearchWindAsPlugin", FALSE);				/**< TRUE to open a search window when acting as a plugin.	*/
 	config_opt_init("FullInfoDisplay", FALSE);				/**< TRUE to display full file info by default.			*/
 	config_int_init("MultitaskTimeslot", 10);				/**< The timeslot, in cs, allowed for a search poll.		*/
+	config_opt_init("ThroughputMode", FALSE);				/**< TRUE to lengthen search timeslots when the desktop is idle.	*/
+	config_int_init("ContentsBufSize", 0);					/**< The contents search buffer size, in KB; 0 to size from free memory.	*/
 	config_opt_init("ValidatePaths", TRUE);					/**< TRUE to validate search paths on load; FALSE to ignore.	*/
+	config_str_init("IgnoreList", "");					/**< The default comma-separated list of objects to ignore.	*/
+	config_str_init("IndexFile", "");					/**< The filename index which searches can read from, or "".	*/
+	config_str_init("IndexRoot", "");					/**< The directory to build a missing index from, or "".	*/
 
 	config_load();
 
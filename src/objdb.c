@@ -29,6 +29,7 @@
 
 /* ANSI C header files. */
 
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -63,10 +64,13 @@
 
 #include "discfile.h"
 #include "file.h"
+#include "flexutils.h"
+#include "fsys.h"
 #include "textdump.h"
 
 
-#define OBJDB_ALLOC_CHUNK 100							/**< The number of objects to allocate from memory at a time.	*/
+#define OBJDB_ALLOC_CHUNK 100							/**< The minimum number of objects to allocate at a time.	*/
+#define OBJDB_TEXT_HASHES 256							/**< The initial size of the name text dump's hash table.	*/
 #define OBJDB_MAX_DEPTH 255							/**< The maximum directory depth that can be handled.		*/
 
 #define OBJDB_NULL_INDEX 0xffffffffu						/**< An index that does not exist.				*/
@@ -88,7 +92,7 @@ struct objdb_block
 	unsigned		longest_name;					/**< The length of the longest filename string in the database.	*/
 	unsigned		longest_path;					/**< The length of the longest pathname string in the database.	*/
 
-	unsigned		key;						/**< Track new unique primary keys.				*/
+	unsigned		key;						/**< Track new unique primary keys; always equal to objects.	*/
 
 	osbool			full_scan;					/**< TRUE if the database contains a full scan; FALSE if not.	*/
 };
@@ -97,7 +101,9 @@ enum objdb_object_flags
 {
 	OBJDB_OBJECT_FLAGS_NONE = 0,						/**< There are no flags set.					*/
 	OBJDB_OBJECT_FLAGS_LOST = 1,						/**< Set if the object is no longer in its original location.	*/
-	OBJDB_OBJECT_FLAGS_CHANGED = 2						/**< Set if the object is on disc, but has changed somehow.	*/
+	OBJDB_OBJECT_FLAGS_CHANGED = 2,						/**< Set if the object is on disc, but has changed somehow.	*/
+	OBJDB_OBJECT_FLAGS_DELETED = 4,						/**< Set if the object has been deleted from the database.	*/
+	OBJDB_OBJECT_FLAGS_NEW_NAME = 8						/**< Set if the object's name was new to the name text dump.	*/
 };
 
 /**
@@ -118,19 +124,30 @@ struct object
 	fileswitch_attr		attributes;					/**< The file attributes of the object.				*/
 	fileswitch_object_type	type;						/**< The fileswitch object type of the object.			*/
 	unsigned		name;						/**< Textdump offset to the name of the object.			*/
+	unsigned		path_length;					/**< The length of the object's full pathname, excluding terminator.	*/
 };
 
+/**
+ * The size of the object records saved by versions of Locate which did not
+ * store the pathname length; these can be expanded when they are loaded.
+ */
+
+#define OBJDB_LEGACY_OBJECT_SIZE (offsetof(struct object, path_length))
+
 
 static unsigned	objdb_find(struct objdb_block *handle, unsigned key);
 static unsigned	objdb_new(struct objdb_block *handle);
 static osbool	objdb_extend(struct objdb_block *handle, unsigned allocation);
 static void	objdb_delete(struct objdb_block *handle, unsigned index);
+static osbool	objdb_make_dense(struct objdb_block *handle);
+static void	objdb_set_path_length(struct objdb_block *handle, unsigned index, size_t length);
 
 
 /**
  * Create a new object database, returning the handle.
  *
- * \param *file			The file to which the database will belong.
+ * \param *file			The file to which the database will belong, or
+ *				NULL for a free-standing database.
  * \return 			The new database handle, or NULL on failure.
  */
 
@@ -139,9 +156,6 @@ struct objdb_block *objdb_create(struct file_block *file)
 	struct objdb_block	*new;
 
 
-	if (file == NULL)
-		return NULL;
-
 	/* Claim the required memory and initialise the contents. */
 
 	new = heap_alloc(sizeof(struct objdb_block));
@@ -165,7 +179,7 @@ struct objdb_block *objdb_create(struct file_block *file)
 	else
 		new->list = NULL;
 
-	new->text = textdump_create(0, 20, '\0');
+	new->text = textdump_create(0, OBJDB_TEXT_HASHES, '\0');
 
 	/* If either of the sub allocations failed, free the claimed memory and exit. */
 
@@ -238,8 +252,7 @@ unsigned objdb_add_root(struct objdb_block *handle, char *path)
 	if ((length = strlen(path)) > handle->longest_name)
 		handle->longest_name = length;
 
-	if ((length = objdb_get_name_length(handle, handle->list[index].key)) > handle->longest_path)
-		handle->longest_path = length;
+	objdb_set_path_length(handle, index, length);
 
 #ifdef DEBUG
 	debug_printf("\\YAdding root details for %s with key %u", path, handle->list[index].key);
@@ -262,12 +275,21 @@ unsigned objdb_add_root(struct objdb_block *handle, char *path)
 unsigned objdb_add_file(struct objdb_block *handle, unsigned parent, osgbpb_info *file)
 {
 	unsigned	length, name, index = objdb_new(handle);
+	size_t		text_size;
 
 	if (handle == NULL || file == NULL || index == OBJDB_NULL_INDEX)
 		return OBJDB_NULL_KEY;
 
+	/* Note whether the name was new to the dump, so that it can be released
+	 * again if the object is deleted straight away.
+	 */
+
+	text_size = textdump_get_size(handle->text);
 	name = textdump_store(handle->text, file->name);
 
+	if (name != TEXTDUMP_NULL && textdump_get_size(handle->text) > text_size)
+		handle->list[index].flags |= OBJDB_OBJECT_FLAGS_NEW_NAME;
+
 	handle->list[index].parent = parent;
 
 	handle->list[index].load_addr = file->load_addr;
@@ -280,8 +302,7 @@ unsigned objdb_add_file(struct objdb_block *handle, unsigned parent, osgbpb_info
 	if ((length = strlen(file->name)) > handle->longest_name)
 		handle->longest_name = length;
 
-	if ((length = objdb_get_name_length(handle, handle->list[index].key)) > handle->longest_path)
-		handle->longest_path = length;
+	objdb_set_path_length(handle, index, length);
 
 #ifdef DEBUG
 	debug_printf("\\YAdding file details for %s to %u with key %u", file->name, parent, handle->list[index].key);
@@ -291,6 +312,40 @@ unsigned objdb_add_file(struct objdb_block *handle, unsigned parent, osgbpb_info
 }
 
 
+/**
+ * Update the catalogue information held for a file in the object database,
+ * using its OS_GBPB file descriptor block to supply the details. The name
+ * of the object is left unchanged.
+ *
+ * \param *handle		The handle of the database holding the file.
+ * \param key			The key of the object to be updated.
+ * \param *file			The new file data.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+osbool objdb_update_file(struct objdb_block *handle, unsigned key, osgbpb_info *file)
+{
+	unsigned	index;
+
+	if (handle == NULL || file == NULL || key == OBJDB_NULL_KEY)
+		return FALSE;
+
+	index = objdb_find(handle, key);
+
+	if (index == OBJDB_NULL_INDEX)
+		return FALSE;
+
+	handle->list[index].load_addr = file->load_addr;
+	handle->list[index].exec_addr = file->exec_addr;
+	handle->list[index].size = file->size;
+	handle->list[index].attributes = file->attr;
+	handle->list[index].type = file->obj_type;
+	handle->list[index].flags &= ~(OBJDB_OBJECT_FLAGS_LOST | OBJDB_OBJECT_FLAGS_CHANGED);
+
+	return TRUE;
+}
+
+
 /**
  * Validate an entry in the object database by checking to see if it is still
  * present on disc in the same location.
@@ -347,7 +402,7 @@ enum objdb_status objdb_validate_file(struct objdb_block *handle, unsigned key,
 
 	/* Read the object's current details and compare them to those on file. */
 
-	error = xosfile_read_no_path(pathname, &type, &load_addr, &exec_addr, &size, &attributes);
+	error = fsys_read_object(pathname, &type, &load_addr, &exec_addr, &size, &attributes);
 
 	free(pathname);
 
@@ -372,6 +427,44 @@ enum objdb_status objdb_validate_file(struct objdb_block *handle, unsigned key,
 }
 
 
+/**
+ * Record the status of an object in the database, as found by checking it
+ * against the disc.
+ *
+ * \param *handle		The database holding the object.
+ * \param key			The key of the object to update.
+ * \param status		The status found for the object.
+ */
+
+void objdb_set_status(struct objdb_block *handle, unsigned key, enum objdb_status status)
+{
+	unsigned	index;
+
+	if (handle == NULL || key == OBJDB_NULL_KEY)
+		return;
+
+	index = objdb_find(handle, key);
+
+	if (index == OBJDB_NULL_INDEX)
+		return;
+
+	switch (status) {
+	case OBJDB_STATUS_UNCHANGED:
+		handle->list[index].flags &= ~(OBJDB_OBJECT_FLAGS_LOST | OBJDB_OBJECT_FLAGS_CHANGED);
+		break;
+	case OBJDB_STATUS_CHANGED:
+		handle->list[index].flags &= ~OBJDB_OBJECT_FLAGS_LOST;
+		handle->list[index].flags |= OBJDB_OBJECT_FLAGS_CHANGED;
+		break;
+	case OBJDB_STATUS_MISSING:
+		handle->list[index].flags |= OBJDB_OBJECT_FLAGS_LOST;
+		break;
+	case OBJDB_STATUS_ERROR:
+		break;
+	}
+}
+
+
 /**
  * Return the parent of an object in the database.
  *
@@ -459,8 +552,7 @@ osbool objdb_get_name(struct objdb_block *handle, unsigned key, char *buffer, si
 
 size_t objdb_get_name_length(struct objdb_block *handle, unsigned key)
 {
-	unsigned	index, length;
-	char		*base;
+	unsigned	index;
 
 	if (handle == NULL)
 		return 0;
@@ -468,25 +560,13 @@ size_t objdb_get_name_length(struct objdb_block *handle, unsigned key)
 	if (key == OBJDB_NULL_KEY)
 		return handle->longest_path * sizeof(char);
 
-	length = 0;
-
-	base = textdump_get_base(handle->text);
-
-	/* The length calculation is the length of each name plus one for the
-	 * RISC OS '.' separator. This is added to every entry, so the extra
-	 * one will provide space for the '\0' terminator.
-	 */
-
-	do {
-		index = (key != OBJDB_NULL_KEY) ? objdb_find(handle, key) : OBJDB_NULL_INDEX;
+	index = objdb_find(handle, key);
+	if (index == OBJDB_NULL_INDEX)
+		return 0;
 
-		if (index != OBJDB_NULL_INDEX) {
-			length += strlen(base + handle->list[index].name) + 1;
-			key = handle->list[index].parent;
-		}
-	} while (index != OBJDB_NULL_INDEX);
+	/* Allow an extra byte for the '\0' terminator. */
 
-	return length * sizeof(char);
+	return (handle->list[index].path_length + 1) * sizeof(char);
 }
 
 
@@ -519,6 +599,26 @@ unsigned objdb_get_filetype(struct objdb_block *handle, unsigned key)
 }
 
 
+/**
+ * Return the size of an object in the database, as recorded when it was
+ * added.
+ *
+ * \param *handle		The database to look in.
+ * \param key			The key of the object to be returned.
+ * \return			The size in bytes, or -1.
+ */
+
+int objdb_get_size(struct objdb_block *handle, unsigned key)
+{
+	unsigned	index = objdb_find(handle, key);
+
+	if (handle == NULL || index == OBJDB_NULL_INDEX)
+		return -1;
+
+	return handle->list[index].size;
+}
+
+
 /**
  * Return information on an object in the database, or details of the memory
  * buffer required to return those details.
@@ -576,7 +676,8 @@ size_t objdb_get_info(struct objdb_block *handle, unsigned key, osgbpb_info *inf
 /**
  * Load the contents of an object file into the database.
  *
- * \param *file			The file to which the database will belong.
+ * \param *file			The file to which the database will belong, or
+ *				NULL for a free-standing database.
  * \param *load			The discfile handle to load from.
  * \return			The new databse, or NULL on failure.
  */
@@ -585,8 +686,9 @@ struct objdb_block *objdb_load_file(struct file_block *file, struct discfile_blo
 {
 	struct objdb_block	*handle;
 	int			size;
+	unsigned		record, index;
 
-	if (file == NULL || load == NULL)
+	if (load == NULL)
 		return NULL;
 
 	if (discfile_read_format(load) != DISCFILE_LOCATE2)
@@ -619,6 +721,19 @@ struct objdb_block *objdb_load_file(struct file_block *file, struct discfile_blo
 			return NULL;
 		}
 
+		/* Files saved before the record size was stored hold legacy
+		 * records without the pathname length.
+		 */
+
+		if (!discfile_read_option_unsigned(load, "OSZ", &record))
+			record = OBJDB_LEGACY_OBJECT_SIZE;
+
+		if (record < OBJDB_LEGACY_OBJECT_SIZE || record > sizeof(struct object)) {
+			discfile_set_error(load, "FileUnrec");
+			objdb_destroy(handle);
+			return NULL;
+		}
+
 		discfile_close_chunk(load);
 
 		if (handle->objects > handle->allocation)
@@ -640,7 +755,7 @@ struct objdb_block *objdb_load_file(struct file_block *file, struct discfile_blo
 	if (discfile_open_chunk(load, DISCFILE_CHUNK_OBJECTS)) {
 		size = discfile_chunk_size(load);
 
-		if ((size <= handle->allocation * sizeof(struct object)) && (size == handle->objects * sizeof(struct object))){
+		if ((size <= handle->allocation * sizeof(struct object)) && (size == handle->objects * record)){
 			discfile_read_chunk(load, (byte *) handle->list, size);
 		} else {
 			discfile_set_error(load, "FileUnrec");
@@ -655,6 +770,28 @@ struct objdb_block *objdb_load_file(struct file_block *file, struct discfile_blo
 		return NULL;
 	}
 
+	/* If the records were shorter than the current structure, spread them
+	 * out to their full size, working backwards so that nothing is
+	 * overwritten before it has been moved.
+	 */
+
+	if (record < sizeof(struct object)) {
+		for (index = handle->objects; index > 0; index--) {
+			memmove(handle->list + (index - 1), (byte *) handle->list + ((index - 1) * record), record);
+			memset((byte *) (handle->list + (index - 1)) + record, 0, sizeof(struct object) - record);
+		}
+	}
+
+	/* Files saved by older versions of Locate can have gaps in their key
+	 * sequences, which must be filled with deleted entries.
+	 */
+
+	if (!objdb_make_dense(handle)) {
+		discfile_set_error(load, "FileMem");
+		objdb_destroy(handle);
+		return NULL;
+	}
+
 	/* Load the textdump contents into memory. */
 
 	if (!textdump_load_file(handle->text, load)) {
@@ -663,6 +800,15 @@ struct objdb_block *objdb_load_file(struct file_block *file, struct discfile_blo
 		return NULL;
 	}
 
+	/* Fill in any missing pathname lengths in one pass, as parents always
+	 * come before their children.
+	 */
+
+	if (record < sizeof(struct object)) {
+		for (index = 0; index < handle->objects; index++)
+			objdb_set_path_length(handle, index, strlen(textdump_get_base(handle->text) + handle->list[index].name));
+	}
+
 	/* Close the database section of the file. */
 
 	discfile_close_section(load);
@@ -681,9 +827,18 @@ struct objdb_block *objdb_load_file(struct file_block *file, struct discfile_blo
 
 osbool objdb_save_file(struct objdb_block *handle, struct discfile_block *file)
 {
+	unsigned	index;
+
 	if (handle == NULL || file == NULL)
 		return FALSE;
 
+	/* The new name flags are only of use while the objects are being added,
+	 * so clear them rather than write them out.
+	 */
+
+	for (index = 0; index < handle->objects; index++)
+		handle->list[index].flags &= ~OBJDB_OBJECT_FLAGS_NEW_NAME;
+
 	/* Open the database section of the file. */
 
 	discfile_start_section(file, DISCFILE_SECTION_OBJECTDB, FALSE);
@@ -696,6 +851,7 @@ osbool objdb_save_file(struct objdb_block *handle, struct discfile_block *file)
 	discfile_write_option_unsigned(file, "PTH", handle->longest_path);
 	discfile_write_option_unsigned(file, "KEY", handle->key);
 	discfile_write_option_boolean(file, "FUL", handle->full_scan);
+	discfile_write_option_unsigned(file, "OSZ", sizeof(struct object));
 	discfile_end_chunk(file);
 
 	/* Write the database object data. */
@@ -779,19 +935,20 @@ void objdb_delete_last_key(struct objdb_block *handle, unsigned key)
 		return;
 
 	/* Don't bother to free up memory; just release the last allocated
-	 * block for reuse, and also free up the key value if it is also the
-	 * last one to be allocated, to keep the two in step and speed up
-	 * accesses.
+	 * block and its key for reuse, to keep the two in step. If the object
+	 * added its name to the text dump, and nothing has been stored since,
+	 * the name can be released too as nothing else can be using it.
 	 */
 
 #ifdef DEBUG
 	debug_printf("\\ODeleting key %u", handle->list[index].key);
 #endif
 
-	if (handle->list[index].key + 1 == handle->key)
-		handle->key--;
+	if (handle->list[index].flags & OBJDB_OBJECT_FLAGS_NEW_NAME)
+		textdump_remove_last(handle->text, handle->list[index].name);
 
 	handle->objects--;
+	handle->key = handle->objects;
 }
 
 
@@ -810,12 +967,51 @@ unsigned objdb_get_next_key(struct objdb_block *handle, unsigned key)
 	if (handle == NULL)
 		return OBJDB_NULL_KEY;
 
-	if (key == OBJDB_NULL_KEY && handle->objects > 0)
-		return handle->list[0].key;
+	/* Keys and indexes are the same, so step on to the next entry which
+	 * hasn't been deleted.
+	 */
 
-	index = objdb_find(handle, key);
+	index = (key == OBJDB_NULL_KEY) ? 0 : key + 1;
+
+	while (index < handle->objects && (handle->list[index].flags & OBJDB_OBJECT_FLAGS_DELETED))
+		index++;
 
-	return (index != OBJDB_NULL_INDEX && index < (handle->objects - 1)) ? handle->list[index + 1].key : OBJDB_NULL_KEY;
+	return (index < handle->objects) ? handle->list[index].key : OBJDB_NULL_KEY;
+}
+
+
+/**
+ * Return the number of keys which have been allocated in a database,
+ * including those of deleted entries. All keys in the database will be
+ * less than this value.
+ *
+ * \param *handle		The database to look in.
+ * \return			The number of keys allocated.
+ */
+
+unsigned objdb_get_key_limit(struct objdb_block *handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return handle->objects;
+}
+
+
+/**
+ * Record whether a database holds the results of a full scan, with every
+ * object below its roots present, rather than just a set of matches.
+ *
+ * \param *handle		The database to update.
+ * \param full_scan		TRUE if the database holds a full scan; else FALSE.
+ */
+
+void objdb_set_full_scan(struct objdb_block *handle, osbool full_scan)
+{
+	if (handle == NULL)
+		return;
+
+	handle->full_scan = full_scan;
 }
 
 
@@ -829,26 +1025,17 @@ unsigned objdb_get_next_key(struct objdb_block *handle, unsigned key)
 
 static unsigned objdb_find(struct objdb_block *handle, unsigned key)
 {
-	unsigned	index;
-
-	if (handle == NULL)
+	if (handle == NULL || key >= handle->objects)
 		return OBJDB_NULL_INDEX;
 
-	/* We know that keys are allocated in ascending order, possibly
-	 * with gaps in the sequence.  Therefore we can hit the list
-	 * at the corresponding index (or the end) and count back until
-	 * we pass the key we're looking for.
+	/* Keys are allocated densely, with deleted entries left in place, so
+	 * the key is also the index into the list.
 	 */
 
-	index = (key >= handle->objects) ? handle->objects - 1 : key;
-
-	while (index > 0 && handle->list[index].key > key)
-		index--;
-
-	if (handle->list[index].key != key)
-		index = OBJDB_NULL_INDEX;
+	if (handle->list[key].flags & OBJDB_OBJECT_FLAGS_DELETED)
+		return OBJDB_NULL_INDEX;
 
-	return index;
+	return key;
 }
 
 
@@ -866,20 +1053,23 @@ static unsigned objdb_new(struct objdb_block *handle)
 		return OBJDB_NULL_INDEX;
 
 	if (handle->objects >= handle->allocation)
-		objdb_extend(handle, handle->allocation + OBJDB_ALLOC_CHUNK);
+		objdb_extend(handle, flexutils_grow_size(handle->allocation, handle->objects + 1, OBJDB_ALLOC_CHUNK));
 
 	if (handle->objects >= handle->allocation)
 		return OBJDB_NULL_INDEX;
 
-	handle->list[handle->objects].key = handle->key++;
+	handle->list[handle->objects].key = handle->objects;
 	handle->list[handle->objects].load_addr = 0;
 	handle->list[handle->objects].exec_addr = 0;
 	handle->list[handle->objects].size = 0;
 	handle->list[handle->objects].attributes = 0;
 	handle->list[handle->objects].type = 0;
 	handle->list[handle->objects].name = 0;
+	handle->list[handle->objects].path_length = 0;
 	handle->list[handle->objects].flags = OBJDB_OBJECT_FLAGS_NONE;
 
+	handle->key = handle->objects + 1;
+
 	return handle->objects++;
 }
 
@@ -897,7 +1087,7 @@ static osbool objdb_extend(struct objdb_block *handle, unsigned allocation)
 	if (handle == NULL || handle->list == NULL || handle->allocation > allocation)
 		return FALSE;
 
-	if (flex_extend((flex_ptr) &(handle->list), allocation * sizeof(struct object)) != 1)
+	if (!flexutils_resize((flex_ptr) &(handle->list), allocation * sizeof(struct object)))
 		return FALSE;
 
 	handle->allocation = allocation;
@@ -907,7 +1097,8 @@ static osbool objdb_extend(struct objdb_block *handle, unsigned allocation)
 
 
 /**
- * Delete an application block, given its index.
+ * Delete an application block, given its index. The block is left in place
+ * and flagged as deleted, so that keys and indexes remain the same.
  *
  * \param *handle		The database to delete the block from.
  * \param index			The index of the block to be deleted.
@@ -918,10 +1109,89 @@ static void objdb_delete(struct objdb_block *handle, unsigned index)
 	if (handle == NULL || handle->list == NULL || index >= handle->objects)
 		return;
 
-	if (flex_midextend((flex_ptr) &(handle->list), (index + 1) * sizeof(struct object),
-			-sizeof(struct object)) == 1) {
-		handle->objects--;
-		handle->allocation--;
+	handle->list[index].flags |= OBJDB_OBJECT_FLAGS_DELETED;
+}
+
+
+/**
+ * Make sure that every key in a database is stored at the matching index,
+ * by spreading out any entries which have gaps in their key sequence and
+ * filling the gaps with deleted entries.
+ *
+ * \param *handle		The database to process.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool objdb_make_dense(struct objdb_block *handle)
+{
+	unsigned	index, key, objects;
+
+	if (handle == NULL || handle->list == NULL)
+		return FALSE;
+
+	if (handle->objects == 0 || handle->list[handle->objects - 1].key == handle->objects - 1) {
+		handle->key = handle->objects;
+		return TRUE;
 	}
+
+	objects = handle->list[handle->objects - 1].key + 1;
+
+	if (objects > handle->allocation && !objdb_extend(handle, objects))
+		return FALSE;
+
+	/* Keys are in ascending order and never less than their index, so
+	 * working backwards will never overwrite an entry before it is moved.
+	 */
+
+	key = objects;
+
+	for (index = handle->objects; index > 0; index--) {
+		while (key > handle->list[index - 1].key + 1) {
+			key--;
+			memset(handle->list + key, 0, sizeof(struct object));
+			handle->list[key].key = key;
+			handle->list[key].parent = OBJDB_NULL_KEY;
+			handle->list[key].flags = OBJDB_OBJECT_FLAGS_DELETED;
+		}
+
+		key--;
+
+		if (key != index - 1)
+			handle->list[key] = handle->list[index - 1];
+	}
+
+	handle->objects = objects;
+	handle->key = objects;
+
+	return TRUE;
+}
+
+
+/**
+ * Set the cached pathname length for an object, based on the length of its
+ * own name and the cached length of its parent, and update the record of
+ * the longest path in the database.
+ *
+ * \param *handle		The database containing the object.
+ * \param index			The index of the object to update.
+ * \param length		The length of the object's name.
+ */
+
+static void objdb_set_path_length(struct objdb_block *handle, unsigned index, size_t length)
+{
+	unsigned	parent;
+
+	if (handle == NULL || index >= handle->objects)
+		return;
+
+	parent = (handle->list[index].parent != OBJDB_NULL_KEY) ? objdb_find(handle, handle->list[index].parent) : OBJDB_NULL_INDEX;
+
+	if (parent != OBJDB_NULL_INDEX)
+		length += handle->list[parent].path_length + 1;
+
+	handle->list[index].path_length = length;
+
+	if (length + 1 > handle->longest_path)
+		handle->longest_path = length + 1;
 }
 
@@ -67,7 +67,8 @@ struct objdb_info {
 /**
  * Create a new object database, returning the handle.
  *
- * \param *file			The file to which the database will belong.
+ * \param *file			The file to which the database will belong, or
+ *				NULL for a free-standing database.
  * \return 			The new database handle, or NULL on failure.
  */
 
@@ -108,6 +109,20 @@ unsigned objdb_add_root(struct objdb_block *handle, char *path);
 unsigned objdb_add_file(struct objdb_block *handle, unsigned parent, osgbpb_info *file);
 
 
+/**
+ * Update the catalogue information held for a file in the object database,
+ * using its OS_GBPB file descriptor block to supply the details. The name
+ * of the object is left unchanged.
+ *
+ * \param *handle		The handle of the database holding the file.
+ * \param key			The key of the object to be updated.
+ * \param *file			The new file data.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+osbool objdb_update_file(struct objdb_block *handle, unsigned key, osgbpb_info *file);
+
+
 /**
  * Validate an entry in the object database by checking to see if it is still
  * present on disc in the same location.
@@ -121,6 +136,18 @@ unsigned objdb_add_file(struct objdb_block *handle, unsigned parent, osgbpb_info
 enum objdb_status objdb_validate_file(struct objdb_block *handle, unsigned key, osbool retest);
 
 
+/**
+ * Record the status of an object in the database, as found by checking it
+ * against the disc.
+ *
+ * \param *handle		The database holding the object.
+ * \param key			The key of the object to update.
+ * \param status		The status found for the object.
+ */
+
+void objdb_set_status(struct objdb_block *handle, unsigned key, enum objdb_status status);
+
+
 /**
  * Return the parent of an object in the database.
  *
@@ -170,6 +197,18 @@ size_t objdb_get_name_length(struct objdb_block *handle, unsigned key);
 unsigned objdb_get_filetype(struct objdb_block *handle, unsigned key);
 
 
+/**
+ * Return the size of an object in the database, as recorded when it was
+ * added.
+ *
+ * \param *handle		The database to look in.
+ * \param key			The key of the object to be returned.
+ * \return			The size in bytes, or -1.
+ */
+
+int objdb_get_size(struct objdb_block *handle, unsigned key);
+
+
 /**
  * Return information on an object in the database, or details of the memory
  * buffer required to return those details.
@@ -188,7 +227,8 @@ size_t objdb_get_info(struct objdb_block *handle, unsigned key, osgbpb_info *inf
 /**
  * Load the contents of an object file into the database.
  *
- * \param *file			The file to which the database will belong.
+ * \param *file			The file to which the database will belong, or
+ *				NULL for a free-standing database.
  * \param *load			The discfile handle to load from.
  * \return			The new databse, or NULL on failure.
  */
@@ -251,5 +291,28 @@ void objdb_delete_last_key(struct objdb_block *handle, unsigned key);
 
 unsigned objdb_get_next_key(struct objdb_block *handle, unsigned key);
 
+
+/**
+ * Return the number of keys which have been allocated in a database,
+ * including those of deleted entries. All keys in the database will be
+ * less than this value.
+ *
+ * \param *handle		The database to look in.
+ * \return			The number of keys allocated.
+ */
+
+unsigned objdb_get_key_limit(struct objdb_block *handle);
+
+
+/**
+ * Record whether a database holds the results of a full scan, with every
+ * object below its roots present, rather than just a set of matches.
+ *
+ * \param *handle		The database to update.
+ * \param full_scan		TRUE if the database holds a full scan; else FALSE.
+ */
+
+void objdb_set_full_scan(struct objdb_block *handle, osbool full_scan);
+
 #endif
 
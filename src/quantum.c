@@ -0,0 +1,157 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: quantum.c
+ *
+ * Calibrated work quanta for time-sliced loops.
+ */
+
+/* OSLib Header files. */
+
+#include "oslib/os.h"
+#include "oslib/types.h"
+
+/* Application header files. */
+
+#include "quantum.h"
+
+
+#define QUANTUM_CHECK_TIME 1							/**< The target time, in cs, between clock reads.		*/
+#define QUANTUM_MAX_INTERVAL 0x100000u						/**< The largest number of units allowed between clock reads.	*/
+
+
+static osbool quantum_read_clock(struct quantum_block *quantum, osbool calibrate);
+
+
+/**
+ * Initialise a work quantum, before its first time slice.
+ *
+ * \param *quantum		The quantum to initialise.
+ */
+
+void quantum_initialise(struct quantum_block *quantum)
+{
+	if (quantum == NULL)
+		return;
+
+	quantum->end_time = 0;
+	quantum->check_time = 0;
+	quantum->interval = 1;
+	quantum->units = 0;
+	quantum->expired = TRUE;
+}
+
+
+/**
+ * Start a new time slice for a work quantum.
+ *
+ * \param *quantum		The quantum to start.
+ * \param end_time		The time at which the slice should end.
+ */
+
+void quantum_start(struct quantum_block *quantum, os_t end_time)
+{
+	if (quantum == NULL)
+		return;
+
+	quantum->end_time = end_time;
+
+	quantum_read_clock(quantum, FALSE);
+}
+
+
+/**
+ * Record units of work done against a quantum, reading the clock and
+ * recalibrating if the calibrated interval has been used up.
+ *
+ * \param *quantum		The quantum to update.
+ * \param units			The number of units of work done.
+ * \return			TRUE if the time slice has ended; else FALSE.
+ */
+
+osbool quantum_expired(struct quantum_block *quantum, unsigned units)
+{
+	if (quantum == NULL)
+		return TRUE;
+
+	quantum->units += units;
+
+	if (quantum->units < quantum->interval)
+		return quantum->expired;
+
+	return quantum_read_clock(quantum, TRUE);
+}
+
+
+/**
+ * Read the clock for a quantum immediately, without recalibrating.
+ *
+ * \param *quantum		The quantum to check.
+ * \return			TRUE if the time slice has ended; else FALSE.
+ */
+
+osbool quantum_check(struct quantum_block *quantum)
+{
+	if (quantum == NULL)
+		return TRUE;
+
+	return quantum_read_clock(quantum, FALSE);
+}
+
+
+/**
+ * Read the clock for a quantum and update its expiry state. If requested,
+ * the interval between reads is recalibrated from the units done since the
+ * last read: doubled if no time passed, or scaled down if the read came
+ * later than intended.
+ *
+ * \param *quantum		The quantum to update.
+ * \param calibrate		TRUE to recalibrate the interval; else FALSE.
+ * \return			TRUE if the time slice has ended; else FALSE.
+ */
+
+static osbool quantum_read_clock(struct quantum_block *quantum, osbool calibrate)
+{
+	os_t	now, elapsed;
+
+	now = os_read_monotonic_time();
+	elapsed = now - quantum->check_time;
+
+	if (calibrate && quantum->units > 0) {
+		if (elapsed < QUANTUM_CHECK_TIME && quantum->interval < QUANTUM_MAX_INTERVAL)
+			quantum->interval *= 2;
+		else if (elapsed > QUANTUM_CHECK_TIME)
+			quantum->interval = (quantum->units * QUANTUM_CHECK_TIME) / elapsed;
+
+		if (quantum->interval == 0)
+			quantum->interval = 1;
+	}
+
+	quantum->check_time = now;
+	quantum->units = 0;
+	quantum->expired = ((int) (now - quantum->end_time) >= 0) ? TRUE : FALSE;
+
+	return quantum->expired;
+}
+
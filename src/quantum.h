@@ -0,0 +1,100 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: quantum.h
+ *
+ * Calibrated work quanta for time-sliced loops.
+ *
+ * Rather than reading the monotonic clock on every pass of a loop, the loop
+ * reports the units of work (objects, bytes) that it has done, and the clock
+ * is only read once enough units have built up to fill the calibrated
+ * interval. The interval is adjusted after each read, so that the clock is
+ * checked about once per centisecond whatever the unit cost turns out to be.
+ */
+
+#ifndef LOCATE_QUANTUM
+#define LOCATE_QUANTUM
+
+#include "oslib/os.h"
+#include "oslib/types.h"
+
+
+/**
+ * A work quantum. The block is embedded in its owner's data, and the
+ * calibration is kept from one time slice to the next.
+ */
+
+struct quantum_block {
+	os_t		end_time;						/**< The time at which the current slice ends.			*/
+	os_t		check_time;						/**< The time at which the clock was last read.			*/
+	unsigned	interval;						/**< The number of units calibrated to fit between clock reads.	*/
+	unsigned	units;							/**< The number of units done since the clock was last read.	*/
+	osbool		expired;						/**< TRUE if the current slice has ended; else FALSE.		*/
+};
+
+
+/**
+ * Initialise a work quantum, before its first time slice.
+ *
+ * \param *quantum		The quantum to initialise.
+ */
+
+void quantum_initialise(struct quantum_block *quantum);
+
+
+/**
+ * Start a new time slice for a work quantum.
+ *
+ * \param *quantum		The quantum to start.
+ * \param end_time		The time at which the slice should end.
+ */
+
+void quantum_start(struct quantum_block *quantum, os_t end_time);
+
+
+/**
+ * Record units of work done against a quantum, reading the clock and
+ * recalibrating if the calibrated interval has been used up.
+ *
+ * \param *quantum		The quantum to update.
+ * \param units			The number of units of work done.
+ * \return			TRUE if the time slice has ended; else FALSE.
+ */
+
+osbool quantum_expired(struct quantum_block *quantum, unsigned units);
+
+
+/**
+ * Read the clock for a quantum immediately, without recalibrating. This is
+ * for use after operations, such as filing system calls, whose cost bears no
+ * relation to the units being counted.
+ *
+ * \param *quantum		The quantum to check.
+ * \return			TRUE if the time slice has ended; else FALSE.
+ */
+
+osbool quantum_check(struct quantum_block *quantum);
+
+#endif
+
@@ -0,0 +1,1267 @@
+/* Copyright 2016, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: regex.c
+ *
+ * Regular expression matching for filenames.
+ *
+ * Expressions are parsed into a tree, from which a Thompson NFA is generated.
+ * Names are matched by a DFA which is built lazily from the NFA as symbols are
+ * seen, so each name is matched in a single pass with no backtracking. If the
+ * cache of DFA states fills up, it is flushed and rebuilt as required.
+ *
+ * The supported syntax covers literals, ., [] and [^] classes, the \d, \w and
+ * \s escapes (and their capitals), ( ) grouping, | alternation, the *, + and ?
+ * quantifiers, {m}, {m,} and {m,n} repeats, and ^ and $ anchors. An expression
+ * matches if it is found anywhere within a name, unless anchored. When case
+ * is to be ignored, both cases of every letter are added to the classes as
+ * the expression is compiled.
+ *
+ * The start and end of a name are presented to the automaton as two extra
+ * symbols, which are the only things that ^ and $ can match.
+ */
+
+/* ANSI C Header files. */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* OSLib header files */
+
+#include "oslib/types.h"
+
+/* SF-Lib header files. */
+
+#include "sflib/debug.h"
+#include "sflib/heap.h"
+
+/* Application header files */
+
+#include "regex.h"
+
+
+#define REGEX_SYMBOLS 258							/**< The number of symbols: the 256 characters, plus start and end.	*/
+#define REGEX_SYMBOL_START 256							/**< The symbol presented before the first character of a name.	*/
+#define REGEX_SYMBOL_END 257							/**< The symbol presented after the last character of a name.		*/
+#define REGEX_CLASS_WORDS ((REGEX_SYMBOLS + 31) / 32)				/**< The number of words in a character class bitmap.			*/
+
+#define REGEX_MAX_STATES 2048							/**< The maximum number of NFA states in an expression.		*/
+#define REGEX_MAX_DFA 128							/**< The maximum number of DFA states cached at once.			*/
+#define REGEX_MAX_REPEAT 255							/**< The largest count allowed in a {m,n} repeat.			*/
+
+#define REGEX_NONE 0xffffffffu							/**< No node, state or list entry.					*/
+#define REGEX_UNKNOWN 0xfffffffeu						/**< A DFA transition which has not yet been built.			*/
+#define REGEX_INFINITE 0xffffffffu						/**< An unbounded repeat count.					*/
+
+#define REGEX_DFA_ACCEPT 0x01u							/**< The DFA state contains the NFA match state.			*/
+#define REGEX_DFA_FINAL 0x02u							/**< The DFA state will accept whatever follows.			*/
+#define REGEX_DFA_DEAD 0x04u							/**< The DFA state can never accept.					*/
+
+#define REGEX_TEST(set, bit) (((set)[(bit) / 32] & (1u << ((bit) % 32))) != 0)
+#define REGEX_SET(set, bit) ((set)[(bit) / 32] |= (1u << ((bit) % 32)))
+
+
+/**
+ * Parse tree node types.
+ */
+
+enum regex_node_type {
+	REGEX_NODE_EMPTY,							/**< Match the empty string.						*/
+	REGEX_NODE_CLASS,							/**< Match one symbol from a class.					*/
+	REGEX_NODE_CONCAT,							/**< Match the left node followed by the right.			*/
+	REGEX_NODE_ALTERNATE,							/**< Match either the left node or the right.				*/
+	REGEX_NODE_REPEAT							/**< Match the left node a number of times.				*/
+};
+
+/**
+ * A parse tree node.
+ */
+
+struct regex_node {
+	enum regex_node_type	type;						/**< The type of node.							*/
+	unsigned		left;						/**< The left child node, or the class for a class node.		*/
+	unsigned		right;						/**< The right child node.						*/
+	unsigned		minimum;					/**< The minimum repeat count.						*/
+	unsigned		maximum;					/**< The maximum repeat count, or REGEX_INFINITE.			*/
+};
+
+/**
+ * NFA state types.
+ */
+
+enum regex_state_type {
+	REGEX_STATE_CLASS,							/**< Consume one symbol from a class.					*/
+	REGEX_STATE_SPLIT,							/**< Follow both out and out1 without consuming anything.		*/
+	REGEX_STATE_EPSILON,							/**< Follow out without consuming anything.				*/
+	REGEX_STATE_MATCH							/**< The expression has matched.					*/
+};
+
+/**
+ * An NFA state. While a state's exits are waiting to be connected up, they
+ * are used to hold a linked list of all of the unconnected exits in the
+ * fragment.
+ */
+
+struct regex_state {
+	enum regex_state_type	type;						/**< The type of state.							*/
+	unsigned		out;						/**< The next state.							*/
+	unsigned		out1;						/**< The alternative next state, for splits.				*/
+	unsigned		class;						/**< The class of symbols consumed, for class states.			*/
+};
+
+/**
+ * An NFA fragment under construction.
+ */
+
+struct regex_fragment {
+	unsigned		start;						/**< The state at which the fragment starts, or REGEX_NONE.		*/
+	unsigned		list;						/**< The list of unconnected exits from the fragment.			*/
+};
+
+/**
+ * The state of an expression compilation.
+ */
+
+struct regex_parser {
+	char			*pattern;					/**< The expression being parsed.					*/
+	size_t			position;					/**< The current position in the expression.				*/
+	osbool			any_case;					/**< TRUE if case is to be ignored; else FALSE.				*/
+	osbool			error;						/**< TRUE if an error has been found; else FALSE.			*/
+
+	struct regex_node	*nodes;						/**< The parse tree nodes.						*/
+	unsigned		node_count;					/**< The number of nodes in use.					*/
+	unsigned		node_size;					/**< The number of nodes allocated.					*/
+};
+
+/**
+ * A compiled regular expression.
+ */
+
+struct regex_block {
+	bits			*classes;					/**< The symbol class bitmaps.						*/
+	unsigned		class_count;					/**< The number of classes in use.					*/
+	unsigned		class_size;					/**< The number of classes allocated.					*/
+
+	struct regex_state	*states;					/**< The NFA states.							*/
+	unsigned		state_count;					/**< The number of NFA states.						*/
+	unsigned		nfa_start;					/**< The NFA start state.						*/
+	unsigned		match;						/**< The NFA match state.						*/
+	unsigned		tail_class;					/**< The class which follows a complete match.				*/
+	unsigned		tail;						/**< The state which follows a complete match.				*/
+
+	unsigned		group[REGEX_SYMBOLS];				/**< The group to which each symbol belongs.				*/
+	unsigned		group_symbol[REGEX_SYMBOLS];			/**< A representative symbol for each group.				*/
+	unsigned		groups;						/**< The number of symbol groups.					*/
+
+	unsigned		words;						/**< The number of words in an NFA state set.				*/
+	bits			*sets;						/**< The NFA state sets for the cached DFA states.			*/
+	unsigned		*next;						/**< The DFA transitions, by state and symbol group.			*/
+	byte			*flags;						/**< The flags for each cached DFA state.				*/
+	unsigned		dfa_count;					/**< The number of cached DFA states.					*/
+	unsigned		start;						/**< The DFA state after the start symbol, or REGEX_NONE.		*/
+	unsigned		flushes;					/**< The number of times that the DFA cache has been flushed.		*/
+
+	bits			*work;						/**< A working NFA state set.						*/
+	unsigned		*stack;						/**< A working stack for closure calculations.				*/
+};
+
+
+static unsigned			regex_parse_alternate(struct regex_parser *parser, struct regex_block *handle);
+static unsigned			regex_parse_concat(struct regex_parser *parser, struct regex_block *handle);
+static unsigned			regex_parse_repeat(struct regex_parser *parser, struct regex_block *handle);
+static unsigned			regex_parse_atom(struct regex_parser *parser, struct regex_block *handle);
+static unsigned			regex_parse_class(struct regex_parser *parser, struct regex_block *handle);
+static osbool			regex_parse_count(struct regex_parser *parser, unsigned *minimum, unsigned *maximum);
+static osbool			regex_add_escape(struct regex_block *handle, unsigned class, char escape);
+static void			regex_fold_class(struct regex_block *handle, unsigned class, osbool any_case, osbool invert);
+static unsigned			regex_new_node(struct regex_parser *parser, enum regex_node_type type, unsigned left, unsigned right);
+static unsigned			regex_new_class(struct regex_block *handle);
+
+static struct regex_fragment	regex_generate(struct regex_parser *parser, struct regex_block *handle, unsigned node);
+static struct regex_fragment	regex_concat(struct regex_block *handle, struct regex_fragment first, struct regex_fragment second);
+static unsigned			regex_new_state(struct regex_block *handle, enum regex_state_type type, unsigned out, unsigned out1, unsigned class);
+static void			regex_patch(struct regex_block *handle, unsigned list, unsigned state);
+static unsigned			regex_append(struct regex_block *handle, unsigned first, unsigned second);
+static unsigned			*regex_exit(struct regex_block *handle, unsigned entry);
+static void			regex_make_groups(struct regex_block *handle);
+
+static void			regex_closure(struct regex_block *handle, bits *set, unsigned state);
+static unsigned			regex_add_dfa(struct regex_block *handle, bits *set);
+static unsigned			regex_step(struct regex_block *handle, unsigned state, unsigned symbol);
+
+
+/**
+ * Compile a regular expression.
+ *
+ * \param *expression		The expression to compile.
+ * \param any_case		TRUE to match without regard to case; else FALSE.
+ * \return			The new expression handle, or NULL if the expression
+ *				was invalid or memory could not be claimed.
+ */
+
+struct regex_block *regex_create(char *expression, osbool any_case)
+{
+	struct regex_block	*new;
+	struct regex_parser	parser;
+	struct regex_fragment	fragment;
+	unsigned		root, lead, tail, class, i;
+
+	if (expression == NULL)
+		return NULL;
+
+	new = heap_alloc(sizeof(struct regex_block));
+	if (new == NULL)
+		return NULL;
+
+	/* Every node and class comes from at most one character in the
+	 * expression, plus a few to wrap the expression up.
+	 */
+
+	parser.pattern = expression;
+	parser.position = 0;
+	parser.any_case = any_case;
+	parser.error = FALSE;
+	parser.node_count = 0;
+	parser.node_size = 3 * strlen(expression) + 8;
+	parser.nodes = heap_alloc(parser.node_size * sizeof(struct regex_node));
+
+	new->class_count = 0;
+	new->class_size = strlen(expression) + 4;
+	new->classes = heap_alloc(new->class_size * REGEX_CLASS_WORDS * sizeof(bits));
+
+	new->state_count = 0;
+	new->states = heap_alloc(REGEX_MAX_STATES * sizeof(struct regex_state));
+
+	new->sets = NULL;
+	new->next = NULL;
+	new->flags = NULL;
+	new->work = NULL;
+	new->stack = NULL;
+
+	if (parser.nodes == NULL || new->classes == NULL || new->states == NULL) {
+		if (parser.nodes != NULL)
+			heap_free(parser.nodes);
+		regex_destroy(new);
+		return NULL;
+	}
+
+	/* Parse the expression, and wrap it up so that it can be found
+	 * anywhere in a name: the start symbol and any characters may come
+	 * before it, and any characters and the end symbol may follow it.
+	 */
+
+	root = regex_parse_alternate(&parser, new);
+
+	if (parser.pattern[parser.position] != '\0')
+		parser.error = TRUE;
+
+	if (!parser.error) {
+		class = regex_new_class(new);
+		for (i = 0; i < 256; i++)
+			REGEX_SET(new->classes + class * REGEX_CLASS_WORDS, i);
+		REGEX_SET(new->classes + class * REGEX_CLASS_WORDS, REGEX_SYMBOL_START);
+
+		lead = regex_new_node(&parser, REGEX_NODE_REPEAT, regex_new_node(&parser, REGEX_NODE_CLASS, class, REGEX_NONE), REGEX_NONE);
+
+		new->tail_class = regex_new_class(new);
+		for (i = 0; i < 256; i++)
+			REGEX_SET(new->classes + new->tail_class * REGEX_CLASS_WORDS, i);
+		REGEX_SET(new->classes + new->tail_class * REGEX_CLASS_WORDS, REGEX_SYMBOL_END);
+
+		tail = regex_new_node(&parser, REGEX_NODE_REPEAT, regex_new_node(&parser, REGEX_NODE_CLASS, new->tail_class, REGEX_NONE), REGEX_NONE);
+
+		root = regex_new_node(&parser, REGEX_NODE_CONCAT, regex_new_node(&parser, REGEX_NODE_CONCAT, lead, root), tail);
+	}
+
+	/* Generate the NFA from the parse tree, then finish it off with a
+	 * match state.
+	 */
+
+	new->tail = REGEX_NONE;
+
+	if (!parser.error) {
+		fragment = regex_generate(&parser, new, root);
+		new->match = regex_new_state(new, REGEX_STATE_MATCH, REGEX_NONE, REGEX_NONE, REGEX_NONE);
+
+		if (!parser.error) {
+			regex_patch(new, fragment.list, new->match);
+			new->nfa_start = fragment.start;
+		}
+	}
+
+	heap_free(parser.nodes);
+
+	if (parser.error) {
+		regex_destroy(new);
+		return NULL;
+	}
+
+	/* Group together the symbols which no class can tell apart, then claim
+	 * the memory for the DFA cache.
+	 */
+
+	regex_make_groups(new);
+
+	new->words = (new->state_count + 31) / 32;
+	new->dfa_count = 0;
+	new->start = REGEX_NONE;
+	new->flushes = 0;
+
+	new->sets = heap_alloc(REGEX_MAX_DFA * new->words * sizeof(bits));
+	new->next = heap_alloc(REGEX_MAX_DFA * new->groups * sizeof(unsigned));
+	new->flags = heap_alloc(REGEX_MAX_DFA * sizeof(byte));
+	new->work = heap_alloc(new->words * sizeof(bits));
+	new->stack = heap_alloc(new->state_count * sizeof(unsigned));
+
+	if (new->sets == NULL || new->next == NULL || new->flags == NULL || new->work == NULL || new->stack == NULL) {
+		regex_destroy(new);
+		return NULL;
+	}
+
+#ifdef DEBUG
+	debug_printf("Regex compiled: %u NFA states, %u classes, %u symbol groups", new->state_count, new->class_count, new->groups);
+#endif
+
+	return new;
+}
+
+
+/**
+ * Destroy a compiled regular expression.
+ *
+ * \param *handle		The expression to destroy.
+ */
+
+void regex_destroy(struct regex_block *handle)
+{
+	if (handle == NULL)
+		return;
+
+	if (handle->classes != NULL)
+		heap_free(handle->classes);
+
+	if (handle->states != NULL)
+		heap_free(handle->states);
+
+	if (handle->sets != NULL)
+		heap_free(handle->sets);
+
+	if (handle->next != NULL)
+		heap_free(handle->next);
+
+	if (handle->flags != NULL)
+		heap_free(handle->flags);
+
+	if (handle->work != NULL)
+		heap_free(handle->work);
+
+	if (handle->stack != NULL)
+		heap_free(handle->stack);
+
+	heap_free(handle);
+}
+
+
+/**
+ * Test a name against a compiled regular expression.
+ *
+ * \param *handle		The expression to test against.
+ * \param *name			The name to test.
+ * \return			TRUE if the name matches; else FALSE.
+ */
+
+osbool regex_match(struct regex_block *handle, char *name)
+{
+	unsigned	state;
+
+	if (handle == NULL || name == NULL)
+		return FALSE;
+
+	if (handle->start == REGEX_NONE) {
+		memset(handle->work, 0, handle->words * sizeof(bits));
+		regex_closure(handle, handle->work, handle->nfa_start);
+		state = regex_add_dfa(handle, handle->work);
+		handle->start = regex_step(handle, state, REGEX_SYMBOL_START);
+	}
+
+	state = handle->start;
+
+	while (*name != '\0') {
+		if (handle->flags[state] & REGEX_DFA_FINAL)
+			return TRUE;
+
+		if (handle->flags[state] & REGEX_DFA_DEAD)
+			return FALSE;
+
+		state = regex_step(handle, state, (unsigned char) *name++);
+	}
+
+	state = regex_step(handle, state, REGEX_SYMBOL_END);
+
+	return (handle->flags[state] & REGEX_DFA_ACCEPT) ? TRUE : FALSE;
+}
+
+
+/**
+ * Parse a series of alternatives, separated by |.
+ *
+ * \param *parser		The parser state.
+ * \param *handle		The expression being compiled.
+ * \return			The resulting parse tree node.
+ */
+
+static unsigned regex_parse_alternate(struct regex_parser *parser, struct regex_block *handle)
+{
+	unsigned	node;
+
+	node = regex_parse_concat(parser, handle);
+
+	while (!parser->error && parser->pattern[parser->position] == '|') {
+		parser->position++;
+		node = regex_new_node(parser, REGEX_NODE_ALTERNATE, node, regex_parse_concat(parser, handle));
+	}
+
+	return node;
+}
+
+
+/**
+ * Parse a sequence of items, up to the next | or ) or the end of the
+ * expression.
+ *
+ * \param *parser		The parser state.
+ * \param *handle		The expression being compiled.
+ * \return			The resulting parse tree node.
+ */
+
+static unsigned regex_parse_concat(struct regex_parser *parser, struct regex_block *handle)
+{
+	unsigned	node = REGEX_NONE;
+	char		c;
+
+	while (!parser->error) {
+		c = parser->pattern[parser->position];
+
+		if (c == '\0' || c == '|' || c == ')')
+			break;
+
+		if (node == REGEX_NONE)
+			node = regex_parse_repeat(parser, handle);
+		else
+			node = regex_new_node(parser, REGEX_NODE_CONCAT, node, regex_parse_repeat(parser, handle));
+	}
+
+	if (node == REGEX_NONE)
+		node = regex_new_node(parser, REGEX_NODE_EMPTY, REGEX_NONE, REGEX_NONE);
+
+	return node;
+}
+
+
+/**
+ * Parse a single item, followed by any quantifiers.
+ *
+ * \param *parser		The parser state.
+ * \param *handle		The expression being compiled.
+ * \return			The resulting parse tree node.
+ */
+
+static unsigned regex_parse_repeat(struct regex_parser *parser, struct regex_block *handle)
+{
+	unsigned	node, minimum, maximum;
+	osbool		quantifier;
+
+	node = regex_parse_atom(parser, handle);
+
+	do {
+		quantifier = TRUE;
+
+		switch (parser->pattern[parser->position]) {
+		case '*':
+			minimum = 0;
+			maximum = REGEX_INFINITE;
+			parser->position++;
+			break;
+		case '+':
+			minimum = 1;
+			maximum = REGEX_INFINITE;
+			parser->position++;
+			break;
+		case '?':
+			minimum = 0;
+			maximum = 1;
+			parser->position++;
+			break;
+		case '{':
+			quantifier = regex_parse_count(parser, &minimum, &maximum);
+			break;
+		default:
+			quantifier = FALSE;
+			break;
+		}
+
+		if (quantifier && !parser->error) {
+			node = regex_new_node(parser, REGEX_NODE_REPEAT, node, REGEX_NONE);
+			if (!parser->error) {
+				parser->nodes[node].minimum = minimum;
+				parser->nodes[node].maximum = maximum;
+			}
+		}
+	} while (quantifier && !parser->error);
+
+	return node;
+}
+
+
+/**
+ * Parse a {m}, {m,} or {m,n} repeat count. If the text does not form a
+ * valid count, it is left to be parsed as literal characters.
+ *
+ * \param *parser		The parser state.
+ * \param *minimum		Pointer to a variable to take the minimum count.
+ * \param *maximum		Pointer to a variable to take the maximum count.
+ * \return			TRUE if a count was found; else FALSE.
+ */
+
+static osbool regex_parse_count(struct regex_parser *parser, unsigned *minimum, unsigned *maximum)
+{
+	char		*start, *end;
+
+	start = parser->pattern + parser->position + 1;
+
+	if (!isdigit(*start))
+		return FALSE;
+
+	*minimum = strtoul(start, &end, 10);
+	*maximum = *minimum;
+
+	if (*end == ',') {
+		end++;
+
+		if (isdigit(*end))
+			*maximum = strtoul(end, &end, 10);
+		else
+			*maximum = REGEX_INFINITE;
+	}
+
+	if (*end != '}')
+		return FALSE;
+
+	if (*minimum > REGEX_MAX_REPEAT || (*maximum != REGEX_INFINITE && (*maximum > REGEX_MAX_REPEAT || *maximum < *minimum)))
+		parser->error = TRUE;
+
+	parser->position = end + 1 - parser->pattern;
+
+	return TRUE;
+}
+
+
+/**
+ * Parse a single atom: a bracketed expression, a class, an anchor or a
+ * literal character.
+ *
+ * \param *parser		The parser state.
+ * \param *handle		The expression being compiled.
+ * \return			The resulting parse tree node.
+ */
+
+static unsigned regex_parse_atom(struct regex_parser *parser, struct regex_block *handle)
+{
+	unsigned	node, class, i;
+	char		c;
+
+	c = parser->pattern[parser->position++];
+
+	switch (c) {
+	case '(':
+		node = regex_parse_alternate(parser, handle);
+		if (parser->pattern[parser->position] != ')')
+			parser->error = TRUE;
+		else
+			parser->position++;
+		return node;
+
+	case '[':
+		return regex_parse_class(parser, handle);
+
+	case '*':
+	case '+':
+	case '?':
+	case '\0':
+		parser->error = TRUE;
+		return REGEX_NONE;
+	}
+
+	class = regex_new_class(handle);
+	if (class == REGEX_NONE) {
+		parser->error = TRUE;
+		return REGEX_NONE;
+	}
+
+	switch (c) {
+	case '.':
+		for (i = 0; i < 256; i++)
+			REGEX_SET(handle->classes + class * REGEX_CLASS_WORDS, i);
+		break;
+
+	case '^':
+		REGEX_SET(handle->classes + class * REGEX_CLASS_WORDS, REGEX_SYMBOL_START);
+		break;
+
+	case '$':
+		REGEX_SET(handle->classes + class * REGEX_CLASS_WORDS, REGEX_SYMBOL_END);
+		break;
+
+	case '\\':
+		c = parser->pattern[parser->position++];
+		if (c == '\0') {
+			parser->error = TRUE;
+			return REGEX_NONE;
+		}
+
+		if (!regex_add_escape(handle, class, c))
+			REGEX_SET(handle->classes + class * REGEX_CLASS_WORDS, (unsigned char) c);
+
+		regex_fold_class(handle, class, parser->any_case, FALSE);
+		break;
+
+	default:
+		REGEX_SET(handle->classes + class * REGEX_CLASS_WORDS, (unsigned char) c);
+		regex_fold_class(handle, class, parser->any_case, FALSE);
+		break;
+	}
+
+	return regex_new_node(parser, REGEX_NODE_CLASS, class, REGEX_NONE);
+}
+
+
+/**
+ * Parse a bracketed class, the opening [ having already been read.
+ *
+ * \param *parser		The parser state.
+ * \param *handle		The expression being compiled.
+ * \return			The resulting parse tree node.
+ */
+
+static unsigned regex_parse_class(struct regex_parser *parser, struct regex_block *handle)
+{
+	unsigned	class, c, last, i;
+	osbool		invert = FALSE, first = TRUE;
+	char		*pattern = parser->pattern;
+
+	class = regex_new_class(handle);
+	if (class == REGEX_NONE) {
+		parser->error = TRUE;
+		return REGEX_NONE;
+	}
+
+	if (pattern[parser->position] == '^') {
+		invert = TRUE;
+		parser->position++;
+	}
+
+	/* A ] straight after the opening bracket is taken as a literal. */
+
+	while (pattern[parser->position] != '\0' && (first || pattern[parser->position] != ']')) {
+		first = FALSE;
+		c = (unsigned char) pattern[parser->position++];
+
+		if (c == '\\') {
+			c = (unsigned char) pattern[parser->position++];
+			if (c == '\0')
+				break;
+
+			if (regex_add_escape(handle, class, c))
+				continue;
+		}
+
+		/* Check for a range, which ends before a closing ]. */
+
+		if (pattern[parser->position] == '-' && pattern[parser->position + 1] != ']' && pattern[parser->position + 1] != '\0') {
+			parser->position++;
+			last = (unsigned char) pattern[parser->position++];
+
+			if (last == '\\' && pattern[parser->position] != '\0')
+				last = (unsigned char) pattern[parser->position++];
+
+			if (last < c) {
+				parser->error = TRUE;
+				return REGEX_NONE;
+			}
+
+			for (i = c; i <= last; i++)
+				REGEX_SET(handle->classes + class * REGEX_CLASS_WORDS, i);
+		} else {
+			REGEX_SET(handle->classes + class * REGEX_CLASS_WORDS, c);
+		}
+	}
+
+	if (pattern[parser->position] != ']') {
+		parser->error = TRUE;
+		return REGEX_NONE;
+	}
+
+	parser->position++;
+
+	regex_fold_class(handle, class, parser->any_case, invert);
+
+	return regex_new_node(parser, REGEX_NODE_CLASS, class, REGEX_NONE);
+}
+
+
+/**
+ * Add the characters for a \d, \w or \s escape (or their inverses) to a
+ * class.
+ *
+ * \param *handle		The expression being compiled.
+ * \param class			The class to add the characters to.
+ * \param escape		The character following the \.
+ * \return			TRUE if the escape was a class; FALSE if it is
+ *				to be taken literally.
+ */
+
+static osbool regex_add_escape(struct regex_block *handle, unsigned class, char escape)
+{
+	bits		*set = handle->classes + class * REGEX_CLASS_WORDS;
+	unsigned	i;
+	int		(*test)(int);
+
+	switch (tolower(escape)) {
+	case 'd':
+		test = isdigit;
+		break;
+	case 'w':
+		test = isalnum;
+		break;
+	case 's':
+		test = isspace;
+		break;
+	default:
+		return FALSE;
+	}
+
+	for (i = 0; i < 256; i++) {
+		if (((test(i) || (tolower(escape) == 'w' && i == '_')) ? TRUE : FALSE) != (isupper(escape) ? TRUE : FALSE))
+			REGEX_SET(set, i);
+	}
+
+	return TRUE;
+}
+
+
+/**
+ * Complete a class of characters, adding the other case of each letter if
+ * case is to be ignored, and then inverting the character symbols if
+ * required.
+ *
+ * \param *handle		The expression being compiled.
+ * \param class			The class to complete.
+ * \param any_case		TRUE if case is to be ignored; else FALSE.
+ * \param invert		TRUE to invert the class; else FALSE.
+ */
+
+static void regex_fold_class(struct regex_block *handle, unsigned class, osbool any_case, osbool invert)
+{
+	bits		*set = handle->classes + class * REGEX_CLASS_WORDS;
+	unsigned	i;
+
+	if (any_case) {
+		for (i = 0; i < 256; i++) {
+			if (REGEX_TEST(set, i)) {
+				REGEX_SET(set, (unsigned char) tolower(i));
+				REGEX_SET(set, (unsigned char) toupper(i));
+			}
+		}
+	}
+
+	if (invert)
+		for (i = 0; i < 256 / 32; i++)
+			set[i] = ~set[i];
+}
+
+
+/**
+ * Claim a new parse tree node.
+ *
+ * \param *parser		The parser state.
+ * \param type			The type of node.
+ * \param left			The left child, or class.
+ * \param right			The right child.
+ * \return			The new node, or REGEX_NONE on failure.
+ */
+
+static unsigned regex_new_node(struct regex_parser *parser, enum regex_node_type type, unsigned left, unsigned right)
+{
+	unsigned	node;
+
+	if (parser->error || parser->node_count >= parser->node_size) {
+		parser->error = TRUE;
+		return REGEX_NONE;
+	}
+
+	node = parser->node_count++;
+
+	parser->nodes[node].type = type;
+	parser->nodes[node].left = left;
+	parser->nodes[node].right = right;
+	parser->nodes[node].minimum = 0;
+	parser->nodes[node].maximum = REGEX_INFINITE;
+
+	return node;
+}
+
+
+/**
+ * Claim a new, empty, symbol class.
+ *
+ * \param *handle		The expression being compiled.
+ * \return			The new class, or REGEX_NONE on failure.
+ */
+
+static unsigned regex_new_class(struct regex_block *handle)
+{
+	unsigned	class, i;
+
+	if (handle->class_count >= handle->class_size)
+		return REGEX_NONE;
+
+	class = handle->class_count++;
+
+	for (i = 0; i < REGEX_CLASS_WORDS; i++)
+		handle->classes[class * REGEX_CLASS_WORDS + i] = 0;
+
+	return class;
+}
+
+
+/**
+ * Generate the NFA states for a parse tree node and its children.
+ *
+ * \param *parser		The parser state.
+ * \param *handle		The expression being compiled.
+ * \param node			The node to generate.
+ * \return			The resulting NFA fragment.
+ */
+
+static struct regex_fragment regex_generate(struct regex_parser *parser, struct regex_block *handle, unsigned node)
+{
+	struct regex_fragment	fragment = {REGEX_NONE, REGEX_NONE}, first, second;
+	struct regex_node	*details;
+	unsigned		state, i;
+
+	if (parser->error || node == REGEX_NONE) {
+		parser->error = TRUE;
+		return fragment;
+	}
+
+	details = parser->nodes + node;
+
+	switch (details->type) {
+	case REGEX_NODE_EMPTY:
+		state = regex_new_state(handle, REGEX_STATE_EPSILON, REGEX_NONE, REGEX_NONE, REGEX_NONE);
+		fragment.start = state;
+		fragment.list = state << 1;
+		break;
+
+	case REGEX_NODE_CLASS:
+		state = regex_new_state(handle, REGEX_STATE_CLASS, REGEX_NONE, REGEX_NONE, details->left);
+		if (details->left == handle->tail_class)
+			handle->tail = state;
+		fragment.start = state;
+		fragment.list = state << 1;
+		break;
+
+	case REGEX_NODE_CONCAT:
+		first = regex_generate(parser, handle, details->left);
+		second = regex_generate(parser, handle, details->right);
+		fragment = regex_concat(handle, first, second);
+		break;
+
+	case REGEX_NODE_ALTERNATE:
+		first = regex_generate(parser, handle, details->left);
+		second = regex_generate(parser, handle, details->right);
+		state = regex_new_state(handle, REGEX_STATE_SPLIT, first.start, second.start, REGEX_NONE);
+		fragment.start = state;
+		fragment.list = regex_append(handle, first.list, second.list);
+		break;
+
+	case REGEX_NODE_REPEAT:
+		/* Generate the required copies, then either a loop or the
+		 * optional copies.
+		 */
+
+		for (i = 0; i < details->minimum && !parser->error; i++)
+			fragment = regex_concat(handle, fragment, regex_generate(parser, handle, details->left));
+
+		if (details->maximum == REGEX_INFINITE) {
+			first = regex_generate(parser, handle, details->left);
+			state = regex_new_state(handle, REGEX_STATE_SPLIT, first.start, REGEX_NONE, REGEX_NONE);
+			regex_patch(handle, first.list, state);
+			second.start = state;
+			second.list = (state << 1) | 1;
+			fragment = regex_concat(handle, fragment, second);
+		} else {
+			for (i = details->minimum; i < details->maximum && !parser->error; i++) {
+				first = regex_generate(parser, handle, details->left);
+				state = regex_new_state(handle, REGEX_STATE_SPLIT, first.start, REGEX_NONE, REGEX_NONE);
+				second.start = state;
+				second.list = regex_append(handle, first.list, (state << 1) | 1);
+				fragment = regex_concat(handle, fragment, second);
+			}
+		}
+
+		if (fragment.start == REGEX_NONE) {
+			state = regex_new_state(handle, REGEX_STATE_EPSILON, REGEX_NONE, REGEX_NONE, REGEX_NONE);
+			fragment.start = state;
+			fragment.list = state << 1;
+		}
+		break;
+	}
+
+	/* Any failure to claim a state will have left REGEX_NONE in the
+	 * state count, and an unusable fragment.
+	 */
+
+	if (handle->state_count > REGEX_MAX_STATES)
+		parser->error = TRUE;
+
+	return fragment;
+}
+
+
+/**
+ * Join two NFA fragments in sequence. The first may be empty, in which case
+ * the second is returned.
+ *
+ * \param *handle		The expression being compiled.
+ * \param first			The first fragment.
+ * \param second		The second fragment.
+ * \return			The combined fragment.
+ */
+
+static struct regex_fragment regex_concat(struct regex_block *handle, struct regex_fragment first, struct regex_fragment second)
+{
+	if (first.start == REGEX_NONE)
+		return second;
+
+	if (second.start == REGEX_NONE || handle->state_count > REGEX_MAX_STATES)
+		return first;
+
+	regex_patch(handle, first.list, second.start);
+	first.list = second.list;
+
+	return first;
+}
+
+
+/**
+ * Claim a new NFA state. If there are no states left, the state count is
+ * pushed past the limit so that the failure can be detected later.
+ *
+ * \param *handle		The expression being compiled.
+ * \param type			The type of state.
+ * \param out			The next state.
+ * \param out1			The alternative next state.
+ * \param class			The class of symbols consumed.
+ * \return			The new state, or 0 on failure.
+ */
+
+static unsigned regex_new_state(struct regex_block *handle, enum regex_state_type type, unsigned out, unsigned out1, unsigned class)
+{
+	unsigned	state;
+
+	if (handle->state_count >= REGEX_MAX_STATES) {
+		handle->state_count = REGEX_MAX_STATES + 1;
+		return 0;
+	}
+
+	state = handle->state_count++;
+
+	handle->states[state].type = type;
+	handle->states[state].out = out;
+	handle->states[state].out1 = out1;
+	handle->states[state].class = class;
+
+	return state;
+}
+
+
+/**
+ * Connect all of the exits on a list to a given state.
+ *
+ * \param *handle		The expression being compiled.
+ * \param list			The list of exits.
+ * \param state			The state to connect them to.
+ */
+
+static void regex_patch(struct regex_block *handle, unsigned list, unsigned state)
+{
+	unsigned	*exit;
+
+	if (handle->state_count > REGEX_MAX_STATES)
+		return;
+
+	while (list != REGEX_NONE) {
+		exit = regex_exit(handle, list);
+		list = *exit;
+		*exit = state;
+	}
+}
+
+
+/**
+ * Join two lists of unconnected exits.
+ *
+ * \param *handle		The expression being compiled.
+ * \param first			The first list.
+ * \param second		The second list.
+ * \return			The combined list.
+ */
+
+static unsigned regex_append(struct regex_block *handle, unsigned first, unsigned second)
+{
+	unsigned	list, *exit;
+
+	if (first == REGEX_NONE || handle->state_count > REGEX_MAX_STATES)
+		return second;
+
+	for (list = first; *(exit = regex_exit(handle, list)) != REGEX_NONE; list = *exit);
+
+	*exit = second;
+
+	return first;
+}
+
+
+/**
+ * Find the exit field referred to by an entry in an exit list: the state
+ * number, shifted left by one, plus 1 for the alternative exit.
+ *
+ * \param *handle		The expression being compiled.
+ * \param entry			The list entry.
+ * \return			Pointer to the exit field.
+ */
+
+static unsigned *regex_exit(struct regex_block *handle, unsigned entry)
+{
+	struct regex_state	*state = handle->states + (entry >> 1);
+
+	return (entry & 1) ? &(state->out1) : &(state->out);
+}
+
+
+/**
+ * Divide the symbols into groups, such that every class either contains all
+ * of a group's symbols or none of them. The DFA then only needs a transition
+ * for each group, instead of each symbol.
+ *
+ * \param *handle		The expression being compiled.
+ */
+
+static void regex_make_groups(struct regex_block *handle)
+{
+	unsigned	map[2 * REGEX_SYMBOLS], class, symbol, groups;
+	bits		*set;
+
+	for (symbol = 0; symbol < REGEX_SYMBOLS; symbol++)
+		handle->group[symbol] = 0;
+
+	handle->groups = 1;
+
+	for (class = 0; class < handle->class_count; class++) {
+		set = handle->classes + class * REGEX_CLASS_WORDS;
+
+		for (symbol = 0; symbol < 2 * handle->groups; symbol++)
+			map[symbol] = REGEX_NONE;
+
+		groups = 0;
+
+		for (symbol = 0; symbol < REGEX_SYMBOLS; symbol++) {
+			unsigned key = 2 * handle->group[symbol] + (REGEX_TEST(set, symbol) ? 1 : 0);
+
+			if (map[key] == REGEX_NONE)
+				map[key] = groups++;
+
+			handle->group[symbol] = map[key];
+		}
+
+		handle->groups = groups;
+	}
+
+	for (symbol = REGEX_SYMBOLS; symbol > 0; symbol--)
+		handle->group_symbol[handle->group[symbol - 1]] = symbol - 1;
+}
+
+
+/**
+ * Add an NFA state to a set, along with all of the states that can be
+ * reached from it without consuming a symbol.
+ *
+ * \param *handle		The expression to use.
+ * \param *set			The set to add the states to.
+ * \param state			The state to add.
+ */
+
+static void regex_closure(struct regex_block *handle, bits *set, unsigned state)
+{
+	unsigned		top = 0;
+	struct regex_state	*details;
+
+	if (REGEX_TEST(set, state))
+		return;
+
+	REGEX_SET(set, state);
+	handle->stack[top++] = state;
+
+	while (top > 0) {
+		details = handle->states + handle->stack[--top];
+
+		if (details->type != REGEX_STATE_SPLIT && details->type != REGEX_STATE_EPSILON)
+			continue;
+
+		if (!REGEX_TEST(set, details->out)) {
+			REGEX_SET(set, details->out);
+			handle->stack[top++] = details->out;
+		}
+
+		if (details->type == REGEX_STATE_SPLIT && !REGEX_TEST(set, details->out1)) {
+			REGEX_SET(set, details->out1);
+			handle->stack[top++] = details->out1;
+		}
+	}
+}
+
+
+/**
+ * Find the DFA state for a set of NFA states, adding it to the cache if it
+ * isn't already there. If the cache is full, it is flushed first.
+ *
+ * \param *handle		The expression to use.
+ * \param *set			The set of NFA states.
+ * \return			The DFA state.
+ */
+
+static unsigned regex_add_dfa(struct regex_block *handle, bits *set)
+{
+	unsigned	state, i;
+	bits		*copy, any = 0;
+
+	for (state = 0; state < handle->dfa_count; state++)
+		if (memcmp(handle->sets + state * handle->words, set, handle->words * sizeof(bits)) == 0)
+			return state;
+
+	if (handle->dfa_count >= REGEX_MAX_DFA) {
+		handle->dfa_count = 0;
+		handle->start = REGEX_NONE;
+		handle->flushes++;
+	}
+
+	state = handle->dfa_count++;
+	copy = handle->sets + state * handle->words;
+
+	for (i = 0; i < handle->words; i++) {
+		copy[i] = set[i];
+		any |= set[i];
+	}
+
+	for (i = 0; i < handle->groups; i++)
+		handle->next[state * handle->groups + i] = REGEX_UNKNOWN;
+
+	handle->flags[state] = 0;
+
+	if (REGEX_TEST(set, handle->match))
+		handle->flags[state] |= REGEX_DFA_ACCEPT;
+
+	if (handle->tail != REGEX_NONE && REGEX_TEST(set, handle->tail))
+		handle->flags[state] |= REGEX_DFA_FINAL;
+
+	if (any == 0)
+		handle->flags[state] |= REGEX_DFA_DEAD;
+
+	return state;
+}
+
+
+/**
+ * Find the DFA state which follows a given state on a given symbol, building
+ * it if it hasn't been seen before.
+ *
+ * \param *handle		The expression to use.
+ * \param state			The current DFA state.
+ * \param symbol		The symbol to consume.
+ * \return			The next DFA state.
+ */
+
+static unsigned regex_step(struct regex_block *handle, unsigned state, unsigned symbol)
+{
+	unsigned		group, next, flushes, word, bit, nfa;
+	bits			*set, *class;
+
+	group = handle->group[symbol];
+	next = handle->next[state * handle->groups + group];
+
+	if (next != REGEX_UNKNOWN)
+		return next;
+
+	/* Follow every NFA state in the set which consumes the symbol. */
+
+	memset(handle->work, 0, handle->words * sizeof(bits));
+
+	set = handle->sets + state * handle->words;
+
+	for (word = 0; word < handle->words; word++) {
+		if (set[word] == 0)
+			continue;
+
+		for (bit = 0; bit < 32; bit++) {
+			if ((set[word] & (1u << bit)) == 0)
+				continue;
+
+			nfa = word * 32 + bit;
+
+			if (handle->states[nfa].type != REGEX_STATE_CLASS)
+				continue;
+
+			class = handle->classes + handle->states[nfa].class * REGEX_CLASS_WORDS;
+
+			if (REGEX_TEST(class, symbol))
+				regex_closure(handle, handle->work, handle->states[nfa].out);
+		}
+	}
+
+	/* Only record the transition if the cache wasn't flushed, as the
+	 * current state will have been lost if it was.
+	 */
+
+	flushes = handle->flushes;
+	next = regex_add_dfa(handle, handle->work);
+
+	if (flushes == handle->flushes)
+		handle->next[state * handle->groups + group] = next;
+
+	return next;
+}
+
@@ -0,0 +1,70 @@
+/* Copyright 2016, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: regex.h
+ *
+ * Regular expression matching for filenames.
+ */
+
+#ifndef LOCATE_REGEX
+#define LOCATE_REGEX
+
+#include "oslib/types.h"
+
+struct regex_block;
+
+
+/**
+ * Compile a regular expression.
+ *
+ * \param *expression		The expression to compile.
+ * \param any_case		TRUE to match without regard to case; else FALSE.
+ * \return			The new expression handle, or NULL if the expression
+ *				was invalid or memory could not be claimed.
+ */
+
+struct regex_block *regex_create(char *expression, osbool any_case);
+
+
+/**
+ * Destroy a compiled regular expression.
+ *
+ * \param *handle		The expression to destroy.
+ */
+
+void regex_destroy(struct regex_block *handle);
+
+
+/**
+ * Test a name against a compiled regular expression.
+ *
+ * \param *handle		The expression to test against.
+ * \param *name			The name to test.
+ * \return			TRUE if the name matches; else FALSE.
+ */
+
+osbool regex_match(struct regex_block *handle, char *name);
+
+#endif
+
@@ -74,14 +74,17 @@
 #include "discfile.h"
 #include "file.h"
 #include "fileicon.h"
+#include "flexutils.h"
 #include "hotlist.h"
 #include "objdb.h"
 #include "textdump.h"
+#include "validate.h"
 
 
 #define STATUS_LENGTH 128							/**< The maximum size of the status bar text field.			*/
 #define TITLE_LENGTH 256							/**< The maximum size of the undefined title bar text field. 		*/
 #define ERROR_LENGTH 128							/**< The maximum size of the error message text.			*/
+#define DUPLICATES_LENGTH 128							/**< The maximum size of a duplicate set heading.			*/
 #define NUM_BUF_LENGTH 20							/**< The size of a buffer used to render numbers.			*/
 #define VALIDATION_LEN 256							/**< The size of a buffer used to build validation strings.		*/
 
@@ -97,7 +100,7 @@
 
 #define RESULTS_AUTOSCROLL_BORDER 80						/**< The autoscroll border for the window, in OS units.			*/
 
-#define RESULTS_ALLOC_REDRAW 50							/**< Number of window redraw blocks to allocate at a time.		*/
+#define RESULTS_ALLOC_REDRAW 50							/**< Minimum number of window redraw blocks to allocate at a time.	*/
 #define RESULTS_ALLOC_FILES 50							/**< Number of file blocks to allocate at a time.			*/
 #define RESULTS_ALLOC_TEXT 1024							/**< Number of bytes of text storage to allocate at a time.		*/
 #define RESULTS_ALLOC_CLIPBOARD 1024						/**< Number of bytes of clipboard storage to allocate at a time.	*/
@@ -143,6 +146,8 @@
 #define RESULTS_MENU_MODIFY_SEARCH 7
 #define RESULTS_MENU_ADD_TO_HOTLIST 8
 #define RESULTS_MENU_STOP_SEARCH 9
+#define RESULTS_MENU_PAUSE_SEARCH 10
+#define RESULTS_MENU_CHECK_OBJECTS 11
 
 #define RESULTS_MENU_DISPLAY_PATH_ONLY 0
 #define RESULTS_MENU_DISPLAY_FULL_INFO 1
@@ -237,6 +242,11 @@ struct results_window {
 
 	struct objdb_block	*objects;					/**< The object database associated with the search results.		*/
 
+	/* Object checking. */
+
+	struct validate_block	*validation;					/**< The check of the objects against the disc, or NULL if none.	*/
+	struct results_window	*next_validation;				/**< The next window in the list of those checking objects.		*/
+
 	/* Window handles */
 
 	wimp_w			window;						/**< The window handle.							*/
@@ -278,11 +288,15 @@ static struct saveas_block	*results_save_options = NULL;			/**< The Save Options
 
 static struct textdump_block	*results_clipboard = NULL;			/**< Text Dump for the clipboard contents.				*/
 
+static struct results_window	*results_foreground = NULL;			/**< The results window whose search is in the foreground.		*/
+
 static struct results_window	*results_select_drag_handle = NULL;		/**< The handle of the results window contining the selection drag.	*/
 static unsigned			results_select_drag_row = RESULTS_ROW_NONE;	/**< The row in which the selection drag started.			*/
 static unsigned			results_select_drag_pos = 0;			/**< The position within the row where the selection drag started.	*/
 static osbool			results_select_drag_adjust = FALSE;		/**< TRUE if the selection drag is with Adjust; FALSE for Select.	*/
 
+static struct results_window	*results_validating = NULL;			/**< A linked list of windows whose objects are being checked.	*/
+
 
 /* Local function prototypes. */
 
@@ -298,7 +312,7 @@ static void	results_add_error_file(struct results_window *handle, unsigned key,
 static osbool	results_reformat_line(struct results_window *handle, unsigned line, char *truncate, size_t truncate_len);
 static void	results_set_display_mode(struct results_window *handle, osbool full_info);
 static void	results_update_extent(struct results_window *handle, osbool to_end);
-static void	results_add_raw(struct results_window *handle, enum results_line_type type, unsigned message, wimp_colour colour, enum fileicon_icons sprite);
+static unsigned	results_add_raw(struct results_window *handle, enum results_line_type type, unsigned message, wimp_colour colour, enum fileicon_icons sprite);
 static unsigned	results_add_line(struct results_window *handle, osbool show);
 static osbool	results_extend(struct results_window *handle, unsigned lines);
 static unsigned	results_calculate_window_click_row(struct results_window *handle, os_coord *pos, wimp_window_state *state);
@@ -321,6 +335,9 @@ static void	results_clipboard_copy_filenames(struct results_window *handle);
 static void	*results_clipboard_find(void *data);
 static size_t	results_clipboard_size(void *data);
 static void	results_clipboard_release(void *data);
+static void	results_check_objects(struct results_window *handle);
+static void	results_end_check(struct results_window *handle);
+static void	results_update_check_status(struct results_window *handle, char *token);
 
 
 //static unsigned	results_add_fileblock(struct results_window *handle);
@@ -412,6 +429,8 @@ struct results_window *results_create(struct file_block *file, struct objdb_bloc
 		new->redraw = NULL;
 		new->text = NULL;
 		new->objects = NULL;
+		new->validation = NULL;
+		new->next_validation = NULL;
 	}
 
 	if (mem_ok) {
@@ -551,6 +570,9 @@ void results_destroy(struct results_window *handle)
 	title = windows_get_indirected_title_addr(handle->window);
 	status = icons_get_indirected_text_addr(handle->status, RESULTS_ICON_STATUS);
 
+	if (results_foreground == handle)
+		results_foreground = NULL;
+
 	ihelp_remove_window(handle->window);
 	event_delete_window(handle->window);
 	wimp_delete_window(handle->window);
@@ -559,6 +581,9 @@ void results_destroy(struct results_window *handle)
 	event_delete_window(handle->status);
 	wimp_delete_window(handle->status);
 
+	if (handle->validation != NULL)
+		results_end_check(handle);
+
 	flex_free((flex_ptr) &(handle->redraw));
 
 	if (handle->text != NULL)
@@ -663,7 +688,7 @@ struct results_window *results_load_file(struct file_block *file, struct objdb_b
 	char				title[TITLE_LENGTH], status[STATUS_LENGTH], errors[ERROR_LENGTH], number[NUM_BUF_LENGTH];
 
 	int				i, size, position;
-	unsigned			lines, file_count, error_count;
+	unsigned			lines, file_count, error_count, line, group_line, group_saved;
 
 	if (file == NULL || objects == NULL || load == NULL)
 		return NULL;
@@ -720,6 +745,9 @@ struct results_window *results_load_file(struct file_block *file, struct objdb_b
 	file_count = 0;
 	error_count = 0;
 
+	group_line = RESULTS_NULL;
+	group_saved = RESULTS_NULL;
+
 	if (discfile_open_chunk(load, DISCFILE_CHUNK_RESULTS)) {
 		size = discfile_chunk_size(load);
 		if ((size % sizeof(struct results_file_block)) != 0) {
@@ -733,16 +761,28 @@ struct results_window *results_load_file(struct file_block *file, struct objdb_b
 		for (i = 0; i < lines && position <= size; i++) {
 			discfile_read_chunk(load, (byte *) &data, sizeof(struct results_file_block));
 
+			/* Lines are renumbered on loading, as the file info lines
+			 * aren't saved, so the parents of duplicate file sets are
+			 * matched up with their new headings as they're found.
+			 */
+
 			switch (data.type) {
 			case RESULTS_LINE_FILENAME:
-				results_add_file(new, data.data);
+				line = results_add_file(new, data.data);
+				if (line != RESULTS_NULL && data.parent != RESULTS_NULL && data.parent == group_saved)
+					new->redraw[line].parent = group_line;
 				file_count++;
 				break;
 			case RESULTS_LINE_ERROR_FILENAME:
 				results_add_error_file(new, data.data, data.parent);
 				break;
 			case RESULTS_LINE_TEXT:
-				results_add_raw(new, RESULTS_LINE_TEXT, data.data, data.colour, data.sprite);
+				line = results_add_raw(new, RESULTS_LINE_TEXT, data.data, data.colour, data.sprite);
+				if (line != RESULTS_NULL && data.parent != RESULTS_NULL) {
+					new->redraw[line].parent = line;
+					group_line = line;
+					group_saved = data.parent;
+				}
 				break;
 			default:
 				break;
@@ -887,6 +927,9 @@ static void results_menu_prepare(wimp_w w, wimp_menu *menu, wimp_pointer *pointe
 	menus_shade_entry(results_window_menu, RESULTS_MENU_MODIFY_SEARCH, dialogue_window_is_open() || file_get_dialogue(handle->file) == NULL);
 	menus_shade_entry(results_window_menu, RESULTS_MENU_ADD_TO_HOTLIST, hotlist_add_window_is_open() || file_get_dialogue(handle->file) == NULL);
 	menus_shade_entry(results_window_menu, RESULTS_MENU_STOP_SEARCH, !file_search_active(handle->file));
+	menus_shade_entry(results_window_menu, RESULTS_MENU_PAUSE_SEARCH, !file_search_active(handle->file));
+	menus_tick_entry(results_window_menu, RESULTS_MENU_PAUSE_SEARCH, file_search_paused(handle->file));
+	menus_shade_entry(results_window_menu, RESULTS_MENU_CHECK_OBJECTS, file_search_active(handle->file) || handle->validation != NULL || handle->redraw_lines == 0);
 
 	menus_tick_entry(results_window_menu_display, RESULTS_MENU_DISPLAY_PATH_ONLY, !handle->full_info);
 	menus_tick_entry(results_window_menu_display, RESULTS_MENU_DISPLAY_FULL_INFO, handle->full_info);
@@ -999,6 +1042,14 @@ static void results_menu_selection(wimp_w w, wimp_menu *menu, wimp_selection *se
 	case RESULTS_MENU_STOP_SEARCH:
 		file_stop_search(handle->file);
 		break;
+
+	case RESULTS_MENU_PAUSE_SEARCH:
+		file_pause_search(handle->file, !file_search_paused(handle->file));
+		break;
+
+	case RESULTS_MENU_CHECK_OBJECTS:
+		results_check_objects(handle);
+		break;
 	}
 }
 
@@ -1371,10 +1422,15 @@ static void results_open_handler(wimp_open *open)
 		handle->format_width = new_width;
 	}
 
-	/* Open the window at its new position. */
+	/* Open the window at its new position. If it has been brought to the
+	 * front, its search takes priority over those in other windows.
+	 */
 
 	wimp_open_window(open);
 
+	if (open->next == wimp_TOP)
+		results_set_foreground(handle);
+
 	/* Resize the info pane's icon to fit. */
 
 	icon.w = handle->status;
@@ -1397,6 +1453,27 @@ static void results_open_handler(wimp_open *open)
 }
 
 
+/**
+ * Make a results window the foreground window, so that its search is given a
+ * larger share of the time available to searches than those belonging to
+ * other windows.
+ *
+ * \param *handle		The handle of the results window.
+ */
+
+void results_set_foreground(struct results_window *handle)
+{
+	if (handle == NULL || handle == results_foreground)
+		return;
+
+	if (results_foreground != NULL)
+		file_set_search_foreground(results_foreground->file, FALSE);
+
+	results_foreground = handle;
+	file_set_search_foreground(handle->file, TRUE);
+}
+
+
 /**
  * Set options for a results window.
  *
@@ -1513,23 +1590,26 @@ void results_set_title(struct results_window *handle, char *title)
  * \param message		The error message text, as a textdump offset.
  * \param colour		The colour of the text.
  * \param sprite		The icon sprite to use.
+ * \return			The new line, or RESULTS_NULL on failure.
  */
 
-static void results_add_raw(struct results_window *handle, enum results_line_type type, unsigned message, wimp_colour colour, enum fileicon_icons sprite)
+static unsigned results_add_raw(struct results_window *handle, enum results_line_type type, unsigned message, wimp_colour colour, enum fileicon_icons sprite)
 {
 	unsigned		line;
 
 	if (handle == NULL || message == TEXTDUMP_NULL)
-		return;
+		return RESULTS_NULL;
 
 	line = results_add_line(handle, TRUE);
 	if (line == RESULTS_NULL)
-		return;
+		return RESULTS_NULL;
 
 	handle->redraw[line].type = type;
 	handle->redraw[line].text = message;
 	handle->redraw[line].sprite = sprite;
 	handle->redraw[line].colour = colour;
+
+	return line;
 }
 
 
@@ -1644,6 +1724,99 @@ unsigned results_add_file(struct results_window *handle, unsigned key)
 }
 
 
+/**
+ * Find the most recent filename line for a file in a results window.
+ *
+ * \param *handle		The handle of the results window to search.
+ * \param key			The database key for the file.
+ * \return			The results line, or RESULTS_NULL if none.
+ */
+
+unsigned results_find_file(struct results_window *handle, unsigned key)
+{
+	unsigned	line;
+
+	if (handle == NULL || key == OBJDB_NULL_KEY)
+		return RESULTS_NULL;
+
+	for (line = handle->redraw_lines; line > 0; line--) {
+		if (handle->redraw[line - 1].type == RESULTS_LINE_FILENAME && handle->redraw[line - 1].file == key)
+			return line - 1;
+	}
+
+	return RESULTS_NULL;
+}
+
+
+/**
+ * Add the heading for a set of duplicate files to the end of the results
+ * window. The files in the set should follow, added with
+ * results_add_duplicate().
+ *
+ * \param *handle		The handle of the results window to update.
+ * \param count			The number of files in the set.
+ * \param size			The size of each file in the set.
+ * \return			The results line, or RESULTS_NULL on failure.
+ */
+
+unsigned results_add_duplicates(struct results_window *handle, unsigned count, int size)
+{
+	unsigned	line, offt, length;
+	char		message[DUPLICATES_LENGTH], number[NUM_BUF_LENGTH], bytes[NUM_BUF_LENGTH];
+
+	if (handle == NULL)
+		return RESULTS_NULL;
+
+	line = results_add_line(handle, TRUE);
+	if (line == RESULTS_NULL)
+		return RESULTS_NULL;
+
+	string_printf(number, NUM_BUF_LENGTH, "%u", count);
+	string_printf(bytes, NUM_BUF_LENGTH, "%d", size);
+	msgs_param_lookup("DupSet", message, DUPLICATES_LENGTH, number, bytes, NULL, NULL);
+
+	offt = textdump_store(handle->text, message);
+
+	if (offt == TEXTDUMP_NULL)
+		return RESULTS_NULL;
+
+	handle->redraw[line].type = RESULTS_LINE_TEXT;
+	handle->redraw[line].text = offt;
+	handle->redraw[line].sprite = FILEICON_UNKNOWN;
+	handle->redraw[line].colour = wimp_COLOUR_DARK_BLUE;
+	handle->redraw[line].parent = line;
+
+	length = strlen(message) + 1;
+	if (length > handle->longest_line)
+		handle->longest_line = length;
+
+	return line;
+}
+
+
+/**
+ * Add a file to the end of the results window, as a member of a set of
+ * duplicate files.
+ *
+ * \param *handle		The handle of the results window to update.
+ * \param key			The database key for the file.
+ * \param parent		The heading line of the set, from
+ *				results_add_duplicates().
+ * \return			The results line, or RESULTS_NULL on failure.
+ */
+
+unsigned results_add_duplicate(struct results_window *handle, unsigned key, unsigned parent)
+{
+	unsigned	file;
+
+	file = results_add_file(handle, key);
+	if (file != RESULTS_NULL)
+		handle->redraw[file].parent = parent;
+
+	return file;
+}
+
+
 /**
  * Add a piece of file content to the end of the results window.
  *
@@ -1920,7 +2093,7 @@ static unsigned results_add_line(struct results_window *handle, osbool show)
 	 */
 
 	if (handle->redraw_lines >= handle->redraw_size)
-		results_extend(handle, handle->redraw_size + RESULTS_ALLOC_REDRAW);
+		results_extend(handle, flexutils_grow_size(handle->redraw_size, handle->redraw_lines + 1, RESULTS_ALLOC_REDRAW));
 
 	if (handle->redraw_lines >= handle->redraw_size)
 		return RESULTS_NULL;
@@ -1963,7 +2136,7 @@ static osbool results_extend(struct results_window *handle, unsigned lines)
 	if (handle == NULL || handle->redraw == NULL || handle->redraw_size > lines)
 		return FALSE;
 
-	if (flex_extend((flex_ptr) &(handle->redraw), lines * sizeof(struct results_line)) != 1)
+	if (!flexutils_resize((flex_ptr) &(handle->redraw), lines * sizeof(struct results_line)))
 		return FALSE;
 
 	handle->redraw_size = lines;
@@ -2793,3 +2966,161 @@ static void results_clipboard_release(void *data)
 	textdump_clear(results_clipboard);
 }
 
+
+
+/**
+ * Test to see if a poll is required for checking objects.
+ *
+ * \return			TRUE if any windows are checking objects; else FALSE.
+ */
+
+osbool results_poll_required(void)
+{
+	return (results_validating == NULL) ? FALSE : TRUE;
+}
+
+
+/**
+ * Share a timeslot between the results windows which are checking their
+ * objects against the disc.
+ *
+ * \param timeslot		The time, in cs, to share between the windows.
+ */
+
+void results_poll_all(os_t timeslot)
+{
+	struct results_window	*handle, *next;
+	os_t			start_time, used;
+	unsigned		windows = 0;
+
+	start_time = os_read_monotonic_time();
+
+	for (handle = results_validating; handle != NULL; handle = handle->next_validation)
+		windows++;
+
+	handle = results_validating;
+
+	while (handle != NULL && windows > 0) {
+		next = handle->next_validation;
+
+		if (validate_poll(handle->validation, start_time + ((timeslot / windows > 0) ? timeslot / windows : 1))) {
+			results_update_check_status(handle, "Checked");
+			results_end_check(handle);
+			windows_redraw(handle->window);
+		} else {
+			results_update_check_status(handle, "Checking");
+		}
+
+		used = os_read_monotonic_time() - start_time;
+		start_time += used;
+
+		timeslot = (used < timeslot) ? timeslot - used : 0;
+		windows--;
+
+		handle = next;
+	}
+}
+
+
+/**
+ * Start checking the objects in a results window against the disc, so that
+ * any which have changed or gone missing are shown as such.
+ *
+ * \param *handle		The results window to check.
+ */
+
+static void results_check_objects(struct results_window *handle)
+{
+	unsigned	line;
+
+	if (handle == NULL || handle->validation != NULL || file_search_active(handle->file))
+		return;
+
+	handle->validation = validate_create(handle->objects);
+	if (handle->validation == NULL) {
+		error_msgs_report_error("NoMemCheck");
+		return;
+	}
+
+	for (line = 0; line < handle->redraw_lines; line++) {
+		if (handle->redraw[line].type != RESULTS_LINE_FILENAME)
+			continue;
+
+		if (!validate_add_key(handle->validation, handle->redraw[line].file)) {
+			validate_destroy(handle->validation);
+			handle->validation = NULL;
+			error_msgs_report_error("NoMemCheck");
+			return;
+		}
+	}
+
+	handle->next_validation = results_validating;
+	results_validating = handle;
+
+	results_update_check_status(handle, "Checking");
+}
+
+
+/**
+ * Stop checking the objects in a results window, and remove it from the list
+ * of windows needing polls.
+ *
+ * \param *handle		The results window to stop checking.
+ */
+
+static void results_end_check(struct results_window *handle)
+{
+	struct results_window	*previous;
+
+	if (handle == NULL || handle->validation == NULL)
+		return;
+
+	validate_destroy(handle->validation);
+	handle->validation = NULL;
+
+	/* If the window is at the head of the list, remove it... */
+
+	if (results_validating == handle) {
+		results_validating = handle->next_validation;
+		return;
+	}
+
+	/* ...otherwise find it in the list and remove it. */
+
+	previous = results_validating;
+
+	while (previous != NULL && previous->next_validation != handle)
+		previous = previous->next_validation;
+
+	if (previous != NULL)
+		previous->next_validation = handle->next_validation;
+}
+
+
+/**
+ * Update the status bar of a results window with the progress of a check
+ * of its objects.
+ *
+ * \param *handle		The results window to update.
+ * \param *token		The MessageTrans token for the status text.
+ */
+
+static void results_update_check_status(struct results_window *handle, char *token)
+{
+	char		status[STATUS_LENGTH], checked[NUM_BUF_LENGTH], total[NUM_BUF_LENGTH], missing[NUM_BUF_LENGTH], changed[NUM_BUF_LENGTH];
+	unsigned	checked_count, total_count, missing_count, changed_count;
+
+	if (handle == NULL || handle->validation == NULL)
+		return;
+
+	validate_get_progress(handle->validation, &checked_count, &total_count, &missing_count, &changed_count);
+
+	string_printf(checked, NUM_BUF_LENGTH, "%u", checked_count);
+	string_printf(total, NUM_BUF_LENGTH, "%u", total_count);
+	string_printf(missing, NUM_BUF_LENGTH, "%u", missing_count);
+	string_printf(changed, NUM_BUF_LENGTH, "%u", changed_count);
+
+	msgs_param_lookup(token, status, STATUS_LENGTH, checked, total, missing, changed);
+
+	results_set_status(handle, status);
+}
@@ -30,6 +30,8 @@
 #ifndef LOCATE_RESULTS
 #define LOCATE_RESULTS
 
+#include "oslib/os.h"
+
 #include "file.h"
 #include "objdb.h"
 
@@ -95,6 +97,17 @@ osbool results_save_file(struct results_window *handle, struct discfile_block *o
 struct results_window *results_load_file(struct file_block *file, struct objdb_block *objects, struct discfile_block *load);
 
 
+/**
+ * Make a results window the foreground window, so that its search is given a
+ * larger share of the time available to searches than those belonging to
+ * other windows.
+ *
+ * \param *handle		The handle of the results window.
+ */
+
+void results_set_foreground(struct results_window *handle);
+
+
 /**
  * Set options for a results window.
  *
@@ -160,6 +173,45 @@ void results_add_error(struct results_window *handle, char *message, unsigned ke
 unsigned results_add_file(struct results_window *handle, unsigned key);
 
 
+/**
+ * Find the most recent filename line for a file in a results window.
+ *
+ * \param *handle		The handle of the results window to search.
+ * \param key			The database key for the file.
+ * \return			The results line, or RESULTS_NULL if none.
+ */
+
+unsigned results_find_file(struct results_window *handle, unsigned key);
+
+
+/**
+ * Add the heading for a set of duplicate files to the end of the results
+ * window. The files in the set should follow, added with
+ * results_add_duplicate().
+ *
+ * \param *handle		The handle of the results window to update.
+ * \param count			The number of files in the set.
+ * \param size			The size of each file in the set.
+ * \return			The results line, or RESULTS_NULL on failure.
+ */
+
+unsigned results_add_duplicates(struct results_window *handle, unsigned count, int size);
+
+
+/**
+ * Add a file to the end of the results window, as a member of a set of
+ * duplicate files.
+ *
+ * \param *handle		The handle of the results window to update.
+ * \param key			The database key for the file.
+ * \param parent		The heading line of the set, from
+ *				results_add_duplicates().
+ * \return			The results line, or RESULTS_NULL on failure.
+ */
+
+unsigned results_add_duplicate(struct results_window *handle, unsigned key, unsigned parent);
+
+
 /**
  * Add a piece of file content to the end of the results window.
  *
@@ -180,5 +232,24 @@ void results_add_contents(struct results_window *handle, unsigned key, unsigned
 
 void results_accept_lines(struct results_window *handle);
 
+
+/**
+ * Test to see if a poll is required for checking objects.
+ *
+ * \return			TRUE if any windows are checking objects; else FALSE.
+ */
+
+osbool results_poll_required(void);
+
+
+/**
+ * Share a timeslot between the results windows which are checking their
+ * objects against the disc.
+ *
+ * \param timeslot		The time, in cs, to share between the windows.
+ */
+
+void results_poll_all(os_t timeslot);
+
 #endif
 
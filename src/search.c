@@ -29,6 +29,8 @@
 
 /* ANSI C Header files. */
 
+#include <ctype.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -41,6 +43,7 @@
 
 #include "oslib/os.h"
 #include "oslib/osfile.h"
+#include "oslib/osfscontrol.h"
 #include "oslib/osgbpb.h"
 
 /* SF-Lib Header files. */
@@ -60,33 +63,88 @@
 #include "search.h"
 
 #include "contents.h"
+#include "discfile.h"
+#include "dupes.h"
 #include "flexutils.h"
+#include "fsys.h"
 #include "ignore.h"
+#include "index.h"
 #include "objdb.h"
+#include "quantum.h"
+#include "regex.h"
 #include "results.h"
+#include "wildcard.h"
 
 
 #define SEARCH_ALLOC_STACK 20							/**< The directory depth in which to allocate stack space.		*/
+#define SEARCH_ALLOC_PATH 1024							/**< The initial space allocated to the current pathname.		*/
 
-#define SEARCH_MAX_FILENAME 256							/**< The maximum length of a file (object) name.			*/
-#define SEARCH_BLOCK_SIZE 4096							/**< The amount of memory to allocate to OS_GBPB.			*/
+#define SEARCH_BLOCK_SIZE 4096							/**< The initial amount of memory to allocate to OS_GBPB.		*/
+#define SEARCH_BLOCK_MAX 65536							/**< The most memory that will be allocated to OS_GBPB.		*/
+#define SEARCH_SLOW_READ 2							/**< The time, in cs, above which an OS_GBPB read is seen as slow.	*/
 
 #define STATUS_LENGTH 128							/**< The maximum size of the status bar text field.			*/
 #define ERROR_LENGTH 128							/**< The maximum size of the error message text.			*/
 #define NUM_BUF_LENGTH 20							/**< The size of a buffer used to render numbers.			*/
+#define SEARCH_TAG_LENGTH 128							/**< The size of the text used to tag results with their pattern.	*/
+
+#define SEARCH_PLAN_INTERVAL 512						/**< The number of objects tested between re-orderings of the plan.	*/
+
+#define SEARCH_RUN_SLICE 100							/**< The timeslice, in cs, used when running a search to completion.	*/
+
+
+/**
+ * The tests which can be applied to an object in a search plan.
+ */
+
+enum search_test {
+	SEARCH_TEST_TYPE = 0,							/**< Test the object and file types.					*/
+	SEARCH_TEST_ATTRIBUTES,							/**< Test the object attributes.					*/
+	SEARCH_TEST_SIZE,							/**< Test the file size.						*/
+	SEARCH_TEST_DATE,							/**< Test the datestamp.						*/
+	SEARCH_TEST_FILENAME,							/**< Test the filename.							*/
+	SEARCH_TEST_MAX								/**< The number of tests available.					*/
+};
+
+/**
+ * A step in a search plan.
+ */
+
+struct search_plan_step {
+	enum search_test	test;						/**< The test to be carried out.					*/
+	unsigned		cost;						/**< The relative cost of the test.					*/
+	unsigned		tested;						/**< The number of recent objects tested, decaying over time.		*/
+	unsigned		rejected;					/**< The number of recent objects rejected, decaying over time.		*/
+	unsigned		total_tested;					/**< The total number of objects tested.				*/
+	unsigned		total_rejected;					/**< The total number of objects rejected.				*/
+};
+
+/**
+ * A path to be searched, while overlapping paths are being pruned.
+ */
+
+struct search_root {
+	char			*path;						/**< The canonical pathname.						*/
+	int			order;						/**< The position of the path in the path index.			*/
+	osbool			pruned;						/**< TRUE if the path lies within another; else FALSE.			*/
+};
 
 #define SEARCH_NULL 0xffffffff							/**< 'NULL' value for use with the unsigned flex block offsets.		*/
 
 /* A data structure to hold the search stack. */
 
 struct search_stack {
-	char			filename[SEARCH_MAX_FILENAME];			/**< The filename of the current directory.				*/
-	byte			info[SEARCH_BLOCK_SIZE];			/**< Block for OS_GBPB 10.						*/
+	size_t			path_length;					/**< The length of the pathname of the current directory.		*/
+	byte			*info;						/**< Heap block for OS_GBPB 10, or NULL if none claimed.		*/
+	size_t			info_size;					/**< The size of the OS_GBPB block.					*/
 
 	int			read;						/**< The number of files read at the last OS_GBPB call.			*/
 	int			context;					/**< The context for the next OS_GBPB call.				*/
+	int			block_context;					/**< The context used for the OS_GBPB call which filled the block.	*/
 	int			next;						/**< The number of the next item to read from the block.		*/
 	unsigned		data_offset;					/**< Offset to the data for the next item to be read from the block.	*/
+	unsigned		record_offset;					/**< Offset to the data for the item currently being processed.		*/
+	osbool			pinned;						/**< TRUE if the current item is in use, so the block can't be changed.	*/
 
 	unsigned		key;						/**< The object database key of the item.				*/
 	unsigned		parent;						/**< The object database key of the parent item.			*/
@@ -97,6 +155,23 @@ struct search_stack {
 	osbool			contents_active;				/**< TRUE if the contents engine is in the middle of a search.		*/
 };
 
+/**
+ * A level of the search stack, as saved in a file. The block of entries is
+ * read again on loading, so only the position within it is kept.
+ */
+
+struct search_file_level {
+	unsigned		path_length;					/**< The length of the pathname of the level's directory.		*/
+	int			block_context;					/**< The context used for the OS_GBPB call which filled the block.	*/
+	int			next;						/**< The number of the next item to read from the block.		*/
+	osbool			pinned;						/**< TRUE if the current item is in use.				*/
+	unsigned		key;						/**< The object database key of the item.				*/
+	unsigned		parent;						/**< The object database key of the parent item.			*/
+	unsigned		filetype;					/**< The filetype of the current file.					*/
+	osbool			file_active;					/**< TRUE if the file is still active; FALSE if fully processed.	*/
+	osbool			contents_active;				/**< TRUE if the contents engine is in the middle of a search.		*/
+};
+
 /* A data structure defining a search. */
 
 struct search_block {
@@ -105,6 +180,7 @@ struct search_block {
 	struct results_window	*results;					/**< Results module to output results to.				*/
 
 	osbool			active;						/**< TRUE if the search is active; else FALSE.				*/
+	osbool			paused;						/**< TRUE if the search is active but paused; else FALSE.		*/
 
 	osbool			include_imagefs;				/**< TRUE to search inside Image Filing Systems; else FALSE.		*/
 	osbool			store_all;					/**< TRUE to save all objects in the database; FALSE for matches.	*/
@@ -117,12 +193,31 @@ struct search_block {
 	unsigned		stack_level;					/**< The current stack level.						*/
 	unsigned		stack_size;					/**< The amount of stack levels currently claimed.			*/
 
+	char			*pathname;					/**< The pathname of the directory at the top of the stack.		*/
+	size_t			pathname_size;					/**< The space allocated to the pathname buffer.			*/
+
+	size_t			buffer_size;					/**< The size of OS_GBPB block to give to each stack level.		*/
+	int			read_count;					/**< The maximum number of objects to read in each OS_GBPB call.	*/
+
+	unsigned		object_count;					/**< The number of objects examined by the search.			*/
 	unsigned		file_count;					/**< The number of files found in the search.				*/
 	unsigned		error_count;					/**< The number of errors encountered during the search.		*/
+	unsigned		ignored_count;					/**< The number of objects skipped due to the ignore list.		*/
+	unsigned		rejected_count;					/**< The number of objects rejected without being stored.		*/
+	unsigned		pruned_count;					/**< The number of paths dropped as overlapping others.			*/
+
+	os_t			start_time;					/**< The time at which the search was started.				*/
+	os_t			stop_time;					/**< The time at which the search stopped.				*/
+	os_t			busy_time;					/**< The time spent polling the search.					*/
+
+	unsigned		flex_resizes;					/**< The flex resize count when the search started.			*/
+	unsigned		flex_resize_bytes;				/**< The flex resize byte count when the search started.		*/
 
 	/* Search Parameters */
 
 	struct ignore_block	*ignore_list;					/**< Handle of the Ignore List, or NULL if there isn't a list defined.	*/
+	struct index_block	*index;						/**< Handle of a filename index to read from, or NULL if none.		*/
+	osbool			index_claimed;					/**< TRUE once the search has started to read from its index.		*/
 
 	osbool			include_files;					/**< TRUE to include files in the results; FALSE to exclude.		*/
 	osbool			include_directories;				/**< TRUE to include directories in the results; FALSE to exclude.	*/
@@ -130,6 +225,8 @@ struct search_block {
 
 	osbool			test_filename;					/**< TRUE to test the filename; FALSE to ignore.			*/
 	char			*filename;					/**< Pointer to a flex block with the filename to test; NULL if none.	*/
+	struct wildcard_block	*filename_matcher;			/**< The compiled filename pattern, or NULL if none.			*/
+	struct regex_block	*filename_regex;				/**< The compiled filename regular expression, or NULL if none.	*/
 	osbool			filename_any_case;				/**< TRUE if the filename should be tested case insenitively.		*/
 	osbool			filename_logic;					/**< The required result of filename comparisons.			*/
 
@@ -140,10 +237,8 @@ struct search_block {
 
 	osbool			test_date;					/**< TRUE to test the datestamp; FALSE to ignore.			*/
 	osbool			date_logic;					/**< The required result of the date comparison.			*/
-	unsigned		minimum_date_lo;				/**< The low four bytes of the minimum allowable datestamp.		*/
-	unsigned		minimum_date_hi;				/**< The high byte of the minimum allowable datestamp.			*/
-	unsigned		maximum_date_lo;				/**< The low four bytes of the maximum allowable datestamp.		*/
-	unsigned		maximum_date_hi;				/**< The high byte of the maximum allowable datestamp.			*/
+	unsigned long long	minimum_date;					/**< The minimum allowable datestamp, as a 40-bit number.		*/
+	unsigned long long	maximum_date;					/**< The maximum allowable datestamp, as a 40-bit number.		*/
 	osbool			date_as_age;					/**< TRUE if the date is expressed as age, for the title flags.		*/
 
 	osbool			test_filetype;					/**< TRUE to test the filetype; FALSE to ignore.			*/
@@ -160,6 +255,18 @@ struct search_block {
 	osbool			contents_any_case;				/**< TRUE if the contents should be tested case insenitively.		*/
 	osbool			contents_logic;					/**< The required result of contents comparisons.			*/
 
+	struct dupes_block	*duplicates;					/**< Handle for the duplicate file detection; NULL if not required.	*/
+
+	/* Search Plan */
+
+	struct search_plan_step	plan[SEARCH_TEST_MAX];				/**< The tests to apply to each object, in order.			*/
+	unsigned		plan_length;					/**< The number of tests in the plan.					*/
+	unsigned		plan_objects;					/**< The number of objects tested since the plan was last ordered.	*/
+
+	/* Scheduling */
+
+	unsigned		priority;					/**< The scheduling priority, used to weight the time slices.		*/
+	struct quantum_block	quantum;					/**< The work quantum used to time the poll loop.			*/
 
 	/* Block List */
 
@@ -175,8 +282,26 @@ static int			search_searches_active = 0;			/**< A count of active searches.
 /* Local function prototypes. */
 
 static osbool		search_poll(struct search_block *search, os_t end_time);
-static unsigned		search_add_stack(struct search_block *search);
+static unsigned		search_add_stack(struct search_block *search, char *name);
 static unsigned		search_drop_stack(struct search_block *search);
+static void		search_unlink(struct search_block *search);
+static void		search_free_stack(struct search_block *search);
+static osbool		search_claim_buffer(struct search_block *search, unsigned stack);
+static os_error		*search_read_block(struct search_block *search, unsigned stack);
+static osbool		search_restore_level(struct search_block *search, unsigned stack, int block_context, int next);
+static void		search_update_title(struct search_block *search);
+static void		search_split_paths(struct search_block *search, int paths);
+static osgbpb_info	*search_get_record(struct search_block *search, unsigned stack);
+static osbool		search_match_filename(struct search_block *search, char *name, unsigned *pattern);
+static void		search_tag_result(struct search_block *search, unsigned key, unsigned line, unsigned pattern);
+static void		search_prune_paths(struct search_block *search);
+static osbool		search_path_is_within(char *path, char *root);
+static int		search_compare_roots(const void *a, const void *b);
+static int		search_compare_root_order(const void *a, const void *b);
+static void		search_compile_plan(struct search_block *search);
+static void		search_add_plan_step(struct search_block *search, enum search_test test, unsigned cost);
+static void		search_order_plan(struct search_block *search);
+static osbool		search_test_object(struct search_block *search, unsigned filetype, osgbpb_info *file_data, unsigned *pattern);
 
 
 /**
@@ -218,6 +343,7 @@ struct search_block *search_create(struct file_block *file, struct objdb_block *
 
 	if (mem_ok) {
 		new->stack = NULL;
+		new->pathname = NULL;
 		new->paths = NULL;
 		new->path = NULL;
 
@@ -227,6 +353,9 @@ struct search_block *search_create(struct file_block *file, struct objdb_block *
 		if ((new->path = heap_alloc(paths * sizeof(char *))) == NULL)
 			mem_ok = FALSE;
 
+		if ((new->pathname = heap_alloc(SEARCH_ALLOC_PATH)) == NULL)
+			mem_ok = FALSE;
+
 		if (flex_alloc((flex_ptr) &(new->stack), SEARCH_ALLOC_STACK * sizeof(struct search_stack)) == 0)
 			mem_ok = FALSE;
 	}
@@ -239,6 +368,9 @@ struct search_block *search_create(struct file_block *file, struct objdb_block *
 		if (new != NULL && new->stack != NULL)
 			flex_free((flex_ptr) &(new->stack));
 
+		if (new != NULL && new->pathname != NULL)
+			heap_free(new->pathname);
+
 		if (new != NULL && new->path != NULL)
 			heap_free(new->path);
 
@@ -259,13 +391,41 @@ struct search_block *search_create(struct file_block *file, struct objdb_block *
 	new->results = results;
 
 	new->active = FALSE;
+	new->paused = FALSE;
 	new->next = NULL;
 
 	new->stack_size = SEARCH_ALLOC_STACK;
 	new->stack_level = 0;
 
+	for (i = 0; i < new->stack_size; i++) {
+		new->stack[i].info = NULL;
+		new->stack[i].info_size = 0;
+	}
+
+	new->buffer_size = SEARCH_BLOCK_SIZE;
+	new->read_count = config_int_read("OSGBPBReadSize");
+	if (new->read_count < 1)
+		new->read_count = 1;
+
+	new->pathname_size = SEARCH_ALLOC_PATH;
+	*(new->pathname) = '\0';
+
+	new->object_count = 0;
 	new->file_count = 0;
 	new->error_count = 0;
+	new->ignored_count = 0;
+	new->rejected_count = 0;
+	new->pruned_count = 0;
+
+	new->start_time = 0;
+	new->stop_time = 0;
+	new->busy_time = 0;
+
+	new->priority = SEARCH_PRIORITY_NORMAL;
+	quantum_initialise(&(new->quantum));
+
+	new->flex_resizes = 0;
+	new->flex_resize_bytes = 0;
 
 	/* The Search criteria. */
 
@@ -280,6 +440,8 @@ struct search_block *search_create(struct file_block *file, struct objdb_block *
 
 	new->test_filename = FALSE;
 	new->filename = NULL;
+	new->filename_matcher = NULL;
+	new->filename_regex = NULL;
 	new->filename_any_case = FALSE;
 	new->filename_logic = TRUE;
 
@@ -301,21 +463,15 @@ struct search_block *search_create(struct file_block *file, struct objdb_block *
 	new->test_contents = FALSE;
 	new->contents_engine = NULL;
 
-	new->path_count = paths;
+	new->duplicates = NULL;
 
-	/* Split the path list into separate paths and link them into .path[]
-	 * in reverse order so that .path_count can be decremented during
-	 * the search.
-	 */
+	new->index = NULL;
+	new->index_claimed = FALSE;
 
-	new->path[--paths] = new->paths;
+	new->plan_length = 0;
+	new->plan_objects = 0;
 
-	for (i = 0; new->paths[i] != '\0'; i++) {
-		if (new->paths[i] == ',' && paths > 0) {
-			new->path[--paths] = new->paths + i + 1;
-			new->paths[i] = '\0';
-		}
-	}
+	search_split_paths(new, paths);
 
 	return new;
 }
@@ -339,8 +495,10 @@ void search_destroy(struct search_block *search)
 
 	/* Free any memory allocated to the search. */
 
-	if (search->stack != NULL)
-		flex_free((flex_ptr) &(search->stack));
+	search_free_stack(search);
+
+	if (search->pathname != NULL)
+		heap_free(search->pathname);
 
 	if (search->path != NULL)
 		heap_free(search->path);
@@ -351,6 +509,12 @@ void search_destroy(struct search_block *search)
 	if (search->filename != NULL)
 		flex_free((flex_ptr) &(search->filename));
 
+	if (search->filename_matcher != NULL)
+		wildcard_destroy(search->filename_matcher);
+
+	if (search->filename_regex != NULL)
+		regex_destroy(search->filename_regex);
+
 	/* Remove the ignore list if present. */
 
 	if (search->ignore_list != NULL)
@@ -361,6 +525,11 @@ void search_destroy(struct search_block *search)
 	if (search->contents_engine != NULL)
 		contents_destroy(search->contents_engine);
 
+	/* Remove the duplicate file detection if present. */
+
+	if (search->duplicates != NULL)
+		dupes_destroy(search->duplicates);
+
 	heap_free(search);
 }
 
@@ -394,11 +563,32 @@ void search_set_options(struct search_block *search, osbool search_imagefs, osbo
 }
 
 
+/**
+ * Set the ignore list for a search.
+ *
+ * \param *search		The search to set the ignore list for.
+ * \param *list			Pointer to a comma-separated list of leafnames,
+ *				pathnames and &filetypes to be ignored.
+ */
+
+void search_set_ignore(struct search_block *search, char *list)
+{
+	if (search == NULL)
+		return;
+
+	if (search->ignore_list != NULL)
+		ignore_destroy(search->ignore_list);
+
+	search->ignore_list = ignore_create(list);
+}
+
+
 /**
  * Set the filename matching options for a search.
  *
  * \param *search		The search to set the options for.
- * \param *filename		Pointer to the filename to match.
+ * \param *filename		Pointer to the filename to match, or a
+ *				comma-separated list of filenames.
  * \param any_case		TRUE to match case insensitively; else FALSE.
  * \param invert		TRUE to match files whose names don't match; else FALSE.
  */
@@ -412,6 +602,56 @@ void search_set_filename(struct search_block *search, char *filename, osbool any
 	search->filename_logic = !invert;
 	flexutils_store_string((flex_ptr) &(search->filename), filename);
 	search->filename_any_case = any_case;
+
+	/* Compile the pattern; if this fails, the search will fall back to
+	 * interpreting the stored copy for each object.
+	 */
+
+	if (search->filename_matcher != NULL)
+		wildcard_destroy(search->filename_matcher);
+
+	if (search->filename_regex != NULL)
+		regex_destroy(search->filename_regex);
+
+	search->filename_regex = NULL;
+
+	search->filename_matcher = wildcard_create(filename, any_case);
+}
+
+
+/**
+ * Set a regular expression for filename matching in a search.
+ *
+ * \param *search		The search to set the options for.
+ * \param *expression		Pointer to the regular expression to match.
+ * \param any_case		TRUE to match case insensitively; else FALSE.
+ * \param invert		TRUE to match files whose names don't match; else FALSE.
+ * \return			TRUE if the expression was compiled; else FALSE.
+ */
+
+osbool search_set_filename_regex(struct search_block *search, char *expression, osbool any_case, osbool invert)
+{
+	if (search == NULL)
+		return FALSE;
+
+	if (search->filename_matcher != NULL)
+		wildcard_destroy(search->filename_matcher);
+
+	search->filename_matcher = NULL;
+
+	if (search->filename_regex != NULL)
+		regex_destroy(search->filename_regex);
+
+	search->filename_regex = regex_create(expression, any_case);
+	if (search->filename_regex == NULL)
+		return FALSE;
+
+	search->test_filename = TRUE;
+	search->filename_logic = !invert;
+	flexutils_store_string((flex_ptr) &(search->filename), expression);
+	search->filename_any_case = any_case;
+
+	return TRUE;
 }
 
 
@@ -453,10 +693,10 @@ void search_set_date(struct search_block *search, osbool in_limits, os_date_and_
 
 	search->test_date = TRUE;
 	search->date_logic = in_limits;
-	search->minimum_date_lo = minimum[0] | (minimum[1] << 8) | (minimum[2] << 16) | (minimum[3] << 24);
-	search->minimum_date_hi = minimum[4];
-	search->maximum_date_lo = maximum[0] | (maximum[1] << 8) | (maximum[2] << 16) | (maximum[3] << 24);
-	search->maximum_date_hi = maximum[4];
+	search->minimum_date = ((unsigned long long) minimum[4] << 32) |
+			(minimum[0] | (minimum[1] << 8) | (minimum[2] << 16) | ((unsigned) minimum[3] << 24));
+	search->maximum_date = ((unsigned long long) maximum[4] << 32) |
+			(maximum[0] | (maximum[1] << 8) | (maximum[2] << 16) | ((unsigned) maximum[3] << 24));
 
 	search->date_as_age = as_age;
 }
@@ -502,9 +742,9 @@ void search_set_types(struct search_block *search, unsigned type_list[], osbool
 			search->include_untyped = !invert;
 		} else if ((type_list[i] >= 0x000u) && (type_list[i] <= 0xfffu)) {
 			if (invert)
-				search->filetypes[type_list[i] / (8 * sizeof(bits))] &= ~(1 << (type_list[i] % (8 * sizeof(bits))));
+				search->filetypes[type_list[i] / (8 * sizeof(bits))] &= ~(1u << (type_list[i] % (8 * sizeof(bits))));
 			else
-				search->filetypes[type_list[i] / (8 * sizeof(bits))] |= (1 << (type_list[i] % (8 * sizeof(bits))));
+				search->filetypes[type_list[i] / (8 * sizeof(bits))] |= (1u << (type_list[i] % (8 * sizeof(bits))));
 		}
 
 		i++;
@@ -550,6 +790,58 @@ void search_set_contents(struct search_block *search, char *contents, osbool any
 }
 
 
+/**
+ * Set a search to look for duplicate files. The files which match the other
+ * tests are compared once the search paths have been scanned, and only those
+ * which share their size and the 64-bit hash of their contents with another
+ * are reported, grouped into sets. The contents are not compared byte for
+ * byte, so a set could in principle hold files which differ. Any contents
+ * test is ignored.
+ *
+ * \param *search		The search to set the options for.
+ * \param duplicates		TRUE to report duplicate files; FALSE to report
+ *				all matching files.
+ */
+
+void search_set_duplicates(struct search_block *search, osbool duplicates)
+{
+	if (search == NULL || search->active)
+		return;
+
+	if (duplicates && search->duplicates == NULL) {
+		search->duplicates = dupes_create(search->objects, search->results);
+	} else if (!duplicates && search->duplicates != NULL) {
+		dupes_destroy(search->duplicates);
+		search->duplicates = NULL;
+	}
+}
+
+
+/**
+ * Set a filename index for a search to read its directory listings from.
+ * Paths outside the root of the index are still read from disc. If the
+ * index is being built or refreshed, the search runs the update from its
+ * own polls and only starts once it has finished; the index is then held
+ * against further refreshes until the search stops.
+ *
+ * \param *search		The search to set the index for.
+ * \param *index		The index to use, or NULL to read from disc.
+ */
+
+void search_set_index(struct search_block *search, struct index_block *index)
+{
+	if (search == NULL)
+		return;
+
+	if (search->index_claimed) {
+		index_release(search->index);
+		search->index_claimed = FALSE;
+	}
+
+	search->index = index;
+}
+
+
 /**
  * Make a search active so that it will run on subsequent calls to search_poll().
  *
@@ -559,57 +851,35 @@ void search_set_contents(struct search_block *search, char *contents, osbool any
 void search_start(struct search_block *search)
 {
 	unsigned	stack, object_key;
-	char		title[256], flag[10], flags[10];
-
 
 	if (search == NULL || search->path_count == 0)
 		return;
 
 	/* Set the window title up. */
 
-	*flags = '\0';
-
-	if (search->test_size == TRUE) {
-		msgs_lookup("SizeFlag", flag, sizeof(flag));
-		strcat(flags, flag);
-	}
+	search_update_title(search);
 
-	if (search->test_date == TRUE) {
-		if (search->date_as_age)
-			msgs_lookup("AgeFlag", flag, sizeof(flag));
-		else
-			msgs_lookup("DateFlag", flag, sizeof(flag));
-		strcat(flags, flag);
-	}
+	/* Drop any paths which overlap others, and compile the tests into a plan. */
 
-	if (search->include_files == FALSE || search->include_directories == FALSE || search->include_applications == FALSE ||
-			search->test_filetype == TRUE) {
-		msgs_lookup("TypeFlag", flag, sizeof(flag));
-		strcat(flags, flag);
-	}
+	search_prune_paths(search);
+	search_compile_plan(search);
 
-	if (search->test_attributes == TRUE) {
-		msgs_lookup("AttrFlag", flag, sizeof(flag));
-		strcat(flags, flag);
-	}
+	/* Allocate a search stack and set up the first search folder. */
 
-	if (search->test_contents == TRUE) {
-		msgs_lookup("ContFlag", flag, sizeof(flag));
-		strcat(flags, flag);
-	}
+	if ((stack = search_add_stack(search, search->path[--search->path_count])) == SEARCH_NULL)
+		return;
 
-	msgs_param_lookup("ResWindTitle", title, sizeof(title), (search->filename != NULL) ? search->filename: "", flags, NULL, NULL);
+	object_key = objdb_add_root(search->objects, search->pathname);
+	search->stack[stack].parent = object_key;
 
-	results_set_title(search->results, title);
+	/* Note the flex resize counts, so that the search's share can be found. */
 
-	/* Allocate a search stack and set up the first search folder. */
+	flexutils_get_resize_counts(&(search->flex_resizes), &(search->flex_resize_bytes));
 
-	if ((stack = search_add_stack(search)) == SEARCH_NULL)
-		return;
+	/* Note the start time, so that the duty cycle can be found. */
 
-	string_copy(search->stack[stack].filename, search->path[--search->path_count], SEARCH_MAX_FILENAME);
-	object_key = objdb_add_root(search->objects, search->stack[stack].filename);
-	search->stack[stack].parent = object_key;
+	search->start_time = os_read_monotonic_time();
+	search->busy_time = 0;
 
 	/* Flag the search as active. */
 
@@ -636,8 +906,12 @@ void search_start(struct search_block *search)
 
 void search_stop(struct search_block *search)
 {
-	struct search_block	*active;
-	char			status[STATUS_LENGTH], errors[ERROR_LENGTH], number[NUM_BUF_LENGTH];
+	char			status[STATUS_LENGTH], errors[ERROR_LENGTH], pruned[ERROR_LENGTH], number[NUM_BUF_LENGTH], count[NUM_BUF_LENGTH];
+	unsigned		sets;
+#ifdef DEBUG
+	unsigned		resizes, bytes, i;
+	char			*test_names[] = {"Type", "Attributes", "Size", "Date", "Filename"};
+#endif
 
 
 	if (search == NULL || search->active == FALSE)
@@ -649,18 +923,33 @@ void search_stop(struct search_block *search)
 
 	search_searches_active--;
 
+	search->stop_time = os_read_monotonic_time();
+
+#ifdef DEBUG
+	debug_printf("Search ran for %u cs, of which %u cs were spent polling (%u%% duty cycle)",
+			search->stop_time - search->start_time, search->busy_time, search_get_duty_cycle(search));
+	flexutils_get_resize_counts(&resizes, &bytes);
+	debug_printf("Search flex usage: %u resizes, holding %u bytes", resizes - search->flex_resizes, bytes - search->flex_resize_bytes);
+	debug_printf("Search ignored %u objects, and rejected %u without storing them", search->ignored_count, search->rejected_count);
+
+	for (i = 0; i < search->plan_length; i++)
+		debug_printf("Search plan step %u: %s test, cost %u, tested %u objects and rejected %u", i, test_names[search->plan[i].test],
+				search->plan[i].cost, search->plan[i].total_tested, search->plan[i].total_rejected);
+#endif
+
 	/* Free any stack that's allocated.
 	 *
 	 * NB: This will need to be reallocated if the search is restarted, so
 	 * it's terminal.  Any search history will be lost.
 	 */
 
-	if (search->stack != NULL) {
-		search->stack_size = 0;
-		search->stack_level = 0;
+	search_free_stack(search);
 
-		flex_free((flex_ptr) &(search->stack));
-		search->stack = NULL;
+	/* Let the index be refreshed again. */
+
+	if (search->index_claimed) {
+		index_release(search->index);
+		search->index_claimed = FALSE;
 	}
 
 	/* Sort out the status bar text. */
@@ -672,11 +961,83 @@ void search_stop(struct search_block *search)
 		msgs_param_lookup("Errors", errors, ERROR_LENGTH, number, NULL, NULL, NULL);
 	}
 
-	string_printf(number, NUM_BUF_LENGTH, "%d", search->file_count);
-	msgs_param_lookup("Found", status, STATUS_LENGTH, number, errors, NULL, NULL);
+	if (search->pruned_count > 0) {
+		string_printf(number, NUM_BUF_LENGTH, "%d", search->pruned_count);
+		msgs_param_lookup("Pruned", pruned, ERROR_LENGTH, number, NULL, NULL, NULL);
+		strncat(errors, pruned, ERROR_LENGTH - strlen(errors) - 1);
+	}
+
+	if (search->duplicates != NULL) {
+		dupes_get_progress(search->duplicates, NULL, NULL, &(search->file_count), &sets);
+		string_printf(number, NUM_BUF_LENGTH, "%d", search->file_count);
+		string_printf(count, NUM_BUF_LENGTH, "%d", sets);
+		msgs_param_lookup("FoundDupes", status, STATUS_LENGTH, number, count, errors, NULL);
+	} else {
+		string_printf(number, NUM_BUF_LENGTH, "%d", search->file_count);
+		msgs_param_lookup("Found", status, STATUS_LENGTH, number, errors, NULL, NULL);
+	}
 
 	results_set_status(search->results, status);
 
+	/* Remove the search from the active list, unless it was paused. */
+
+	if (search->paused)
+		search->paused = FALSE;
+	else
+		search_unlink(search);
+}
+
+
+/**
+ * Pause an active search, so that it keeps its place but isn't polled until
+ * it is resumed.
+ *
+ * \param *search		The handle of the search to pause.
+ */
+
+void search_pause(struct search_block *search)
+{
+	if (search == NULL || !search->active || search->paused)
+		return;
+
+	search_unlink(search);
+	search->paused = TRUE;
+
+	results_set_status_template(search->results, "Paused", search->pathname);
+}
+
+
+/**
+ * Resume a paused search, so that it runs again on subsequent calls to
+ * search_poll().
+ *
+ * \param *search		The handle of the search to resume.
+ */
+
+void search_resume(struct search_block *search)
+{
+	if (search == NULL || !search->active || !search->paused)
+		return;
+
+	search->paused = FALSE;
+
+	search->next = search_active;
+	search_active = search;
+
+	results_set_status_template(search->results, "Searching", search->pathname);
+}
+
+
+/**
+ * Remove a search from the active search list.
+ *
+ * \param *search		The search to remove.
+ */
+
+static void search_unlink(struct search_block *search)
+{
+	struct search_block	*active;
+
 	/* If the search is at the head of the list, remove it... */
 
 	if (search_active == search) {
@@ -722,125 +1083,663 @@ osbool search_is_active(struct search_block *search)
 
 
 /**
- * Run any active searches in a Null poll.
+ * Test to see if a given search is active but paused.
+ *
+ * \param *search		The search to test.
+ * \return			TRUE if paused; else FALSE.
  */
 
-void search_poll_all(void)
+osbool search_is_paused(struct search_block *search)
 {
-	struct search_block	*search = search_active;
-	os_t			time_slice;
-
-	time_slice = (os_t) (config_int_read("MultitaskTimeslot") / search_searches_active);
-
-	while (search != NULL) {
-		search_poll(search, os_read_monotonic_time() + time_slice);
-		search = search->next;
-	}
+	return (search == NULL || !search->active || !search->paused) ? FALSE : TRUE;
 }
 
 
 /**
- * Poll an active search for a given timeslice.
+ * Run any active searches in a Null poll.
  *
- * \param *search		The search to be polled.
- * \param end_time		The time by which control must return.
- * \return			TRUE or FALSE. \TODO!
+ * The timeslot is shared between the active searches in proportion to their
+ * priorities. Each search is offered its share of the time that remains, so
+ * any time left unused by a search which finishes or runs out of work early
+ * passes on to those after it in the list.
+ *
+ * \param timeslot		The time, in cs, to share between the searches.
  */
 
-static osbool search_poll(struct search_block *search, os_t end_time)
+void search_poll_all(os_t timeslot)
 {
-	os_error		*error;
-	int			i;
-	unsigned		stack, object_key;
-	byte			*original, copy[SEARCH_BLOCK_SIZE];
-	osgbpb_info		*file_data = (osgbpb_info *) copy;
-	char			filename[4996], leafname[SEARCH_MAX_FILENAME];
-	osbool			contents_match;
+	struct search_block	*search = search_active, *next;
+	os_t			time_slice, start_time, used;
+	unsigned		weights = 0;
 
-	// \TODO -- The allocation of copy[] is ugly.
+	start_time = os_read_monotonic_time();
 
+	for (search = search_active; search != NULL; search = search->next)
+		weights += search->priority;
 
-	if (search == NULL || !search->active)
-		return TRUE;
+	search = search_active;
 
-	/* If there's no stack set up, the search must have ended. */
+	while (search != NULL && weights > 0) {
+		next = search->next;
 
-	if (search->stack_level == 0) {
-		search_stop(search);
-		return FALSE;
-	}
+		time_slice = (timeslot * search->priority) / weights;
+		if (time_slice < 1)
+			time_slice = 1;
 
-	/* Get the current stack level, and enter the search loop. */
+		weights -= search->priority;
 
-	stack = search->stack_level - 1;
+		search_poll(search, start_time + time_slice);
 
-	while (stack != SEARCH_NULL && (os_read_monotonic_time() < end_time)) {
-		/* **** Bracket here to skip search if directory is on ignore??? **** */
-		
-		if (search->stack[stack].contents_active == FALSE) {
-			/* If there are no outstanding entries in the current buffer, call
-			 * OS_GBPB 10 to get another set of file details.
-			 */
+		used = os_read_monotonic_time() - start_time;
+		search->busy_time += used;
+		start_time += used;
 
-			error = NULL;
+		timeslot = (used < timeslot) ? timeslot - used : 0;
 
-			if (search->stack[stack].next >= search->stack[stack].read) {
-				*filename = '\0';
+		search = next;
+	}
+}
 
-				for (i = 0; i <= stack; i++) {
-					if (i > 0)
-						strcat(filename, ".");
-					strcat(filename, search->stack[i].filename);
-				}
 
-				error = xosgbpb_dir_entries_info(filename, (osgbpb_info_list *) search->stack[stack].info, 1000, search->stack[stack].context,
-						SEARCH_BLOCK_SIZE, "*", &(search->stack[stack].read), &(search->stack[stack].context));
+/**
+ * Set the scheduling priority of a search, which weights the share of each
+ * multitasking timeslot that it is given.
+ *
+ * \param *search		The search to update.
+ * \param priority		The new priority, from 1 upwards.
+ */
 
-				search->stack[stack].next = 0;
-				search->stack[stack].data_offset = 0;
-			}
+void search_set_priority(struct search_block *search, unsigned priority)
+{
+	if (search == NULL)
+		return;
 
-			/* Handle any errors thrown by the OS_GBPB call by dropping back out of
-			 * the current directory. Because we're adding an error with a database
-			 * key, it's important that we now continue out of the current loop and
-			 * don't call objdb_delete_last_key() in the usual way -- otherwise, the
-			 * key that's linked to the error will probably get removed from the
-			 * object database.
-			 */
+	search->priority = (priority > 0) ? priority : 1;
+}
 
-			if (error != NULL) {
-				search->error_count++;
-				results_add_error(search->results, error->errmess, search->stack[stack].parent);
 
-				stack = search_drop_stack(search);
+/**
+ * Run a search to completion without returning control, for use by front
+ * ends which don't need to multitask.
+ *
+ * \param *search		The search to run.
+ */
 
-				continue;
-			}
-		}
+void search_run(struct search_block *search)
+{
+	os_t	start_time;
+
+	if (search == NULL)
+		return;
+
+	while (search->active && !search->paused) {
+		start_time = os_read_monotonic_time();
+		search_poll(search, start_time + SEARCH_RUN_SLICE);
+		search->busy_time += os_read_monotonic_time() - start_time;
+	}
+}
+
+
+/**
+ * Return the counts of objects examined, matched and in error for a search.
+ *
+ * \param *search		The search to report on.
+ * \param *objects		Pointer to a variable to take the number of
+ *				objects examined, or NULL.
+ * \param *matches		Pointer to a variable to take the number of
+ *				matches found, or NULL.
+ * \param *errors		Pointer to a variable to take the number of
+ *				errors encountered, or NULL.
+ */
+
+void search_get_counts(struct search_block *search, unsigned *objects, unsigned *matches, unsigned *errors)
+{
+	if (search == NULL)
+		return;
+
+	if (objects != NULL)
+		*objects = search->object_count;
+
+	if (matches != NULL)
+		*matches = search->file_count;
+
+	if (errors != NULL)
+		*errors = search->error_count;
+}
+
+
+/**
+ * Return the duty cycle achieved by a search: the proportion of the time
+ * since it started (or of its run, if it has stopped) that was spent polling
+ * it.
+ *
+ * \param *search		The search to report on.
+ * \return			The duty cycle, as a percentage.
+ */
+
+unsigned search_get_duty_cycle(struct search_block *search)
+{
+	os_t	elapsed;
+
+	if (search == NULL || search->start_time == 0)
+		return 0;
+
+	elapsed = ((search->active) ? os_read_monotonic_time() : search->stop_time) - search->start_time;
+
+	if (elapsed == 0)
+		return 100;
+
+	return (search->busy_time >= elapsed) ? 100 : (search->busy_time * 100) / elapsed;
+}
+
+
+/**
+ * Return the number of paths which were dropped from a search when it
+ * started, because they were the same as or lay within other paths.
+ *
+ * \param *search		The search to report on.
+ * \return			The number of paths dropped.
+ */
+
+unsigned search_get_pruned_paths(struct search_block *search)
+{
+	return (search != NULL) ? search->pruned_count : 0;
+}
+
+
+/**
+ * Save the state of an active search to a file, so that it can be resumed
+ * from the same place later. The search's object database and results must
+ * be saved into the same file.
+ *
+ * The directory blocks held by the stack aren't saved: instead, each level
+ * records the OS_GBPB context from which its block was read and the position
+ * within it, so that the block can be read again when the search resumes.
+ *
+ * \param *search		The search to save.
+ * \param *out			The file to save to.
+ * \return			TRUE if a search was saved; else FALSE.
+ */
+
+osbool search_save_file(struct search_block *search, struct discfile_block *out)
+{
+	struct search_file_level	level;
+	char				*paths;
+	size_t				length;
+	unsigned			stack, key = OBJDB_NULL_KEY;
+	int				i, pointer = 0;
+	osbool				matched = FALSE;
+
+	if (search == NULL || out == NULL || !search->active)
+		return FALSE;
+
+	/* The state of a duplicate file detection isn't saved, so these
+	 * searches can't be carried on later.
+	 */
+
+	if (search->duplicates != NULL)
+		return FALSE;
+
+	/* Join the paths which are still to be searched back into a list, in
+	 * the order in which they were given.
+	 */
+
+	length = 1;
+
+	for (i = 0; i < search->path_count; i++)
+		length += strlen(search->path[i]) + 1;
+
+	paths = heap_alloc(length);
+	if (paths == NULL)
+		return FALSE;
+
+	*paths = '\0';
+
+	for (i = search->path_count - 1; i >= 0; i--) {
+		strcat(paths, search->path[i]);
+		if (i > 0)
+			strcat(paths, ",");
+	}
+
+	/* Find the position of any contents search in progress. */
+
+	if (search->stack_level > 0 && search->stack[search->stack_level - 1].contents_active)
+		contents_get_position(search->contents_engine, &key, &pointer, &matched);
+
+	discfile_start_section(out, DISCFILE_SECTION_SEARCH, FALSE);
+
+	/* Write the search details. */
+
+	discfile_start_chunk(out, DISCFILE_CHUNK_OPTIONS);
+	discfile_write_option_string(out, "PTH", paths);
+	discfile_write_option_string(out, "PTN", search->pathname);
+	discfile_write_option_unsigned(out, "LEV", search->stack_level);
+	discfile_write_option_unsigned(out, "LSZ", sizeof(struct search_file_level));
+	discfile_write_option_unsigned(out, "BUF", search->buffer_size);
+	discfile_write_option_unsigned(out, "OBJ", search->object_count);
+	discfile_write_option_unsigned(out, "FIL", search->file_count);
+	discfile_write_option_unsigned(out, "ERR", search->error_count);
+	discfile_write_option_unsigned(out, "IGN", search->ignored_count);
+	discfile_write_option_unsigned(out, "REJ", search->rejected_count);
+	discfile_write_option_unsigned(out, "PRU", search->pruned_count);
+	discfile_write_option_unsigned(out, "CKY", key);
+	discfile_write_option_unsigned(out, "CPT", pointer);
+	discfile_write_option_boolean(out, "CMT", matched);
+	discfile_end_chunk(out);
+
+	/* Write the stack levels. */
+
+	discfile_start_chunk(out, DISCFILE_CHUNK_STACK);
+
+	for (stack = 0; stack < search->stack_level; stack++) {
+		level.path_length = search->stack[stack].path_length;
+		level.block_context = search->stack[stack].block_context;
+		level.next = search->stack[stack].next;
+		level.pinned = search->stack[stack].pinned;
+		level.key = search->stack[stack].key;
+		level.parent = search->stack[stack].parent;
+		level.filetype = search->stack[stack].filetype;
+		level.file_active = search->stack[stack].file_active;
+		level.contents_active = search->stack[stack].contents_active;
+
+		discfile_write_chunk(out, (byte *) &level, sizeof(struct search_file_level));
+	}
+
+	discfile_end_chunk(out);
+
+	discfile_end_section(out);
+
+	heap_free(paths);
+
+	return TRUE;
+}
+
+
+/**
+ * Test a file to see if it contains the state of a search.
+ *
+ * \param *load			The file to test.
+ * \return			TRUE if there is a search state; else FALSE.
+ */
+
+osbool search_check_file(struct discfile_block *load)
+{
+	if (load == NULL || discfile_read_format(load) != DISCFILE_LOCATE2)
+		return FALSE;
+
+	if (!discfile_open_section(load, DISCFILE_SECTION_SEARCH))
+		return FALSE;
+
+	discfile_close_section(load);
+
+	return TRUE;
+}
+
+
+/**
+ * Restore the state of a search from a file, into a search which has been
+ * created from the same object database and results and given the same
+ * options, but not started. The search is left active but paused, ready
+ * to be resumed with search_resume().
+ *
+ * If a directory has changed since the search was saved, the search picks
+ * up from the same position in its listing: objects may be missed or seen
+ * twice, as they would be if the directory changed during a search.
+ *
+ * \param *search		The search to restore into.
+ * \param *load			The file to load from.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+osbool search_load_file(struct search_block *search, struct discfile_block *load)
+{
+	struct search_file_level	*levels = NULL;
+	char				*flex_paths = NULL, *flex_pathname = NULL, *paths = NULL, *pathname = NULL, **path = NULL, *name, c;
+	unsigned			count = 0, size = 0, buffer = 0, objects = 0, files = 0, errors = 0, ignored = 0, rejected = 0, pruned = 0;
+	unsigned			key = OBJDB_NULL_KEY, pointer = 0, limit, i, stack;
+	osbool				matched = FALSE, valid = TRUE, mem_ok = TRUE;
+	size_t				length, start;
+	int				path_count = 0;
+
+	if (search == NULL || load == NULL || search->active || discfile_read_format(load) != DISCFILE_LOCATE2)
+		return FALSE;
+
+	if (!discfile_open_section(load, DISCFILE_SECTION_SEARCH)) {
+		discfile_set_error(load, "FileUnrec");
+		return FALSE;
+	}
+
+	/* Load the search details. */
+
+	if (!discfile_open_chunk(load, DISCFILE_CHUNK_OPTIONS)) {
+		discfile_set_error(load, "FileUnrec");
+		return FALSE;
+	}
+
+	if (flex_alloc((flex_ptr) &flex_paths, 1) == 0 || flex_alloc((flex_ptr) &flex_pathname, 1) == 0)
+		mem_ok = FALSE;
+
+	if (mem_ok && (!discfile_read_option_flex_string(load, "PTH", (flex_ptr) &flex_paths) ||
+			!discfile_read_option_flex_string(load, "PTN", (flex_ptr) &flex_pathname) ||
+			!discfile_read_option_unsigned(load, "LEV", &count) ||
+			!discfile_read_option_unsigned(load, "LSZ", &size) ||
+			!discfile_read_option_unsigned(load, "BUF", &buffer) ||
+			!discfile_read_option_unsigned(load, "OBJ", &objects) ||
+			!discfile_read_option_unsigned(load, "FIL", &files) ||
+			!discfile_read_option_unsigned(load, "ERR", &errors) ||
+			!discfile_read_option_unsigned(load, "IGN", &ignored) ||
+			!discfile_read_option_unsigned(load, "REJ", &rejected) ||
+			!discfile_read_option_unsigned(load, "PRU", &pruned) ||
+			!discfile_read_option_unsigned(load, "CKY", &key) ||
+			!discfile_read_option_unsigned(load, "CPT", &pointer) ||
+			!discfile_read_option_boolean(load, "CMT", &matched) ||
+			size != sizeof(struct search_file_level) || buffer == 0 || buffer > SEARCH_BLOCK_MAX))
+		valid = FALSE;
+
+	discfile_close_chunk(load);
+
+	/* Copy the strings out of flex, so that they stay put while the stack
+	 * is rebuilt.
+	 */
+
+	if (mem_ok && valid) {
+		if ((paths = heap_strdup(flex_paths)) == NULL || (pathname = heap_strdup(flex_pathname)) == NULL ||
+				(levels = heap_alloc((count > 0 ? count : 1) * sizeof(struct search_file_level))) == NULL)
+			mem_ok = FALSE;
+	}
+
+	if (flex_paths != NULL)
+		flex_free((flex_ptr) &flex_paths);
+
+	if (flex_pathname != NULL)
+		flex_free((flex_ptr) &flex_pathname);
+
+	/* Load the stack levels. */
+
+	if (mem_ok && valid) {
+		if (discfile_open_chunk(load, DISCFILE_CHUNK_STACK) && discfile_chunk_size(load) == count * sizeof(struct search_file_level)) {
+			discfile_read_chunk(load, (byte *) levels, count * sizeof(struct search_file_level));
+			discfile_close_chunk(load);
+		} else {
+			valid = FALSE;
+		}
+	}
+
+	/* Check that the levels fit the pathname and the object database. */
+
+	if (mem_ok && valid) {
+		length = strlen(pathname);
+		limit = objdb_get_key_limit(search->objects);
+
+		for (i = 0; i < count && valid; i++) {
+			start = (i == 0) ? 0 : levels[i - 1].path_length + 1;
+
+			if (levels[i].path_length <= start || levels[i].path_length > length ||
+					(pathname[levels[i].path_length] != '\0' && pathname[levels[i].path_length] != '.') ||
+					(levels[i].parent != OBJDB_NULL_KEY && levels[i].parent >= limit) ||
+					(levels[i].file_active && levels[i].key >= limit))
+				valid = FALSE;
+		}
+
+		if (count > 0 && levels[count - 1].path_length != length)
+			valid = FALSE;
+
+		if (count > 0 && levels[count - 1].contents_active && (search->contents_engine == NULL || key >= limit))
+			valid = FALSE;
+	}
+
+	/* Replace the search's list of paths with those which remain. */
+
+	if (mem_ok && valid) {
+		path_count = (*paths == '\0') ? 0 : 1;
+
+		for (i = 0; paths[i] != '\0'; i++)
+			if (paths[i] == ',')
+				path_count++;
+
+		if ((path = heap_alloc((path_count > 0 ? path_count : 1) * sizeof(char *))) == NULL)
+			mem_ok = FALSE;
+	}
+
+	if (!mem_ok || !valid) {
+		if (path != NULL)
+			heap_free(path);
+
+		if (levels != NULL)
+			heap_free(levels);
+
+		if (pathname != NULL)
+			heap_free(pathname);
+
+		if (paths != NULL)
+			heap_free(paths);
+
+		discfile_set_error(load, (mem_ok) ? "FileUnrec" : "FileMem");
+		return FALSE;
+	}
+
+	discfile_close_section(load);
+
+	heap_free(search->path);
+	heap_free(search->paths);
+
+	search->paths = paths;
+	search->path = path;
+	search_split_paths(search, path_count);
+
+	search->buffer_size = buffer;
+	search->object_count = objects;
+	search->file_count = files;
+	search->error_count = errors;
+	search->ignored_count = ignored;
+	search->rejected_count = rejected;
+	search->pruned_count = pruned;
+
+	/* Rebuild the stack a level at a time, reading each directory again. */
+
+	search->stack_level = 0;
+	*(search->pathname) = '\0';
+
+	for (i = 0; i < count; i++) {
+		start = (i == 0) ? 0 : levels[i - 1].path_length + 1;
+		name = pathname + start;
+
+		c = pathname[levels[i].path_length];
+		pathname[levels[i].path_length] = '\0';
+		stack = search_add_stack(search, name);
+		pathname[levels[i].path_length] = c;
+
+		if (stack == SEARCH_NULL) {
+			search->error_count++;
+			results_add_error(search->results, "Search stack full", levels[i].parent);
+			break;
+		}
+
+		search->stack[stack].key = levels[i].key;
+		search->stack[stack].parent = levels[i].parent;
+		search->stack[stack].filetype = levels[i].filetype;
+		search->stack[stack].pinned = levels[i].pinned;
+		search->stack[stack].file_active = levels[i].file_active;
+		search->stack[stack].contents_active = levels[i].contents_active;
+
+		/* If the entry that was being processed can't be found again, move
+		 * on past it.
+		 */
+
+		if (!search_restore_level(search, stack, levels[i].block_context, levels[i].next)) {
+			search->stack[stack].pinned = FALSE;
+			search->stack[stack].contents_active = FALSE;
+		}
+	}
+
+	/* Pick up any contents search where it left off. */
+
+	if (search->stack_level > 0 && search->stack[search->stack_level - 1].contents_active &&
+			!contents_resume_file(search->contents_engine, key, pointer, matched,
+			(matched) ? results_find_file(search->results, key) : RESULTS_NULL))
+		search->stack[search->stack_level - 1].contents_active = FALSE;
+
+	heap_free(levels);
+	heap_free(pathname);
+
+	/* Set the window title and plan up, and leave the search paused. */
+
+	search_update_title(search);
+	search_compile_plan(search);
+
+	flexutils_get_resize_counts(&(search->flex_resizes), &(search->flex_resize_bytes));
+
+	search->start_time = os_read_monotonic_time();
+	search->busy_time = 0;
+
+	search->active = TRUE;
+	search->paused = TRUE;
+
+	search_searches_active++;
+
+	results_set_status_template(search->results, "Paused", search->pathname);
+
+	return TRUE;
+}
+
+
+/**
+ * Poll an active search for a given timeslice.
+ *
+ * \param *search		The search to be polled.
+ * \param end_time		The time by which control must return.
+ * \return			TRUE or FALSE. \TODO!
+ */
+
+static osbool search_poll(struct search_block *search, os_t end_time)
+{
+	os_error		*error;
+	os_t			start_time;
+	unsigned		stack, object_key, pattern;
+	osgbpb_info		*file_data;
+	osbool			contents_match, contents_done, match;
+	unsigned		compared, total;
+	char			status[STATUS_LENGTH], number[NUM_BUF_LENGTH], count[NUM_BUF_LENGTH];
+
+	if (search == NULL || !search->active)
+		return TRUE;
+
+	/* The index can't be read until any update to it has finished, so
+	 * until then the search's time goes to running the update. If the
+	 * update fails, the search reads from disc instead.
+	 */
+
+	if (search->index != NULL && !search->index_claimed) {
+		if (!index_poll(search->index, end_time)) {
+			results_set_status_template(search->results, "Indexing", index_get_root(search->index));
+			results_accept_lines(search->results);
+			return TRUE;
+		}
+
+		if (index_is_valid(search->index)) {
+			index_claim(search->index);
+			search->index_claimed = TRUE;
+		} else {
+			msgs_param_lookup("NoIndex", status, STATUS_LENGTH, index_get_root(search->index), NULL, NULL, NULL);
+			search->error_count++;
+			results_add_error(search->results, status, OBJDB_NULL_KEY);
+			search->index = NULL;
+		}
+	}
+
+	/* If there's no stack set up, the scan must have ended: any duplicate
+	 * files can now be compared, before the search ends.
+	 */
+
+	if (search->stack_level == 0) {
+		if (search->duplicates != NULL && !dupes_poll(search->duplicates, end_time)) {
+			dupes_get_progress(search->duplicates, &compared, &total, NULL, NULL);
+			string_printf(number, NUM_BUF_LENGTH, "%u", compared);
+			string_printf(count, NUM_BUF_LENGTH, "%u", total);
+			msgs_param_lookup("Comparing", status, STATUS_LENGTH, number, count, NULL, NULL);
+			results_set_status(search->results, status);
+			results_accept_lines(search->results);
+			return TRUE;
+		}
+
+		search_stop(search);
+		return FALSE;
+	}
+
+	/* Get the current stack level, and enter the search loop. The clock is
+	 * only read when the calibrated quantum of objects has been processed,
+	 * or after calls whose time can't be predicted.
+	 */
+
+	stack = search->stack_level - 1;
+
+	quantum_start(&(search->quantum), end_time);
+
+	while (stack != SEARCH_NULL && !quantum_expired(&(search->quantum), 0)) {
+		if (search->stack[stack].contents_active == FALSE) {
+			/* If there are no outstanding entries in the current buffer, call
+			 * OS_GBPB 10 to get another set of file details.
+			 */
+
+			error = NULL;
+
+			if (search->stack[stack].next >= search->stack[stack].read && !search->stack[stack].pinned) {
+				start_time = os_read_monotonic_time();
+
+				error = search_read_block(search, stack);
+
+				/* If the filing system is slow to respond and the block was filled
+				 * before the object count was reached, ask for bigger blocks, so
+				 * that fewer calls are needed on things like network shares.
+				 */
+
+				quantum_check(&(search->quantum));
+
+				if (error == NULL && (search->quantum.check_time - start_time) >= SEARCH_SLOW_READ && search->stack[stack].context != -1 &&
+						search->stack[stack].read < search->read_count && search->buffer_size < SEARCH_BLOCK_MAX)
+					search->buffer_size *= 2;
+
+				search->stack[stack].next = 0;
+				search->stack[stack].data_offset = 0;
+			}
+
+			/* Handle any errors thrown by the OS_GBPB call by dropping back out of
+			 * the current directory. Because we're adding an error with a database
+			 * key, it's important that we now continue out of the current loop and
+			 * don't call objdb_delete_last_key() in the usual way -- otherwise, the
+			 * key that's linked to the error will probably get removed from the
+			 * object database.
+			 */
+
+			if (error != NULL) {
+				search->error_count++;
+				results_add_error(search->results, error->errmess, search->stack[stack].parent);
+
+				stack = search_drop_stack(search);
+
+				continue;
+			}
+		}
 
 		/* Process the buffered details. */
 
-		while ((os_read_monotonic_time() < end_time) &&
+		while (!quantum_expired(&(search->quantum), 1) &&
 				((search->stack[stack].contents_active == TRUE) || (search->stack[stack].next < search->stack[stack].read))) {
 			if (search->stack[stack].contents_active == FALSE) {
-				/* Take a copy of the current file data into static memory, so that any pointers that we
-				 * use on it remain valid even if the flex heap moved around.
-				 *
-				 * At the head of the function, file_data = copy, so we can now access the block via a
-				 * sensible data type.
+				/* Pin the next record in the block, and step the data offset on to
+				 * the one after it. The record is used where it is: the block is on
+				 * the heap so it won't move with the flex heap, and the pin stops it
+				 * being refilled or resized until the record has been dealt with.
 				 */
 
-				original = search->stack[stack].info + search->stack[stack].data_offset;
-
-				for (i = 0; i < 20 || original[i] != '\0'; i++)
-					copy[i] = original[i];
-
-				copy[i] = '\0';
+				search->stack[stack].record_offset = search->stack[stack].data_offset;
+				search->stack[stack].pinned = TRUE;
 
-				/* Update the data offsets for the next file. */
+				file_data = search_get_record(search, stack);
 
-				search->stack[stack].data_offset += ((i + 4) & 0xfffffffc);
+				search->stack[stack].data_offset += (offsetof(osgbpb_info, name) + strlen(file_data->name) + 4) & 0xfffffffc;
 				search->stack[stack].next++;
+				search->object_count++;
 
 				/* Add the file to the database.
 				 *
@@ -850,10 +1749,6 @@ static osbool search_poll(struct search_block *search, os_t end_time)
 				 * back to the wrong place if it went straight to a flex block pointer.
 				 */
 
-				object_key = objdb_add_file(search->objects, search->stack[stack].parent, file_data);
-				search->stack[stack].key = object_key;
-				search->stack[stack].file_active = TRUE;
-
 				/* Work out a filetype using the convention 0x000-0xfff, 0x1000, 0x2000, 0x3000. */
 
 				if (file_data->obj_type == fileswitch_IS_DIR && file_data->name[0] == '!')
@@ -865,108 +1760,118 @@ static osbool search_poll(struct search_block *search, os_t end_time)
 				else
 					search->stack[stack].filetype = (file_data->load_addr & osfile_FILE_TYPE) >> osfile_FILE_TYPE_SHIFT;
 
-				/* Test the object that we have found, starting by making sure that it's not included in the ignore list. */
-
-				if (((search->ignore_list == NULL) || (ignore_match_object(search->ignore_list, file_data->name))) &&
-
-						/* Is the object type one that we want? */
-
-						((((search->stack[stack].filetype >= 0x000 && search->stack[stack].filetype <= 0xfff) ||
-						(search->stack[stack].filetype == osfile_TYPE_UNTYPED)) && search->include_files) ||
-						((search->stack[stack].filetype == osfile_TYPE_DIR) && search->include_directories) ||
-						((search->stack[stack].filetype == osfile_TYPE_APPLICATION) && search->include_applications)) &&
-
-						/* If we're testing filename, does the name match? */
-
-						(!search->test_filename || (string_wildcard_compare(search->filename, file_data->name, search->filename_any_case) == search->filename_logic)) &&
-
-						/* If we're testing filesize, does it fall into range? */
-
-						(!search->test_size || (search->stack[stack].filetype == osfile_TYPE_DIR) || (search->stack[stack].filetype == osfile_TYPE_APPLICATION) ||
-								(((file_data->size >= search->minimum_size) && (file_data->size <= search->maximum_size)) == search->size_logic)) &&
-
-						/* If we're testing date, does it fall into range? */
-
-						(!search->test_date || (search->stack[stack].filetype == osfile_TYPE_UNTYPED) ||
-								(((((file_data->load_addr & 0xffu) > search->minimum_date_hi) ||
-										(((file_data->load_addr & 0xffu) == search->minimum_date_hi) &&
-										(file_data->exec_addr >= search->minimum_date_lo))) &&
-								(((file_data->load_addr & 0xffu) < search->maximum_date_hi) ||
-										(((file_data->load_addr & 0xffu) == search->maximum_date_hi) &&
-										(file_data->exec_addr <= search->maximum_date_lo)))) == search->date_logic)) &&
-
-						/* If we're testing filetype and the type falls between 0x000 and 0xfff, is it set in the bitmask? */
+				/* If the object is on the ignore list, skip it completely: it isn't
+				 * stored or reported, and if it's a directory, it isn't entered.
+				 */
 
-						(!search->test_filetype || ((search->stack[stack].filetype >= 0x000) && (search->stack[stack].filetype <= 0xfff) &&
-								((search->filetypes[search->stack[stack].filetype /
-										(8 * sizeof(bits))] & (1 << (search->stack[stack].filetype % (8 * sizeof(bits))))) != 0)) ||
-								((search->stack[stack].filetype == osfile_TYPE_UNTYPED) && search->include_untyped) ||
-								(search->stack[stack].filetype == osfile_TYPE_APPLICATION) || (search->stack[stack].filetype == osfile_TYPE_DIR)) &&
+				if (search->ignore_list != NULL &&
+						ignore_match_object(search->ignore_list, search->pathname,
+						search->stack[stack].path_length, file_data->name, search->stack[stack].filetype)) {
+					search->ignored_count++;
+					search->stack[stack].pinned = FALSE;
+					continue;
+				}
 
-						/* If we're testing attributes, do the bits cancel out? */
+				/* Test the object that we have found against the search plan,
+				 * using the details straight from OS_GBPB.
+				 */
 
-						(!search->test_attributes || (((file_data->attr ^ search->attributes) & search->attributes_mask) == 0x0u))
+				pattern = WILDCARD_NONE;
+				match = search_test_object(search, search->stack[stack].filetype, file_data, &pattern);
 
-						) {
-					*filename = '\0';
+				/* If the object didn't match and won't be entered, there's no need
+				 * to store it unless everything is being kept: this saves its name
+				 * from being added to the text dump.
+				 */
 
-					for (i = 0; i <= stack; i++) {
-						if (i > 0)
-							strcat(filename, ".");
-						strcat(filename, search->stack[i].filename);
-					}
+				if (!match && !search->store_all && !(file_data->obj_type == fileswitch_IS_DIR ||
+						(search->include_imagefs && file_data->obj_type == fileswitch_IS_IMAGE))) {
+					search->rejected_count++;
+					search->stack[stack].pinned = FALSE;
+					continue;
+				}
 
-					strcat(filename, ".");
-					strcat(filename, file_data->name);
+				object_key = objdb_add_file(search->objects, search->stack[stack].parent, file_data);
+				search->stack[stack].key = object_key;
+				search->stack[stack].file_active = TRUE;
 
-					/* Files (and image files if not being treated as folders) get passed to the contents
-					 * search if one is configured; otherwise the get added to the results window
-					 * immediately.
+				if (match) {
+					/* Files (and image files if not being treated as folders) get passed to the duplicate
+					 * file detection or the contents search if one is configured; otherwise the get added
+					 * to the results window immediately. Only files can be duplicates, so other objects
+					 * aren't reported if duplicates are being looked for.
 					 */
 
-					if (search->contents_engine != NULL && (file_data->obj_type == fileswitch_IS_FILE ||
+					if (search->duplicates != NULL) {
+						if ((file_data->obj_type == fileswitch_IS_FILE ||
+								(!search->include_imagefs && file_data->obj_type == fileswitch_IS_IMAGE)) &&
+								dupes_add_key(search->duplicates, search->stack[stack].key))
+							search->stack[stack].file_active = FALSE;
+					} else if (search->contents_engine != NULL && (file_data->obj_type == fileswitch_IS_FILE ||
 							(!search->include_imagefs && file_data->obj_type == fileswitch_IS_IMAGE))) {
 						if (contents_add_file(search->contents_engine, search->stack[stack].key))
 							search->stack[stack].contents_active = TRUE;
 					} else {
 						search->file_count++;
-						results_add_file(search->results, search->stack[stack].key);
+						object_key = results_add_file(search->results, search->stack[stack].key);
+						search_tag_result(search, search->stack[stack].key, object_key, pattern);
 						search->stack[stack].file_active = FALSE;
 					}
 				}
 			}
 
-			if (search->stack[stack].contents_active == TRUE && contents_poll(search->contents_engine, end_time, &contents_match)) {
-				search->stack[stack].contents_active = FALSE;
-				if (contents_match) {
-					search->file_count++;
-					search->stack[stack].file_active = FALSE;
+			if (search->stack[stack].contents_active == TRUE) {
+				contents_done = contents_poll(search->contents_engine, end_time, &contents_match);
+
+				quantum_check(&(search->quantum));
+
+				if (contents_done) {
+					search->stack[stack].contents_active = FALSE;
+					if (contents_match) {
+						search->file_count++;
+						search->stack[stack].file_active = FALSE;
+					}
 				}
 			}
 
 			if (search->stack[stack].contents_active == FALSE) {
-				/* If the object is a folder, recurse down into it. */
+				/* Find the record again, as it may have been left pinned while a
+				 * contents search ran over several polls.
+				 */
+
+				file_data = search_get_record(search, stack);
+
+				/* If the object is a folder, recurse down into it. The record can be
+				 * released once the new level has been set up.
+				 */
 
 				if (file_data->obj_type == fileswitch_IS_DIR || (search->include_imagefs && file_data->obj_type == fileswitch_IS_IMAGE)) {
-					/* Take a copy of the name before we shift the flex heap. */
+					/* The name is in a heap block, so it won't move with the flex heap. */
 
-					string_copy(leafname, file_data->name, SEARCH_MAX_FILENAME);
+					object_key = search_add_stack(search, file_data->name);
+					search->stack[stack].pinned = FALSE;
 
-					stack = search_add_stack(search);
+					if (object_key != SEARCH_NULL) {
+						stack = object_key;
+						search->stack[stack].parent = search->stack[stack - 1].key;
 
-					string_copy(search->stack[stack].filename, leafname, SEARCH_MAX_FILENAME);
-					search->stack[stack].parent = search->stack[stack - 1].key;
+						continue;
+					}
 
-					continue;
-				} else if (search->stack[stack].file_active && !search->store_all) {
-					objdb_delete_last_key(search->objects, search->stack[stack].key);
+					search->error_count++;
+					results_add_error(search->results, "Search stack full", search->stack[stack].key);
 					search->stack[stack].file_active = FALSE;
+				} else {
+					search->stack[stack].pinned = FALSE;
+
+					if (search->stack[stack].file_active && !search->store_all) {
+						objdb_delete_last_key(search->objects, search->stack[stack].key);
+						search->stack[stack].file_active = FALSE;
+					}
 				}
 			}
 		}
 
-		/***** Bracket down to here??? *****/
-
 		/* If that was all the files in the current folder, return to the
 		 * parent.
 		 */
@@ -980,105 +1885,393 @@ static osbool search_poll(struct search_block *search, os_t end_time)
 				search->stack[stack].file_active = FALSE;
 			}
 
-			continue;
-		}
-	}
+			continue;
+		}
+	}
+
+	/* If the stack is empty, the current path has been completed.  Either prepare
+	 * the next path for the next poll, or terminate the search if there are
+	 * no more paths to search.
+	 */
+
+	if (stack == SEARCH_NULL) {
+		if ((search->path_count > 0) && ((stack = search_add_stack(search, search->path[--search->path_count])) != SEARCH_NULL)) {
+			/* Re-allocate a search stack and set up the first search folder. */
+
+			object_key = objdb_add_root(search->objects, search->pathname);
+			search->stack[stack].parent = object_key;
+		} else if (search->duplicates == NULL) {
+			search_stop(search);
+		}
+	}
+
+	/* If the search continues, update the status bar. */
+
+	if (stack != SEARCH_NULL)
+		results_set_status_template(search->results, "Searching", search->pathname);
+
+	results_accept_lines(search->results);
+
+	return TRUE;
+}
+
+
+/**
+ * Claim a new line from the search stack, allocating more memory if required,
+ * set it up and return its offset. The name of the new level is appended to
+ * the current pathname.
+ *
+ * \param *handle		The handle of the search.
+ * \param *name			The name of the directory for the new level; for
+ *				the first level, this will be the full path.
+ * \return			The offset of the new entry, or SEARCH_NULL.
+ */
+
+static unsigned search_add_stack(struct search_block *search, char *name)
+{
+	unsigned	offset;
+	size_t		length, required;
+	char		*pathname;
+
+	if (search == NULL || name == NULL)
+		return SEARCH_NULL;
+
+	/* Make sure that there is enough space in the block to take the new
+	 * level, allocating more if required.
+	 */
+
+	if (search->stack_level >= search->stack_size) {
+		if (flex_extend((flex_ptr) &(search->stack), (search->stack_size + SEARCH_ALLOC_STACK) * sizeof(struct search_stack)) == 0)
+			return SEARCH_NULL;
+
+		for (offset = search->stack_size; offset < search->stack_size + SEARCH_ALLOC_STACK; offset++) {
+			search->stack[offset].info = NULL;
+			search->stack[offset].info_size = 0;
+		}
+
+		search->stack_size += SEARCH_ALLOC_STACK;
+	}
+
+	/* Make sure that the level has a block for OS_GBPB. Blocks stay with
+	 * their levels when they are dropped, so they can be used again.
+	 */
+
+	if (!search_claim_buffer(search, search->stack_level))
+		return SEARCH_NULL;
+
+	/* Make sure that there is enough space in the pathname buffer to take
+	 * the new level's name, a separator and a terminator.
+	 */
+
+	length = (search->stack_level > 0) ? search->stack[search->stack_level - 1].path_length : 0;
+	required = length + strlen(name) + 2;
+
+	if (required > search->pathname_size) {
+		size_t size = search->pathname_size;
+
+		while (required > size)
+			size *= 2;
+
+		pathname = heap_extend(search->pathname, size);
+		if (pathname == NULL)
+			return SEARCH_NULL;
+
+		search->pathname = pathname;
+		search->pathname_size = size;
+	}
+
+	/* Get the new level and initialise it. */
+
+	offset = search->stack_level++;
+
+	if (offset > 0)
+		search->pathname[length++] = '.';
+
+	strcpy(search->pathname + length, name);
+
+	search->stack[offset].path_length = length + strlen(name);
+	search->stack[offset].read = 0;
+	search->stack[offset].context = 0;
+	search->stack[offset].block_context = 0;
+	search->stack[offset].next = 0;
+	search->stack[offset].data_offset = 0;
+	search->stack[offset].record_offset = 0;
+	search->stack[offset].pinned = FALSE;
+	search->stack[offset].file_active = FALSE;
+	search->stack[offset].contents_active = FALSE;
+
+	return offset;
+}
+
+
+/**
+ * Drop back down a line on the search stack and return the new offset,
+ * trimming the current pathname back to match.
+ *
+ * \param *handle		The handle of the search.
+ * \return			The offset of the new entry, or SEARCH_NULL.
+ */
+
+static unsigned search_drop_stack(struct search_block *search)
+{
+	if (search == NULL)
+		return SEARCH_NULL;
+
+	if (search->stack_level > 0)
+		search->stack_level--;
+
+	search->pathname[(search->stack_level > 0) ? search->stack[search->stack_level - 1].path_length : 0] = '\0';
+
+	return (search->stack_level == 0) ? SEARCH_NULL : search->stack_level - 1;
+}
+
+
+/**
+ * Free the search stack, along with the OS_GBPB blocks held by its levels.
+ *
+ * \param *search		The search to free the stack for.
+ */
+
+static void search_free_stack(struct search_block *search)
+{
+	unsigned	level;
+
+	if (search == NULL || search->stack == NULL)
+		return;
+
+	for (level = 0; level < search->stack_size; level++) {
+		if (search->stack[level].info != NULL)
+			heap_free(search->stack[level].info);
+	}
+
+	search->stack_size = 0;
+	search->stack_level = 0;
+
+	flex_free((flex_ptr) &(search->stack));
+	search->stack = NULL;
+}
+
+
+/**
+ * Make sure that a level on the search stack has an OS_GBPB block of the
+ * size currently in use by the search. If a bigger block can't be claimed,
+ * the level keeps any block that it already has.
+ *
+ * \param *search		The search to which the stack belongs.
+ * \param stack			The stack level to claim a block for.
+ * \return			TRUE if the level has a block; FALSE on failure.
+ */
+
+static osbool search_claim_buffer(struct search_block *search, unsigned stack)
+{
+	byte		*info;
+
+	if (search->stack[stack].info != NULL && (search->stack[stack].info_size >= search->buffer_size || search->stack[stack].pinned))
+		return TRUE;
+
+	/* The heap won't shift the flex heap, so the stack pointer stays valid. */
+
+	if (search->stack[stack].info == NULL)
+		info = heap_alloc(search->buffer_size);
+	else
+		info = heap_extend(search->stack[stack].info, search->buffer_size);
+
+	if (info == NULL)
+		return (search->stack[stack].info != NULL) ? TRUE : FALSE;
+
+	search->stack[stack].info = info;
+	search->stack[stack].info_size = search->buffer_size;
+
+	return TRUE;
+}
+
+
+/**
+ * Fill the block at a level of the search stack with the next set of
+ * entries from its directory, taking them from the filename index if the
+ * directory is covered by one.
+ *
+ * \param *search		The search to which the stack belongs.
+ * \param stack			The stack level to fill.
+ * \return			Pointer to an error block, or NULL.
+ */
+
+static os_error *search_read_block(struct search_block *search, unsigned stack)
+{
+	search_claim_buffer(search, stack);
+
+	search->stack[stack].block_context = search->stack[stack].context;
+
+	if (search->index != NULL && index_covers(search->index, search->pathname))
+		return index_read_dir(search->index, search->pathname, (osgbpb_info_list *) search->stack[stack].info,
+				search->read_count, search->stack[stack].context, search->stack[stack].info_size,
+				&(search->stack[stack].read), &(search->stack[stack].context));
+
+	return fsys_read_dir(search->pathname, (osgbpb_info_list *) search->stack[stack].info, search->read_count,
+			search->stack[stack].context, search->stack[stack].info_size,
+			&(search->stack[stack].read), &(search->stack[stack].context));
+}
+
+
+/**
+ * Refill the block at a level of the search stack from a saved position, by
+ * reading the directory again from the saved context and stepping on to the
+ * saved entry. If the directory can't be read, the level is left to read it
+ * again on the next poll, so that the error is reported in the usual way.
+ *
+ * \param *search		The search to which the stack belongs.
+ * \param stack			The stack level to refill.
+ * \param block_context		The context from which the saved block was read.
+ * \param next			The number of the next entry to process in the
+ *				saved block.
+ * \return			TRUE if the position was found; FALSE if the
+ *				directory could not be read, or no longer
+ *				holds the saved entry.
+ */
+
+static osbool search_restore_level(struct search_block *search, unsigned stack, int block_context, int next)
+{
+	osgbpb_info	*file_data;
+	int		i;
+	osbool		found;
+
+	search->stack[stack].context = block_context;
 
-	/* If the stack is empty, the current path has been completed.  Either prepare
-	 * the next path for the next poll, or terminate the search if there are
-	 * no more paths to search.
+	/* Read blocks until the one holding the saved entry is reached. If the
+	 * directory has shrunk since the search was saved, stop at its end.
 	 */
 
-	if (stack == SEARCH_NULL) {
-		if ((search->path_count > 0) && ((stack = search_add_stack(search)) != SEARCH_NULL)) {
-			/* Re-allocate a search stack and set up the first search folder. */
+	while (TRUE) {
+		if (search_read_block(search, stack) != NULL) {
+			search->stack[stack].context = block_context;
+			search->stack[stack].read = 0;
+			search->stack[stack].next = 0;
+			return FALSE;
+		}
 
-			string_copy(search->stack[stack].filename, search->path[--search->path_count], SEARCH_MAX_FILENAME);
+		if (next <= search->stack[stack].read || search->stack[stack].context == -1)
+			break;
 
-			object_key = objdb_add_root(search->objects, search->stack[stack].filename);
-			search->stack[stack].parent = object_key;
-		} else {
-			search_stop(search);
-		}
+		next -= search->stack[stack].read;
 	}
 
-	/* If the search continues, update the status bar. */
+	found = TRUE;
 
-	if (stack != SEARCH_NULL) {
-		*filename = '\0';
+	if (next > search->stack[stack].read) {
+		next = search->stack[stack].read;
+		found = FALSE;
+	}
 
-		for (i = 0; i <= stack; i++) {
-			if (i > 0)
-				strcat(filename, ".");
-			strcat(filename, search->stack[i].filename);
-		}
+	/* Step through the entries up to the saved one. */
 
-		results_set_status_template(search->results, "Searching", filename);
+	search->stack[stack].data_offset = 0;
+	search->stack[stack].record_offset = 0;
+
+	for (i = 0; i < next; i++) {
+		search->stack[stack].record_offset = search->stack[stack].data_offset;
+		file_data = search_get_record(search, stack);
+		search->stack[stack].data_offset += (offsetof(osgbpb_info, name) + strlen(file_data->name) + 4) & 0xfffffffc;
 	}
 
-	results_accept_lines(search->results);
+	search->stack[stack].next = next;
 
-	return TRUE;
+	return found;
 }
 
 
 /**
- * Claim a new line from the search stack, allocating more memory if required,
- * set it up and return its offset.
+ * Return a pointer to the record currently being processed at a given
+ * level of the search stack. The pointer remains valid until the level's
+ * block is next refilled, which can't happen while the record is pinned.
  *
- * \param *handle		The handle of the search.
- * \return			The offset of the new entry, or SEARCH_NULL.
+ * \param *search		The search to which the stack belongs.
+ * \param stack			The stack level holding the record.
+ * \return			Pointer to the record.
  */
 
-static unsigned search_add_stack(struct search_block *search)
+static osgbpb_info *search_get_record(struct search_block *search, unsigned stack)
 {
-	unsigned offset;
+	return (osgbpb_info *) (search->stack[stack].info + search->stack[stack].record_offset);
+}
 
-	if (search == NULL)
-		return SEARCH_NULL;
 
-	/* Make sure that there is enough space in the block to take the new
-	 * level, allocating more if required.
-	 */
+/**
+ * Split a search's list of paths into separate paths, linking them into the
+ * path index in reverse order so that the path count can be decremented
+ * during the search.
+ *
+ * \param *search		The search holding the list of paths.
+ * \param paths			The number of paths in the list.
+ */
 
-	if (search->stack_level >= search->stack_size) {
-		if (flex_extend((flex_ptr) &(search->stack), (search->stack_size + SEARCH_ALLOC_STACK) * sizeof(struct search_stack)) == 0)
-			return SEARCH_NULL;
+static void search_split_paths(struct search_block *search, int paths)
+{
+	int	i;
 
-		search->stack_size += SEARCH_ALLOC_STACK;
+	search->path_count = paths;
+
+	if (paths == 0)
+		return;
+
+	search->path[--paths] = search->paths;
+
+	for (i = 0; search->paths[i] != '\0'; i++) {
+		if (search->paths[i] == ',' && paths > 0) {
+			search->path[--paths] = search->paths + i + 1;
+			search->paths[i] = '\0';
+		}
 	}
+}
 
-	/* Get the new level and initialise it. */
 
-	offset = search->stack_level++;
+/**
+ * Test a leafname against the filename pattern(s) for a search.
+ *
+ * \param *search		The search to test against.
+ * \param *name			The leafname to test.
+ * \param *pattern		Pointer to a variable to take the index of the
+ *				pattern which matched, or WILDCARD_NONE.
+ * \return			TRUE if the name matched; else FALSE.
+ */
 
-	search->stack[offset].read = 0;
-	search->stack[offset].context = 0;
-	search->stack[offset].next = 0;
-	search->stack[offset].data_offset = 0;
-	search->stack[offset].file_active = FALSE;
-	search->stack[offset].contents_active = FALSE;
+static osbool search_match_filename(struct search_block *search, char *name, unsigned *pattern)
+{
+	*pattern = WILDCARD_NONE;
 
-	return offset;
+	if (search->filename_regex != NULL)
+		return regex_match(search->filename_regex, name);
+
+	if (search->filename_matcher == NULL)
+		return string_wildcard_compare(search->filename, name, search->filename_any_case);
+
+	*pattern = wildcard_match(search->filename_matcher, name);
+
+	return (*pattern != WILDCARD_NONE) ? TRUE : FALSE;
 }
 
 
 /**
- * Drop back down a line on the search stack and return the new offset.
+ * If a search has more than one filename pattern, add a line to the results
+ * showing which of them a result matched.
  *
- * \param *handle		The handle of the search.
- * \return			The offset of the new entry, or SEARCH_NULL.
+ * \param *search		The search to which the result belongs.
+ * \param key			The object database key of the result.
+ * \param line			The results window line of the result.
+ * \param pattern		The index of the matching pattern, or WILDCARD_NONE.
  */
 
-static unsigned search_drop_stack(struct search_block *search)
+static void search_tag_result(struct search_block *search, unsigned key, unsigned line, unsigned pattern)
 {
-	if (search == NULL)
-		return SEARCH_NULL;
+	char	name[SEARCH_TAG_LENGTH], text[SEARCH_TAG_LENGTH];
 
-	if (search->stack_level > 0)
-		search->stack_level--;
+	if (pattern == WILDCARD_NONE || line == RESULTS_NULL || wildcard_get_count(search->filename_matcher) < 2)
+		return;
 
-	return (search->stack_level == 0) ? SEARCH_NULL : search->stack_level - 1;
+	if (wildcard_get_pattern(search->filename_matcher, pattern, name, sizeof(name)) == NULL)
+		return;
+
+	msgs_param_lookup("Matched", text, sizeof(text), name, NULL, NULL, NULL);
+	results_add_contents(search->results, key, line, text);
 }
 
 
@@ -1116,7 +2309,7 @@ osbool search_validate_paths(char *paths, osbool report)
 			*path_end = '\0';
 
 		if (*path != '\0') {
-			error = xosfile_read_no_path(path, &type, NULL, NULL, NULL, NULL);
+			error = fsys_read_object(path, &type, NULL, NULL, NULL, NULL);
 			if (error != NULL) {
 				if (report)
 					error_report_error(error->errmess);
@@ -1144,3 +2337,417 @@ osbool search_validate_paths(char *paths, osbool report)
 	return success;
 }
 
+
+
+/**
+ * Set the title of a search's results window, flagging up the tests which
+ * are in use.
+ *
+ * \param *search		The search to set the title for.
+ */
+
+static void search_update_title(struct search_block *search)
+{
+	char		title[256], flag[10], flags[10];
+
+	*flags = '\0';
+
+	if (search->test_size == TRUE) {
+		msgs_lookup("SizeFlag", flag, sizeof(flag));
+		strncat(flags, flag, sizeof(flags) - strlen(flags) - 1);
+	}
+
+	if (search->test_date == TRUE) {
+		if (search->date_as_age)
+			msgs_lookup("AgeFlag", flag, sizeof(flag));
+		else
+			msgs_lookup("DateFlag", flag, sizeof(flag));
+		strncat(flags, flag, sizeof(flags) - strlen(flags) - 1);
+	}
+
+	if (search->include_files == FALSE || search->include_directories == FALSE || search->include_applications == FALSE ||
+			search->test_filetype == TRUE) {
+		msgs_lookup("TypeFlag", flag, sizeof(flag));
+		strncat(flags, flag, sizeof(flags) - strlen(flags) - 1);
+	}
+
+	if (search->test_attributes == TRUE) {
+		msgs_lookup("AttrFlag", flag, sizeof(flag));
+		strncat(flags, flag, sizeof(flags) - strlen(flags) - 1);
+	}
+
+	if (search->test_contents == TRUE && search->duplicates == NULL) {
+		msgs_lookup("ContFlag", flag, sizeof(flag));
+		strncat(flags, flag, sizeof(flags) - strlen(flags) - 1);
+	}
+
+	if (search->duplicates != NULL) {
+		msgs_lookup("DupFlag", flag, sizeof(flag));
+		strncat(flags, flag, sizeof(flags) - strlen(flags) - 1);
+	}
+
+	msgs_param_lookup("ResWindTitle", title, sizeof(title), (search->filename != NULL) ? search->filename: "", flags, NULL, NULL);
+
+	results_set_title(search->results, title);
+}
+
+
+/**
+ * Canonicalise the paths to be searched, so that they can be compared with
+ * the canonical pathnames held in the ignore list, and remove any which are
+ * the same as, or contained within, another path in the list, so that no
+ * part of the tree is searched twice. The remaining paths keep the order in which they
+ * were given. If memory runs out, the paths are left as they were.
+ *
+ * \param *search		The search to process the paths for.
+ */
+
+static void search_prune_paths(struct search_block *search)
+{
+	struct search_root	*roots;
+	char			*paths, *root;
+	os_error		*error;
+	int			i, size, total, count;
+	osbool			barrier, checked;
+	fileswitch_object_type	type;
+
+	if (search == NULL || search->path_count == 0)
+		return;
+
+	roots = heap_alloc(search->path_count * sizeof(struct search_root));
+	if (roots == NULL)
+		return;
+
+	/* Find the space needed for the canonical pathnames. If a path can't
+	 * be canonicalised, it is used as it was given.
+	 */
+
+	total = 0;
+
+	for (i = 0; i < search->path_count; i++) {
+		error = xosfscontrol_canonicalise_path(search->path[i], NULL, NULL, NULL, 0, &size);
+		total += (error == NULL) ? 1 - size : strlen(search->path[i]) + 1;
+	}
+
+	paths = heap_alloc(total);
+	if (paths == NULL) {
+		heap_free(roots);
+		return;
+	}
+
+	for (i = 0, root = paths; i < search->path_count; i++) {
+		error = xosfscontrol_canonicalise_path(search->path[i], NULL, NULL, NULL, 0, &size);
+		size = (error == NULL) ? 1 - size : strlen(search->path[i]) + 1;
+
+		if (error == NULL)
+			error = xosfscontrol_canonicalise_path(search->path[i], root, NULL, NULL, size, NULL);
+
+		if (error != NULL)
+			string_copy(root, search->path[i], size);
+
+		roots[i].path = root;
+		roots[i].order = i;
+		roots[i].pruned = FALSE;
+
+		root += strlen(root) + 1;
+	}
+
+	/* Sort the paths so that each one is followed directly by any which
+	 * lie within it, then prune those. A path can't swallow the ones in
+	 * it if it's an image and images aren't being searched.
+	 */
+
+	qsort(roots, search->path_count, sizeof(struct search_root), search_compare_roots);
+
+	root = NULL;
+	barrier = FALSE;
+	checked = FALSE;
+
+	for (i = 0; i < search->path_count; i++) {
+		if (*(roots[i].path) == '\0')
+			continue;
+
+		if (root != NULL && search_path_is_within(roots[i].path, root)) {
+			if (!checked && !search->include_imagefs && strlen(roots[i].path) != strlen(root)) {
+				barrier = (fsys_read_object(root, &type, NULL, NULL, NULL, NULL) == NULL && type == fileswitch_IS_IMAGE) ? TRUE : FALSE;
+				checked = TRUE;
+			}
+
+			if (!barrier || strlen(roots[i].path) == strlen(root)) {
+				roots[i].pruned = TRUE;
+				search->pruned_count++;
+				continue;
+			}
+		}
+
+		root = roots[i].path;
+		barrier = FALSE;
+		checked = FALSE;
+	}
+
+	/* Rebuild the path index from the survivors, in their original order. */
+
+	qsort(roots, search->path_count, sizeof(struct search_root), search_compare_root_order);
+
+	for (i = 0, count = 0; i < search->path_count; i++) {
+		if (!roots[i].pruned)
+			search->path[count++] = roots[i].path;
+	}
+
+	search->path_count = count;
+
+	heap_free(search->paths);
+	search->paths = paths;
+
+	heap_free(roots);
+}
+
+
+/**
+ * Test whether a canonical pathname is the same as, or lies within, another.
+ *
+ * \param *path			The pathname to test.
+ * \param *root			The pathname that it might lie within.
+ * \return			TRUE if the path lies within the root; else FALSE.
+ */
+
+static osbool search_path_is_within(char *path, char *root)
+{
+	while (*root != '\0') {
+		if (toupper(*path) != toupper(*root))
+			return FALSE;
+
+		path++;
+		root++;
+	}
+
+	return (*path == '\0' || *path == '.') ? TRUE : FALSE;
+}
+
+
+/**
+ * Compare two search roots by pathname, without regard to case, for qsort().
+ * Directory separators sort before any other character, so that the
+ * contents of a directory follow it directly. Identical paths are ordered
+ * by the position in which they were given.
+ *
+ * \param *a			The first root to compare.
+ * \param *b			The second root to compare.
+ * \return			The result of the comparison.
+ */
+
+static int search_compare_roots(const void *a, const void *b)
+{
+	const struct search_root	*x = a, *y = b;
+	char				*p = x->path, *q = y->path;
+	int				c, d;
+
+	while (*p != '\0' || *q != '\0') {
+		c = (*p == '.') ? 1 : toupper(*p);
+		d = (*q == '.') ? 1 : toupper(*q);
+
+		if (c != d)
+			return c - d;
+
+		p++;
+		q++;
+	}
+
+	return (x->order > y->order) ? -1 : (x->order < y->order) ? 1 : 0;
+}
+
+
+/**
+ * Compare two search roots by their position in the path index, for qsort().
+ *
+ * \param *a			The first root to compare.
+ * \param *b			The second root to compare.
+ * \return			The result of the comparison.
+ */
+
+static int search_compare_root_order(const void *a, const void *b)
+{
+	const struct search_root	*x = a, *y = b;
+
+	return (x->order > y->order) ? 1 : (x->order < y->order) ? -1 : 0;
+}
+
+
+/**
+ * Compile the tests set for a search into a plan, starting with the
+ * cheapest tests. Tests which can never reject an object are left out.
+ *
+ * \param *search		The search to compile the plan for.
+ */
+
+static void search_compile_plan(struct search_block *search)
+{
+	search->plan_length = 0;
+	search->plan_objects = 0;
+
+	if (search->include_files == FALSE || search->include_directories == FALSE || search->include_applications == FALSE ||
+			search->test_filetype == TRUE)
+		search_add_plan_step(search, SEARCH_TEST_TYPE, 1);
+
+	if (search->test_attributes && search->attributes_mask != 0x0u)
+		search_add_plan_step(search, SEARCH_TEST_ATTRIBUTES, 1);
+
+	if (search->test_size)
+		search_add_plan_step(search, SEARCH_TEST_SIZE, 1);
+
+	if (search->test_date)
+		search_add_plan_step(search, SEARCH_TEST_DATE, 2);
+
+	if (search->test_filename)
+		search_add_plan_step(search, SEARCH_TEST_FILENAME, (search->filename_regex != NULL) ? 12 : 8);
+}
+
+
+/**
+ * Add a test to the end of a search plan.
+ *
+ * \param *search		The search to add the test to.
+ * \param test			The test to add.
+ * \param cost			The relative cost of the test.
+ */
+
+static void search_add_plan_step(struct search_block *search, enum search_test test, unsigned cost)
+{
+	struct search_plan_step	*step;
+
+	if (search->plan_length >= SEARCH_TEST_MAX)
+		return;
+
+	step = search->plan + search->plan_length++;
+
+	step->test = test;
+	step->cost = cost;
+	step->tested = 0;
+	step->rejected = 0;
+	step->total_tested = 0;
+	step->total_rejected = 0;
+}
+
+
+/**
+ * Re-order the steps in a search plan, so that those which reject the most
+ * objects for the least cost come first. The recent counts are then halved,
+ * so that the ordering can follow changes as the search moves between
+ * directories.
+ *
+ * \param *search		The search to re-order the plan for.
+ */
+
+static void search_order_plan(struct search_block *search)
+{
+	struct search_plan_step	step;
+	unsigned		i, j, rank[SEARCH_TEST_MAX], this_rank;
+
+	/* Rank each step by its cost per rejection; the counts start at one,
+	 * so that tests which never reject anything don't divide by zero.
+	 */
+
+	for (i = 0; i < search->plan_length; i++)
+		rank[i] = (search->plan[i].cost * (search->plan[i].tested + 1) * 16) / (search->plan[i].rejected + 1);
+
+	for (i = 1; i < search->plan_length; i++) {
+		step = search->plan[i];
+		this_rank = rank[i];
+
+		for (j = i; j > 0 && rank[j - 1] > this_rank; j--) {
+			search->plan[j] = search->plan[j - 1];
+			rank[j] = rank[j - 1];
+		}
+
+		search->plan[j] = step;
+		rank[j] = this_rank;
+	}
+
+	for (i = 0; i < search->plan_length; i++) {
+		search->plan[i].tested /= 2;
+		search->plan[i].rejected /= 2;
+	}
+
+	search->plan_objects = 0;
+}
+
+
+/**
+ * Test an object against a search's plan, stopping at the first test which
+ * rejects it.
+ *
+ * \param *search		The search to test against.
+ * \param filetype		The filetype of the object.
+ * \param *file_data		The OS_GBPB details of the object.
+ * \param *pattern		Pointer to a variable to take the index of the
+ *				filename pattern which matched, if any.
+ * \return			TRUE if the object passes all of the tests; else FALSE.
+ */
+
+static osbool search_test_object(struct search_block *search, unsigned filetype, osgbpb_info *file_data, unsigned *pattern)
+{
+	struct search_plan_step	*step;
+	unsigned long long	date;
+	unsigned		i;
+	osbool			match = TRUE;
+
+	for (i = 0; match && i < search->plan_length; i++) {
+		step = search->plan + i;
+
+		switch (step->test) {
+		case SEARCH_TEST_TYPE:
+			/* Check that the object type is wanted and, if the type falls
+			 * between 0x000 and 0xfff, that it is set in the bitmask.
+			 */
+
+			if (filetype == osfile_TYPE_DIR)
+				match = search->include_directories;
+			else if (filetype == osfile_TYPE_APPLICATION)
+				match = search->include_applications;
+			else if (!search->include_files)
+				match = FALSE;
+			else if (!search->test_filetype)
+				match = TRUE;
+			else if (filetype == osfile_TYPE_UNTYPED)
+				match = search->include_untyped;
+			else
+				match = ((search->filetypes[filetype / (8 * sizeof(bits))] & (1u << (filetype % (8 * sizeof(bits))))) != 0) ? TRUE : FALSE;
+			break;
+
+		case SEARCH_TEST_ATTRIBUTES:
+			match = (((file_data->attr ^ search->attributes) & search->attributes_mask) == 0x0u) ? TRUE : FALSE;
+			break;
+
+		case SEARCH_TEST_SIZE:
+			match = (filetype == osfile_TYPE_DIR || filetype == osfile_TYPE_APPLICATION ||
+					(((file_data->size >= search->minimum_size) && (file_data->size <= search->maximum_size)) == search->size_logic)) ? TRUE : FALSE;
+			break;
+
+		case SEARCH_TEST_DATE:
+			date = ((unsigned long long) (file_data->load_addr & 0xffu) << 32) | file_data->exec_addr;
+			match = (filetype == osfile_TYPE_UNTYPED ||
+					(((date >= search->minimum_date) && (date <= search->maximum_date)) == search->date_logic)) ? TRUE : FALSE;
+			break;
+
+		case SEARCH_TEST_FILENAME:
+			match = (search_match_filename(search, file_data->name, pattern) == search->filename_logic) ? TRUE : FALSE;
+			break;
+
+		case SEARCH_TEST_MAX:
+			break;
+		}
+
+		step->tested++;
+		step->total_tested++;
+
+		if (!match) {
+			step->rejected++;
+			step->total_rejected++;
+		}
+	}
+
+	if (++search->plan_objects >= SEARCH_PLAN_INTERVAL)
+		search_order_plan(search);
+
+	return match;
+}
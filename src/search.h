@@ -32,6 +32,8 @@
 
 #include "oslib/fileswitch.h"
 
+#include "discfile.h"
+#include "index.h"
 #include "objdb.h"
 #include "results.h"
 
@@ -77,11 +79,23 @@ void search_set_options(struct search_block *search, osbool search_imagefs, osbo
 		osbool include_files, osbool include_directories, osbool include_applications);
 
 
+/**
+ * Set the ignore list for a search.
+ *
+ * \param *search		The search to set the ignore list for.
+ * \param *list			Pointer to a comma-separated list of leafnames,
+ *				pathnames and &filetypes to be ignored.
+ */
+
+void search_set_ignore(struct search_block *search, char *list);
+
+
 /**
  * Set the filename matching options for a search.
  *
  * \param *search		The search to set the options for.
- * \param *filename		Pointer to the filename to match.
+ * \param *filename		Pointer to the filename to match, or a
+ *				comma-separated list of filenames.
  * \param any_case		TRUE to match case insensitively; else FALSE.
  * \param invert		TRUE to match files whose names don't match; else FALSE.
  */
@@ -89,6 +103,19 @@ void search_set_options(struct search_block *search, osbool search_imagefs, osbo
 void search_set_filename(struct search_block *search, char *filename, osbool any_case, osbool invert);
 
 
+/**
+ * Set a regular expression for filename matching in a search.
+ *
+ * \param *search		The search to set the options for.
+ * \param *expression		Pointer to the regular expression to match.
+ * \param any_case		TRUE to match case insensitively; else FALSE.
+ * \param invert		TRUE to match files whose names don't match; else FALSE.
+ * \return			TRUE if the expression was compiled; else FALSE.
+ */
+
+osbool search_set_filename_regex(struct search_block *search, char *expression, osbool any_case, osbool invert);
+
+
 /**
  * Set the filesize matching options for a search.
  *
@@ -148,6 +175,34 @@ void search_set_attributes(struct search_block *search, fileswitch_attr mask, fi
 void search_set_contents(struct search_block *search, char *contents, osbool any_case, osbool invert);
 
 
+/**
+ * Set a search to look for duplicate files. The files which match the other
+ * tests are compared once the search paths have been scanned, and only those
+ * which share their size and the 64-bit hash of their contents with another
+ * are reported, grouped into sets. The contents are not compared byte for
+ * byte, so a set could in principle hold files which differ. Any contents
+ * test is ignored.
+ *
+ * \param *search		The search to set the options for.
+ * \param duplicates		TRUE to report duplicate files; FALSE to report
+ *				all matching files.
+ */
+
+void search_set_duplicates(struct search_block *search, osbool duplicates);
+
+
+/**
+ * Set a filename index for a search to read its directory listings from.
+ * Paths outside the root of the index are still read from disc. The index
+ * must not be rebuilt or refreshed while the search is using it.
+ *
+ * \param *search		The search to set the index for.
+ * \param *index		The index to use, or NULL to read from disc.
+ */
+
+void search_set_index(struct search_block *search, struct index_block *index);
+
+
 /**
  * Make a search active so that it will run on subsequent calls to search_poll().
  *
@@ -166,6 +221,26 @@ void search_start(struct search_block *search);
 void search_stop(struct search_block *search);
 
 
+/**
+ * Pause an active search, so that it keeps its place but isn't polled until
+ * it is resumed.
+ *
+ * \param *search		The handle of the search to pause.
+ */
+
+void search_pause(struct search_block *search);
+
+
+/**
+ * Resume a paused search, so that it runs again on subsequent calls to
+ * search_poll().
+ *
+ * \param *search		The handle of the search to resume.
+ */
+
+void search_resume(struct search_block *search);
+
+
 /**
  * Test to see if a poll is required.
  *
@@ -186,10 +261,126 @@ osbool search_is_active(struct search_block *search);
 
 
 /**
- * Run any active searches in a Null poll.
+ * Test to see if a given search is active but paused.
+ *
+ * \param *search		The search to test.
+ * \return			TRUE if paused; else FALSE.
+ */
+
+osbool search_is_paused(struct search_block *search);
+
+
+/**
+ * Run any active searches in a Null poll, sharing a timeslot between them.
+ *
+ * \param timeslot		The time, in cs, to share between the searches.
+ */
+
+void search_poll_all(os_t timeslot);
+
+
+/**
+ * Scheduling priorities for searches.
+ */
+
+#define SEARCH_PRIORITY_NORMAL 2						/**< The default scheduling priority for a search.			*/
+#define SEARCH_PRIORITY_FOREGROUND 4						/**< The priority of the search whose results are at the front.		*/
+
+
+/**
+ * Set the scheduling priority of a search, which weights the share of each
+ * multitasking timeslot that it is given.
+ *
+ * \param *search		The search to update.
+ * \param priority		The new priority, from 1 upwards.
+ */
+
+void search_set_priority(struct search_block *search, unsigned priority);
+
+
+/**
+ * Run a search to completion without returning control, for use by front
+ * ends which don't need to multitask.
+ *
+ * \param *search		The search to run.
+ */
+
+void search_run(struct search_block *search);
+
+
+/**
+ * Return the counts of objects examined, matched and in error for a search.
+ *
+ * \param *search		The search to report on.
+ * \param *objects		Pointer to a variable to take the number of
+ *				objects examined, or NULL.
+ * \param *matches		Pointer to a variable to take the number of
+ *				matches found, or NULL.
+ * \param *errors		Pointer to a variable to take the number of
+ *				errors encountered, or NULL.
+ */
+
+void search_get_counts(struct search_block *search, unsigned *objects, unsigned *matches, unsigned *errors);
+
+
+/**
+ * Return the duty cycle achieved by a search: the proportion of the time
+ * since it started (or of its run, if it has stopped) that was spent polling
+ * it.
+ *
+ * \param *search		The search to report on.
+ * \return			The duty cycle, as a percentage.
+ */
+
+unsigned search_get_duty_cycle(struct search_block *search);
+
+
+/**
+ * Return the number of paths which were dropped from a search when it
+ * started, because they were the same as or lay within other paths.
+ *
+ * \param *search		The search to report on.
+ * \return			The number of paths dropped.
+ */
+
+unsigned search_get_pruned_paths(struct search_block *search);
+
+
+/**
+ * Save the state of an active search to a file, so that it can be resumed
+ * from the same place later. The search's object database and results must
+ * be saved into the same file.
+ *
+ * \param *search		The search to save.
+ * \param *out			The file to save to.
+ * \return			TRUE if a search was saved; else FALSE.
+ */
+
+osbool search_save_file(struct search_block *search, struct discfile_block *out);
+
+
+/**
+ * Test a file to see if it contains the state of a search.
+ *
+ * \param *load			The file to test.
+ * \return			TRUE if there is a search state; else FALSE.
+ */
+
+osbool search_check_file(struct discfile_block *load);
+
+
+/**
+ * Restore the state of a search from a file, into a search which has been
+ * created from the same object database and results and given the same
+ * options, but not started. The search is left active but paused, ready
+ * to be resumed with search_resume().
+ *
+ * \param *search		The search to restore into.
+ * \param *load			The file to load from.
+ * \return			TRUE if successful; else FALSE.
  */
 
-void search_poll_all(void);
+osbool search_load_file(struct search_block *search, struct discfile_block *load);
 
 
 /**
@@ -51,9 +51,13 @@
 #include "textdump.h"
 
 #include "discfile.h"
+#include "flexutils.h"
 
 
-#define TEXTDUMP_ALLOCATION 1024						/**< The default allocation block size.					*/
+#define TEXTDUMP_ALLOCATION 1024						/**< The default minimum allocation step.				*/
+#define TEXTDUMP_LOAD_FACTOR 4							/**< The average chain length at which the hash table is grown.		*/
+#define TEXTDUMP_FNV_OFFSET 2166136261u						/**< The FNV-1a 32-bit offset basis.					*/
+#define TEXTDUMP_FNV_PRIME 16777619u						/**< The FNV-1a 32-bit prime.						*/
 
 struct textdump_block {
 	byte			*text;						/**< The general text string dump.					*/
@@ -62,6 +66,7 @@ struct textdump_block {
 	unsigned		size;						/**< The current claimed size of the text dump.				*/
 	unsigned		allocation;					/**< The allocation block size of the text dump.			*/
 	unsigned		hashes;						/**< The size of the hash table, or 0 if none.				*/
+	unsigned		entries;					/**< The number of strings held in the hash table.			*/
 	char			terminator;					/**< The terminating character for strings added to the text dump.	*/
 };
 
@@ -72,6 +77,9 @@ struct textdump_header {
 
 
 static int	textdump_make_hash(struct textdump_block *handle, char *text);
+static osbool	textdump_grow_hash(struct textdump_block *handle);
+static osbool	textdump_reserve(struct textdump_block *handle, unsigned required);
+static osbool	textdump_expand_hashed(struct textdump_block *handle, unsigned size);
 
 /**
  * Initialise a text storage block.
@@ -105,6 +113,7 @@ struct textdump_block *textdump_create(unsigned allocation, unsigned hash, char
 
 	new->hashes = hash;
 	new->hash = NULL;
+	new->entries = 0;
 
 	new->terminator = terminator;
 
@@ -170,6 +179,7 @@ void textdump_clear(struct textdump_block *handle)
 		return;
 
 	handle->free = 0;
+	handle->entries = 0;
 
 	if (handle->hash != NULL)
 		for (i = 0; i < handle->hashes; i++)
@@ -178,7 +188,7 @@ void textdump_clear(struct textdump_block *handle)
 	if (handle->text == NULL)
 		return;
 
-	if (flex_extend((flex_ptr) &(handle->text), handle->allocation * sizeof(byte)) == 1)
+	if (flexutils_resize((flex_ptr) &(handle->text), handle->allocation * sizeof(byte)))
 		handle->size = handle->allocation;
 }
 
@@ -228,7 +238,7 @@ size_t textdump_get_size(struct textdump_block *handle)
 
 unsigned textdump_store(struct textdump_block *handle, char *text)
 {
-	int		length, blocks;
+	int		length;
 	unsigned	offset;
 	int		hash = -1;
 
@@ -248,25 +258,27 @@ unsigned textdump_store(struct textdump_block *handle, char *text)
 			return offset + sizeof(unsigned);
 		}
 
+		/* If the chains have grown too long, try to enlarge the table. If
+		 * this fails, the old table remains valid and is used as it is.
+		 */
+
+		if (handle->entries >= handle->hashes * TEXTDUMP_LOAD_FACTOR && textdump_grow_hash(handle))
+			hash = textdump_make_hash(handle, text);
+
 		length = (strlen(text) + sizeof(struct textdump_header)) & 0xfffffffc;
 	} else {
 		length = strlen(text) + 1;
 	}
 
-	if ((handle->free + length) > handle->size) {
-		for (blocks = 1; (handle->free + length) > (handle->size + blocks * handle->allocation); blocks++);
-
-		if (flex_extend((flex_ptr) &(handle->text), (handle->size + blocks * handle->allocation) * sizeof(char)) == 0)
-			return TEXTDUMP_NULL;
-
-		handle->size += blocks * handle->allocation;
-	}
+	if (!textdump_reserve(handle, handle->free + length))
+		return TEXTDUMP_NULL;
 
 	offset = handle->free;
 
 	if (handle->hash != NULL && hash != -1) {
 		((struct textdump_header *) (handle->text + offset))->next = handle->hash[hash];
 		handle->hash[hash] = offset;
+		handle->entries++;
 		offset += sizeof(unsigned);
 	}
 
@@ -282,7 +294,65 @@ unsigned textdump_store(struct textdump_block *handle, char *text)
 
 
 /**
- * Create a hash for a given text string in a given text dump.
+ * Remove a text string from the text dump, if it was the last one to be
+ * stored. This allows strings to be released again by clients which only
+ * need them for a short while, so long as they are released in the reverse
+ * order to that in which they were stored. The caller must know that the
+ * string is not being shared with any other client of the dump.
+ *
+ * \param *handle		The handle of the text dump holding the string.
+ * \param offset		The offset of the string to be removed.
+ * \return			TRUE if the string was removed; else FALSE.
+ */
+
+osbool textdump_remove_last(struct textdump_block *handle, unsigned offset)
+{
+	unsigned	start, length;
+	int		hash;
+	char		*text;
+
+	if (handle == NULL || handle->text == NULL || offset == TEXTDUMP_NULL || offset >= handle->free)
+		return FALSE;
+
+	text = (char *) (handle->text + offset);
+
+	if (handle->hash != NULL) {
+		if (offset < sizeof(unsigned))
+			return FALSE;
+
+		start = offset - sizeof(unsigned);
+		length = (strlen(text) + sizeof(struct textdump_header)) & 0xfffffffc;
+	} else {
+		start = offset;
+		length = strlen(text) + 1;
+	}
+
+	if (start + length != handle->free)
+		return FALSE;
+
+	/* The most recent entry will always be at the head of its hash chain,
+	 * even if the table has been rebuilt since it was added.
+	 */
+
+	if (handle->hash != NULL) {
+		hash = textdump_make_hash(handle, text);
+
+		if (hash == -1 || handle->hash[hash] != start)
+			return FALSE;
+
+		handle->hash[hash] = ((struct textdump_header *) (handle->text + start))->next;
+		handle->entries--;
+	}
+
+	handle->free = start;
+
+	return TRUE;
+}
+
+
+/**
+ * Create a hash for a given text string in a given text dump, using the 32-bit
+ * FNV-1a algorithm.
  *
  * \param *handle		The handle of the relevant text dump.
  * \param *text			Pointer to the string to hash.
@@ -291,21 +361,184 @@ unsigned textdump_store(struct textdump_block *handle, char *text)
 
 static int textdump_make_hash(struct textdump_block *handle, char *text)
 {
-	int hash = 0, length, i;
+	unsigned	hash = TEXTDUMP_FNV_OFFSET;
 
 	if (handle == NULL || text == NULL)
 		return -1;
 
-	length = strlen(text);
-	for (i = 0; i < length; i++)
-		hash += text[i];
+	while (*text != '\0') {
+		hash ^= (unsigned char) *text++;
+		hash *= TEXTDUMP_FNV_PRIME;
+	}
 
 	return hash % handle->hashes;
 }
 
 
 /**
- * Load text from a file chunk into a text dump.
+ * Double the size of the hash table in a text dump, and rebuild the chains
+ * by walking through the stored strings in order.
+ *
+ * \param *handle		The handle of the text dump to update.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool textdump_grow_hash(struct textdump_block *handle)
+{
+	unsigned			*table, offset, size;
+	int				i, hash;
+	struct textdump_header		*header;
+
+	if (handle == NULL || handle->hash == NULL)
+		return FALSE;
+
+	size = handle->hashes * 2;
+
+	table = heap_alloc(size * sizeof(unsigned));
+	if (table == NULL)
+		return FALSE;
+
+	heap_free(handle->hash);
+
+	handle->hash = table;
+	handle->hashes = size;
+
+	for (i = 0; i < size; i++)
+		handle->hash[i] = TEXTDUMP_NULL;
+
+	offset = 0;
+
+	while (offset < handle->free) {
+		header = (struct textdump_header *) (handle->text + offset);
+		hash = textdump_make_hash(handle, header->text);
+
+		header->next = handle->hash[hash];
+		handle->hash[hash] = offset;
+
+		offset += (strlen(header->text) + sizeof(struct textdump_header)) & 0xfffffffc;
+	}
+
+#ifdef DEBUG
+	debug_printf("Text dump hash grown to %u buckets for %u entries", handle->hashes, handle->entries);
+#endif
+
+	return TRUE;
+}
+
+
+/**
+ * Make sure that a text dump has space claimed for at least the given number
+ * of bytes, extending its flex block if required.
+ *
+ * \param *handle		The handle of the text dump to update.
+ * \param required		The number of bytes which must be available.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool textdump_reserve(struct textdump_block *handle, unsigned required)
+{
+	unsigned	size;
+
+	if (handle == NULL)
+		return FALSE;
+
+	if (required <= handle->size)
+		return TRUE;
+
+	size = flexutils_grow_size(handle->size, required, handle->allocation);
+
+	if (!flexutils_resize((flex_ptr) &(handle->text), size * sizeof(char)))
+		return FALSE;
+
+	handle->size = size;
+
+	return TRUE;
+}
+
+
+/**
+ * Convert a block of packed, \0 terminated strings which has been placed at
+ * the free offset of a hashed text dump into hashed entries, expanding them
+ * in place and linking each into the hash table.
+ *
+ * This produces exactly the layout that storing each string in turn would,
+ * so offsets remain valid, but without searching the hash chains: the strings
+ * are assumed to be unique, as they will be if saved from a hashed dump.
+ *
+ * \param *handle		The handle of the text dump to update.
+ * \param size			The size of the packed strings, in bytes.
+ * \return			TRUE if successful; FALSE on failure.
+ */
+
+static osbool textdump_expand_hashed(struct textdump_block *handle, unsigned size)
+{
+	unsigned			source, target, end, required, entries, length;
+	int				hash;
+	struct textdump_header		*header;
+
+	if (handle == NULL || handle->hash == NULL)
+		return FALSE;
+
+	/* Find the number of strings, and the space that they will take once
+	 * each has been given a word-aligned header.
+	 */
+
+	required = 0;
+	entries = 0;
+
+	for (source = handle->free; source < handle->free + size; source += length + 1) {
+		length = strlen((char *) handle->text + source);
+		required += (length + sizeof(struct textdump_header)) & 0xfffffffc;
+		entries++;
+	}
+
+	if (!textdump_reserve(handle, handle->free + required))
+		return FALSE;
+
+	/* Size the hash table for the final number of entries, so that it
+	 * doesn't need to be rebuilt part way through.
+	 */
+
+	while (handle->entries + entries > handle->hashes * TEXTDUMP_LOAD_FACTOR && textdump_grow_hash(handle));
+
+	/* Move the strings to the end of the new space, then work forwards
+	 * expanding them into place. The target can never overtake the next
+	 * source string, as every entry is at least as long as its string.
+	 */
+
+	end = handle->free + required;
+
+	memmove(handle->text + end - size, handle->text + handle->free, size);
+
+	source = end - size;
+	target = handle->free;
+
+	while (target < end) {
+		header = (struct textdump_header *) (handle->text + target);
+		length = strlen((char *) handle->text + source);
+
+		memmove(header->text, handle->text + source, length + 1);
+		source += length + 1;
+
+		hash = textdump_make_hash(handle, header->text);
+		header->next = handle->hash[hash];
+		handle->hash[hash] = target;
+
+		target += (length + sizeof(struct textdump_header)) & 0xfffffffc;
+	}
+
+	handle->free = end;
+	handle->entries += entries;
+
+	return TRUE;
+}
+
+
+/**
+ * Load text from a file chunk into a text dump. The chunk is read in a single
+ * operation, so the strings must have been saved from a dump with the same
+ * terminator and hashing; if the dump is empty, the offsets returned when the
+ * strings were first stored will be valid once again.
  *
  * \param *handle		The handle of the text dump to load into.
  * \param *file			The file to be loaded from, which should have an
@@ -315,27 +548,47 @@ static int textdump_make_hash(struct textdump_block *handle, char *text)
 
 osbool textdump_load_file(struct textdump_block *handle, struct discfile_block *file)
 {
-	size_t		size;
-	char		buffer[1024]; // \TODO -- Remove!
+	unsigned	size;
 
 	if (handle == NULL || file == NULL || !discfile_open_chunk(file, DISCFILE_CHUNK_TEXTDUMP))
 		return FALSE;
 
 	size = discfile_chunk_size(file);
 
-	while (size > 0) {
-		discfile_read_string(file, buffer, 1024);
-
-		size -= (strlen(buffer) + 1);
+	/* Read the chunk into the free space at the end of the dump. */
 
-		if (textdump_store(handle, buffer) == TEXTDUMP_NULL) {
-			discfile_set_error(file, "FileMem");
-			return FALSE;
-		}
+	if (!textdump_reserve(handle, handle->free + size)) {
+		discfile_set_error(file, "FileMem");
+		return FALSE;
 	}
 
+	if (size > 0)
+		discfile_read_chunk(file, handle->text + handle->free, size);
+
 	discfile_close_chunk(file);
 
+	if (size == 0)
+		return TRUE;
+
+	/* The chunk must end with a complete string, or any scan through it
+	 * would run off the end of the data.
+	 */
+
+	if (handle->text[handle->free + size - 1] != handle->terminator) {
+		discfile_set_error(file, "FileUnrec");
+		return FALSE;
+	}
+
+	if (handle->hash == NULL) {
+		handle->free += size;
+		return TRUE;
+	}
+
+	if (!textdump_expand_hashed(handle, size)) {
+		discfile_set_error(file, "FileMem");
+		return FALSE;
+	}
+
 	return TRUE;
 }
 
@@ -350,24 +603,28 @@ osbool textdump_load_file(struct textdump_block *handle, struct discfile_block *
 
 void textdump_save_file(struct textdump_block *handle, struct discfile_block *file)
 {
-	char	*ptr, *end;
+	unsigned			offset;
+	struct textdump_header		*header;
 
 	if (handle == NULL || file == NULL)
 		return;
 
 	discfile_start_chunk(file, DISCFILE_CHUNK_TEXTDUMP);
 
-	ptr = (char *) handle->text;
-	end = (char *) handle->text + handle->free;
+	/* An unhashed dump is already in the file format; a hashed one must
+	 * have the headers stripped from its strings.
+	 */
 
-	if (handle->hash != NULL)
-		ptr += sizeof(unsigned);
-
-	while (ptr < end) {
-		ptr = discfile_write_string(file, ptr);
+	if (handle->hash == NULL) {
+		discfile_write_chunk(file, handle->text, handle->free);
+	} else {
+		offset = 0;
 
-		if (handle->hash != NULL)
-			ptr = (char *) (((int) ptr + (2 * sizeof(unsigned)) - 1) & 0xfffffffc);
+		while (offset < handle->free) {
+			header = (struct textdump_header *) (handle->text + offset);
+			discfile_write_string(file, header->text);
+			offset += (strlen(header->text) + sizeof(struct textdump_header)) & 0xfffffffc;
+		}
 	}
 
 	discfile_end_chunk(file);
@@ -138,7 +138,23 @@ unsigned textdump_store(struct textdump_block *handle, char *text);
 
 
 /**
- * Load text from a file chunk into a text dump.
+ * Remove a text string from the text dump, if it was the last one to be
+ * stored. The caller must know that the string is not being shared with
+ * any other client of the dump.
+ *
+ * \param *handle		The handle of the text dump holding the string.
+ * \param offset		The offset of the string to be removed.
+ * \return			TRUE if the string was removed; else FALSE.
+ */
+
+osbool textdump_remove_last(struct textdump_block *handle, unsigned offset);
+
+
+/**
+ * Load text from a file chunk into a text dump. The chunk is read in a single
+ * operation, so the strings must have been saved from a dump with the same
+ * terminator and hashing; if the dump is empty, the offsets returned when the
+ * strings were first stored will be valid once again.
  *
  * \param *handle		The handle of the text dump to load into.
  * \param *file			The file to be loaded from, which should have an
@@ -0,0 +1,589 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: validate.c
+ *
+ * Batch validation of objects against the disc.
+ */
+
+/* ANSI C Header files. */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Acorn C Header files. */
+
+#include "flex.h"
+
+/* OSLib Header files. */
+
+#include "oslib/fileswitch.h"
+#include "oslib/os.h"
+#include "oslib/osgbpb.h"
+#include "oslib/types.h"
+
+/* SF-Lib Header files. */
+
+#include "sflib/heap.h"
+#include "sflib/string.h"
+
+/* Application header files. */
+
+#include "validate.h"
+
+#include "flexutils.h"
+#include "fsys.h"
+#include "objdb.h"
+#include "quantum.h"
+
+
+#define VALIDATE_ALLOC_CHUNK 256						/**< The minimum number of objects to allocate at a time.	*/
+#define VALIDATE_BUFFER_SIZE 4096						/**< The size of the buffer used to read directories.		*/
+#define VALIDATE_READ_COUNT 256							/**< The maximum number of objects to read in each call.	*/
+
+
+/**
+ * An object waiting to be checked.
+ */
+
+struct validate_entry {
+	unsigned		parent;						/**< The key of the object's parent.				*/
+	unsigned		key;						/**< The key of the object.					*/
+};
+
+
+/**
+ * An object in the directory currently being checked, along with the
+ * details held for it in the database.
+ */
+
+struct validate_child {
+	char			*name;						/**< The name of the object.					*/
+	unsigned		key;						/**< The key of the object.					*/
+	bits			load_addr;					/**< The load address held for the object.			*/
+	bits			exec_addr;					/**< The execution address held for the object.			*/
+	int			size;						/**< The size held for the object.				*/
+	fileswitch_attr		attributes;					/**< The attributes held for the object.			*/
+	fileswitch_object_type	type;						/**< The object type held for the object.			*/
+	osbool			seen;						/**< TRUE if the object has been found in the listing.		*/
+};
+
+
+/**
+ * A batch validation.
+ */
+
+struct validate_block {
+	struct objdb_block	*objects;					/**< The database holding the objects.				*/
+
+	struct validate_entry	*entries;					/**< The objects to be checked (flex block).			*/
+	unsigned		entry_count;					/**< The number of objects to be checked.			*/
+	unsigned		entry_allocation;				/**< The number of objects for which space is allocated.	*/
+	osbool			sorted;						/**< TRUE once the objects have been grouped by parent.		*/
+
+	unsigned		next;						/**< The next object to be checked.				*/
+	unsigned		group_end;					/**< The end of the group of objects being checked.		*/
+	struct validate_child	*children;					/**< The objects in the current directory, or NULL.		*/
+	unsigned		child_count;					/**< The number of objects in the current directory.		*/
+	int			context;					/**< The context for the next directory read.			*/
+
+	char			*path;						/**< The pathname of the current directory (heap block).	*/
+	size_t			path_size;					/**< The space allocated to the pathname.			*/
+	byte			*buffer;					/**< The buffer used to read directories (heap block).		*/
+	osgbpb_info		*info;						/**< Space to read object details (heap block).			*/
+	size_t			info_size;					/**< The space allocated to the object details.			*/
+
+	unsigned		missing;					/**< The number of objects found to be missing.			*/
+	unsigned		changed;					/**< The number of objects found to have changed.		*/
+
+	struct quantum_block	quantum;					/**< The work quantum used to time the poll loop.		*/
+};
+
+
+static void		validate_check_object(struct validate_block *handle, unsigned key);
+static osbool		validate_open_group(struct validate_block *handle, unsigned end);
+static void		validate_read_group(struct validate_block *handle);
+static void		validate_close_group(struct validate_block *handle, osbool complete);
+static void		validate_set_status(struct validate_block *handle, unsigned key, enum objdb_status status);
+static int		validate_compare_entries(const void *a, const void *b);
+static int		validate_compare_children(const void *a, const void *b);
+
+
+/**
+ * Create a new batch validation for an object database.
+ *
+ * \param *objects		The database holding the objects to check.
+ * \return			The new validation handle, or NULL on failure.
+ */
+
+struct validate_block *validate_create(struct objdb_block *objects)
+{
+	struct validate_block	*new;
+
+	if (objects == NULL)
+		return NULL;
+
+	new = heap_alloc(sizeof(struct validate_block));
+	if (new == NULL)
+		return NULL;
+
+	new->objects = objects;
+
+	new->entry_count = 0;
+	new->entry_allocation = 0;
+	new->sorted = FALSE;
+
+	new->next = 0;
+	new->group_end = 0;
+	new->children = NULL;
+	new->child_count = 0;
+	new->context = 0;
+
+	new->path = NULL;
+	new->path_size = 0;
+	new->info = NULL;
+	new->info_size = 0;
+
+	new->missing = 0;
+	new->changed = 0;
+
+	quantum_initialise(&(new->quantum));
+
+	if (flex_alloc((flex_ptr) &(new->entries), VALIDATE_ALLOC_CHUNK * sizeof(struct validate_entry)) == 1)
+		new->entry_allocation = VALIDATE_ALLOC_CHUNK;
+	else
+		new->entries = NULL;
+
+	new->buffer = heap_alloc(VALIDATE_BUFFER_SIZE);
+
+	if (new->entries == NULL || new->buffer == NULL) {
+		validate_destroy(new);
+		return NULL;
+	}
+
+	return new;
+}
+
+
+/**
+ * Destroy a batch validation and free its memory. Any objects which haven't
+ * been checked are left as they were.
+ *
+ * \param *handle		The validation to destroy.
+ */
+
+void validate_destroy(struct validate_block *handle)
+{
+	if (handle == NULL)
+		return;
+
+	if (handle->entries != NULL)
+		flex_free((flex_ptr) &(handle->entries));
+
+	if (handle->children != NULL)
+		heap_free(handle->children);
+
+	if (handle->path != NULL)
+		heap_free(handle->path);
+
+	if (handle->buffer != NULL)
+		heap_free(handle->buffer);
+
+	if (handle->info != NULL)
+		heap_free(handle->info);
+
+	heap_free(handle);
+}
+
+
+/**
+ * Add an object to a batch validation. Objects can only be added before the
+ * first call to validate_poll().
+ *
+ * \param *handle		The validation to add the object to.
+ * \param key			The database key of the object.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+osbool validate_add_key(struct validate_block *handle, unsigned key)
+{
+	size_t		allocation;
+
+	if (handle == NULL || handle->sorted || key == OBJDB_NULL_KEY)
+		return FALSE;
+
+	if (handle->entry_count >= handle->entry_allocation) {
+		allocation = flexutils_grow_size(handle->entry_allocation, handle->entry_count + 1, VALIDATE_ALLOC_CHUNK);
+
+		if (!flexutils_resize((flex_ptr) &(handle->entries), allocation * sizeof(struct validate_entry)))
+			return FALSE;
+
+		handle->entry_allocation = allocation;
+	}
+
+	handle->entries[handle->entry_count].parent = objdb_get_parent(handle->objects, key);
+	handle->entries[handle->entry_count].key = key;
+	handle->entry_count++;
+
+	return TRUE;
+}
+
+
+/**
+ * Run a batch validation until it completes or the time slice ends, updating
+ * the status of each object in the database as it is checked.
+ *
+ * \param *handle		The validation to run.
+ * \param end_time		The time at which the slice should end.
+ * \return			TRUE if the validation has completed; else FALSE.
+ */
+
+osbool validate_poll(struct validate_block *handle, os_t end_time)
+{
+	unsigned	from, to, end;
+
+	if (handle == NULL)
+		return TRUE;
+
+	/* On the first pass, group the objects by parent and remove any
+	 * which were added more than once.
+	 */
+
+	if (!handle->sorted) {
+		qsort(handle->entries, handle->entry_count, sizeof(struct validate_entry), validate_compare_entries);
+
+		for (from = 0, to = 0; from < handle->entry_count; from++) {
+			if (to > 0 && handle->entries[from].key == handle->entries[to - 1].key)
+				continue;
+
+			handle->entries[to++] = handle->entries[from];
+		}
+
+		handle->entry_count = to;
+		handle->sorted = TRUE;
+	}
+
+	quantum_start(&(handle->quantum), end_time);
+
+	while (!quantum_expired(&(handle->quantum), 0)) {
+		if (handle->children != NULL) {
+			validate_read_group(handle);
+			quantum_check(&(handle->quantum));
+			continue;
+		}
+
+		if (handle->next >= handle->entry_count)
+			return TRUE;
+
+		for (end = handle->next + 1; end < handle->entry_count && handle->entries[end].parent == handle->entries[handle->next].parent; end++);
+
+		/* Roots, and objects which are the only ones to be checked in
+		 * their directory, are cheaper to read on their own.
+		 */
+
+		if (handle->entries[handle->next].parent == OBJDB_NULL_KEY || end - handle->next == 1 || !validate_open_group(handle, end)) {
+			validate_check_object(handle, handle->entries[handle->next].key);
+			handle->next++;
+			quantum_check(&(handle->quantum));
+		}
+	}
+
+	return FALSE;
+}
+
+
+/**
+ * Return details of the progress of a batch validation.
+ *
+ * \param *handle		The validation of interest.
+ * \param *checked		Pointer to a variable to take the number of
+ *				objects checked so far, or NULL.
+ * \param *total		Pointer to a variable to take the number of
+ *				objects to be checked, or NULL.
+ * \param *missing		Pointer to a variable to take the number of
+ *				objects found to be missing, or NULL.
+ * \param *changed		Pointer to a variable to take the number of
+ *				objects found to have changed, or NULL.
+ */
+
+void validate_get_progress(struct validate_block *handle, unsigned *checked, unsigned *total, unsigned *missing, unsigned *changed)
+{
+	if (checked != NULL)
+		*checked = (handle != NULL) ? handle->next : 0;
+
+	if (total != NULL)
+		*total = (handle != NULL) ? handle->entry_count : 0;
+
+	if (missing != NULL)
+		*missing = (handle != NULL) ? handle->missing : 0;
+
+	if (changed != NULL)
+		*changed = (handle != NULL) ? handle->changed : 0;
+}
+
+
+/**
+ * Check a single object by reading its catalogue information.
+ *
+ * \param *handle		The validation to which the object belongs.
+ * \param key			The key of the object to check.
+ */
+
+static void validate_check_object(struct validate_block *handle, unsigned key)
+{
+	validate_set_status(handle, key, objdb_validate_file(handle->objects, key, TRUE));
+}
+
+
+/**
+ * Set up the group of objects which share the parent of the next object to
+ * be checked, ready for their directory to be listed.
+ *
+ * \param *handle		The validation to set up.
+ * \param end			The entry after the last one in the group.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+static osbool validate_open_group(struct validate_block *handle, unsigned end)
+{
+	unsigned	entry, count;
+	size_t		length, text;
+	char		*name, *path;
+	osgbpb_info	*info;
+
+	/* Find the pathname of the directory. */
+
+	length = objdb_get_name_length(handle->objects, handle->entries[handle->next].parent);
+	if (length == 0)
+		return FALSE;
+
+	if (length > handle->path_size) {
+		path = heap_extend(handle->path, length);
+		if (path == NULL)
+			return FALSE;
+
+		handle->path = path;
+		handle->path_size = length;
+	}
+
+	objdb_get_name(handle->objects, handle->entries[handle->next].parent, handle->path, handle->path_size);
+
+	/* Copy the details of the objects, as the database can move. */
+
+	text = 0;
+
+	for (entry = handle->next; entry < end; entry++)
+		text += objdb_get_info(handle->objects, handle->entries[entry].key, NULL, 0, NULL);
+
+	handle->children = heap_alloc((end - handle->next) * sizeof(struct validate_child) + text);
+	if (handle->children == NULL)
+		return FALSE;
+
+	name = (char *) (handle->children + (end - handle->next));
+	count = 0;
+
+	for (entry = handle->next; entry < end; entry++) {
+		length = objdb_get_info(handle->objects, handle->entries[entry].key, NULL, 0, NULL);
+
+		/* If there's no room to copy an object's details, abandon the
+		 * group so that its objects are checked one by one instead.
+		 */
+
+		if (length > handle->info_size) {
+			info = heap_extend(handle->info, length);
+			if (info == NULL) {
+				heap_free(handle->children);
+				handle->children = NULL;
+				return FALSE;
+			}
+
+			handle->info = info;
+			handle->info_size = length;
+		}
+
+		objdb_get_info(handle->objects, handle->entries[entry].key, handle->info, handle->info_size, NULL);
+
+		strcpy(name, handle->info->name);
+
+		handle->children[count].name = name;
+		handle->children[count].key = handle->entries[entry].key;
+		handle->children[count].load_addr = handle->info->load_addr;
+		handle->children[count].exec_addr = handle->info->exec_addr;
+		handle->children[count].size = handle->info->size;
+		handle->children[count].attributes = handle->info->attr;
+		handle->children[count].type = handle->info->obj_type;
+		handle->children[count].seen = FALSE;
+
+		name += strlen(name) + 1;
+		count++;
+	}
+
+	qsort(handle->children, count, sizeof(struct validate_child), validate_compare_children);
+
+	handle->child_count = count;
+	handle->group_end = end;
+	handle->context = 0;
+
+	return TRUE;
+}
+
+
+/**
+ * Read the next block of entries from the directory being checked, and
+ * compare them with the objects held in the database.
+ *
+ * \param *handle		The validation to process.
+ */
+
+static void validate_read_group(struct validate_block *handle)
+{
+	os_error		*error;
+	osgbpb_info		*file;
+	struct validate_child	*child, find;
+	fileswitch_object_type	type;
+	int			read, offset, i;
+
+	error = fsys_read_dir(handle->path, (osgbpb_info_list *) handle->buffer, VALIDATE_READ_COUNT, handle->context,
+			VALIDATE_BUFFER_SIZE, &read, &(handle->context));
+
+	/* If the directory can't be read, its contents have only gone if the
+	 * directory itself has.
+	 */
+
+	if (error != NULL) {
+		error = fsys_read_object(handle->path, &type, NULL, NULL, NULL, NULL);
+		validate_close_group(handle, (error == NULL && type != fileswitch_IS_DIR && type != fileswitch_IS_IMAGE) ? TRUE : FALSE);
+		return;
+	}
+
+	offset = 0;
+
+	for (i = 0; i < read; i++) {
+		file = (osgbpb_info *) (handle->buffer + offset);
+		offset += (offsetof(osgbpb_info, name) + strlen(file->name) + 4) & 0xfffffffc;
+
+		find.name = file->name;
+		child = bsearch(&find, handle->children, handle->child_count, sizeof(struct validate_child), validate_compare_children);
+
+		if (child == NULL || child->seen)
+			continue;
+
+		child->seen = TRUE;
+
+		if (file->obj_type != child->type || file->load_addr != child->load_addr || file->exec_addr != child->exec_addr ||
+				file->size != child->size || file->attr != child->attributes)
+			validate_set_status(handle, child->key, OBJDB_STATUS_CHANGED);
+		else
+			validate_set_status(handle, child->key, OBJDB_STATUS_UNCHANGED);
+	}
+
+	if (handle->context == -1)
+		validate_close_group(handle, TRUE);
+}
+
+
+/**
+ * Finish checking a group of objects, marking any which weren't found in
+ * their directory as missing, and move on to the next group.
+ *
+ * \param *handle		The validation to process.
+ * \param complete		TRUE if the directory was read in full; FALSE
+ *				to leave the objects which weren't found alone.
+ */
+
+static void validate_close_group(struct validate_block *handle, osbool complete)
+{
+	unsigned	i;
+
+	if (complete) {
+		for (i = 0; i < handle->child_count; i++) {
+			if (!handle->children[i].seen)
+				validate_set_status(handle, handle->children[i].key, OBJDB_STATUS_MISSING);
+		}
+	}
+
+	heap_free(handle->children);
+	handle->children = NULL;
+	handle->child_count = 0;
+
+	handle->next = handle->group_end;
+}
+
+
+/**
+ * Record the status found for an object, and update the counts.
+ *
+ * \param *handle		The validation to which the object belongs.
+ * \param key			The key of the object.
+ * \param status		The status found for the object.
+ */
+
+static void validate_set_status(struct validate_block *handle, unsigned key, enum objdb_status status)
+{
+	objdb_set_status(handle->objects, key, status);
+
+	if (status == OBJDB_STATUS_MISSING)
+		handle->missing++;
+	else if (status == OBJDB_STATUS_CHANGED)
+		handle->changed++;
+}
+
+
+/**
+ * Compare two entries by parent and then key, for qsort().
+ *
+ * \param *a			The first entry to compare.
+ * \param *b			The second entry to compare.
+ * \return			The result of the comparison.
+ */
+
+static int validate_compare_entries(const void *a, const void *b)
+{
+	const struct validate_entry	*x = a, *y = b;
+
+	if (x->parent != y->parent)
+		return (x->parent < y->parent) ? -1 : 1;
+
+	if (x->key != y->key)
+		return (x->key < y->key) ? -1 : 1;
+
+	return 0;
+}
+
+
+/**
+ * Compare two objects by name, ignoring case as the filing system would,
+ * for qsort() and bsearch().
+ *
+ * \param *a			The first object to compare.
+ * \param *b			The second object to compare.
+ * \return			The result of comparing the names.
+ */
+
+static int validate_compare_children(const void *a, const void *b)
+{
+	return string_nocase_strcmp(((struct validate_child *) a)->name, ((struct validate_child *) b)->name);
+}
+
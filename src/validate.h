@@ -0,0 +1,108 @@
+/* Copyright 2012, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: validate.h
+ *
+ * Batch validation of objects against the disc.
+ *
+ * Objects are grouped by their parent directory, and each directory is
+ * listed once to check all of the objects in it, rather than reading the
+ * catalogue information for each object separately. The work is done in
+ * time slices, so that it can run from the Wimp's null polls.
+ */
+
+#ifndef LOCATE_VALIDATE
+#define LOCATE_VALIDATE
+
+#include "oslib/os.h"
+#include "oslib/types.h"
+
+#include "objdb.h"
+
+
+struct validate_block;
+
+
+/**
+ * Create a new batch validation for an object database.
+ *
+ * \param *objects		The database holding the objects to check.
+ * \return			The new validation handle, or NULL on failure.
+ */
+
+struct validate_block *validate_create(struct objdb_block *objects);
+
+
+/**
+ * Destroy a batch validation and free its memory. Any objects which haven't
+ * been checked are left as they were.
+ *
+ * \param *handle		The validation to destroy.
+ */
+
+void validate_destroy(struct validate_block *handle);
+
+
+/**
+ * Add an object to a batch validation. Objects can only be added before the
+ * first call to validate_poll().
+ *
+ * \param *handle		The validation to add the object to.
+ * \param key			The database key of the object.
+ * \return			TRUE if successful; else FALSE.
+ */
+
+osbool validate_add_key(struct validate_block *handle, unsigned key);
+
+
+/**
+ * Run a batch validation until it completes or the time slice ends, updating
+ * the status of each object in the database as it is checked.
+ *
+ * \param *handle		The validation to run.
+ * \param end_time		The time at which the slice should end.
+ * \return			TRUE if the validation has completed; else FALSE.
+ */
+
+osbool validate_poll(struct validate_block *handle, os_t end_time);
+
+
+/**
+ * Return details of the progress of a batch validation.
+ *
+ * \param *handle		The validation of interest.
+ * \param *checked		Pointer to a variable to take the number of
+ *				objects checked so far, or NULL.
+ * \param *total		Pointer to a variable to take the number of
+ *				objects to be checked, or NULL.
+ * \param *missing		Pointer to a variable to take the number of
+ *				objects found to be missing, or NULL.
+ * \param *changed		Pointer to a variable to take the number of
+ *				objects found to have changed, or NULL.
+ */
+
+void validate_get_progress(struct validate_block *handle, unsigned *checked, unsigned *total, unsigned *missing, unsigned *changed);
+
+#endif
+
@@ -0,0 +1,525 @@
+/* Copyright 2016, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: wildcard.c
+ *
+ * Compiled wildcard matching.
+ *
+ * A comma-separated list of wildcard patterns, using the * and # wildcards of
+ * string_wildcard_compare(), is analysed once when it is created so that the
+ * literal text at either end of each pattern and the minimum possible name
+ * length are known. Most names can then be rejected after checking their
+ * length and a few characters, with the full backtracking comparison only
+ * needed for the section between the first and last wildcards.
+ *
+ * Patterns are indexed on their first literal character or, if they start
+ * with a wildcard, their last. A name is therefore only compared against
+ * the patterns which share its first or last character, plus any which
+ * both start and end with a wildcard.
+ */
+
+/* ANSI C Header files. */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* OSLib header files */
+
+#include "oslib/types.h"
+
+/* SF-Lib header files. */
+
+#include "sflib/heap.h"
+#include "sflib/string.h"
+
+/* Application header files */
+
+#include "wildcard.h"
+
+
+/**
+ * A compiled wildcard pattern.
+ */
+
+struct wildcard_pattern {
+	char			*pattern;					/**< The pattern, folded to lower case if case is to be ignored.	*/
+	size_t			length;						/**< The length of the pattern.						*/
+
+	size_t			prefix;						/**< The length of the literal text before the first wildcard.		*/
+	size_t			suffix;						/**< The length of the literal text after the last wildcard.		*/
+	size_t			minimum;					/**< The minimum length of a name which could match.			*/
+
+	osbool			any_length;					/**< TRUE if the pattern contains a *, so names may be longer.		*/
+	osbool			literal;					/**< TRUE if the pattern contains no wildcards at all.			*/
+	osbool			simple;						/**< TRUE if the pattern is just prefix, * and suffix.			*/
+
+	unsigned		next;						/**< The next pattern in the same index chain, or WILDCARD_NONE.	*/
+};
+
+/**
+ * A compiled list of wildcard patterns.
+ */
+
+struct wildcard_block {
+	char			*text;						/**< A copy of the list, split into individual patterns.		*/
+	char			*folded;					/**< A folded copy of the split list, used for matching.		*/
+	unsigned char		*fold;						/**< The folding table to apply to names before comparison.		*/
+
+	struct wildcard_pattern	*patterns;					/**< The compiled patterns.						*/
+	unsigned		count;						/**< The number of patterns in the list.				*/
+
+	unsigned		first[256];					/**< Chains of patterns, indexed on their first character.		*/
+	unsigned		last[256];					/**< Chains of patterns starting with a wildcard, on their last.	*/
+	unsigned		floating;					/**< The chain of patterns starting and ending with wildcards.		*/
+};
+
+
+/**
+ * Case folding tables, shared by all patterns.
+ */
+
+static unsigned char		wildcard_fold_none[256];
+static unsigned char		wildcard_fold_case[256];
+static osbool			wildcard_tables_ready = FALSE;
+
+
+static void	wildcard_compile(struct wildcard_pattern *pattern, char *text, char *folded, unsigned char *fold);
+static unsigned	wildcard_match_chain(struct wildcard_block *handle, unsigned chain, char *name, size_t length);
+static osbool	wildcard_match_section(unsigned char *fold, char *name, size_t name_length, char *pattern, size_t pattern_length);
+
+
+/**
+ * Compile a comma-separated list of wildcard patterns into a matcher. A
+ * comma which is part of a pattern must be escaped as "\,".
+ *
+ * \param *patterns		The list of patterns to compile.
+ * \param any_case		TRUE to match without regard to case; else FALSE.
+ * \return			The new matcher handle, or NULL on failure.
+ */
+
+struct wildcard_block *wildcard_create(char *patterns, osbool any_case)
+{
+	struct wildcard_block	*new;
+	struct wildcard_pattern	*pattern;
+	char			*text, *start, *end, separator;
+	unsigned		entries, i, *chain;
+
+	if (patterns == NULL)
+		return NULL;
+
+	if (!wildcard_tables_ready) {
+		for (i = 0; i < 256; i++) {
+			wildcard_fold_none[i] = i;
+			wildcard_fold_case[i] = tolower(i);
+		}
+
+		wildcard_tables_ready = TRUE;
+	}
+
+	/* Count the patterns in the list, to size the pattern array. Escaped
+	 * commas are counted too, which can only over-estimate the space.
+	 */
+
+	entries = 1;
+
+	for (text = patterns; *text != '\0'; text++)
+		if (*text == ',')
+			entries++;
+
+	new = heap_alloc(sizeof(struct wildcard_block));
+	if (new == NULL)
+		return NULL;
+
+	new->fold = (any_case) ? wildcard_fold_case : wildcard_fold_none;
+	new->count = 0;
+	new->floating = WILDCARD_NONE;
+
+	for (i = 0; i < 256; i++) {
+		new->first[i] = WILDCARD_NONE;
+		new->last[i] = WILDCARD_NONE;
+	}
+
+	new->text = heap_alloc(strlen(patterns) + 1);
+	new->folded = heap_alloc(strlen(patterns) + 1);
+	new->patterns = heap_alloc(entries * sizeof(struct wildcard_pattern));
+
+	if (new->text == NULL || new->folded == NULL || new->patterns == NULL) {
+		wildcard_destroy(new);
+		return NULL;
+	}
+
+	strcpy(new->text, patterns);
+
+	/* Split the list up at the commas and compile each pattern in turn.
+	 * Commas are valid in leafnames, so one preceded by a backslash is
+	 * taken as part of the pattern. The escapes are removed as the list
+	 * is split, leaving the patterns packed end to end in the text.
+	 */
+
+	text = new->text;
+	start = new->text;
+
+	do {
+		for (end = start; *text != '\0' && *text != ','; text++) {
+			if (*text == '\\' && *(text + 1) == ',')
+				text++;
+
+			*end++ = *text;
+		}
+
+		separator = *text++;
+		*end = '\0';
+
+		wildcard_compile(new->patterns + new->count++, start, new->folded + (start - new->text), new->fold);
+
+		start = end + 1;
+	} while (separator != '\0');
+
+	/* Link the patterns into the index chains. Working backwards leaves
+	 * each chain in ascending order, so that the first match found in a
+	 * chain is also the earliest in the list.
+	 */
+
+	for (i = new->count; i > 0; i--) {
+		pattern = new->patterns + i - 1;
+
+		if (pattern->prefix > 0)
+			chain = &(new->first[(unsigned char) pattern->pattern[0]]);
+		else if (pattern->suffix > 0)
+			chain = &(new->last[(unsigned char) pattern->pattern[pattern->length - 1]]);
+		else
+			chain = &(new->floating);
+
+		pattern->next = *chain;
+		*chain = i - 1;
+	}
+
+	return new;
+}
+
+
+/**
+ * Destroy a compiled wildcard list.
+ *
+ * \param *handle		The matcher to destroy.
+ */
+
+void wildcard_destroy(struct wildcard_block *handle)
+{
+	if (handle == NULL)
+		return;
+
+	if (handle->patterns != NULL)
+		heap_free(handle->patterns);
+
+	if (handle->folded != NULL)
+		heap_free(handle->folded);
+
+	if (handle->text != NULL)
+		heap_free(handle->text);
+
+	heap_free(handle);
+}
+
+
+/**
+ * Return the number of patterns in a compiled wildcard list.
+ *
+ * \param *handle		The matcher to query.
+ * \return			The number of patterns, or 0 on error.
+ */
+
+unsigned wildcard_get_count(struct wildcard_block *handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return handle->count;
+}
+
+
+/**
+ * Return a pattern from a compiled wildcard list, as it was supplied.
+ *
+ * \param *handle		The matcher to query.
+ * \param index			The index of the pattern in the list.
+ * \param *buffer		Pointer to a buffer to take the pattern.
+ * \param length		The length of the buffer.
+ * \return			Pointer to the buffer, or NULL on error.
+ */
+
+char *wildcard_get_pattern(struct wildcard_block *handle, unsigned index, char *buffer, size_t length)
+{
+	char	*text;
+
+	if (handle == NULL || index >= handle->count || buffer == NULL || length == 0)
+		return NULL;
+
+	/* The unfolded patterns remain in the split-up list text. */
+
+	for (text = handle->text; index > 0; index--)
+		text += strlen(text) + 1;
+
+	string_copy(buffer, text, length);
+
+	return buffer;
+}
+
+
+/**
+ * Test a name against a compiled wildcard list.
+ *
+ * \param *handle		The matcher to test against.
+ * \param *name			The name to test.
+ * \return			The index of the first pattern in the list which
+ *				matches, or WILDCARD_NONE if none do.
+ */
+
+unsigned wildcard_match(struct wildcard_block *handle, char *name)
+{
+	size_t		length;
+	unsigned	match, best = WILDCARD_NONE;
+
+	if (handle == NULL || name == NULL)
+		return WILDCARD_NONE;
+
+	length = strlen(name);
+
+	/* Test the three chains which could contain a match. Each is in
+	 * ascending order, so the lowest match overall is the lowest of their
+	 * first matches.
+	 */
+
+	if (length > 0) {
+		best = wildcard_match_chain(handle, handle->first[handle->fold[(unsigned char) name[0]]], name, length);
+
+		match = wildcard_match_chain(handle, handle->last[handle->fold[(unsigned char) name[length - 1]]], name, length);
+		if (match < best)
+			best = match;
+	}
+
+	match = wildcard_match_chain(handle, handle->floating, name, length);
+	if (match < best)
+		best = match;
+
+	return best;
+}
+
+
+/**
+ * Turn a comma-separated list of names into a list of wildcard patterns
+ * which will match any names containing them, by wrapping each in *s. The
+ * list is split in the same way as by wildcard_create(), so an escaped
+ * "\," is copied through as part of its name.
+ *
+ * \param *buffer		Pointer to the buffer to take the patterns.
+ * \param length		The length of the buffer.
+ * \param *list			Pointer to the list of names.
+ */
+
+void wildcard_make_contains_list(char *buffer, size_t length, char *list)
+{
+	char	*end;
+
+	if (buffer == NULL || length == 0)
+		return;
+
+	end = buffer + length - 1;
+
+	while (list != NULL && buffer < end) {
+		*buffer++ = '*';
+
+		while (*list != '\0' && *list != ',' && buffer < end) {
+			if (*list == '\\' && *(list + 1) == ',') {
+				if (buffer + 1 >= end)
+					break;
+
+				*buffer++ = *list++;
+			}
+
+			*buffer++ = *list++;
+		}
+
+		if (buffer < end)
+			*buffer++ = '*';
+
+		if (*list == ',' && buffer < end)
+			*buffer++ = *list++;
+		else
+			list = NULL;
+	}
+
+	*buffer = '\0';
+}
+
+
+/**
+ * Analyse a pattern and take a folded copy of it.
+ *
+ * \param *pattern		The pattern block to fill in.
+ * \param *text			The pattern text.
+ * \param *folded		Pointer to the space to take the folded copy.
+ * \param *fold			The folding table to apply.
+ */
+
+static void wildcard_compile(struct wildcard_pattern *pattern, char *text, char *folded, unsigned char *fold)
+{
+	size_t		i, first, last;
+
+	pattern->pattern = folded;
+	pattern->length = strlen(text);
+
+	/* Take a folded copy of the pattern, noting the positions of the first
+	 * and last wildcards and the number of characters that a name must
+	 * contain to match.
+	 */
+
+	first = pattern->length;
+	last = pattern->length;
+	pattern->minimum = 0;
+	pattern->any_length = FALSE;
+
+	for (i = 0; i <= pattern->length; i++) {
+		folded[i] = fold[(unsigned char) text[i]];
+
+		if (text[i] == '*' || text[i] == '#') {
+			if (first == pattern->length)
+				first = i;
+			last = i;
+		}
+
+		if (text[i] == '*')
+			pattern->any_length = TRUE;
+		else if (text[i] != '\0')
+			pattern->minimum++;
+	}
+
+	pattern->literal = (first == pattern->length) ? TRUE : FALSE;
+	pattern->prefix = first;
+	pattern->suffix = (pattern->literal) ? 0 : pattern->length - last - 1;
+
+	/* The pattern is simple if everything between the prefix and suffix
+	 * is a *.
+	 */
+
+	pattern->simple = !pattern->literal;
+
+	for (i = first; pattern->simple && i <= last; i++)
+		if (folded[i] != '*')
+			pattern->simple = FALSE;
+}
+
+
+/**
+ * Test a name against the patterns in an index chain, stopping at the first
+ * which matches.
+ *
+ * \param *handle		The matcher holding the chain.
+ * \param chain			The index of the first pattern in the chain.
+ * \param *name			The name to test.
+ * \param length		The length of the name.
+ * \return			The index of the matching pattern, or
+ *				WILDCARD_NONE if none do.
+ */
+
+static unsigned wildcard_match_chain(struct wildcard_block *handle, unsigned chain, char *name, size_t length)
+{
+	struct wildcard_pattern	*pattern;
+	unsigned char		*fold = handle->fold;
+	size_t			i;
+
+	for (; chain != WILDCARD_NONE; chain = pattern->next) {
+		pattern = handle->patterns + chain;
+
+		if (length < pattern->minimum || (!pattern->any_length && length != pattern->minimum))
+			continue;
+
+		for (i = 0; i < pattern->prefix; i++)
+			if (fold[(unsigned char) name[i]] != (unsigned char) pattern->pattern[i])
+				break;
+
+		if (i < pattern->prefix)
+			continue;
+
+		if (pattern->literal)
+			return chain;
+
+		for (i = 1; i <= pattern->suffix; i++)
+			if (fold[(unsigned char) name[length - i]] != (unsigned char) pattern->pattern[pattern->length - i])
+				break;
+
+		if (i <= pattern->suffix)
+			continue;
+
+		if (pattern->simple || wildcard_match_section(fold, name + pattern->prefix, length - pattern->prefix - pattern->suffix,
+				pattern->pattern + pattern->prefix, pattern->length - pattern->prefix - pattern->suffix))
+			return chain;
+	}
+
+	return WILDCARD_NONE;
+}
+
+
+/**
+ * Match part of a name against part of a pattern, allowing the pattern to
+ * contain wildcards. Only the most recent * needs to be returned to when
+ * a comparison fails, so no recursion is required.
+ *
+ * \param *fold			The folding table to apply to the name.
+ * \param *name			The start of the section of name to test.
+ * \param name_length		The length of the section of name.
+ * \param *pattern		The start of the section of folded pattern.
+ * \param pattern_length	The length of the section of pattern.
+ * \return			TRUE if the sections match; else FALSE.
+ */
+
+static osbool wildcard_match_section(unsigned char *fold, char *name, size_t name_length, char *pattern, size_t pattern_length)
+{
+	size_t		n = 0, p = 0, star_n = 0, star_p = 0;
+	osbool		star = FALSE;
+
+	while (n < name_length) {
+		if (p < pattern_length && pattern[p] == '*') {
+			star = TRUE;
+			star_p = ++p;
+			star_n = n;
+		} else if (p < pattern_length && (pattern[p] == '#' || (unsigned char) pattern[p] == fold[(unsigned char) name[n]])) {
+			p++;
+			n++;
+		} else if (star) {
+			p = star_p;
+			n = ++star_n;
+		} else {
+			return FALSE;
+		}
+	}
+
+	while (p < pattern_length && pattern[p] == '*')
+		p++;
+
+	return (p == pattern_length) ? TRUE : FALSE;
+}
+
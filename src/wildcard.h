@@ -0,0 +1,111 @@
+/* Copyright 2016, Stephen Fryatt (info@stevefryatt.org.uk)
+ *
+ * This file is part of Locate:
+ *
+ *   http://www.stevefryatt.org.uk/software/
+ *
+ * Licensed under the EUPL, Version 1.2 only (the "Licence");
+ * You may not use this work except in compliance with the
+ * Licence.
+ *
+ * You may obtain a copy of the Licence at:
+ *
+ *   http://joinup.ec.europa.eu/software/page/eupl
+ *
+ * Unless required by applicable law or agreed to in
+ * writing, software distributed under the Licence is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES
+ * OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * See the Licence for the specific language governing
+ * permissions and limitations under the Licence.
+ */
+
+/**
+ * \file: wildcard.h
+ *
+ * Compiled wildcard matching.
+ */
+
+#ifndef LOCATE_WILDCARD
+#define LOCATE_WILDCARD
+
+#include <stddef.h>
+#include "oslib/types.h"
+
+struct wildcard_block;
+
+
+#define WILDCARD_NONE 0xffffffffu						/**< No pattern matched.						*/
+
+
+/**
+ * Compile a comma-separated list of wildcard patterns into a matcher. A
+ * comma which is part of a pattern must be escaped as "\,".
+ *
+ * \param *patterns		The list of patterns to compile.
+ * \param any_case		TRUE to match without regard to case; else FALSE.
+ * \return			The new matcher handle, or NULL on failure.
+ */
+
+struct wildcard_block *wildcard_create(char *patterns, osbool any_case);
+
+
+/**
+ * Destroy a compiled wildcard list.
+ *
+ * \param *handle		The matcher to destroy.
+ */
+
+void wildcard_destroy(struct wildcard_block *handle);
+
+
+/**
+ * Return the number of patterns in a compiled wildcard list.
+ *
+ * \param *handle		The matcher to query.
+ * \return			The number of patterns, or 0 on error.
+ */
+
+unsigned wildcard_get_count(struct wildcard_block *handle);
+
+
+/**
+ * Return a pattern from a compiled wildcard list, as it was supplied.
+ *
+ * \param *handle		The matcher to query.
+ * \param index			The index of the pattern in the list.
+ * \param *buffer		Pointer to a buffer to take the pattern.
+ * \param length		The length of the buffer.
+ * \return			Pointer to the buffer, or NULL on error.
+ */
+
+char *wildcard_get_pattern(struct wildcard_block *handle, unsigned index, char *buffer, size_t length);
+
+
+/**
+ * Test a name against a compiled wildcard list.
+ *
+ * \param *handle		The matcher to test against.
+ * \param *name			The name to test.
+ * \return			The index of the first pattern in the list which
+ *				matches, or WILDCARD_NONE if none do.
+ */
+
+unsigned wildcard_match(struct wildcard_block *handle, char *name);
+
+
+/**
+ * Turn a comma-separated list of names into a list of wildcard patterns
+ * which will match any names containing them. Escaped commas are kept as
+ * part of their names, as they are by wildcard_create().
+ *
+ * \param *buffer		Pointer to the buffer to take the patterns.
+ * \param length		The length of the buffer.
+ * \param *list			Pointer to the list of names.
+ */
+
+void wildcard_make_contains_list(char *buffer, size_t length, char *list);
+
+#endif
+